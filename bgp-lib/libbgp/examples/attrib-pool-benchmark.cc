@@ -0,0 +1,120 @@
+/**
+ * @file attrib-pool-benchmark.cc
+ * @author Nato Morichika <nat@nat.moe>
+ * @brief Memory accounting of path attribute interning with many RIBs.
+ * @version 0.1
+ * @date 2020-01-26
+ * 
+ * Simulate the RIBs of a full-mesh of routers: every router learns the same
+ * routes, grouped in updates, from its peers. Path attributes are created for
+ * every update received by every router, like the deserializer does. The RIBs
+ * are filled once with a pool per RIB and once with a single shared pool, and
+ * the memory accounting of the pools is printed.
+ * 
+ * @copyright Copyright (c) 2020
+ * 
+ */
+#include <libbgp/bgp-rib4.h>
+#include <arpa/inet.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+// Create path attributes of an update, like the deserializer would.
+std::vector<std::shared_ptr<libbgp::BgpPathAttrib>> makeAttribs(libbgp::BgpLogHandler *logger, uint32_t nexthop, uint32_t origin_asn) {
+    std::vector<std::shared_ptr<libbgp::BgpPathAttrib>> attribs;
+    libbgp::BgpPathAttribOrigin *origin = new libbgp::BgpPathAttribOrigin(logger);
+    libbgp::BgpPathAttribNexthop *nexthop_attr = new libbgp::BgpPathAttribNexthop(logger);
+    libbgp::BgpPathAttribAsPath *as_path = new libbgp::BgpPathAttribAsPath(logger, true);
+    libbgp::BgpPathAttribLocalPref *local_pref = new libbgp::BgpPathAttribLocalPref(logger);
+
+    origin->origin = libbgp::IGP;
+    nexthop_attr->next_hop = nexthop;
+    as_path->prepend(origin_asn);
+    as_path->prepend(65000);
+    local_pref->local_pref = 100;
+
+    attribs.push_back(std::shared_ptr<libbgp::BgpPathAttrib>(origin));
+    attribs.push_back(std::shared_ptr<libbgp::BgpPathAttrib>(nexthop_attr));
+    attribs.push_back(std::shared_ptr<libbgp::BgpPathAttrib>(as_path));
+    attribs.push_back(std::shared_ptr<libbgp::BgpPathAttrib>(local_pref));
+
+    return attribs;
+}
+
+// Fill the RIBs, print and return stats summed over the given pools.
+libbgp::BgpAttribPoolStats fill(libbgp::BgpLogHandler *logger, std::vector<std::unique_ptr<libbgp::BgpRib4>> &ribs, const std::vector<const libbgp::BgpAttribPool*> &pools, size_t n_updates, size_t routes_per_update, const char *name) {
+    size_t n_routers = ribs.size();
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (size_t router = 0; router < n_routers; router++) {
+        // every peer of the router advertises the same updates. (full-mesh of
+        // IBGP sessions with the updates originated behind one border router)
+        for (size_t peer = 0; peer < 3 && peer < n_routers; peer++) {
+            uint32_t peer_id = htonl(0x0a000001 + peer);
+            for (size_t update = 0; update < n_updates; update++) {
+                std::vector<libbgp::Prefix4> routes;
+                for (size_t i = 0; i < routes_per_update; i++) {
+                    uint32_t prefix = 0x64000000 + ((update * routes_per_update + i) << 8);
+                    routes.push_back(libbgp::Prefix4(htonl(prefix), 24));
+                }
+                ribs[router]->insert(peer_id, routes, makeAttribs(logger, htonl(0x0a000001), 64512 + update), 0, 65000);
+            }
+        }
+    }
+    auto t1 = std::chrono::steady_clock::now();
+
+    libbgp::BgpAttribPoolStats total;
+    memset(&total, 0, sizeof(total));
+    for (const libbgp::BgpAttribPool *pool : pools) {
+        libbgp::BgpAttribPoolStats stats = pool->getStats();
+        total.sets += stats.sets;
+        total.references += stats.references;
+        total.bytes += stats.bytes;
+        total.bytes_saved += stats.bytes_saved;
+        total.lookups += stats.lookups;
+        total.hits += stats.hits;
+    }
+
+    printf("%-8s %zu routers: %zu sets, %zu references, %zu bytes of attributes (%zu saved), %lu/%lu intern hits, %.1f ms\n",
+        name, n_routers, total.sets, total.references, total.bytes, total.bytes_saved, (unsigned long) total.hits,
+        (unsigned long) total.lookups, std::chrono::duration<double, std::milli>(t1 - t0).count());
+
+    return total;
+}
+
+int main(int argc, char **argv) {
+    size_t n_routers = argc > 1 ? strtoul(argv[1], NULL, 10) : 100;
+    size_t n_updates = argc > 2 ? strtoul(argv[2], NULL, 10) : 100;
+    size_t routes_per_update = argc > 3 ? strtoul(argv[3], NULL, 10) : 10;
+
+    libbgp::BgpLogHandler logger;
+    logger.setLogLevel(libbgp::ERROR);
+
+    std::vector<std::unique_ptr<libbgp::BgpRib4>> ribs;
+    std::vector<const libbgp::BgpAttribPool*> pools;
+
+    // one pool per RIB (the default).
+    for (size_t i = 0; i < n_routers; i++) {
+        ribs.push_back(std::unique_ptr<libbgp::BgpRib4>(new libbgp::BgpRib4(&logger)));
+        pools.push_back(&ribs.back()->getAttribPool());
+    }
+    libbgp::BgpAttribPoolStats separated = fill(&logger, ribs, pools, n_updates, routes_per_update, "per-rib");
+
+    // one pool shared by all RIBs.
+    libbgp::BgpAttribPool shared_pool;
+    ribs.clear();
+    pools.clear();
+    for (size_t i = 0; i < n_routers; i++) {
+        ribs.push_back(std::unique_ptr<libbgp::BgpRib4>(new libbgp::BgpRib4(&logger)));
+        ribs.back()->setAttribPool(&shared_pool);
+    }
+    pools.push_back(&shared_pool);
+    libbgp::BgpAttribPoolStats shared = fill(&logger, ribs, pools, n_updates, routes_per_update, "shared");
+
+    // the shared pool should hold one set per distinct update.
+    return shared.sets == n_updates && separated.sets == n_updates * n_routers ? 0 : 1;
+}
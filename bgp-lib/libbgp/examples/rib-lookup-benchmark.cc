@@ -0,0 +1,252 @@
+/**
+ * @file rib-lookup-benchmark.cc
+ * @author Nato Morichika <nat@nat.moe>
+ * @brief Benchmark of BgpRib4/BgpRib6 lookups against a linear scan of the RIB.
+ * @version 0.2
+ * @date 2020-01-23
+ * 
+ * Fill a BgpRib4 and a BgpRib6 with routes from a few peers, then compare the
+ * results and timing of lookup (which uses the FIB trie) with a linear scan of
+ * every RIB entry. The comparison is repeated after withdrawing and discarding
+ * routes to check the FIB is kept in sync with the RIB. The cost of best path
+ * comparisons between RIB entries is also measured.
+ * 
+ * @copyright Copyright (c) 2020
+ * 
+ */
+#include <libbgp/bgp-rib4.h>
+#include <libbgp/bgp-rib6.h>
+#include <arpa/inet.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <random>
+#include <vector>
+
+// Netmask of a CIDR length, in host byte order.
+uint32_t hostMask(uint8_t length) {
+    return length == 0 ? 0 : 0xffffffff << (32 - length);
+}
+
+// An IPv6 address, so it can be stored in vectors.
+struct Address6 {
+    uint8_t addr[16];
+};
+
+// The linear scan lookup used to do: pick the most specific active entry
+// including the destination, and the best one among equal prefixes.
+template<typename Entry, typename Rib, typename Dest> const Entry* scanRib(const Rib &rib, const Dest &dest) {
+    const Entry *selected = NULL;
+
+    for (const auto &entry : rib.get()) {
+        const Entry &e = entry.second;
+        if (e.status != libbgp::RS_ACTIVE || !e.route.includes(dest)) continue;
+        if (selected == NULL || e.route.getLength() > selected->route.getLength()) selected = &e;
+        else if (e.route.getLength() == selected->route.getLength() && !(*selected > e)) selected = &e;
+    }
+
+    return selected;
+}
+
+const void* scanLookup(const libbgp::BgpRib4 &rib, uint32_t dest) {
+    return scanRib<libbgp::BgpRib4Entry>(rib, dest);
+}
+
+const void* scanLookup(const libbgp::BgpRib6 &rib, const Address6 &dest) {
+    return scanRib<libbgp::BgpRib6Entry>(rib, dest.addr);
+}
+
+const void* fibLookup(const libbgp::BgpRib4 &rib, uint32_t dest) {
+    return rib.lookup(dest);
+}
+
+const void* fibLookup(const libbgp::BgpRib6 &rib, const Address6 &dest) {
+    return rib.lookup(dest.addr);
+}
+
+// Create path attributes for a route with an AS path of the given length.
+std::vector<std::shared_ptr<libbgp::BgpPathAttrib>> makeAttribs(libbgp::BgpLogHandler *logger, uint32_t nexthop, uint32_t peer_asn, int as_path_len) {
+    std::vector<std::shared_ptr<libbgp::BgpPathAttrib>> attribs;
+    libbgp::BgpPathAttribOrigin *origin = new libbgp::BgpPathAttribOrigin(logger);
+    libbgp::BgpPathAttribNexthop *nexthop_attr = new libbgp::BgpPathAttribNexthop(logger);
+    libbgp::BgpPathAttribAsPath *as_path = new libbgp::BgpPathAttribAsPath(logger, true);
+
+    origin->origin = libbgp::IGP;
+    nexthop_attr->next_hop = nexthop;
+    for (int i = 0; i < as_path_len; i++) as_path->prepend(peer_asn + i);
+
+    attribs.push_back(std::shared_ptr<libbgp::BgpPathAttrib>(origin));
+    attribs.push_back(std::shared_ptr<libbgp::BgpPathAttrib>(nexthop_attr));
+    attribs.push_back(std::shared_ptr<libbgp::BgpPathAttrib>(as_path));
+
+    return attribs;
+}
+
+// Run the queries with both methods, print timing, return number of mismatches.
+template<typename Rib, typename Dest> size_t compare(const Rib &rib, const std::vector<Dest> &queries, const char *stage) {
+    std::vector<const void*> scanned, looked_up;
+    scanned.reserve(queries.size());
+    looked_up.reserve(queries.size());
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (const Dest &dest : queries) scanned.push_back(scanLookup(rib, dest));
+    auto t1 = std::chrono::steady_clock::now();
+    for (const Dest &dest : queries) looked_up.push_back(fibLookup(rib, dest));
+    auto t2 = std::chrono::steady_clock::now();
+
+    size_t mismatches = 0, matched = 0;
+    for (size_t i = 0; i < queries.size(); i++) {
+        if (scanned[i] != looked_up[i]) mismatches++;
+        if (looked_up[i] != NULL) matched++;
+    }
+
+    double scan_us = std::chrono::duration<double, std::micro>(t1 - t0).count() / queries.size();
+    double fib_us = std::chrono::duration<double, std::micro>(t2 - t1).count() / queries.size();
+
+    printf("%-12s rib %7zu entries, fib %7zu prefixes, %zu/%zu matched: scan %10.3f us/lookup, fib %8.3f us/lookup (x%.0f), %zu mismatches\n",
+        stage, rib.get().size(), rib.getFib().size(), matched, queries.size(), scan_us, fib_us, scan_us / fib_us, mismatches);
+
+    return mismatches;
+}
+
+// Time best path comparisons between the entries of a RIB.
+template<typename Entry, typename Rib> void benchmarkSelection(const Rib &rib, const char *stage) {
+    std::vector<const Entry*> entries;
+    for (const auto &entry : rib.get()) entries.push_back(&entry.second);
+    if (entries.size() < 2) return;
+
+    size_t n_compares = 1000000, better = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < n_compares; i++) {
+        const Entry &a = *entries[i % entries.size()];
+        const Entry &b = *entries[(i * 7919 + 1) % entries.size()];
+        if (a > b) better++;
+    }
+    auto t1 = std::chrono::steady_clock::now();
+
+    double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / n_compares;
+    printf("%-12s %zu comparisons (%zu greater): %.1f ns/comparison\n", stage, n_compares, better, ns);
+}
+
+// Benchmark IPv4 lookups, return number of mismatches.
+size_t benchmark4(libbgp::BgpLogHandler *logger, std::mt19937 &rng, size_t n_routes, size_t n_queries, uint32_t n_peers) {
+    libbgp::BgpRib4 rib(logger);
+
+    // every peer announces a random subset of a common pool of prefixes, so
+    // that most prefixes have several paths to select from.
+    std::vector<libbgp::Prefix4> pool;
+    for (size_t i = 0; i < n_routes; i++) {
+        uint8_t length = 8 + rng() % 25; // /8 to /32
+        uint32_t prefix = htonl(rng() & hostMask(length));
+        pool.push_back(libbgp::Prefix4(prefix, length));
+    }
+
+    for (uint32_t peer = 1; peer <= n_peers; peer++) {
+        uint32_t router_id = htonl(0x0a000000 + peer);
+        for (int as_path_len = 1; as_path_len <= 3; as_path_len++) {
+            std::vector<libbgp::Prefix4> routes;
+            for (const libbgp::Prefix4 &route : pool) {
+                if (rng() % (3 * n_peers) == 0) routes.push_back(route);
+            }
+            rib.insert(router_id, routes, makeAttribs(logger, router_id, 65000 + peer, as_path_len), 0, 0);
+        }
+    }
+
+    // half of the queries hit announced prefixes, the others are random.
+    std::vector<uint32_t> queries;
+    for (size_t i = 0; i < n_queries; i++) {
+        if (i % 2 == 0) {
+            const libbgp::Prefix4 &route = pool[rng() % pool.size()];
+            uint32_t host = rng() & ~hostMask(route.getLength());
+            queries.push_back(route.getPrefix() | htonl(host));
+        } else queries.push_back(rng());
+    }
+
+    benchmarkSelection<libbgp::BgpRib4Entry>(rib, "v4 select");
+    size_t mismatches = compare(rib, queries, "v4 inserted");
+
+    uint32_t router_id = htonl(0x0a000000 + 1);
+    for (size_t i = 0; i < pool.size(); i += 2) rib.withdraw(router_id, pool[i]);
+    mismatches += compare(rib, queries, "v4 withdrawn");
+
+    rib.discard(htonl(0x0a000000 + 2));
+    mismatches += compare(rib, queries, "v4 discarded");
+
+    rib.discard2(htonl(0x0a000000 + 3));
+    mismatches += compare(rib, queries, "v4 discard2");
+
+    return mismatches;
+}
+
+// Benchmark IPv6 lookups, return number of mismatches.
+size_t benchmark6(libbgp::BgpLogHandler *logger, std::mt19937 &rng, size_t n_routes, size_t n_queries, uint32_t n_peers) {
+    libbgp::BgpRib6 rib(logger);
+
+    // prefixes from /16 to /64, and a few /128, all inside 2000::/3.
+    std::vector<libbgp::Prefix6> pool;
+    for (size_t i = 0; i < n_routes; i++) {
+        uint8_t length = i % 16 == 0 ? 128 : 16 + rng() % 49;
+        uint8_t addr[16], prefix[16];
+        for (int j = 0; j < 16; j++) addr[j] = rng();
+        addr[0] = 0x20 | (addr[0] & 0x1f);
+        libbgp::mask_ipv6(addr, length, prefix);
+        pool.push_back(libbgp::Prefix6(prefix, length));
+    }
+
+    uint8_t nexthop_linklocal[16] = { 0 };
+    for (uint32_t peer = 1; peer <= n_peers; peer++) {
+        uint32_t router_id = htonl(0x0a000000 + peer);
+        uint8_t nexthop[16] = { 0x20, 0x01, 0x0d, 0xb8 };
+        nexthop[15] = peer;
+        for (int as_path_len = 1; as_path_len <= 3; as_path_len++) {
+            std::vector<libbgp::Prefix6> routes;
+            for (const libbgp::Prefix6 &route : pool) {
+                if (rng() % (3 * n_peers) == 0) routes.push_back(route);
+            }
+            rib.insert(router_id, routes, nexthop, nexthop_linklocal, makeAttribs(logger, router_id, 65000 + peer, as_path_len), 0, 0);
+        }
+    }
+
+    // half of the queries hit announced prefixes, the others are random.
+    std::vector<Address6> queries;
+    for (size_t i = 0; i < n_queries; i++) {
+        Address6 dest;
+        for (int j = 0; j < 16; j++) dest.addr[j] = rng();
+        dest.addr[0] = 0x20 | (dest.addr[0] & 0x1f);
+        if (i % 2 == 0) {
+            const libbgp::Prefix6 &route = pool[rng() % pool.size()];
+            uint8_t prefix[16], mask[16];
+            route.getPrefix(prefix);
+            route.getMask(mask);
+            for (int j = 0; j < 16; j++) dest.addr[j] = prefix[j] | (dest.addr[j] & ~mask[j]);
+        }
+        queries.push_back(dest);
+    }
+
+    benchmarkSelection<libbgp::BgpRib6Entry>(rib, "v6 select");
+    size_t mismatches = compare(rib, queries, "v6 inserted");
+
+    uint32_t router_id = htonl(0x0a000000 + 1);
+    for (size_t i = 0; i < pool.size(); i += 2) rib.withdraw(router_id, pool[i]);
+    mismatches += compare(rib, queries, "v6 withdrawn");
+
+    rib.discard(htonl(0x0a000000 + 2));
+    mismatches += compare(rib, queries, "v6 discarded");
+
+    return mismatches;
+}
+
+int main(int argc, char **argv) {
+    size_t n_routes = argc > 1 ? strtoul(argv[1], NULL, 10) : 100000;
+    size_t n_queries = argc > 2 ? strtoul(argv[2], NULL, 10) : 1000;
+    const uint32_t n_peers = 3;
+
+    libbgp::BgpLogHandler logger;
+    logger.setLogLevel(libbgp::ERROR);
+    std::mt19937 rng(42);
+
+    size_t mismatches = benchmark4(&logger, rng, n_routes, n_queries, n_peers);
+    mismatches += benchmark6(&logger, rng, n_routes, n_queries, n_peers);
+
+    return mismatches == 0 ? 0 : 1;
+}
@@ -231,7 +231,7 @@ int main(void) {
     std::vector<libbgp::Prefix4> new_routes;
     new_routes.push_back(inserted->route);
     add_event.new_routes = &new_routes;
-    add_event.shared_attribs = &(inserted->attribs);
+    add_event.shared_attribs = &(inserted->attribs.get());
 
     // publish the event with event bus. The first parameter is pointer to the
     // publisher, and it is for ensuring publisher of the event does not
@@ -0,0 +1,130 @@
+/**
+ * @file sink-benchmark.cc
+ * @author Nato Morichika <nat@nat.moe>
+ * @brief Compare copying and borrowing receive paths of BgpSink.
+ * @version 0.1
+ * @date 2020-01-30
+ * 
+ * A stream of UPDATE messages is cut into segments, like TCP would deliver it,
+ * and poured from a BgpSink. The segments are either copied into the sink with
+ * fill(), or lent to the sink with fillBorrowed() so that complete messages are
+ * parsed in place. Both runs must get the same messages.
+ * 
+ * @copyright Copyright (c) 2020
+ * 
+ */
+#include <libbgp/bgp-sink.h>
+#include <libbgp/bgp-update-message.h>
+#include <arpa/inet.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+// Build a stream of UPDATE messages.
+std::vector<uint8_t> makeStream(libbgp::BgpLogHandler *logger, size_t n_messages, size_t routes_per_message) {
+    std::vector<uint8_t> stream;
+    uint8_t buffer[4096];
+
+    for (size_t i = 0; i < n_messages; i++) {
+        libbgp::BgpUpdateMessage update(logger, true);
+        std::vector<std::shared_ptr<libbgp::BgpPathAttrib>> attribs;
+        libbgp::BgpPathAttribOrigin *origin = new libbgp::BgpPathAttribOrigin(logger);
+        libbgp::BgpPathAttribNexthop *nexthop = new libbgp::BgpPathAttribNexthop(logger);
+        libbgp::BgpPathAttribAsPath *as_path = new libbgp::BgpPathAttribAsPath(logger, true);
+
+        origin->origin = libbgp::IGP;
+        nexthop->next_hop = htonl(0x0a000001);
+        as_path->prepend(64512 + i % 1000);
+        as_path->prepend(65001);
+
+        attribs.push_back(std::shared_ptr<libbgp::BgpPathAttrib>(origin));
+        attribs.push_back(std::shared_ptr<libbgp::BgpPathAttrib>(nexthop));
+        attribs.push_back(std::shared_ptr<libbgp::BgpPathAttrib>(as_path));
+        update.setAttribs(attribs);
+
+        for (size_t r = 0; r < routes_per_message; r++) {
+            update.addNlri4(htonl(0x64000000 + ((i * routes_per_message + r) << 8)), 24);
+        }
+
+        libbgp::BgpPacket pkt(logger, true, &update);
+        ssize_t len = pkt.write(buffer, sizeof(buffer));
+        if (len < 0) return std::vector<uint8_t>();
+        stream.insert(stream.end(), buffer, buffer + len);
+    }
+
+    return stream;
+}
+
+// Pour all packets, return number of routes received, or -1 on error.
+ssize_t pourAll(libbgp::BgpSink &sink) {
+    ssize_t routes = 0;
+
+    while (sink.getBytesInSink() > 0) {
+        libbgp::BgpPacket *packet = NULL;
+        ssize_t ret = sink.pour(&packet);
+
+        if (ret == 0) break;
+        if (ret < 0) {
+            if (packet) delete packet;
+            return -1;
+        }
+
+        const libbgp::BgpUpdateMessage *update = dynamic_cast<const libbgp::BgpUpdateMessage *>(packet->getMessage());
+        if (update) routes += update->nlri.size();
+        delete packet;
+    }
+
+    return routes;
+}
+
+// Feed the stream in segments of given size, return number of routes received.
+ssize_t run(libbgp::BgpLogHandler *logger, const std::vector<uint8_t> &stream, size_t segment_size, bool borrow, const char *name) {
+    libbgp::BgpSink sink(true);
+    sink.setLogger(logger);
+    ssize_t routes = 0;
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (size_t offset = 0; offset < stream.size(); offset += segment_size) {
+        size_t len = stream.size() - offset < segment_size ? stream.size() - offset : segment_size;
+
+        if (borrow) sink.fillBorrowed(stream.data() + offset, len);
+        else sink.fill(stream.data() + offset, len);
+
+        ssize_t ret = pourAll(sink);
+        if (ret < 0) return -1;
+        routes += ret;
+
+        if (borrow) sink.release();
+    }
+    auto t1 = std::chrono::steady_clock::now();
+
+    double ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    printf("%-9s segment %5zu: %zu bytes, %zd routes, %zu bytes left in sink, %.1f ms (%.1f MB/s)\n",
+        name, segment_size, stream.size(), routes, sink.getBytesInSink(), ms, stream.size() / ms / 1000);
+
+    return routes;
+}
+
+int main(int argc, char **argv) {
+    size_t n_messages = argc > 1 ? strtoul(argv[1], NULL, 10) : 100000;
+    size_t routes_per_message = argc > 2 ? strtoul(argv[2], NULL, 10) : 20;
+
+    libbgp::BgpLogHandler logger;
+    logger.setLogLevel(libbgp::ERROR);
+
+    std::vector<uint8_t> stream = makeStream(&logger, n_messages, routes_per_message);
+    ssize_t expected = n_messages * routes_per_message;
+    bool ok = stream.size() > 0;
+
+    // ns-3 default TCP segment size, Ethernet MSS, and a large read.
+    size_t segment_sizes[] = { 536, 1448, 65535 };
+
+    for (size_t segment_size : segment_sizes) {
+        ok = run(&logger, stream, segment_size, false, "copy") == expected && ok;
+        ok = run(&logger, stream, segment_size, true, "borrow") == expected && ok;
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,206 @@
+/**
+ * @file update-packing-benchmark.cc
+ * @author Nato Morichika <nat@nat.moe>
+ * @brief Count UPDATE messages sent by BgpFsm on route events.
+ * @version 0.2
+ * @date 2020-01-28
+ *
+ * Two BGP FSMs are connected to each other in the same program, like in the
+ * route-event-bus example. The local RIB has the same routes from two peers.
+ * The first one then flaps a few times: every flap replaces its routes with
+ * the routes of the other peer, and then brings them back. Finally all routes
+ * are withdrawn. The messages and bytes written on the session and the packing
+ * counters of the FSM are printed for each step.
+ *
+ * The scenario is run without MinRouteAdvertisementInterval (changes are sent
+ * at once), and with it (advertisements are queued in the Adj-RIB-Out and sent
+ * when the interval expires, superseded ones are dropped; withdrawals are still
+ * sent at once).
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#include <libbgp/bgp-fsm.h>
+#include <libbgp/route-event-bus.h>
+#include <arpa/inet.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+// Pass data directly to another BGP FSM, and count messages.
+class CountingOutHandler : public libbgp::BgpOutHandler {
+public:
+    CountingOutHandler() {
+        other = NULL;
+        messages = bytes = 0;
+    }
+
+    void setPeer(libbgp::BgpFsm *other) {
+        this->other = other;
+    }
+
+    bool handleOut(const uint8_t *buffer, size_t length) {
+        messages++;
+        bytes += length;
+        return other->run(buffer, length) >= 0;
+    };
+
+    size_t messages;
+    size_t bytes;
+
+private:
+    libbgp::BgpFsm *other;
+};
+
+// A clock we can move forward ourself.
+class ManualClock : public libbgp::Clock {
+public:
+    ManualClock() { now = 1000; }
+    uint64_t getTime() const { return now; }
+    uint64_t now;
+};
+
+// Create path attributes with an AS path of the given length.
+std::vector<std::shared_ptr<libbgp::BgpPathAttrib>> makeAttribs(libbgp::BgpLogHandler *logger, uint32_t nexthop, uint32_t peer_asn, int as_path_len) {
+    std::vector<std::shared_ptr<libbgp::BgpPathAttrib>> attribs;
+    libbgp::BgpPathAttribOrigin *origin = new libbgp::BgpPathAttribOrigin(logger);
+    libbgp::BgpPathAttribNexthop *nexthop_attr = new libbgp::BgpPathAttribNexthop(logger);
+    libbgp::BgpPathAttribAsPath *as_path = new libbgp::BgpPathAttribAsPath(logger, true);
+
+    origin->origin = libbgp::IGP;
+    nexthop_attr->next_hop = nexthop;
+    for (int i = 0; i < as_path_len; i++) as_path->prepend(peer_asn);
+
+    attribs.push_back(std::shared_ptr<libbgp::BgpPathAttrib>(origin));
+    attribs.push_back(std::shared_ptr<libbgp::BgpPathAttrib>(nexthop_attr));
+    attribs.push_back(std::shared_ptr<libbgp::BgpPathAttrib>(as_path));
+
+    return attribs;
+}
+
+// Fill a config with the common parameters.
+void configure(libbgp::BgpConfig &config, uint32_t asn, uint32_t peer_asn, const char *router_id) {
+    config.asn = asn;
+    config.peer_asn = peer_asn;
+    config.use_4b_asn = true;
+    config.hold_timer = 120;
+    config.no_collision_detection = true;
+    inet_pton(AF_INET, router_id, &config.router_id);
+    inet_pton(AF_INET, router_id, &config.default_nexthop4);
+    config.forced_default_nexthop4 = true;
+    config.no_nexthop_check4 = true;
+}
+
+// Print messages written since last call and the packing counters.
+void report(const char *stage, CountingOutHandler &out, const libbgp::BgpFsm &fsm, size_t remote_rib_size) {
+    const libbgp::BgpUpdatePackingStats &stats = fsm.getPackingStats();
+    printf("  %-10s %6zu messages, %8zu bytes (remote rib %zu entries); packing total: %lu messages for %lu routes, %lu messages and %lu bytes saved; %lu changes superseded\n",
+        stage, out.messages, out.bytes, remote_rib_size, (unsigned long) stats.messages, (unsigned long) stats.routes,
+        (unsigned long) stats.messages_saved, (unsigned long) stats.bytes_saved, (unsigned long) fsm.getAdjRibOut4().getSuperseded());
+    out.messages = out.bytes = 0;
+}
+
+// Run the scenario, return true if the remote RIB ends up empty.
+bool run(size_t n_routes, size_t n_flaps, uint32_t mrai) {
+    libbgp::BgpLogHandler logger;
+    logger.setLogLevel(libbgp::FATAL);
+
+    ManualClock clock;
+    libbgp::RouteEventBus local_bus;
+    libbgp::BgpRib4 local_rib(&logger);
+    CountingOutHandler pipe_local, pipe_remote;
+
+    libbgp::BgpConfig local_config;
+    configure(local_config, 65000, 65001, "10.0.0.1");
+    local_config.out_handler = &pipe_local;
+    local_config.rib4 = &local_rib;
+    local_config.rev_bus = &local_bus;
+    local_config.log_handler = &logger;
+    local_config.clock = &clock;
+    local_config.mrai = mrai;
+
+    libbgp::BgpConfig remote_config;
+    configure(remote_config, 65001, 65000, "10.0.0.2");
+    remote_config.out_handler = &pipe_remote;
+    remote_config.log_handler = &logger;
+    remote_config.clock = &clock;
+
+    libbgp::BgpFsm local(local_config);
+    libbgp::BgpFsm remote(remote_config);
+    pipe_local.setPeer(&remote);
+    pipe_remote.setPeer(&local);
+
+    printf("mrai %us, %zu routes, %zu flaps:\n", mrai, n_routes, n_flaps);
+
+    local.start();
+    if (local.getState() != libbgp::ESTABLISHED) {
+        fprintf(stderr, "session not established.\n");
+        return false;
+    }
+
+    // the same routes from two peers, the first one with a shorter path.
+    std::vector<libbgp::Prefix4> routes;
+    for (size_t i = 0; i < n_routes; i++) {
+        routes.push_back(libbgp::Prefix4(htonl(0x64000000 + (i << 8)), 24));
+    }
+
+    uint32_t peer1 = htonl(0x0a010001), peer2 = htonl(0x0a010002);
+    local_rib.insert(peer2, routes, makeAttribs(&logger, peer2, 64602, 2), 0, 0);
+    libbgp::Route4AddEvent add_event;
+    add_event.new_routes = &routes;
+    add_event.shared_attribs = &(local_rib.lookup(routes[0].getPrefix())->attribs.get());
+    local_bus.publish(NULL, add_event);
+
+    for (size_t flap = 0; flap <= n_flaps; flap++) {
+        // the first peer (re)advertises its routes.
+        std::vector<std::shared_ptr<libbgp::BgpPathAttrib>> attribs = makeAttribs(&logger, peer1, 64601, 1);
+        local_rib.insert(peer1, routes, attribs, 0, 0);
+        libbgp::Route4AddEvent up_event;
+        up_event.new_routes = &routes;
+        up_event.shared_attribs = &attribs;
+        local_bus.publish(NULL, up_event);
+
+        if (flap == n_flaps) break;
+
+        // and goes down: its routes are replaced by the ones of the other peer.
+        clock.now++;
+        std::pair<std::vector<libbgp::Prefix4>, std::vector<libbgp::BgpRib4Entry>> discarded = local_rib.discard(peer1);
+        libbgp::Route4AddEvent down_event;
+        down_event.replaced_entries = &(discarded.second);
+        local_bus.publish(NULL, down_event);
+        clock.now++;
+    }
+
+    // let MRAI expire.
+    clock.now += mrai;
+    local.tick();
+    report("churn", pipe_local, local, remote.getRib4().get().size());
+
+    // drop both peers.
+    local_rib.discard(peer1);
+    std::pair<std::vector<libbgp::Prefix4>, std::vector<libbgp::BgpRib4Entry>> discarded = local_rib.discard(peer2);
+    libbgp::Route4WithdrawEvent withdraw_event;
+    withdraw_event.routes = &(discarded.first);
+    local_bus.publish(NULL, withdraw_event);
+    clock.now += mrai;
+    local.tick();
+    report("withdrawn", pipe_local, local, remote.getRib4().get().size());
+
+    bool ok = remote.getRib4().get().size() == 0 && local.getState() == libbgp::ESTABLISHED;
+
+    local.stop();
+    remote.stop();
+
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    size_t n_routes = argc > 1 ? strtoul(argv[1], NULL, 10) : 10000;
+    size_t n_flaps = argc > 2 ? strtoul(argv[2], NULL, 10) : 5;
+    uint32_t mrai = argc > 3 ? strtoul(argv[3], NULL, 10) : 30;
+
+    bool ok = run(n_routes, n_flaps, 0);
+    ok = run(n_routes, n_flaps, mrai) && ok;
+
+    return ok ? 0 : 1;
+}
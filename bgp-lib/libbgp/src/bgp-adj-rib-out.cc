@@ -0,0 +1,158 @@
+/**
+ * @file bgp-adj-rib-out.cc
+ * @author Nato Morichika <nat@nat.moe>
+ * @brief The IPv4 Adj-RIB-Out of a BGP session.
+ * @version 0.1
+ * @date 2020-01-28
+ * 
+ * @copyright Copyright (c) 2020
+ * 
+ */
+#include "bgp-adj-rib-out.h"
+
+namespace libbgp {
+
+/**
+ * @brief Construct a new empty BgpAdjRibOut4 object.
+ * 
+ */
+BgpAdjRibOut4::BgpAdjRibOut4() {
+    superseded = 0;
+}
+
+/**
+ * @brief Queue an advertisement of a route.
+ * 
+ * @param route The route.
+ * @param attribs Attributes of the route, before egress processing.
+ */
+void BgpAdjRibOut4::advertise(const Prefix4 &route, const BgpAttribSet &attribs) {
+    BgpRib4EntryKey key(route);
+    pending_t::iterator change = changes.find(key);
+
+    if (change != changes.end()) {
+        superseded++;
+        changes.erase(change);
+    }
+
+    advertised_t::const_iterator current = advertised.find(key);
+    if (current != advertised.end() && current->second == attribs) {
+        // peer already has it.
+        superseded++;
+        return;
+    }
+
+    Change c;
+    c.route = route;
+    c.attribs = attribs;
+    changes.insert(std::make_pair(key, c));
+}
+
+/**
+ * @brief Withdraw a route.
+ * 
+ * Any queued advertisement of the route is dropped, and the route is removed
+ * from the Adj-RIB-Out as if the withdrawal was sent to the peer. Withdrawals
+ * are not queued: the caller sends them at once.
+ * 
+ * @param route The route.
+ * @return true The withdrawal is to be sent to the peer.
+ * @return false The route was never sent to the peer, nothing to withdraw.
+ */
+bool BgpAdjRibOut4::withdraw(const Prefix4 &route) {
+    BgpRib4EntryKey key(route);
+    pending_t::iterator change = changes.find(key);
+    bool known = advertised.erase(key) > 0;
+
+    if (change != changes.end()) {
+        superseded++;
+        changes.erase(change);
+
+        // never sent to the peer, nothing to withdraw. (a route without
+        // pending change we don't know about is still withdrawn, to be safe)
+        if (!known) return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Record a route sent to the peer without going through the queue.
+ * 
+ * @param route The route.
+ * @param attribs Attributes of the route, before egress processing.
+ */
+void BgpAdjRibOut4::sent(const Prefix4 &route, const BgpAttribSet &attribs) {
+    BgpRib4EntryKey key(route);
+    advertised[key] = attribs;
+}
+
+/**
+ * @brief Take the queued advertisements.
+ * 
+ * The Adj-RIB-Out is updated as if the advertisements were sent to the peer.
+ * 
+ * @param updates Where to put the advertisements, grouped by attribute set.
+ * @return size_t Number of advertisements taken.
+ */
+size_t BgpAdjRibOut4::flush(std::vector<std::pair<BgpAttribSet, std::vector<Prefix4>>> &updates) {
+    size_t n_changes = changes.size();
+    std::unordered_map<const void*, size_t> group_index;
+
+    for (const std::pair<const BgpRib4EntryKey, Change> &change : changes) {
+        const Change &c = change.second;
+
+        advertised[change.first] = c.attribs;
+
+        std::pair<std::unordered_map<const void*, size_t>::iterator, bool> group =
+            group_index.insert(std::make_pair(&(c.attribs.get()), updates.size()));
+
+        if (group.second) {
+            updates.push_back(std::make_pair(c.attribs, std::vector<Prefix4>()));
+        }
+
+        updates[group.first->second].second.push_back(c.route);
+    }
+
+    changes.clear();
+    return n_changes;
+}
+
+/**
+ * @brief Drop all routes and queued changes.
+ * 
+ */
+void BgpAdjRibOut4::clear() {
+    advertised.clear();
+    changes.clear();
+}
+
+/**
+ * @brief Get number of queued advertisements.
+ * 
+ * @return size_t Number of advertisements.
+ */
+size_t BgpAdjRibOut4::pending() const {
+    return changes.size();
+}
+
+/**
+ * @brief Get number of routes advertised to the peer.
+ * 
+ * @return size_t Number of routes.
+ */
+size_t BgpAdjRibOut4::size() const {
+    return advertised.size();
+}
+
+/**
+ * @brief Get number of changes dropped since superseded by a later change, or
+ * since the peer already had the route.
+ * 
+ * @return uint64_t Number of changes.
+ */
+uint64_t BgpAdjRibOut4::getSuperseded() const {
+    return superseded;
+}
+
+}
@@ -0,0 +1,77 @@
+/**
+ * @file bgp-adj-rib-out.h
+ * @author Nato Morichika <nat@nat.moe>
+ * @brief The IPv4 Adj-RIB-Out of a BGP session.
+ * @version 0.1
+ * @date 2020-01-28
+ * 
+ * @copyright Copyright (c) 2020
+ * 
+ */
+#ifndef BGP_ADJ_RIB_OUT_H_
+#define BGP_ADJ_RIB_OUT_H_
+#include <stdint.h>
+#include <vector>
+#include <unordered_map>
+#include "bgp-attrib-pool.h"
+#include "bgp-rib4.h"
+#include "prefix4.h"
+
+namespace libbgp {
+
+/**
+ * @brief The IPv4 Adj-RIB-Out of a BGP session.
+ * 
+ * Holds the routes advertised to the peer, and the advertisements waiting to
+ * be sent to the peer (until the MinRouteAdvertisementInterval expires). An
+ * advertisement that is superseded by another change of the same prefix before
+ * being sent is dropped, and so is one that brings a prefix back to what the
+ * peer already has. Withdrawals are not queued but sent at once, as the MRAI
+ * does not apply to them (RFC 4271, section 9.2.1.1).
+ * 
+ */
+class BgpAdjRibOut4 {
+public:
+    BgpAdjRibOut4();
+
+    // queue an advertisement of a route.
+    void advertise(const Prefix4 &route, const BgpAttribSet &attribs);
+
+    // withdraw a route, return true if the withdrawal is to be sent.
+    bool withdraw(const Prefix4 &route);
+
+    // record a route sent to the peer without going through the queue.
+    void sent(const Prefix4 &route, const BgpAttribSet &attribs);
+
+    // take the queued advertisements, grouped by attribute set.
+    size_t flush(std::vector<std::pair<BgpAttribSet, std::vector<Prefix4>>> &updates);
+
+    // drop all routes and changes. (session closed)
+    void clear();
+
+    // number of queued advertisements.
+    size_t pending() const;
+
+    // number of routes advertised to the peer.
+    size_t size() const;
+
+    // number of changes dropped since superseded or redundant.
+    uint64_t getSuperseded() const;
+
+private:
+    struct Change {
+        Prefix4 route;
+        BgpAttribSet attribs;
+    };
+
+    typedef std::unordered_map<BgpRib4EntryKey, BgpAttribSet, BgpRib4EntryHash> advertised_t;
+    typedef std::unordered_map<BgpRib4EntryKey, Change, BgpRib4EntryHash> pending_t;
+
+    advertised_t advertised;
+    pending_t changes;
+    uint64_t superseded;
+};
+
+}
+
+#endif // BGP_ADJ_RIB_OUT_H_
@@ -0,0 +1,247 @@
+/**
+ * @file bgp-attrib-pool.cc
+ * @author Nato Morichika <nat@nat.moe>
+ * @brief Interned path attribute sets.
+ * @version 0.1
+ * @date 2020-01-26
+ * 
+ * @copyright Copyright (c) 2020
+ * 
+ */
+#include "bgp-attrib-pool.h"
+#include <string.h>
+
+namespace libbgp {
+
+// serialize a list of attributes, return bytes written or -1.
+static ssize_t serialize(const attrib_vector_t &attribs, uint8_t *buffer, size_t buffer_sz) {
+    size_t written = 0;
+
+    for (const std::shared_ptr<BgpPathAttrib> &attr : attribs) {
+        ssize_t len = attr->write(buffer + written, buffer_sz - written);
+        if (len < 0) return -1;
+        written += len;
+    }
+
+    return written;
+}
+
+// FNV-1a hash of a buffer.
+static uint64_t hash_buffer(const uint8_t *buffer, size_t length) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    for (size_t i = 0; i < length; i++) {
+        hash ^= buffer[i];
+        hash *= 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+
+// list of attributes of empty sets.
+static const attrib_vector_t empty_attribs;
+
+/**
+ * @brief Construct a new empty BgpAttribSet object.
+ * 
+ */
+BgpAttribSet::BgpAttribSet() {
+    interned = false;
+}
+
+/**
+ * @brief Construct a new BgpAttribSet object with its own list of attributes.
+ * 
+ * The set is not interned. Use BgpAttribPool::intern to get a shared set.
+ * 
+ * @param attribs The attributes.
+ */
+BgpAttribSet::BgpAttribSet(const attrib_vector_t &attribs) : attribs(std::make_shared<const attrib_vector_t>(attribs)) {
+    interned = false;
+}
+
+/**
+ * @brief Get the list of attributes.
+ * 
+ * @return const attrib_vector_t& The attributes.
+ */
+const attrib_vector_t& BgpAttribSet::get() const {
+    return attribs == nullptr ? empty_attribs : *attribs;
+}
+
+BgpAttribSet::operator const attrib_vector_t& () const {
+    return get();
+}
+
+BgpAttribSet::const_iterator BgpAttribSet::begin() const {
+    return get().begin();
+}
+
+BgpAttribSet::const_iterator BgpAttribSet::end() const {
+    return get().end();
+}
+
+size_t BgpAttribSet::size() const {
+    return get().size();
+}
+
+bool BgpAttribSet::empty() const {
+    return get().empty();
+}
+
+/**
+ * @brief Test if the set is the interned instance of a pool.
+ * 
+ * @return true The set is shared with other entries of the pool.
+ * @return false The set is a private copy.
+ */
+bool BgpAttribSet::isInterned() const {
+    return interned;
+}
+
+bool BgpAttribSet::operator== (const BgpAttribSet &other) const {
+    return &get() == &(other.get());
+}
+
+bool BgpAttribSet::operator!= (const BgpAttribSet &other) const {
+    return !(*this == other);
+}
+
+/**
+ * @brief Construct a new empty BgpAttribPool object.
+ * 
+ */
+BgpAttribPool::BgpAttribPool() : state(std::make_shared<State>()) {
+    state->lookups = 0;
+    state->hits = 0;
+}
+
+/**
+ * @brief Destroy the BgpAttribPool object.
+ * 
+ * Sets obtained from the pool stay valid.
+ * 
+ */
+BgpAttribPool::~BgpAttribPool() {}
+
+/**
+ * @brief Deleter of interned sets: remove the set from its pool.
+ * 
+ * @param state State of the pool. (may be gone)
+ * @param hash Hash of the set.
+ * @param attribs The set.
+ */
+void BgpAttribPool::release(const std::weak_ptr<State> &state, uint64_t hash, const attrib_vector_t *attribs) {
+    std::shared_ptr<State> pool = state.lock();
+
+    if (pool != nullptr) {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        auto its = pool->sets.equal_range(hash);
+        for (auto it = its.first; it != its.second; it++) {
+            if (it->second.attribs == attribs) {
+                pool->sets.erase(it);
+                break;
+            }
+        }
+    }
+
+    delete attribs;
+}
+
+/**
+ * @brief Get the interned set of a list of attributes.
+ * 
+ * If a set with the same attributes (compared in wire format) is already in
+ * the pool, it is returned. Otherwise, a new set with the given attributes
+ * (not copies of them) is added to the pool.
+ * 
+ * @param attribs The attributes.
+ * @return BgpAttribSet The interned set. If the attributes can't be
+ * serialized, a set that is not interned is returned.
+ */
+BgpAttribSet BgpAttribPool::intern(const attrib_vector_t &attribs) {
+    uint8_t buffer[4096];
+    ssize_t length = serialize(attribs, buffer, sizeof(buffer));
+
+    if (length < 0) return BgpAttribSet(attribs);
+
+    uint64_t hash = hash_buffer(buffer, length);
+    BgpAttribSet set;
+
+    std::lock_guard<std::mutex> lock(state->mutex);
+    state->lookups++;
+
+    auto its = state->sets.equal_range(hash);
+    for (auto it = its.first; it != its.second; it++) {
+        const Node &node = it->second;
+
+        // the list is not deleted before its node is removed, which can't
+        // happen while we hold the lock.
+        if ((size_t) length != node.bytes || node.ref.expired()) continue;
+
+        uint8_t other[4096];
+        if (serialize(*node.attribs, other, sizeof(other)) != length) continue;
+        if (memcmp(buffer, other, length) != 0) continue;
+
+        set.attribs = node.ref.lock();
+        if (set.attribs == nullptr) continue;
+
+        set.interned = true;
+        state->hits++;
+        return set;
+    }
+
+    Node node;
+    node.attribs = new attrib_vector_t(attribs);
+    node.bytes = length;
+
+    std::weak_ptr<State> weak_state = state;
+    std::shared_ptr<const attrib_vector_t> ref(node.attribs, [weak_state, hash] (const attrib_vector_t *attribs) {
+        release(weak_state, hash, attribs);
+    });
+
+    node.ref = ref;
+    state->sets.insert(std::make_pair(hash, node));
+
+    set.attribs = ref;
+    set.interned = true;
+    return set;
+}
+
+/**
+ * @brief Get memory accounting of the pool.
+ * 
+ * @return BgpAttribPoolStats Stats.
+ */
+BgpAttribPoolStats BgpAttribPool::getStats() const {
+    BgpAttribPoolStats stats;
+    memset(&stats, 0, sizeof(stats));
+
+    std::lock_guard<std::mutex> lock(state->mutex);
+    stats.lookups = state->lookups;
+    stats.hits = state->hits;
+
+    for (const auto &set : state->sets) {
+        size_t refs = set.second.ref.use_count();
+        if (refs == 0) continue;
+
+        stats.sets++;
+        stats.references += refs;
+        stats.bytes += set.second.bytes;
+        stats.bytes_saved += (refs - 1) * set.second.bytes;
+    }
+
+    return stats;
+}
+
+/**
+ * @brief Get number of distinct sets in the pool.
+ * 
+ * @return size_t Number of sets.
+ */
+size_t BgpAttribPool::size() const {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    return state->sets.size();
+}
+
+}
@@ -0,0 +1,160 @@
+/**
+ * @file bgp-attrib-pool.h
+ * @author Nato Morichika <nat@nat.moe>
+ * @brief Interned path attribute sets.
+ * @version 0.1
+ * @date 2020-01-26
+ * 
+ * @copyright Copyright (c) 2020
+ * 
+ */
+#ifndef BGP_ATTRIB_POOL_H_
+#define BGP_ATTRIB_POOL_H_
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include "bgp-path-attrib.h"
+
+namespace libbgp {
+
+typedef std::vector<std::shared_ptr<BgpPathAttrib>> attrib_vector_t;
+
+/**
+ * @brief An immutable, shared set of path attributes.
+ * 
+ * BgpAttribSet is a handle to a list of path attributes: copying it does not
+ * copy the attributes, only the reference. Sets obtained from a BgpAttribPool
+ * are interned: all RIB entries with the same attributes share a single list.
+ * The attributes in a set MUST NOT be modified.
+ * 
+ */
+class BgpAttribSet {
+public:
+    typedef attrib_vector_t::const_iterator const_iterator;
+
+    BgpAttribSet();
+
+    // create a set holding its own (not interned) copy of the list.
+    BgpAttribSet(const attrib_vector_t &attribs);
+
+    // get the list of attributes.
+    const attrib_vector_t& get() const;
+    operator const attrib_vector_t& () const;
+
+    const_iterator begin() const;
+    const_iterator end() const;
+    size_t size() const;
+    bool empty() const;
+
+    // test if the set is the interned instance of a pool.
+    bool isInterned() const;
+
+    // test if two handles refer to the same list. (interned sets with the
+    // same attributes always do)
+    bool operator== (const BgpAttribSet &other) const;
+    bool operator!= (const BgpAttribSet &other) const;
+
+private:
+    friend class BgpAttribPool;
+
+    std::shared_ptr<const attrib_vector_t> attribs;
+    bool interned;
+};
+
+/**
+ * @brief Memory accounting of a BgpAttribPool.
+ * 
+ * Sizes are in bytes of attributes in wire format.
+ * 
+ */
+struct BgpAttribPoolStats {
+    /**
+     * @brief Number of distinct attribute sets currently in the pool.
+     * 
+     */
+    size_t sets;
+
+    /**
+     * @brief Number of references to the sets (RIB entries, mostly).
+     * 
+     */
+    size_t references;
+
+    /**
+     * @brief Size of the distinct attribute sets.
+     * 
+     */
+    size_t bytes;
+
+    /**
+     * @brief Size the referenced attributes would take without interning,
+     * minus bytes.
+     * 
+     */
+    size_t bytes_saved;
+
+    /**
+     * @brief Number of intern() calls.
+     * 
+     */
+    uint64_t lookups;
+
+    /**
+     * @brief Number of intern() calls that found an existing set.
+     * 
+     */
+    uint64_t hits;
+};
+
+/**
+ * @brief The path attribute intern table.
+ * 
+ * Identical attribute lists are stored once: intern() hashes the serialized
+ * attributes and returns the existing set if there is one. Sets are removed
+ * from the pool when the last reference to them is dropped. A pool can be
+ * shared between RIBs (and threads); sets may safely outlive the pool.
+ * 
+ */
+class BgpAttribPool {
+public:
+    BgpAttribPool();
+    ~BgpAttribPool();
+
+    // get the interned set of a list of attributes.
+    BgpAttribSet intern(const attrib_vector_t &attribs);
+
+    // get memory accounting of the pool.
+    BgpAttribPoolStats getStats() const;
+
+    // number of distinct sets in the pool.
+    size_t size() const;
+
+private:
+    struct Node {
+        const attrib_vector_t *attribs;
+        std::weak_ptr<const attrib_vector_t> ref;
+        size_t bytes;
+    };
+
+    struct State {
+        std::mutex mutex;
+        std::unordered_multimap<uint64_t, Node> sets;
+        uint64_t lookups;
+        uint64_t hits;
+    };
+
+    static void release(const std::weak_ptr<State> &state, uint64_t hash, const attrib_vector_t *attribs);
+
+    // pool state, shared with the deleter of the sets.
+    std::shared_ptr<State> state;
+
+    BgpAttribPool(const BgpAttribPool&);
+    BgpAttribPool& operator=(const BgpAttribPool&);
+};
+
+}
+
+#endif // BGP_ATTRIB_POOL_H_
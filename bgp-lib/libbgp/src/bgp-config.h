@@ -42,6 +42,7 @@ typedef struct BgpConfig {
         weight = 0;
         no_autotick = false;
         ibgp_alter_nexthop = false;
+        mrai = 0;
     }
 
     /**
@@ -337,6 +338,19 @@ typedef struct BgpConfig {
      * (default: false)
      */
     bool ibgp_alter_nexthop;
+
+    /**
+     * @brief The MinRouteAdvertisementInterval, in seconds.
+     * 
+     * If non-zero, IPv4 routes advertised on the route event bus are queued
+     * in the Adj-RIB-Out of the session, and sent to the peer at most once 
+     * per interval (on tick). Advertisements superseded before being sent are
+     * dropped. Withdrawals are always sent to the peer immediately, and so are
+     * advertisements if zero.
+     * 
+     * (default: 0)
+     */
+    uint32_t mrai;
 } BgpConfig;
 
 /**
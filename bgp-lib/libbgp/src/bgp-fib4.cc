@@ -0,0 +1,227 @@
+/**
+ * @file bgp-fib4.cc
+ * @author Nato Morichika <nat@nat.moe>
+ * @brief The IPv4 BGP Forwarding Information Base.
+ * @version 0.2
+ * @date 2019-07-21
+ * 
+ * @copyright Copyright (c) 2019
+ * 
+ */
+#include "bgp-fib4.h"
+#include <arpa/inet.h>
+
+namespace libbgp {
+
+// netmask of a CIDR length, in host byte order.
+static inline uint32_t host_mask(uint8_t length) {
+    return length == 0 ? 0 : 0xffffffff << (32 - length);
+}
+
+// the bit after the first "length" bits of an address, in host byte order.
+static inline int next_bit(uint32_t address, uint8_t length) {
+    return (address >> (31 - length)) & 1;
+}
+
+// number of leading bits two addresses (in host byte order) have in common.
+static inline uint8_t common_length(uint32_t a, uint32_t b) {
+    uint32_t diff = a ^ b;
+    return diff == 0 ? 32 : __builtin_clz(diff);
+}
+
+/**
+ * @brief Construct a new empty BgpFib4 object.
+ * 
+ */
+BgpFib4::BgpFib4() {
+    root = NULL;
+    n_prefixes = 0;
+}
+
+/**
+ * @brief Destroy the BgpFib4 object.
+ * 
+ */
+BgpFib4::~BgpFib4() {
+    deleteNode(root);
+}
+
+BgpFib4::Node* BgpFib4::newNode(uint32_t prefix, uint8_t length, const BgpRib4Entry *entry) {
+    Node *node = new Node;
+    node->prefix = prefix;
+    node->length = length;
+    node->entry = entry;
+    node->child[0] = node->child[1] = NULL;
+    return node;
+}
+
+void BgpFib4::deleteNode(Node *node) {
+    if (node == NULL) return;
+    deleteNode(node->child[0]);
+    deleteNode(node->child[1]);
+    delete node;
+}
+
+/**
+ * @brief Set the entry of a prefix.
+ * 
+ * If the prefix is already in the FIB, its entry is replaced.
+ * 
+ * @param prefix The prefix.
+ * @param entry The entry to forward matching destinations with.
+ */
+void BgpFib4::insert(const Prefix4 &prefix, const BgpRib4Entry *entry) {
+    uint8_t length = prefix.getLength();
+    uint32_t key = ntohl(prefix.getPrefix()) & host_mask(length);
+    Node **link = &root;
+
+    while (*link != NULL) {
+        Node *node = *link;
+        uint8_t common = common_length(key, node->prefix);
+        if (common > length) common = length;
+        if (common > node->length) common = node->length;
+
+        if (common == node->length) {
+            if (length == node->length) {
+                // prefix already in trie, or a branching node at its place.
+                if (node->entry == NULL) n_prefixes++;
+                node->entry = entry;
+                return;
+            }
+
+            link = &(node->child[next_bit(key, node->length)]);
+            continue;
+        }
+
+        // the prefix diverges from the node, or is a super-prefix of it.
+        Node *leaf = newNode(key, length, entry);
+        n_prefixes++;
+
+        if (common == length) {
+            leaf->child[next_bit(node->prefix, length)] = node;
+            *link = leaf;
+            return;
+        }
+
+        Node *branch = newNode(key & host_mask(common), common, NULL);
+        branch->child[next_bit(key, common)] = leaf;
+        branch->child[next_bit(node->prefix, common)] = node;
+        *link = branch;
+        return;
+    }
+
+    *link = newNode(key, length, entry);
+    n_prefixes++;
+}
+
+/**
+ * @brief Remove a prefix from FIB.
+ * 
+ * @param prefix The prefix.
+ * @return true Prefix removed.
+ * @return false Prefix not in FIB.
+ */
+bool BgpFib4::remove(const Prefix4 &prefix) {
+    uint8_t length = prefix.getLength();
+    uint32_t key = ntohl(prefix.getPrefix()) & host_mask(length);
+    Node **parent_link = NULL;
+    Node **link = &root;
+
+    while (*link != NULL) {
+        Node *node = *link;
+        if (node->length > length) return false;
+        if (((key ^ node->prefix) & host_mask(node->length)) != 0) return false;
+        if (node->length == length) break;
+        parent_link = link;
+        link = &(node->child[next_bit(key, node->length)]);
+    }
+
+    Node *node = *link;
+    if (node == NULL || node->entry == NULL) return false;
+
+    node->entry = NULL;
+    n_prefixes--;
+
+    // keep the node as a branching node if it still has two children.
+    if (node->child[0] != NULL && node->child[1] != NULL) return true;
+
+    *link = node->child[0] != NULL ? node->child[0] : node->child[1];
+    delete node;
+
+    // a branching parent left with a single child is no longer needed.
+    if (parent_link != NULL && *link == NULL) {
+        Node *parent = *parent_link;
+        if (parent->entry == NULL) {
+            *parent_link = parent->child[0] != NULL ? parent->child[0] : parent->child[1];
+            delete parent;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Lookup a destination in FIB.
+ * 
+ * @param dest The destination address in network byte order.
+ * @return const BgpRib4Entry* Entry of the longest matching prefix.
+ * @retval NULL no match found.
+ * @retval BgpRib4Entry* Matching entry.
+ */
+const BgpRib4Entry* BgpFib4::lookup(uint32_t dest) const {
+    uint32_t key = ntohl(dest);
+    const BgpRib4Entry *selected_entry = NULL;
+    const Node *node = root;
+
+    while (node != NULL) {
+        if (((key ^ node->prefix) & host_mask(node->length)) != 0) break;
+        if (node->entry != NULL) selected_entry = node->entry;
+        if (node->length == 32) break;
+        node = node->child[next_bit(key, node->length)];
+    }
+
+    return selected_entry;
+}
+
+/**
+ * @brief Get the entry of a prefix.
+ * 
+ * @param prefix The prefix.
+ * @return const BgpRib4Entry* Entry of the prefix.
+ * @retval NULL prefix not in FIB.
+ * @retval BgpRib4Entry* Entry of the prefix.
+ */
+const BgpRib4Entry* BgpFib4::find(const Prefix4 &prefix) const {
+    uint8_t length = prefix.getLength();
+    uint32_t key = ntohl(prefix.getPrefix()) & host_mask(length);
+    const Node *node = root;
+
+    while (node != NULL && node->length <= length) {
+        if (((key ^ node->prefix) & host_mask(node->length)) != 0) break;
+        if (node->length == length) return node->entry;
+        node = node->child[next_bit(key, node->length)];
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Remove all prefixes from FIB.
+ * 
+ */
+void BgpFib4::clear() {
+    deleteNode(root);
+    root = NULL;
+    n_prefixes = 0;
+}
+
+/**
+ * @brief Get number of prefixes in FIB.
+ * 
+ * @return size_t Number of prefixes.
+ */
+size_t BgpFib4::size() const {
+    return n_prefixes;
+}
+
+}
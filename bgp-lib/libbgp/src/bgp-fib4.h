@@ -0,0 +1,80 @@
+/**
+ * @file bgp-fib4.h
+ * @author Nato Morichika <nat@nat.moe>
+ * @brief The IPv4 BGP Forwarding Information Base.
+ * @version 0.2
+ * @date 2019-07-21
+ * 
+ * @copyright Copyright (c) 2019
+ * 
+ */
+#ifndef BGP_FIB4_H_
+#define BGP_FIB4_H_
+#include <stdint.h>
+#include <stddef.h>
+#include "prefix4.h"
+
+namespace libbgp {
+
+class BgpRib4Entry;
+
+/**
+ * @brief The BgpFib4 (IPv4 BGP Forwarding Information Base) class.
+ * 
+ * The FIB is a path-compressed binary (Patricia) trie holding the best
+ * (RS_ACTIVE) entry of every prefix in a BgpRib4. Each node of the trie is
+ * either a prefix with an entry or a branching point with two children, so the
+ * trie never has more than 2n - 1 nodes for n prefixes, and a lookup visits at
+ * most 33 nodes regardless of the size of the table.
+ * 
+ * The FIB does not own the entries. BgpRib4 keeps it in sync with the RIB, so
+ * you should not need to modify it yourself.
+ * 
+ */
+class BgpFib4 {
+public:
+    BgpFib4();
+    ~BgpFib4();
+
+    // set the entry of a prefix (replacing the old one, if any)
+    void insert(const Prefix4 &prefix, const BgpRib4Entry *entry);
+
+    // remove a prefix, return false if not found
+    bool remove(const Prefix4 &prefix);
+
+    // longest-prefix-match lookup, return null if not found
+    const BgpRib4Entry* lookup(uint32_t dest) const;
+
+    // exact-match lookup, return null if not found
+    const BgpRib4Entry* find(const Prefix4 &prefix) const;
+
+    // remove all prefixes
+    void clear();
+
+    // get number of prefixes
+    size_t size() const;
+
+private:
+    BgpFib4(const BgpFib4 &);
+    BgpFib4& operator= (const BgpFib4 &);
+
+    /**
+     * @brief Node of the trie.
+     * 
+     */
+    struct Node {
+        uint32_t prefix; // host byte order, host bits cleared.
+        uint8_t length;
+        const BgpRib4Entry *entry; // NULL for branching nodes.
+        Node *child[2];
+    };
+
+    static Node* newNode(uint32_t prefix, uint8_t length, const BgpRib4Entry *entry);
+    static void deleteNode(Node *node);
+
+    Node *root;
+    size_t n_prefixes;
+};
+
+}
+#endif // BGP_FIB4_H_
\ No newline at end of file
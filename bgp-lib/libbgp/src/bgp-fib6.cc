@@ -0,0 +1,261 @@
+/**
+ * @file bgp-fib6.cc
+ * @author Nato Morichika <nat@nat.moe>
+ * @brief The IPv6 BGP Forwarding Information Base.
+ * @version 0.1
+ * @date 2019-07-21
+ * 
+ * @copyright Copyright (c) 2019
+ * 
+ */
+#include "bgp-fib6.h"
+
+namespace libbgp {
+
+// load an address in network byte order as two words in host byte order.
+static inline void load_key(const uint8_t address[16], uint64_t key[2]) {
+    key[0] = key[1] = 0;
+    for (int i = 0; i < 8; i++) {
+        key[0] = (key[0] << 8) | address[i];
+        key[1] = (key[1] << 8) | address[i + 8];
+    }
+}
+
+// netmask of the given word of a CIDR length, in host byte order.
+static inline uint64_t host_mask(uint8_t length, int word) {
+    int bits = (int) length - 64 * word;
+    if (bits <= 0) return 0;
+    if (bits >= 64) return 0xffffffffffffffffULL;
+    return 0xffffffffffffffffULL << (64 - bits);
+}
+
+// test if the first "length" bits of two keys are the same.
+static inline bool same_prefix(const uint64_t a[2], const uint64_t b[2], uint8_t length) {
+    return ((a[0] ^ b[0]) & host_mask(length, 0)) == 0 &&
+        ((a[1] ^ b[1]) & host_mask(length, 1)) == 0;
+}
+
+// the bit after the first "length" bits of a key.
+static inline int next_bit(const uint64_t key[2], uint8_t length) {
+    if (length < 64) return (key[0] >> (63 - length)) & 1;
+    return (key[1] >> (127 - length)) & 1;
+}
+
+// number of leading bits two keys have in common.
+static inline uint8_t common_length(const uint64_t a[2], const uint64_t b[2]) {
+    uint64_t diff = a[0] ^ b[0];
+    if (diff != 0) return __builtin_clzll(diff);
+    diff = a[1] ^ b[1];
+    return diff == 0 ? 128 : 64 + __builtin_clzll(diff);
+}
+
+// load the key of a prefix, with host bits cleared.
+static inline void prefix_key(const Prefix6 &prefix, uint64_t key[2]) {
+    uint8_t address[16];
+    prefix.getPrefix(address);
+    load_key(address, key);
+    key[0] &= host_mask(prefix.getLength(), 0);
+    key[1] &= host_mask(prefix.getLength(), 1);
+}
+
+/**
+ * @brief Construct a new empty BgpFib6 object.
+ * 
+ */
+BgpFib6::BgpFib6() {
+    root = NULL;
+    n_prefixes = 0;
+}
+
+/**
+ * @brief Destroy the BgpFib6 object.
+ * 
+ */
+BgpFib6::~BgpFib6() {
+    deleteNode(root);
+}
+
+BgpFib6::Node* BgpFib6::newNode(const uint64_t prefix[2], uint8_t length, const BgpRib6Entry *entry) {
+    Node *node = new Node;
+    node->prefix[0] = prefix[0] & host_mask(length, 0);
+    node->prefix[1] = prefix[1] & host_mask(length, 1);
+    node->length = length;
+    node->entry = entry;
+    node->child[0] = node->child[1] = NULL;
+    return node;
+}
+
+void BgpFib6::deleteNode(Node *node) {
+    if (node == NULL) return;
+    deleteNode(node->child[0]);
+    deleteNode(node->child[1]);
+    delete node;
+}
+
+/**
+ * @brief Set the entry of a prefix.
+ * 
+ * If the prefix is already in the FIB, its entry is replaced.
+ * 
+ * @param prefix The prefix.
+ * @param entry The entry to forward matching destinations with.
+ */
+void BgpFib6::insert(const Prefix6 &prefix, const BgpRib6Entry *entry) {
+    uint8_t length = prefix.getLength();
+    uint64_t key[2];
+    prefix_key(prefix, key);
+    Node **link = &root;
+
+    while (*link != NULL) {
+        Node *node = *link;
+        uint8_t common = common_length(key, node->prefix);
+        if (common > length) common = length;
+        if (common > node->length) common = node->length;
+
+        if (common == node->length) {
+            if (length == node->length) {
+                // prefix already in trie, or a branching node at its place.
+                if (node->entry == NULL) n_prefixes++;
+                node->entry = entry;
+                return;
+            }
+
+            link = &(node->child[next_bit(key, node->length)]);
+            continue;
+        }
+
+        // the prefix diverges from the node, or is a super-prefix of it.
+        Node *leaf = newNode(key, length, entry);
+        n_prefixes++;
+
+        if (common == length) {
+            leaf->child[next_bit(node->prefix, length)] = node;
+            *link = leaf;
+            return;
+        }
+
+        Node *branch = newNode(key, common, NULL);
+        branch->child[next_bit(key, common)] = leaf;
+        branch->child[next_bit(node->prefix, common)] = node;
+        *link = branch;
+        return;
+    }
+
+    *link = newNode(key, length, entry);
+    n_prefixes++;
+}
+
+/**
+ * @brief Remove a prefix from FIB.
+ * 
+ * @param prefix The prefix.
+ * @return true Prefix removed.
+ * @return false Prefix not in FIB.
+ */
+bool BgpFib6::remove(const Prefix6 &prefix) {
+    uint8_t length = prefix.getLength();
+    uint64_t key[2];
+    prefix_key(prefix, key);
+    Node **parent_link = NULL;
+    Node **link = &root;
+
+    while (*link != NULL) {
+        Node *node = *link;
+        if (node->length > length) return false;
+        if (!same_prefix(key, node->prefix, node->length)) return false;
+        if (node->length == length) break;
+        parent_link = link;
+        link = &(node->child[next_bit(key, node->length)]);
+    }
+
+    Node *node = *link;
+    if (node == NULL || node->entry == NULL) return false;
+
+    node->entry = NULL;
+    n_prefixes--;
+
+    // keep the node as a branching node if it still has two children.
+    if (node->child[0] != NULL && node->child[1] != NULL) return true;
+
+    *link = node->child[0] != NULL ? node->child[0] : node->child[1];
+    delete node;
+
+    // a branching parent left with a single child is no longer needed.
+    if (parent_link != NULL && *link == NULL) {
+        Node *parent = *parent_link;
+        if (parent->entry == NULL) {
+            *parent_link = parent->child[0] != NULL ? parent->child[0] : parent->child[1];
+            delete parent;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Lookup a destination in FIB.
+ * 
+ * @param dest The destination address.
+ * @return const BgpRib6Entry* Entry of the longest matching prefix.
+ * @retval NULL no match found.
+ * @retval BgpRib6Entry* Matching entry.
+ */
+const BgpRib6Entry* BgpFib6::lookup(const uint8_t dest[16]) const {
+    uint64_t key[2];
+    load_key(dest, key);
+    const BgpRib6Entry *selected_entry = NULL;
+    const Node *node = root;
+
+    while (node != NULL) {
+        if (!same_prefix(key, node->prefix, node->length)) break;
+        if (node->entry != NULL) selected_entry = node->entry;
+        if (node->length == 128) break;
+        node = node->child[next_bit(key, node->length)];
+    }
+
+    return selected_entry;
+}
+
+/**
+ * @brief Get the entry of a prefix.
+ * 
+ * @param prefix The prefix.
+ * @return const BgpRib6Entry* Entry of the prefix.
+ * @retval NULL prefix not in FIB.
+ * @retval BgpRib6Entry* Entry of the prefix.
+ */
+const BgpRib6Entry* BgpFib6::find(const Prefix6 &prefix) const {
+    uint8_t length = prefix.getLength();
+    uint64_t key[2];
+    prefix_key(prefix, key);
+    const Node *node = root;
+
+    while (node != NULL && node->length <= length) {
+        if (!same_prefix(key, node->prefix, node->length)) break;
+        if (node->length == length) return node->entry;
+        node = node->child[next_bit(key, node->length)];
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Remove all prefixes from FIB.
+ * 
+ */
+void BgpFib6::clear() {
+    deleteNode(root);
+    root = NULL;
+    n_prefixes = 0;
+}
+
+/**
+ * @brief Get number of prefixes in FIB.
+ * 
+ * @return size_t Number of prefixes.
+ */
+size_t BgpFib6::size() const {
+    return n_prefixes;
+}
+
+}
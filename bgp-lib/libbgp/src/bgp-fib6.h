@@ -0,0 +1,81 @@
+/**
+ * @file bgp-fib6.h
+ * @author Nato Morichika <nat@nat.moe>
+ * @brief The IPv6 BGP Forwarding Information Base.
+ * @version 0.1
+ * @date 2019-07-21
+ * 
+ * @copyright Copyright (c) 2019
+ * 
+ */
+#ifndef BGP_FIB6_H_
+#define BGP_FIB6_H_
+#include <stdint.h>
+#include <stddef.h>
+#include "prefix6.h"
+
+namespace libbgp {
+
+class BgpRib6Entry;
+
+/**
+ * @brief The BgpFib6 (IPv6 BGP Forwarding Information Base) class.
+ * 
+ * The FIB is a path-compressed binary (Patricia) trie holding the best
+ * (RS_ACTIVE) entry of every prefix in a BgpRib6. Each node of the trie is
+ * either a prefix with an entry or a branching point with two children, so the
+ * trie never has more than 2n - 1 nodes for n prefixes, and a lookup visits at
+ * most 129 nodes regardless of the size of the table. Prefixes are kept as
+ * two 64-bit words in host byte order.
+ * 
+ * The FIB does not own the entries. BgpRib6 keeps it in sync with the RIB, so
+ * you should not need to modify it yourself.
+ * 
+ */
+class BgpFib6 {
+public:
+    BgpFib6();
+    ~BgpFib6();
+
+    // set the entry of a prefix (replacing the old one, if any)
+    void insert(const Prefix6 &prefix, const BgpRib6Entry *entry);
+
+    // remove a prefix, return false if not found
+    bool remove(const Prefix6 &prefix);
+
+    // longest-prefix-match lookup, return null if not found
+    const BgpRib6Entry* lookup(const uint8_t dest[16]) const;
+
+    // exact-match lookup, return null if not found
+    const BgpRib6Entry* find(const Prefix6 &prefix) const;
+
+    // remove all prefixes
+    void clear();
+
+    // get number of prefixes
+    size_t size() const;
+
+private:
+    BgpFib6(const BgpFib6 &);
+    BgpFib6& operator= (const BgpFib6 &);
+
+    /**
+     * @brief Node of the trie.
+     * 
+     */
+    struct Node {
+        uint64_t prefix[2]; // host byte order, host bits cleared.
+        uint8_t length;
+        const BgpRib6Entry *entry; // NULL for branching nodes.
+        Node *child[2];
+    };
+
+    static Node* newNode(const uint64_t prefix[2], uint8_t length, const BgpRib6Entry *entry);
+    static void deleteNode(Node *node);
+
+    Node *root;
+    size_t n_prefixes;
+};
+
+}
+#endif // BGP_FIB6_H_
\ No newline at end of file
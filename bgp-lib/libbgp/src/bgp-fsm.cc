@@ -14,6 +14,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <arpa/inet.h>
+#include <unordered_map>
 
 namespace libbgp {
 
@@ -72,6 +73,9 @@ BgpFsm::BgpFsm(const BgpConfig &config) : in_sink(config.use_4b_asn) {
     hold_timer = 0;
     peer_bgp_id = 0;
     peer_asn = 0;
+    memset(&packing_stats, 0, sizeof(packing_stats));
+    memset(&message_stats, 0, sizeof(message_stats));
+    last_advertised = 0;
 }
 
 BgpFsm::~BgpFsm() {
@@ -115,6 +119,39 @@ BgpState BgpFsm::getState() const {
     return state;
 }
 
+const BgpUpdatePackingStats& BgpFsm::getPackingStats() const {
+    return packing_stats;
+}
+
+const BgpMessageStats& BgpFsm::getMessageStats() const {
+    return message_stats;
+}
+
+const BgpAdjRibOut4& BgpFsm::getAdjRibOut4() const {
+    return adj_rib_out4;
+}
+
+uint64_t BgpFsm::getNextDeadline() const {
+    if (state != ESTABLISHED) return 0;
+
+    uint64_t deadline = 0;
+
+    if (hold_timer > 0) {
+        // tick() checks with "now - last > timer", so the timers fire one 
+        // second after.
+        uint64_t hold = last_recv + hold_timer + 1;
+        uint64_t keepalive = last_sent + hold_timer / 3 + 1;
+        deadline = hold < keepalive ? hold : keepalive;
+    }
+
+    if (config.mrai > 0 && adj_rib_out4.pending() > 0) {
+        uint64_t mrai = last_advertised + config.mrai;
+        if (deadline == 0 || mrai < deadline) deadline = mrai;
+    }
+
+    return deadline;
+}
+
 int BgpFsm::start() {
     if (state == BROKEN) {
         logger->log(ERROR, "BgpFsm::start: FSM is broken, consider reset.\n");
@@ -182,13 +219,22 @@ int BgpFsm::run(const uint8_t *buffer, const size_t buffer_size) {
         return -1;
     }
 
-    ssize_t fill_ret = in_sink.fill(buffer, buffer_size);
+    // complete packets are parsed from buffer in place, the rest is copied
+    // into the sink by release().
+    ssize_t fill_ret = in_sink.fillBorrowed(buffer, buffer_size);
     if (fill_ret != (ssize_t) buffer_size) {
         logger->log(ERROR, "BgpFsm::run: failed to fill() sink.\n");
         setState(BROKEN);
         return -1;
     }
 
+    int ret = runSink();
+    in_sink.release();
+
+    return ret;
+}
+
+int BgpFsm::runSink() {
     // tick the clock
     if (!config.no_autotick) {
         int tick_ret = tick();
@@ -212,12 +258,22 @@ int BgpFsm::run(const uint8_t *buffer, const size_t buffer_size) {
 
         if (poured == 0) return 3;
 
+        const BgpMessage *msg = packet->getMessage();
+
+        if (poured > 0) {
+            message_stats.messages_in++;
+            message_stats.bytes_in += poured;
+            if (msg->type == UPDATE) {
+                message_stats.updates_in++;
+                countUpdate(*dynamic_cast<const BgpUpdateMessage *>(msg), message_stats.routes_in, message_stats.withdrawn_in);
+            }
+        }
+
         LIBBGP_LOG(logger, DEBUG) {
             logger->log(DEBUG, "BgpFsm::run: got message (Current state: %s):\n", bgp_fsm_state_str[state]);
             logger->log(DEBUG, *packet);
         }
 
-        const BgpMessage *msg = packet->getMessage();
         // parse failed / packet invalid (errors like Unsupported Optional 
         // Parameter falls in this catagory, since those errors are checked by
         // parsers, other errors like FSM error, Bad Peer AS, etc is handled in 
@@ -300,6 +356,9 @@ int BgpFsm::tick() {
         return 0;
     }
 
+    // MRAI expired with route changes queued?
+    if (config.mrai > 0 && !sendAdjRibOut4()) return -1;
+
     // send keepalive? 
     if (hold_timer > 0 && now - last_sent > hold_timer / 3) {
         BgpKeepaliveMessage keep = BgpKeepaliveMessage(logger);
@@ -604,12 +663,11 @@ bool BgpFsm::handleRoute4AddEvent(const Route4AddEvent &ev) {
 
     if (ev.new_routes != NULL && ev.shared_attribs != NULL) {
         if (!ibgp || ev.ibgp_peer_asn != peer_asn) {
-            BgpUpdateMessage update (logger, use_4b_asn);
-            update.setAttribs(*(ev.shared_attribs));
+            std::vector<Prefix4> routes;
 
             for (const Prefix4 &route : *(ev.new_routes)) {
                 if (config.out_filters4.apply(route, *(ev.shared_attribs)) == ACCEPT) {
-                    update.addNlri4(route);
+                    routes.push_back(route);
                 } else {
                     LIBBGP_LOG(logger, DEBUG) {
                         uint32_t prefix = route.getPrefix();
@@ -620,12 +678,10 @@ bool BgpFsm::handleRoute4AddEvent(const Route4AddEvent &ev) {
                 }
             }
 
-            if (update.nlri.size() > 0) {
-                alterNexthop4(update);
-                prepareUpdateMessage(update);
-
-                if(!writeMessage(update)) return false;
-            }
+            if (config.mrai > 0) {
+                BgpAttribSet attribs = rib4->getAttribPool().intern(*(ev.shared_attribs));
+                for (const Prefix4 &route : routes) adj_rib_out4.advertise(route, attribs);
+            } else if(!sendRoutes4(*(ev.shared_attribs), routes)) return false;
         } else {
             logger->log(DEBUG, "BgpFsm::handleRoute4AddEvent: ignoring new_routes in add event since remote is IBGP.\n");
         }
@@ -635,10 +691,15 @@ bool BgpFsm::handleRoute4AddEvent(const Route4AddEvent &ev) {
 
     if (ev.replaced_entries == NULL) {
         logger->log(DEBUG, "BgpFsm::handleRoute4AddEvent: replaced_entries is NULL.\n");
-        return true;
+        return config.mrai > 0 ? sendAdjRibOut4() : true;
     }
 
-    // consider merging of replaced_entries?
+    // group replaced entries by attributes. entries from the RIB with the same
+    // attributes share the same interned set.
+    std::vector<const std::vector<std::shared_ptr<BgpPathAttrib>>*> group_attribs;
+    std::vector<std::vector<Prefix4>> group_routes;
+    std::unordered_map<const void*, size_t> group_index;
+
     for (const BgpRib4Entry &entry : *(ev.replaced_entries)) {
         if (entry.src_router_id == peer_bgp_id) continue;
 
@@ -664,15 +725,28 @@ bool BgpFsm::handleRoute4AddEvent(const Route4AddEvent &ev) {
             continue;
         }
 
-        BgpUpdateMessage update (logger, use_4b_asn);
-        update.setAttribs(entry.attribs);
-        update.addNlri4(entry.route);
-        alterNexthop4(update);
-        prepareUpdateMessage(update);
-        if(!writeMessage(update)) return false;
+        if (config.mrai > 0) {
+            adj_rib_out4.advertise(entry.route, entry.attribs);
+            continue;
+        }
+
+        const std::vector<std::shared_ptr<BgpPathAttrib>> &attribs = entry.attribs;
+        std::pair<std::unordered_map<const void*, size_t>::iterator, bool> group = 
+            group_index.insert(std::make_pair(&attribs, group_attribs.size()));
+
+        if (group.second) {
+            group_attribs.push_back(&attribs);
+            group_routes.push_back(std::vector<Prefix4>());
+        }
+
+        group_routes[group.first->second].push_back(entry.route);
     }
 
-    return true;
+    for (size_t i = 0; i < group_attribs.size(); i++) {
+        if(!sendRoutes4(*(group_attribs[i]), group_routes[i])) return false;
+    }
+
+    return config.mrai > 0 ? sendAdjRibOut4() : true;
 }
 
 bool BgpFsm::handleRoute4WithdrawEvent(const Route4WithdrawEvent &ev) {
@@ -682,10 +756,107 @@ bool BgpFsm::handleRoute4WithdrawEvent(const Route4WithdrawEvent &ev) {
 
     logger->log(DEBUG, "BgpFsm::handleRoute4AddEvent: got route-withdraw event with %zu routes.\n", ev.routes->size());
 
+    if (config.mrai > 0) {
+        // withdrawals are not subject to the MRAI. (RFC 4271, 9.2.1.1)
+        std::vector<Prefix4> withdrawn;
+        for (const Prefix4 &route : *(ev.routes)) {
+            if (adj_rib_out4.withdraw(route)) withdrawn.push_back(route);
+        }
+
+        if (!sendWithdrawn4(withdrawn)) return false;
+        return sendAdjRibOut4();
+    }
+
+    return sendWithdrawn4(*(ev.routes));
+}
+
+bool BgpFsm::sendAdjRibOut4() {
+    if (adj_rib_out4.pending() == 0) return true;
+
+    uint64_t now = clock->getTime();
+    if (now < last_advertised + config.mrai) return true;
+
+    std::vector<std::pair<BgpAttribSet, std::vector<Prefix4>>> updates;
+    size_t n_changes = adj_rib_out4.flush(updates);
+
+    logger->log(DEBUG, "BgpFsm::sendAdjRibOut4: sending %zu routes (%zu attribute sets).\n", n_changes, updates.size());
+
+    last_advertised = now;
+
+    for (const std::pair<BgpAttribSet, std::vector<Prefix4>> &update : updates) {
+        if (!sendRoutes4(update.first, update.second)) return false;
+    }
+
+    return true;
+}
+
+bool BgpFsm::sendRoutes4(const std::vector<std::shared_ptr<BgpPathAttrib>> &attribs, const std::vector<Prefix4> &routes) {
+    if (routes.size() == 0) return true;
+
+    BgpUpdateMessage update (logger, use_4b_asn);
+    update.setAttribs(attribs);
+    alterNexthop4(update);
+    prepareUpdateMessage(update);
+
+    // length of the update message w/o nlri, 19: headers, 4: length fields
+    size_t overhead = 19 + 4;
+    for (const std::shared_ptr<BgpPathAttrib> &attrib : update.path_attribute) {
+        overhead += attrib->length();
+    }
+
+    size_t msg_len = overhead;
+
+    for (const Prefix4 &route : routes) {
+        size_t nlri_len = 1 + (route.getLength() + 7) / 8;
+
+        if (msg_len + nlri_len > BGP_FSM_BUFFER_SIZE && update.nlri.size() > 0) {
+            if (!writePackedUpdate(update, update.nlri.size(), overhead)) return false;
+            update.nlri.clear();
+            msg_len = overhead;
+        }
+
+        update.addNlri4(route);
+        msg_len += nlri_len;
+    }
+
+    return writePackedUpdate(update, update.nlri.size(), overhead);
+}
+
+bool BgpFsm::sendWithdrawn4(const std::vector<Prefix4> &routes) {
+    if (routes.size() == 0) return true;
+
     BgpUpdateMessage withdraw (logger, use_4b_asn);
-    withdraw.setWithdrawn4(*(ev.routes));
 
-    if(!writeMessage(withdraw)) return false;
+    // 19: headers, 4: length fields
+    const size_t overhead = 19 + 4;
+    size_t msg_len = overhead;
+
+    for (const Prefix4 &route : routes) {
+        size_t route_len = 1 + (route.getLength() + 7) / 8;
+
+        if (msg_len + route_len > BGP_FSM_BUFFER_SIZE) {
+            if (!writePackedUpdate(withdraw, withdraw.withdrawn_routes.size(), overhead)) return false;
+            withdraw.withdrawn_routes.clear();
+            msg_len = overhead;
+        }
+
+        withdraw.addWithdrawn4(route);
+        msg_len += route_len;
+    }
+
+    return writePackedUpdate(withdraw, withdraw.withdrawn_routes.size(), overhead);
+}
+
+bool BgpFsm::writePackedUpdate(const BgpUpdateMessage &update, size_t n_routes, size_t overhead) {
+    if(!writeMessage(update)) return false;
+
+    packing_stats.messages++;
+    packing_stats.routes += n_routes;
+    if (n_routes > 1) {
+        packing_stats.messages_saved += n_routes - 1;
+        packing_stats.bytes_saved += (n_routes - 1) * overhead;
+    }
+
     return true;
 }
 
@@ -903,6 +1074,7 @@ int BgpFsm::fsmEvalOpenConfirm(__attribute__((unused)) const BgpMessage *msg) {
                         break;
                     }
                     update.addNlri4(r);
+                    if (config.mrai > 0) adj_rib_out4.sent(r, e.attribs);
                 } else {
                     LIBBGP_LOG(logger, DEBUG) {
                         uint32_t prefix = r.getPrefix();
@@ -918,6 +1090,8 @@ int BgpFsm::fsmEvalOpenConfirm(__attribute__((unused)) const BgpMessage *msg) {
                 if(!writeMessage(update)) return -1;
             }
         }
+
+        last_advertised = clock->getTime();
     }
 
     if (send_ipv6_routes) {
@@ -1234,6 +1408,7 @@ void BgpFsm::setState(BgpState new_state) {
 
         // moved from ESTABLISHED to something else. Drop all routes.
         dropAllRoutes();
+        adj_rib_out4.clear();
     }
 
     state = new_state;
@@ -1284,7 +1459,33 @@ bool BgpFsm::writeMessage(const BgpMessage &msg) {
         return false;
     }
 
+    message_stats.messages_out++;
+    message_stats.bytes_out += pkt_len;
+    if (msg.type == UPDATE) {
+        message_stats.updates_out++;
+        countUpdate(dynamic_cast<const BgpUpdateMessage &>(msg), message_stats.routes_out, message_stats.withdrawn_out);
+    }
+
     return true;
 }
 
+void BgpFsm::countUpdate(const BgpUpdateMessage &update, uint64_t &routes, uint64_t &withdrawn) {
+    routes += update.nlri.size();
+    withdrawn += update.withdrawn_routes.size();
+
+    if (update.hasAttrib(MP_REACH_NLRI)) {
+        const BgpPathAttribMpNlriBase &mp_reach = dynamic_cast<const BgpPathAttribMpNlriBase &>(update.getAttrib(MP_REACH_NLRI));
+        if (mp_reach.afi == IPV6 && mp_reach.safi == UNICAST) {
+            routes += dynamic_cast<const BgpPathAttribMpReachNlriIpv6 &>(mp_reach).nlri.size();
+        }
+    }
+
+    if (update.hasAttrib(MP_UNREACH_NLRI)) {
+        const BgpPathAttribMpNlriBase &mp_unreach = dynamic_cast<const BgpPathAttribMpNlriBase &>(update.getAttrib(MP_UNREACH_NLRI));
+        if (mp_unreach.afi == IPV6 && mp_unreach.safi == UNICAST) {
+            withdrawn += dynamic_cast<const BgpPathAttribMpUnreachNlriIpv6 &>(mp_unreach).withdrawn_routes.size();
+        }
+    }
+}
+
 }
@@ -15,6 +15,7 @@
 #include "clock.h"
 #include "bgp-rib4.h"
 #include "bgp-rib6.h"
+#include "bgp-adj-rib-out.h"
 #include "bgp-config.h"
 #include "bgp-sink.h"
 #include "route-event-receiver.h"
@@ -25,6 +26,107 @@
 
 namespace libbgp {
 
+/**
+ * @brief Counters of UPDATE packing.
+ * 
+ * Routes sent on route events are packed into as few UPDATE messages as 
+ * possible. Savings are counted against sending one message per route.
+ * 
+ */
+struct BgpUpdatePackingStats {
+    /**
+     * @brief UPDATE messages sent for route events.
+     * 
+     */
+    uint64_t messages;
+
+    /**
+     * @brief Routes (NLRI and withdrawn routes) in those messages.
+     * 
+     */
+    uint64_t routes;
+
+    /**
+     * @brief Messages saved by packing.
+     * 
+     */
+    uint64_t messages_saved;
+
+    /**
+     * @brief Bytes (headers and path attributes) saved by packing.
+     * 
+     */
+    uint64_t bytes_saved;
+};
+
+/**
+ * @brief Counters of messages sent and received by the FSM.
+ * 
+ * Routes are counted for IPv4 and IPv6 (MP-BGP) unicast.
+ * 
+ */
+struct BgpMessageStats {
+    /**
+     * @brief Messages received.
+     * 
+     */
+    uint64_t messages_in;
+
+    /**
+     * @brief Messages sent.
+     * 
+     */
+    uint64_t messages_out;
+
+    /**
+     * @brief UPDATE messages received.
+     * 
+     */
+    uint64_t updates_in;
+
+    /**
+     * @brief UPDATE messages sent.
+     * 
+     */
+    uint64_t updates_out;
+
+    /**
+     * @brief Routes (NLRI) received.
+     * 
+     */
+    uint64_t routes_in;
+
+    /**
+     * @brief Routes (NLRI) sent.
+     * 
+     */
+    uint64_t routes_out;
+
+    /**
+     * @brief Withdrawn routes received.
+     * 
+     */
+    uint64_t withdrawn_in;
+
+    /**
+     * @brief Withdrawn routes sent.
+     * 
+     */
+    uint64_t withdrawn_out;
+
+    /**
+     * @brief Bytes received.
+     * 
+     */
+    uint64_t bytes_in;
+
+    /**
+     * @brief Bytes sent.
+     * 
+     */
+    uint64_t bytes_out;
+};
+
 /**
  * @brief BGP Finite State Machine status.
  * 
@@ -108,6 +210,30 @@ public:
      */
     BgpState getState() const;
 
+    /**
+     * @brief Get counters of UPDATE packing.
+     * 
+     * @return const BgpUpdatePackingStats& The counters.
+     */
+    const BgpUpdatePackingStats& getPackingStats() const;
+
+    /**
+     * @brief Get counters of messages sent and received.
+     * 
+     * @return const BgpMessageStats& The counters.
+     */
+    const BgpMessageStats& getMessageStats() const;
+
+    /**
+     * @brief Get the IPv4 Adj-RIB-Out of the session.
+     * 
+     * The Adj-RIB-Out is only used if the MinRouteAdvertisementInterval (mrai)
+     * is set in the configuration.
+     * 
+     * @return const BgpAdjRibOut4& The Adj-RIB-Out.
+     */
+    const BgpAdjRibOut4& getAdjRibOut4() const;
+
     /**
      * @brief send OPEN message to peer. (IDLE -> OpenSent)
      * 
@@ -150,8 +276,10 @@ public:
      * tick() should be called regularly to check for time-based events like 
      * hold timer checks and keepalive message sending. BGP FSM will tick itself
      * when run() is called but you should call tink() regularly to ensure the 
-     * hold timer on the other side won't expire.
+     * hold timer on the other side won't expire. Route advertisements queued in 
+     * the Adj-RIB-Out are sent on tick once the MRAI has expired.
      * 
+     * @retval -1 Fatal error occured. FSM is now in BROKEN state.
      * @retval 0 Hold timer expired. Notification message was sent to the peer.
      * FSM is now in IDLE state. error may be written to stderr with log 
      * handler.
@@ -160,6 +288,21 @@ public:
      */
     int tick();
 
+    /**
+     * @brief Get the time of the next time-based event.
+     * 
+     * Instead of calling tick() regularly, tick() may be called at the time
+     * returned here (hold timer expiry, keepalive to send, or MRAI expiry with
+     * advertisements queued). The deadline changes when messages are sent or
+     * received, on state changes and on route events, so it should be checked
+     * again after calling run(), tick() or publishing on the route event bus.
+     * Calling tick() before the deadline is harmless.
+     * 
+     * @return uint64_t Time (as returned by the Clock) of the next event.
+     * @retval 0 No time-based event pending. (e.g. FSM not ESTABLISHED)
+     */
+    uint64_t getNextDeadline() const;
+
     // soft reset: send Administrative Reset and go to idle
     // return value:
     // -1: fatal_error, FSM now BROKEN, check errbuf.
@@ -200,6 +343,9 @@ private:
     bool handleRoute6WithdrawEvent(const Route6WithdrawEvent &ev);
     bool handleRoute6AddEvent(const Route6AddEvent &ev);
 
+    // run the FSM on packets in sink.
+    int runSink();
+
     int validateState(uint8_t type);
     int fsmEvalIdle(const BgpMessage *msg);
     int fsmEvalOpenSent(const BgpMessage *msg);
@@ -232,6 +378,9 @@ private:
 
     bool writeMessage(const BgpMessage &msg);
 
+    // count routes of an update in message stats.
+    void countUpdate(const BgpUpdateMessage &update, uint64_t &routes, uint64_t &withdrawn);
+
     // automaically change IPv4 nexthop for outgoing routes if needed
     void alterNexthop4 (BgpUpdateMessage &update);
 
@@ -242,6 +391,19 @@ private:
     // non-trans attrs)
     void prepareUpdateMessage(BgpUpdateMessage &update);
 
+    // send routes with the same attributes, packed in as few updates as 
+    // possible.
+    bool sendRoutes4(const std::vector<std::shared_ptr<BgpPathAttrib>> &attribs, const std::vector<Prefix4> &routes);
+
+    // send withdrawn routes, packed in as few updates as possible.
+    bool sendWithdrawn4(const std::vector<Prefix4> &routes);
+
+    // send the routes queued in Adj-RIB-Out if MRAI has expired.
+    bool sendAdjRibOut4();
+
+    // write a packed update and count it.
+    bool writePackedUpdate(const BgpUpdateMessage &update, size_t n_routes, size_t overhead);
+
     BgpSink in_sink;
     BgpState state;
     BgpConfig config;
@@ -276,6 +438,15 @@ private:
 
     uint32_t peer_asn;
 
+    BgpUpdatePackingStats packing_stats;
+
+    BgpMessageStats message_stats;
+
+    BgpAdjRibOut4 adj_rib_out4;
+
+    // time changes from Adj-RIB-Out last sent
+    uint64_t last_advertised;
+
 };
 
 /**
@@ -5,6 +5,7 @@
 #include <memory>
 #include <arpa/inet.h>
 #include "bgp-path-attrib.h"
+#include "bgp-attrib-pool.h"
 #include "bgp-log-handler.h"
 
 namespace libbgp {
@@ -40,7 +41,7 @@ public:
      * source default to SRC_EBGP 
      * 
      */
-    BgpRibEntry () { src = SRC_EBGP; status = RS_ACTIVE; }
+    BgpRibEntry () { src = SRC_EBGP; status = RS_ACTIVE; decision_key = 0; med = orig_as = 0; }
 
     /**
      * @brief The originating BGP speaker's ID of this entry. (network bytes order)
@@ -70,8 +71,11 @@ public:
     /**
      * @brief Path attributes for this entry.
      * 
+     * Entries inserted by the RIB share an interned set with all other 
+     * entries of the same attributes.
+     * 
      */
-    std::vector<std::shared_ptr<BgpPathAttrib>> attribs;
+    BgpAttribSet attribs;
 
     /**
      * @brief Source of this entry.
@@ -100,56 +104,63 @@ public:
     uint32_t ibgp_peer_asn;
 
     /**
-     * @brief Test if this entry has greater weight then anoter entry. 
-     * Please note that weight are only calculated based on path attribues. 
-     * (i.e., you need to compare route prefix first)
+     * @brief Packed decision key of the path attributes.
+     * 
+     * LOCAL_PREF in the upper 32 bits, then the complement of the AS_PATH 
+     * length and the complement of ORIGIN, so that a greater key is a better
+     * path for the first steps of best path selection. Computed from attribs
+     * by updateDecisionKey.
      * 
-     * @param other The other entry.
-     * @return true This entry has higher weight.
-     * @return false This entry has lower or equals weight.
      */
-    bool operator> (const T &other) const {
-        // perfer ebgp
-        if (this->src > other.src) return false;
-
-        // prefer higher weight
-        if (this->weight > other.weight) return true;
-        if (this->weight < other.weight) return false;
+    uint64_t decision_key;
 
-        uint32_t other_med = 0;
-        uint32_t this_med = 0;
-
-        uint32_t other_orig_as = 0;
-        uint32_t this_orig_as = 0;
+    /**
+     * @brief MULTI_EXIT_DISC of this entry (0 if none).
+     * 
+     */
+    uint32_t med;
 
-        uint8_t other_origin = 0;
-        uint8_t this_origin = 0;
+    /**
+     * @brief Originating ASN (last ASN of the AS_SEQUENCE, 0 if none).
+     * 
+     * MED is only compared between entries of the same originating ASN.
+     * 
+     */
+    uint32_t orig_as;
 
-        uint8_t other_as_path_len = 0;
-        uint8_t this_as_path_len = 0;
+    /**
+     * @brief Compute the decision key (and med, orig_as) from attribs.
+     * 
+     * The key is computed when the entry is created. This must be called again
+     * if attribs are modified afterward.
+     */
+    void updateDecisionKey() {
+        uint32_t local_pref = 100;
+        uint8_t origin = 0;
+        uint8_t as_path_len = 0;
 
-        uint32_t other_local_pref = 100;
-        uint32_t this_local_pref = 100;
+        med = 0;
+        orig_as = 0;
 
-        // grab attributes
-        for (const std::shared_ptr<BgpPathAttrib> &attr : other.attribs) {
+        for (const std::shared_ptr<BgpPathAttrib> &attr : attribs) {
             if (attr->type_code == MULTI_EXIT_DISC) {
-                const BgpPathAttribMed &med = dynamic_cast<const BgpPathAttribMed &>(*attr);
-                other_med = med.med;
+                const BgpPathAttribMed &med_attr = dynamic_cast<const BgpPathAttribMed &>(*attr);
+                med = med_attr.med;
+                continue;
             }
 
             if (attr->type_code == ORIGIN) {
                 const BgpPathAttribOrigin &orig = dynamic_cast<const BgpPathAttribOrigin &>(*attr);
-                other_origin = orig.origin;
+                origin = orig.origin;
                 continue;
             }
 
             if (attr->type_code == AS_PATH) {
                 const BgpPathAttribAsPath &as_path = dynamic_cast<const BgpPathAttribAsPath &>(*attr);
                 for (const BgpAsPathSegment &seg : as_path.as_paths) {
-                    if (seg.type == AS_SEQUENCE) {
-                        other_as_path_len = seg.value.size();
-                        other_orig_as = seg.value.back();
+                    if (seg.type == AS_SEQUENCE && seg.value.size() > 0) {
+                        as_path_len = seg.value.size();
+                        orig_as = seg.value.back();
                     }
                 }
                 continue;
@@ -157,54 +168,42 @@ public:
 
             if (attr->type_code == LOCAL_PREF) {
                 const BgpPathAttribLocalPref &pref = dynamic_cast<const BgpPathAttribLocalPref &>(*attr);
-                other_local_pref = pref.local_pref;
+                local_pref = pref.local_pref;
                 continue;
             }
         }
 
-        for (const std::shared_ptr<BgpPathAttrib> &attr : attribs) {
-            if (attr->type_code == MULTI_EXIT_DISC) {
-                const BgpPathAttribMed &med = dynamic_cast<const BgpPathAttribMed &>(*attr);
-                this_med = med.med;
-            }
+        decision_key = ((uint64_t) local_pref << 32) | 
+            ((uint64_t) (uint8_t) ~as_path_len << 8) | (uint8_t) ~origin;
+    }
 
-            if (attr->type_code == ORIGIN) {
-                const BgpPathAttribOrigin &orig = dynamic_cast<const BgpPathAttribOrigin &>(*attr);
-                this_origin = orig.origin;
-                continue;
-            }
+    /**
+     * @brief Test if this entry has greater weight then anoter entry. 
+     * Please note that weight are only calculated based on path attribues. 
+     * (i.e., you need to compare route prefix first)
+     * 
+     * The path attributes are compared with the precomputed decision keys, so
+     * the comparison does not need to walk the attributes.
+     * 
+     * @param other The other entry.
+     * @return true This entry has higher weight.
+     * @return false This entry has lower or equals weight.
+     */
+    bool operator> (const T &other) const {
+        // perfer ebgp
+        if (this->src > other.src) return false;
 
-            if (attr->type_code == AS_PATH) {
-                const BgpPathAttribAsPath &as_path = dynamic_cast<const BgpPathAttribAsPath &>(*attr);
-                for (const BgpAsPathSegment &seg : as_path.as_paths) {
-                    if (seg.type == AS_SEQUENCE) {
-                        this_as_path_len = seg.value.size();
-                        this_orig_as = seg.value.back();
-                    }
-                }
-                continue;
-            }
+        // prefer higher weight
+        if (this->weight > other.weight) return true;
+        if (this->weight < other.weight) return false;
 
-            if (attr->type_code == LOCAL_PREF) {
-                const BgpPathAttribLocalPref &pref = dynamic_cast<const BgpPathAttribLocalPref &>(*attr);
-                this_local_pref = pref.local_pref;
-                continue;
-            }
-        }
+        // local_pref, as_path length, origin
+        if (decision_key != other.decision_key) return decision_key > other.decision_key;
+
+        if (orig_as == other.orig_as && med != other.med) return other.med > med;
+        if (other.update_id != update_id) return other.update_id > update_id;
 
-        /**/ if (this_local_pref > other_local_pref) return true;
-        else if (this_local_pref < other_local_pref) return false;
-        else if (other_as_path_len > this_as_path_len) return true;
-        else if (other_as_path_len < this_as_path_len) return false;
-        else if (other_origin > this_origin) return true;
-        else if (other_origin < this_origin) return false;
-        else if (other_orig_as == this_orig_as && other_med > this_med) return true;
-        else if (other_orig_as == this_orig_as && other_med < this_med) return false;
-        else if (other.update_id > update_id) return true;
-        else if (other.update_id < update_id) return false;
-        else if (htonl(other.src_router_id) > htonl(src_router_id)) return true;
-
-        return false;
+        return htonl(other.src_router_id) > htonl(src_router_id);
     }
 
 };
@@ -16,6 +16,7 @@ namespace libbgp {
 
 BgpRib4Entry::BgpRib4Entry() {
     src_router_id = 0;
+    updateDecisionKey();
 }
 
 /**
@@ -25,9 +26,10 @@ BgpRib4Entry::BgpRib4Entry() {
  * @param src Originating BGP speaker's ID in network bytes order.
  * @param as Path attributes for this entry.
  */
-BgpRib4Entry::BgpRib4Entry(Prefix4 r, uint32_t src, const std::vector<std::shared_ptr<BgpPathAttrib>> as) : route(r) {
+BgpRib4Entry::BgpRib4Entry(Prefix4 r, uint32_t src, const BgpAttribSet &as) : route(r) {
     src_router_id = src;
     attribs = as;
+    updateDecisionKey();
 }
 
 /**
@@ -55,6 +57,7 @@ uint32_t BgpRib4Entry::getNexthop() const {
 BgpRib4::BgpRib4(BgpLogHandler *logger) {
     this->logger = logger;
     update_id = 0;    
+    pool = &own_pool;
 }
 
 rib4_t::iterator BgpRib4::find_best (const Prefix4 &prefix) {
@@ -92,6 +95,29 @@ rib4_t::iterator BgpRib4::find_entry (const Prefix4 &prefix, uint32_t src) {
     return rib.end();
 }
 
+/**
+ * @brief Bring the FIB entry of a prefix in sync with the RIB.
+ * 
+ * Must be called after any change to the entries of the prefix, as the FIB
+ * holds pointers to the active entry.
+ * 
+ * @param prefix The prefix.
+ */
+void BgpRib4::updateFib(const Prefix4 &prefix) {
+    std::pair<rib4_t::iterator, rib4_t::iterator> its = 
+        rib.equal_range(BgpRib4EntryKey(prefix));
+
+    const BgpRib4Entry *best = NULL;
+
+    for (rib4_t::iterator it = its.first; it != its.second; it++) {
+        if (it->second.route != prefix || it->second.status != RS_ACTIVE) continue;
+        best = selectEntry(best, &(it->second));
+    }
+
+    if (best == NULL) fib.remove(prefix);
+    else fib.insert(prefix, best);
+}
+
 /**
  * @brief The actual insert implementation.
  * 
@@ -110,7 +136,7 @@ rib4_t::iterator BgpRib4::find_entry (const Prefix4 &prefix, uint32_t src) {
  * @retval <NULL, false> inserted route is not the new best, and current best
  * has not changed.
  */
-std::pair<const BgpRib4Entry*, bool> BgpRib4::insertPriv(uint32_t src_router_id, const Prefix4 &route, const std::vector<std::shared_ptr<BgpPathAttrib>> &attrib, int32_t weight, uint32_t ibgp_asn) {
+std::pair<const BgpRib4Entry*, bool> BgpRib4::insertPriv(uint32_t src_router_id, const Prefix4 &route, const BgpAttribSet &attrib, int32_t weight, uint32_t ibgp_asn) {
     std::lock_guard<std::recursive_mutex> lock(mutex);
 
     /* construct the new entry object */
@@ -182,6 +208,7 @@ std::pair<const BgpRib4Entry*, bool> BgpRib4::insertPriv(uint32_t src_router_id,
     }
 
     if (new_best != NULL) new_best->status = RS_ACTIVE;
+    updateFib(route);
     
     LIBBGP_LOG(logger, DEBUG) {
         uint32_t prefix = route.getPrefix();
@@ -246,12 +273,13 @@ const BgpRib4Entry* BgpRib4::insert(BgpLogHandler *logger, const Prefix4 &route,
         }
     }
 
-    BgpRib4Entry new_entry(route, 0, attribs);
+    BgpRib4Entry new_entry(route, 0, pool->intern(attribs));
     std::lock_guard<std::recursive_mutex> lock(mutex);
     new_entry.update_id = use_update_id;
     new_entry.weight = weight;
     if (use_update_id == update_id) update_id++;
     rib4_t::const_iterator it = rib.insert(MAKE_ENTRY4(route, new_entry));
+    updateFib(route);
 
     return &(it->second);
 }
@@ -282,16 +310,19 @@ const std::vector<BgpRib4Entry> BgpRib4::insert(BgpLogHandler *logger, const std
     attribs.push_back(std::shared_ptr<BgpPathAttrib>(nexhop_attr));
     attribs.push_back(std::shared_ptr<BgpPathAttrib>(as_path));
 
+    BgpAttribSet attrib_set = pool->intern(attribs);
+
     for (const Prefix4 &route : routes) {
         rib4_t::const_iterator it = find_entry(route, 0);
 
         if (it != rib.end()) continue;
 
-        BgpRib4Entry new_entry (route, 0, attribs);
+        BgpRib4Entry new_entry (route, 0, attrib_set);
         new_entry.update_id = update_id;
         new_entry.weight = weight;
         rib4_t::const_iterator isrt_it = rib.insert(MAKE_ENTRY4(route, new_entry));
         inserted.push_back(isrt_it->second);
+        updateFib(route);
     }
 
     update_id++;
@@ -310,7 +341,7 @@ const std::vector<BgpRib4Entry> BgpRib4::insert(BgpLogHandler *logger, const std
  */
 std::pair<const BgpRib4Entry*, bool> BgpRib4::insert(uint32_t src_router_id, const Prefix4 &route, const std::vector<std::shared_ptr<BgpPathAttrib>> &attrib, int32_t weight, uint32_t ibgp_asn) {
     update_id++;
-    return insertPriv(src_router_id, route, attrib, weight, ibgp_asn);
+    return insertPriv(src_router_id, route, pool->intern(attrib), weight, ibgp_asn);
 }
 
 /**
@@ -328,8 +359,9 @@ std::pair<std::vector<BgpRib4Entry>, std::vector<Prefix4>> BgpRib4::insert(uint3
     update_id++;
     std::vector<BgpRib4Entry> updated;
     std::vector<Prefix4> unchanged;
+    BgpAttribSet attrib_set = pool->intern(attrib);
     for (const Prefix4 &route : routes) {
-        std::pair<const BgpRib4Entry*, bool> rslt = insertPriv(src_router_id, route, attrib, weight, ibgp_asn);
+        std::pair<const BgpRib4Entry*, bool> rslt = insertPriv(src_router_id, route, attrib_set, weight, ibgp_asn);
         if (rslt.first != NULL) {
             if (!rslt.second) updated.push_back(*(rslt.first));
             else unchanged.push_back(route);
@@ -400,6 +432,7 @@ std::pair<bool, const void*> BgpRib4::withdraw(uint32_t src_router_id, const Pre
 
     rib.erase(to_remove);
     if (replacement != NULL) replacement->status = RS_ACTIVE;
+    updateFib(route);
 
     LIBBGP_LOG(logger, DEBUG) {
         uint32_t prefix = route.getPrefix();
@@ -459,6 +492,7 @@ std::pair<std::vector<Prefix4>, std::vector<BgpRib4Entry>> BgpRib4::discard(uint
             replacement->second.status = RS_ACTIVE;
             replacements.push_back(replacement->second);
         }
+        updateFib(prefix);
 
         LIBBGP_LOG(logger, DEBUG) {
             uint32_t pfx = prefix.getPrefix();
@@ -493,6 +527,8 @@ std::vector<Prefix4> BgpRib4::discard2(uint32_t src_router_id) {
         }
     }
 
+    for (const Prefix4 &route : dropped_routes) updateFib(route);
+
     return dropped_routes;
 }
 
@@ -501,29 +537,23 @@ std::vector<Prefix4> BgpRib4::discard2(uint32_t src_router_id) {
  */
 void BgpRib4::clear() {
     std::lock_guard<std::recursive_mutex> lock(mutex);
+    fib.clear();
     rib.clear();
 }
 
 /**
  * @brief Lookup a destination in RIB.
  * 
+ * The lookup is done on the FIB, which holds the active entries of the RIB in
+ * a trie, so its cost depends on the prefix lengths and not on the RIB size.
+ * 
  * @param dest The destination address in network byte order.
  * @return const BgpRib4Entry* Matching entry.
  * @retval NULL no match found.
  * @retval BgpRib4Entry* Matching entry.
  */
 const BgpRib4Entry* BgpRib4::lookup(uint32_t dest) const {
-    const BgpRib4Entry *selected_entry = NULL;
-
-    for (const auto &entry : rib) {
-        if (entry.second.status != RS_ACTIVE) continue;
-        const Prefix4 &route = entry.second.route;
-        if (route.includes(dest)) 
-            selected_entry = selectEntry(&entry.second, selected_entry);
-
-    }
-
-    return selected_entry;
+    return fib.lookup(dest);
 }
 
 /**
@@ -562,4 +592,46 @@ const rib4_t& BgpRib4::get() const {
     return rib;
 }
 
+/**
+ * @brief Get the FIB.
+ * 
+ * @return const BgpFib4& The FIB (best entry of each prefix).
+ */
+const BgpFib4& BgpRib4::getFib() const {
+    return fib;
+}
+
+/**
+ * @brief Share an attribute intern table with other RIBs.
+ * 
+ * By default, every RIB has its own table. Sharing one between the RIBs of
+ * many speakers (e.g., in a simulation) stores identical path attributes once.
+ * Entries already in the RIB keep their sets. The pool must outlive this RIB,
+ * but the sets it gave out may outlive it.
+ * 
+ * @param pool The table, or NULL to use our own table again.
+ */
+void BgpRib4::setAttribPool(BgpAttribPool *pool) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    this->pool = pool == NULL ? &own_pool : pool;
+}
+
+/**
+ * @brief Get the attribute intern table used by this RIB.
+ * 
+ * @return const BgpAttribPool& The table.
+ */
+const BgpAttribPool& BgpRib4::getAttribPool() const {
+    return *pool;
+}
+
+/**
+ * @brief Get the attribute intern table used by this RIB.
+ * 
+ * @return BgpAttribPool& The table.
+ */
+BgpAttribPool& BgpRib4::getAttribPool() {
+    return *pool;
+}
+
 }
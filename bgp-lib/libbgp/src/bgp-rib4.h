@@ -18,6 +18,7 @@
 #include <mutex>
 #include <iostream>
 #include "bgp-rib.h"
+#include "bgp-fib4.h"
 #include "prefix4.h"
 #include "bgp-path-attrib.h"
 
@@ -67,7 +68,7 @@ struct BgpRib4EntryHash {
 class BgpRib4Entry : public BgpRibEntry<BgpRib4Entry> {
 public:
     BgpRib4Entry ();
-    BgpRib4Entry (Prefix4 r, uint32_t src, const std::vector<std::shared_ptr<BgpPathAttrib>> attribs);
+    BgpRib4Entry (Prefix4 r, uint32_t src, const BgpAttribSet &attribs);
 
     /**
      * @brief The prefix of this entry.
@@ -124,11 +125,25 @@ public:
     // get RIB
     const rib4_t &get() const;
 
+    // get FIB
+    const BgpFib4 &getFib() const;
+
+    // share the attribute intern table with other RIBs. (NULL to use our own)
+    void setAttribPool(BgpAttribPool *pool);
+
+    // get the attribute intern table.
+    const BgpAttribPool &getAttribPool() const;
+    BgpAttribPool &getAttribPool();
+
 private:
     rib4_t::iterator find_best (const Prefix4 &prefix);
     rib4_t::iterator find_entry (const Prefix4 &prefix, uint32_t src);
-    std::pair<const BgpRib4Entry*, bool> insertPriv(uint32_t src_router_id, const Prefix4 &route, const std::vector<std::shared_ptr<BgpPathAttrib>> &attrib, int32_t weight, uint32_t ibgp_asn);
+    std::pair<const BgpRib4Entry*, bool> insertPriv(uint32_t src_router_id, const Prefix4 &route, const BgpAttribSet &attrib, int32_t weight, uint32_t ibgp_asn);
+    void updateFib(const Prefix4 &prefix);
+    BgpAttribPool own_pool;
+    BgpAttribPool *pool;
     rib4_t rib;
+    BgpFib4 fib;
     std::recursive_mutex mutex;
     BgpLogHandler *logger;
     uint64_t update_id;
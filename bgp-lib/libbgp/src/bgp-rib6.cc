@@ -25,7 +25,7 @@ namespace libbgp {
  * @param attribs Path attributes for this entry.
  */
 BgpRib6Entry::BgpRib6Entry (Prefix6 r, uint32_t src, const uint8_t nexthop_global[16], 
-    const uint8_t nexthop_linklocal[16], const std::vector<std::shared_ptr<BgpPathAttrib>> attribs)
+    const uint8_t nexthop_linklocal[16], const BgpAttribSet &attribs)
     : route(r) {
 
     memcpy(this->nexthop_global, nexthop_global, 16);
@@ -33,6 +33,7 @@ BgpRib6Entry::BgpRib6Entry (Prefix6 r, uint32_t src, const uint8_t nexthop_globa
     else memset(this->nexthop_linklocal, 0, 16);
     src_router_id = src;
     this->attribs = attribs;
+    updateDecisionKey();
 }
 
 /**
@@ -43,6 +44,7 @@ BgpRib6Entry::BgpRib6Entry (Prefix6 r, uint32_t src, const uint8_t nexthop_globa
 BgpRib6::BgpRib6(BgpLogHandler *logger) {
     this->logger = logger;
     update_id = 0;
+    pool = &own_pool;
 }
 
 rib6_t::iterator BgpRib6::find_entry(const Prefix6 &prefix, uint32_t src) {
@@ -80,10 +82,33 @@ rib6_t::iterator BgpRib6::find_best (const Prefix6 &prefix) {
     return best;
 }
 
+/**
+ * @brief Bring the FIB entry of a prefix in sync with the RIB.
+ * 
+ * Must be called after any change to the entries of the prefix, as the FIB
+ * holds pointers to the active entry.
+ * 
+ * @param prefix The prefix.
+ */
+void BgpRib6::updateFib(const Prefix6 &prefix) {
+    std::pair<rib6_t::iterator, rib6_t::iterator> its = 
+        rib.equal_range(BgpRib6EntryKey(prefix));
+
+    const BgpRib6Entry *best = NULL;
+
+    for (rib6_t::iterator it = its.first; it != its.second; it++) {
+        if (it->second.route != prefix || it->second.status != RS_ACTIVE) continue;
+        best = selectEntry(best, &(it->second));
+    }
+
+    if (best == NULL) fib.remove(prefix);
+    else fib.insert(prefix, best);
+}
+
 std::pair<const BgpRib6Entry*, bool> BgpRib6::insertPriv(uint32_t src_router_id, 
     const Prefix6 &route, 
     const uint8_t nexthop_global[16], const uint8_t nexthop_linklocal[16], 
-    const std::vector<std::shared_ptr<BgpPathAttrib>> &attribs, 
+    const BgpAttribSet &attribs, 
     int32_t weight, uint32_t ibgp_asn) {
     std::lock_guard<std::recursive_mutex> lock(mutex);
     BgpRib6Entry new_entry(route, src_router_id, nexthop_global, nexthop_linklocal, attribs);
@@ -152,6 +177,7 @@ std::pair<const BgpRib6Entry*, bool> BgpRib6::insertPriv(uint32_t src_router_id,
     }
 
     if (new_best != NULL) new_best->status = RS_ACTIVE;
+    updateFib(route);
     
     LIBBGP_LOG(logger, INFO) {
         uint8_t prefix_arr[16];
@@ -198,7 +224,7 @@ const BgpRib6Entry* BgpRib6::insert(BgpLogHandler *logger, const Prefix6 &route,
     attribs.push_back(std::shared_ptr<BgpPathAttrib>(origin));
     attribs.push_back(std::shared_ptr<BgpPathAttrib>(as_path));
 
-    BgpRib6Entry new_entry(route, 0, nexthop_global, nexthop_linklocal, attribs);
+    BgpRib6Entry new_entry(route, 0, nexthop_global, nexthop_linklocal, pool->intern(attribs));
     new_entry.weight = weight;
     uint64_t use_update_id = update_id;
 
@@ -221,6 +247,7 @@ const BgpRib6Entry* BgpRib6::insert(BgpLogHandler *logger, const Prefix6 &route,
     new_entry.update_id = use_update_id;
     if (use_update_id == update_id) update_id++;
     rib6_t::const_iterator it = rib.insert(MAKE_ENTRY6(route, new_entry));
+    updateFib(route);
 
     return &(it->second);
 }
@@ -251,16 +278,19 @@ const std::vector<BgpRib6Entry> BgpRib6::insert(BgpLogHandler *logger,
     attribs.push_back(std::shared_ptr<BgpPathAttrib>(origin));
     attribs.push_back(std::shared_ptr<BgpPathAttrib>(as_path));
 
+    BgpAttribSet attrib_set = pool->intern(attribs);
+
     for (const Prefix6 &route : routes) {
         rib6_t::const_iterator it = find_entry(route, 0);
 
         if (it != rib.end()) continue;
 
-        BgpRib6Entry new_entry (route, 0, nexthop_global, nexthop_linklocal, attribs);
+        BgpRib6Entry new_entry (route, 0, nexthop_global, nexthop_linklocal, attrib_set);
         new_entry.update_id = update_id;
         new_entry.weight = weight;
         rib6_t::const_iterator isrt_it = rib.insert(MAKE_ENTRY6(route, new_entry));
         inserted.push_back(isrt_it->second);
+        updateFib(route);
     }
 
     update_id++;
@@ -294,7 +324,7 @@ std::pair<const BgpRib6Entry*, bool> BgpRib6::insert(uint32_t src_router_id,
     uint32_t ibgp_asn) {
 
     update_id++;
-    return insertPriv(src_router_id, route, nexthop_global, nexthop_linklocal, attribs, weight, ibgp_asn);
+    return insertPriv(src_router_id, route, nexthop_global, nexthop_linklocal, pool->intern(attribs), weight, ibgp_asn);
 }
 
 /**
@@ -316,8 +346,9 @@ std::pair<std::vector<BgpRib6Entry>, std::vector<Prefix6>> BgpRib6::insert(
     update_id++;
     std::vector<BgpRib6Entry> updated;
     std::vector<Prefix6> unchanged;
+    BgpAttribSet attrib_set = pool->intern(attribs);
     for (const Prefix6 &route : routes) {
-        std::pair<const BgpRib6Entry*, bool> rslt = insertPriv(src_router_id, route, nexthop_global, nexthop_linklocal, attribs, weight, ibgp_asn);
+        std::pair<const BgpRib6Entry*, bool> rslt = insertPriv(src_router_id, route, nexthop_global, nexthop_linklocal, attrib_set, weight, ibgp_asn);
         if (rslt.first != NULL) {
             if (!rslt.second) updated.push_back(*(rslt.first));
             else unchanged.push_back(route);
@@ -380,6 +411,7 @@ std::pair<bool, const void*> BgpRib6::withdraw(uint32_t src_router_id, const Pre
 
     rib.erase(to_remove);
     if (replacement != NULL) replacement->status = RS_ACTIVE;
+    updateFib(route);
 
     LIBBGP_LOG(logger, INFO) {
         uint8_t prefix_arr[16];
@@ -457,6 +489,7 @@ std::pair<std::vector<Prefix6>, std::vector<BgpRib6Entry>> BgpRib6::discard(uint
             replacement->second.status = RS_ACTIVE;
             replacements.push_back(replacement->second);
         }
+        updateFib(prefix);
 
         LIBBGP_LOG(logger, INFO) {
             uint8_t prefix_arr[16];
@@ -476,22 +509,16 @@ std::pair<std::vector<Prefix6>, std::vector<BgpRib6Entry>> BgpRib6::discard(uint
 /**
  * @brief Lookup a destination in RIB.
  * 
+ * The lookup is done on the FIB, which holds the active entries of the RIB in
+ * a trie, so its cost depends on the prefix lengths and not on the RIB size.
+ * 
  * @param dest The destination address.
  * @return const BgpRib6::BgpRib6Entry* Matching entry.
  * @retval NULL no match found.
  * @retval BgpRib6Entry* Matching entry.
  */
 const BgpRib6Entry* BgpRib6::lookup(const uint8_t dest[16]) const {
-    const BgpRib6Entry *selected_entry = NULL;
-
-    for (const auto &entry : rib) {
-        if (entry.second.status != RS_ACTIVE) continue;
-        const Prefix6 &route = entry.second.route;
-        if (route.includes(dest)) 
-            selected_entry = selectEntry(&entry.second, selected_entry);
-    }
-
-    return selected_entry;
+    return fib.lookup(dest);
 }
 
 /**
@@ -529,4 +556,46 @@ const rib6_t& BgpRib6::get() const {
     return rib;
 }
 
+/**
+ * @brief Get the FIB.
+ * 
+ * @return const BgpFib6& The FIB (best entry of each prefix).
+ */
+const BgpFib6& BgpRib6::getFib() const {
+    return fib;
+}
+
+/**
+ * @brief Share an attribute intern table with other RIBs.
+ * 
+ * By default, every RIB has its own table. Sharing one between the RIBs of
+ * many speakers (e.g., in a simulation) stores identical path attributes once.
+ * Entries already in the RIB keep their sets. The pool must outlive this RIB,
+ * but the sets it gave out may outlive it.
+ * 
+ * @param pool The table, or NULL to use our own table again.
+ */
+void BgpRib6::setAttribPool(BgpAttribPool *pool) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    this->pool = pool == NULL ? &own_pool : pool;
+}
+
+/**
+ * @brief Get the attribute intern table used by this RIB.
+ * 
+ * @return const BgpAttribPool& The table.
+ */
+const BgpAttribPool& BgpRib6::getAttribPool() const {
+    return *pool;
+}
+
+/**
+ * @brief Get the attribute intern table used by this RIB.
+ * 
+ * @return BgpAttribPool& The table.
+ */
+BgpAttribPool& BgpRib6::getAttribPool() {
+    return *pool;
+}
+
 }
\ No newline at end of file
@@ -17,6 +17,7 @@
 #include <memory>
 #include <mutex>
 #include "bgp-rib.h"
+#include "bgp-fib6.h"
 #include "prefix6.h"
 #include "bgp-path-attrib.h"
 #include "route-event-bus.h"
@@ -67,7 +68,7 @@ class BgpRib6Entry : public BgpRibEntry<BgpRib6Entry> {
 public:
     BgpRib6Entry (Prefix6 r, uint32_t src, const uint8_t nexthop_global[16], 
         const uint8_t nexthop_linklocal[16], 
-        const std::vector<std::shared_ptr<BgpPathAttrib>> attribs);
+        const BgpAttribSet &attribs);
 
     /**
      * @brief The prefix of this entry.
@@ -141,6 +142,16 @@ public:
 
     // get RIB
     const rib6_t &get() const;
+
+    // get FIB
+    const BgpFib6 &getFib() const;
+
+    // share the attribute intern table with other RIBs. (NULL to use our own)
+    void setAttribPool(BgpAttribPool *pool);
+
+    // get the attribute intern table.
+    const BgpAttribPool &getAttribPool() const;
+    BgpAttribPool &getAttribPool();
 private:
     rib6_t::iterator find_best (const Prefix6 &prefix);
     rib6_t::iterator find_entry (const Prefix6 &prefix, uint32_t src);
@@ -148,10 +159,15 @@ private:
     std::pair<const BgpRib6Entry*, bool> insertPriv(uint32_t src_router_id, 
         const Prefix6 &route, 
         const uint8_t nexthop_global[16], const uint8_t nexthop_linklocal[16], 
-        const std::vector<std::shared_ptr<BgpPathAttrib>> &attrib, 
+        const BgpAttribSet &attrib, 
         int32_t weight, uint32_t ibgp_asn);
 
+    void updateFib(const Prefix6 &prefix);
+
+    BgpAttribPool own_pool;
+    BgpAttribPool *pool;
     rib6_t rib;
+    BgpFib6 fib;
     std::recursive_mutex mutex;
     BgpLogHandler *logger;
     uint64_t update_id;
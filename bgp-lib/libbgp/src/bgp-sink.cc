@@ -14,6 +14,12 @@
 #include <arpa/inet.h>
 #define BGP_SINK_DEFAULT_BUFSZ 65536
 
+#ifdef LIBBGP_SINK_NO_LOCKING
+#define BGP_SINK_LOCK()
+#else
+#define BGP_SINK_LOCK() std::lock_guard<std::recursive_mutex> lock(mutex)
+#endif
+
 namespace libbgp {
 
 /**
@@ -27,6 +33,8 @@ BgpSink::BgpSink(bool use_4b_asn) {
     this->use_4b_asn = use_4b_asn;
     this->logger = NULL;
     offset_start = offset_end = 0;
+    borrowed = NULL;
+    borrowed_start = borrowed_end = 0;
 }
 
 /**
@@ -48,7 +56,7 @@ BgpSink::~BgpSink() {
  * @retval >=0 Bytes consumed.
  */
 ssize_t BgpSink::fill(const uint8_t *buffer, size_t len) {
-    std::lock_guard<std::recursive_mutex> lock(mutex);
+    BGP_SINK_LOCK();
 
     // expand if too small
     while (len > buffer_size) expand();
@@ -65,6 +73,66 @@ ssize_t BgpSink::fill(const uint8_t *buffer, size_t len) {
     return len;
 }
 
+/**
+ * @brief Lend a buffer to the sink.
+ * 
+ * Complete packets are parsed from the buffer itself by pour(), without being
+ * copied into the sink. If the sink holds an incomplete packet, only the bytes
+ * needed to complete it are copied. The buffer must stay valid until 
+ * release() is called, which copies what is left of it (an incomplete packet)
+ * into the sink. If a buffer is already lent, it is released first.
+ * 
+ * @param buffer The pointer to data buffer.
+ * @param len The length of data.
+ * @return ssize_t Bytes consumed.
+ * @retval -1 Failed to fill sink. error may be written to stderr with log
+ * handler.
+ * @retval >=0 Bytes consumed.
+ */
+ssize_t BgpSink::fillBorrowed(const uint8_t *buffer, size_t len) {
+    BGP_SINK_LOCK();
+
+    if (borrowed != NULL) release();
+
+    size_t copied = 0;
+    size_t missing;
+
+    // complete the packet left in sink buffer.
+    while (copied < len && (missing = getMissingBytes()) > 0) {
+        size_t n = missing < len - copied ? missing : len - copied;
+        if (fill(buffer + copied, n) != (ssize_t) n) return -1;
+        copied += n;
+    }
+
+    if (copied < len) {
+        borrowed = buffer;
+        borrowed_start = copied;
+        borrowed_end = len;
+    }
+
+    return len;
+}
+
+/**
+ * @brief Stop borrowing the buffer lent by fillBorrowed().
+ * 
+ * Data not poured yet is copied into the sink.
+ * 
+ */
+void BgpSink::release() {
+    BGP_SINK_LOCK();
+
+    if (borrowed == NULL) return;
+
+    const uint8_t *left = borrowed + borrowed_start;
+    size_t left_len = borrowed_end - borrowed_start;
+
+    borrowed = NULL;
+    borrowed_start = borrowed_end = 0;
+
+    if (left_len > 0) fill(left, left_len);
+}
+
 /**
  * @brief Pour BGP packet out from sink.
  * 
@@ -81,11 +149,27 @@ ssize_t BgpSink::fill(const uint8_t *buffer, size_t len) {
  * @throws "bad_packet" Parsed packet length mismatch.
  */
 ssize_t BgpSink::pour(BgpPacket **pkt) {
-    std::lock_guard<std::recursive_mutex> lock(mutex);
+    BGP_SINK_LOCK();
+
+    size_t consumed = 0;
+    ssize_t ret;
+
+    // packets in sink buffer arrived before the borrowed ones.
+    if (offset_end > offset_start) {
+        ret = pourFrom(this->buffer + offset_start, offset_end - offset_start, pkt, consumed);
+        offset_start += consumed;
+        return ret;
+    }
+
+    if (borrowed == NULL) return 0;
 
-    uint8_t *cur = this->buffer + offset_start;
+    ret = pourFrom(borrowed + borrowed_start, borrowed_end - borrowed_start, pkt, consumed);
+    borrowed_start += consumed;
+    return ret;
+}
 
-    if (offset_end - offset_start < 19) return 0;
+ssize_t BgpSink::pourFrom(const uint8_t *cur, size_t len, BgpPacket **pkt, size_t &consumed) {
+    if (len < 19) return 0;
     if (memcmp(cur, "\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff", 16) != 0) {
         if (logger) logger->log(ERROR, "BgpSink::pour: invalid BGP marker.\n");
         return -2;
@@ -98,10 +182,9 @@ ssize_t BgpSink::pour(BgpPacket **pkt) {
         return -2;
     }
 
-    ssize_t bytes = getBytesInSink();
-    if (field_len > bytes) return 0; // incomplete packet, wait for more.
+    if (field_len > len) return 0; // incomplete packet, wait for more.
 
-    offset_start += field_len;
+    consumed = field_len;
 
     BgpPacket *new_pkt = new BgpPacket(logger, use_4b_asn);
     ssize_t par_ret = new_pkt->parse(cur, field_len);
@@ -117,14 +200,34 @@ ssize_t BgpSink::pour(BgpPacket **pkt) {
 
 void BgpSink::settle() {
     if (offset_start > 0) {
-        if (offset_start == offset_end) offset_start = offset_end = 0;
-        else memmove(buffer, buffer + offset_start, offset_end - offset_start);
+        if (offset_start != offset_end) memmove(buffer, buffer + offset_start, offset_end - offset_start);
+        offset_end -= offset_start;
+        offset_start = 0;
     }
 }
 
+size_t BgpSink::getMissingBytes() const {
+    size_t offset = offset_start;
+
+    while (offset < offset_end) {
+        size_t left = offset_end - offset;
+        if (left < 19) return 19 - left;
+
+        uint16_t field_len = ntohs(*(uint16_t *) (buffer + offset + 16));
+
+        // broken packet, let pour() report it.
+        if (field_len < 19 || field_len > 4096) return 0;
+
+        if (left < field_len) return field_len - left;
+        offset += field_len;
+    }
+
+    return 0;
+}
+
 void BgpSink::expand() {
     size_t new_buf_sz = buffer_size * 2;
-    size_t content_sz = getBytesInSink();
+    size_t content_sz = offset_end - offset_start;
     uint8_t *new_buffer = (uint8_t *) malloc(new_buf_sz);
     memcpy(new_buffer, buffer + offset_start, content_sz);
     free(buffer);
@@ -140,8 +243,10 @@ void BgpSink::expand() {
  * 
  */
 void BgpSink::drain() {
-    std::lock_guard<std::recursive_mutex> lock(mutex);
+    BGP_SINK_LOCK();
     offset_end = offset_start = 0;
+    borrowed = NULL;
+    borrowed_start = borrowed_end = 0;
 }
 
 /**
@@ -150,7 +255,7 @@ void BgpSink::drain() {
  * @return size_t Data size in bytes.
  */
 size_t BgpSink::getBytesInSink() const {
-    return offset_end - offset_start;
+    return offset_end - offset_start + borrowed_end - borrowed_start;
 }
 
 /**
@@ -25,6 +25,14 @@ namespace libbgp {
  * fill the sink (buffer) and allows users to get full BGP packet from the sink
  * (buffer). This is useful since BGP uses TCP, and TCP streams the data. (so we
  * might not get a full BGP packet in buffer every time)
+ * 
+ * Data can also be lent to the sink with fillBorrowed(): complete packets are
+ * then parsed in place from the caller's buffer, and only an incomplete packet
+ * at the end of it is copied into the sink by release().
+ * 
+ * Define LIBBGP_SINK_NO_LOCKING when building libbgp (configure with 
+ * --disable-sink-locking) to drop the locking, for single-threaded users like
+ * simulators.
  */
 class BgpSink {
 public:
@@ -34,6 +42,12 @@ public:
     // feed stream of packets into sink
     ssize_t fill(const uint8_t *buffer, size_t len);
 
+    // lend a buffer to the sink, buffer must stay valid until release()
+    ssize_t fillBorrowed(const uint8_t *buffer, size_t len);
+
+    // copy what is left of the borrowed buffer into the sink
+    void release();
+
     // get a pointer to next packet from sink (might chane if fill())
     //BufferPtr pourPtr();
 
@@ -71,10 +85,19 @@ private:
     // exapnd the sink
     void expand();
 
+    // bytes the sink needs to complete the last packet in sink buffer
+    size_t getMissingBytes() const;
+
+    // parse a packet from cur, set consumed to the length of the packet
+    ssize_t pourFrom(const uint8_t *cur, size_t len, BgpPacket **pkt, size_t &consumed);
+
     uint8_t *buffer;
     size_t buffer_size;
     size_t offset_start;
     size_t offset_end;
+    const uint8_t *borrowed;
+    size_t borrowed_start;
+    size_t borrowed_end;
     bool use_4b_asn;
     std::recursive_mutex mutex;
     BgpLogHandler *logger;
@@ -0,0 +1,150 @@
+/**
+ * @file bgp-convergence-detector.cc
+ * @author Nato Morichika <nat@nat.moe>
+ * @brief Network-wide BGP convergence detector.
+ * @version 0.1
+ * @date 2020-02-02
+ * 
+ * @copyright Copyright (c) 2020
+ * 
+ */
+#include "bgp-convergence-detector.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/trace-source-accessor.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("BgpConvergenceDetector");
+NS_OBJECT_ENSURE_REGISTERED(BgpConvergenceDetector);
+
+TypeId BgpConvergenceDetector::GetTypeId(void) {
+    static TypeId tid = TypeId("ns3::BgpConvergenceDetector")
+        .SetParent<Object>()
+        .SetGroupName("Internet")
+        .AddConstructor<BgpConvergenceDetector>()
+        .AddAttribute("QuietTime", "Time without RIB change after which the network is converged.",
+            TimeValue(Seconds(30)),
+            MakeTimeAccessor(&BgpConvergenceDetector::_quiet_time),
+            MakeTimeChecker(Seconds(0)))
+        .AddTraceSource("Converged", "The network converged after a topology change.",
+            MakeTraceSourceAccessor(&BgpConvergenceDetector::_converged_trace),
+            "ns3::BgpConvergenceDetector::ConvergedTracedCallback");
+
+    return tid;
+}
+
+BgpConvergenceDetector::BgpConvergenceDetector() {
+    _measuring = false;
+    _changes = 0;
+    _convergence_count = 0;
+}
+
+/**
+ * @brief Watch the RIB and topology changes of a Bgp application.
+ * 
+ * @param bgp The application.
+ */
+void BgpConvergenceDetector::Add(Ptr<Bgp> bgp) {
+    bgp->TraceConnectWithoutContext("BestPathChange", MakeCallback(&BgpConvergenceDetector::HandleBestPathChange, this));
+    bgp->TraceConnectWithoutContext("PeersChange", MakeCallback(&BgpConvergenceDetector::HandlePeersChange, this));
+}
+
+/**
+ * @brief Watch the Bgp applications of a container. Other applications are
+ * ignored.
+ * 
+ * @param apps The applications.
+ */
+void BgpConvergenceDetector::Add(ApplicationContainer apps) {
+    for (ApplicationContainer::Iterator app = apps.Begin(); app != apps.End(); app++) {
+        Ptr<Bgp> bgp = DynamicCast<Bgp>(*app);
+        if (bgp != nullptr) Add(bgp);
+    }
+}
+
+/**
+ * @brief Start measuring from a topology change now.
+ * 
+ * Changes of the topology made in other ways than Bgp::UpdatePeers and 
+ * Bgp::DeletePeer (e.g. links going down) should be notified here. Changes 
+ * notified at the same time are one change.
+ * 
+ */
+void BgpConvergenceDetector::NotifyTopologyChange(void) {
+    if (_measuring && _event_time == Simulator::Now()) return;
+
+    if (_measuring) {
+        NS_LOG_INFO("topology changed at " << Simulator::Now().GetSeconds() << "s before convergence of the change at " << _event_time.GetSeconds() << "s.");
+    }
+
+    Start();
+}
+
+/**
+ * @brief Check if the network is converged.
+ * 
+ * @return true No measurement running.
+ * @return false Waiting for the RIBs to stop changing.
+ */
+bool BgpConvergenceDetector::IsConverged(void) const {
+    return !_measuring;
+}
+
+/**
+ * @brief Get the last convergence time measured.
+ * 
+ * @return Time Convergence time.
+ */
+Time BgpConvergenceDetector::GetLastConvergenceTime(void) const {
+    return _last_convergence_time;
+}
+
+/**
+ * @brief Get number of convergences measured.
+ * 
+ * @return uint32_t Number of convergences.
+ */
+uint32_t BgpConvergenceDetector::GetConvergenceCount(void) const {
+    return _convergence_count;
+}
+
+void BgpConvergenceDetector::HandleBestPathChange(uint32_t changed4, uint32_t changed6) {
+    if (!_measuring) Start();
+
+    _last_change = Simulator::Now();
+    _changes += changed4 + changed6;
+}
+
+void BgpConvergenceDetector::HandlePeersChange(uint32_t added, uint32_t removed) {
+    NotifyTopologyChange();
+}
+
+void BgpConvergenceDetector::Start(void) {
+    _measuring = true;
+    _event_time = _last_change = Simulator::Now();
+    _changes = 0;
+
+    _check.Cancel();
+    _check = Simulator::Schedule(_quiet_time, &BgpConvergenceDetector::Check, this);
+}
+
+void BgpConvergenceDetector::Check(void) {
+    Time quiet_until = _last_change + _quiet_time;
+
+    // changed since scheduled, check again at the end of the quiet time.
+    if (quiet_until > Simulator::Now()) {
+        _check = Simulator::Schedule(quiet_until - Simulator::Now(), &BgpConvergenceDetector::Check, this);
+        return;
+    }
+
+    _measuring = false;
+    _last_convergence_time = _last_change - _event_time;
+    _convergence_count++;
+
+    NS_LOG_INFO("converged: topology change at " << _event_time.GetSeconds() << "s, last RIB change at " << _last_change.GetSeconds() << "s, " << _changes << " prefixes changed.");
+
+    _converged_trace(_event_time, _last_convergence_time, _changes);
+}
+
+}
@@ -0,0 +1,81 @@
+/**
+ * @file bgp-convergence-detector.h
+ * @author Nato Morichika <nat@nat.moe>
+ * @brief Network-wide BGP convergence detector.
+ * @version 0.1
+ * @date 2020-02-02
+ * 
+ * @copyright Copyright (c) 2020
+ * 
+ */
+#ifndef BGP_CONVERGENCE_DETECTOR_H
+#define BGP_CONVERGENCE_DETECTOR_H
+#include "bgp.h"
+#include "ns3/object.h"
+#include "ns3/event-id.h"
+#include "ns3/nstime.h"
+#include "ns3/traced-callback.h"
+#include "ns3/application-container.h"
+
+namespace ns3 {
+
+/**
+ * @brief Network-wide BGP convergence detector.
+ * 
+ * Watches the RIBs of a set of Bgp applications. After a topology change 
+ * (peers added or removed on any of the applications), the network is 
+ * considered converged once no RIB has changed for QuietTime. The convergence
+ * time is then the time from the topology change to the last RIB change.
+ * RIB changes not following a topology change (e.g. the initial convergence)
+ * are measured from the first change.
+ * 
+ * Only one timer event is pending at a time, whatever the number of RIB 
+ * changes. The detector must outlive the simulation of the applications it
+ * watches.
+ * 
+ */
+class BgpConvergenceDetector : public Object {
+public:
+    static TypeId GetTypeId(void);
+    BgpConvergenceDetector();
+
+    void Add(Ptr<Bgp> bgp);
+    void Add(ApplicationContainer apps);
+    void NotifyTopologyChange(void);
+
+    bool IsConverged(void) const;
+    Time GetLastConvergenceTime(void) const;
+    uint32_t GetConvergenceCount(void) const;
+
+    /**
+     * @brief TracedCallback signature for convergence.
+     * 
+     * @param event Time of the topology change.
+     * @param convergence_time Time from the change to the last RIB change.
+     * @param changes Number of prefixes changed in all RIBs meanwhile.
+     */
+    typedef void (* ConvergedTracedCallback)(Time event, Time convergence_time, uint64_t changes);
+
+private:
+    void HandleBestPathChange(uint32_t changed4, uint32_t changed6);
+    void HandlePeersChange(uint32_t added, uint32_t removed);
+    void Start(void);
+    void Check(void);
+
+    Time _quiet_time;
+
+    bool _measuring;
+    Time _event_time;
+    Time _last_change;
+    uint64_t _changes;
+    EventId _check;
+
+    Time _last_convergence_time;
+    uint32_t _convergence_count;
+
+    TracedCallback<Time, Time, uint64_t> _converged_trace;
+};
+
+}
+
+#endif // BGP_CONVERGENCE_DETECTOR_H
@@ -0,0 +1,67 @@
+/**
+ * @file bgp-ns3-route-observer.cc
+ * @author Nato Morichika <nat@nat.moe>
+ * @brief Route event bus receiver reporting RIB changes to ns3.
+ * @version 0.1
+ * @date 2020-02-02
+ * 
+ * @copyright Copyright (c) 2020
+ * 
+ */
+#include "bgp-ns3-route-observer.h"
+#include <libbgp/bgp-rib4.h>
+#include <libbgp/bgp-rib6.h>
+
+namespace ns3 {
+
+/**
+ * @brief Construct the receiver.
+ * 
+ * @param change_cb Callback to notify RIB changes, with the number of IPv4 and
+ * IPv6 prefixes changed.
+ */
+BgpNs3RouteObserver::BgpNs3RouteObserver(Callback<void, uint32_t, uint32_t> change_cb) {
+    _change_cb = change_cb;
+}
+
+/**
+ * @brief Count the prefixes changed by a route event.
+ * 
+ * @param ev The event.
+ * @return false Always, the event is only observed.
+ */
+bool BgpNs3RouteObserver::handleRouteEvent(const libbgp::RouteEvent &ev) {
+    uint32_t changed4 = 0, changed6 = 0;
+
+    switch (ev.type) {
+        case libbgp::ADD4: {
+            const libbgp::Route4AddEvent &add = dynamic_cast<const libbgp::Route4AddEvent &>(ev);
+            if (add.new_routes != NULL) changed4 += add.new_routes->size();
+            if (add.replaced_entries != NULL) changed4 += add.replaced_entries->size();
+            break;
+        }
+        case libbgp::WITHDRAW4: {
+            const libbgp::Route4WithdrawEvent &withdraw = dynamic_cast<const libbgp::Route4WithdrawEvent &>(ev);
+            if (withdraw.routes != NULL) changed4 += withdraw.routes->size();
+            break;
+        }
+        case libbgp::ADD6: {
+            const libbgp::Route6AddEvent &add = dynamic_cast<const libbgp::Route6AddEvent &>(ev);
+            if (add.new_routes != NULL) changed6 += add.new_routes->size();
+            if (add.replaced_entries != NULL) changed6 += add.replaced_entries->size();
+            break;
+        }
+        case libbgp::WITHDRAW6: {
+            const libbgp::Route6WithdrawEvent &withdraw = dynamic_cast<const libbgp::Route6WithdrawEvent &>(ev);
+            if (withdraw.routes != NULL) changed6 += withdraw.routes->size();
+            break;
+        }
+        default: return false;
+    }
+
+    if ((changed4 > 0 || changed6 > 0) && !_change_cb.IsNull()) _change_cb(changed4, changed6);
+
+    return false;
+}
+
+}
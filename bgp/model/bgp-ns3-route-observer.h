@@ -0,0 +1,41 @@
+/**
+ * @file bgp-ns3-route-observer.h
+ * @author Nato Morichika <nat@nat.moe>
+ * @brief Route event bus receiver reporting RIB changes to ns3.
+ * @version 0.1
+ * @date 2020-02-02
+ * 
+ * @copyright Copyright (c) 2020
+ * 
+ */
+#ifndef BGP_NS3_ROUTE_OBSERVER_H
+#define BGP_NS3_ROUTE_OBSERVER_H
+#include <libbgp/route-event-receiver.h>
+#include <libbgp/route-event.h>
+#include "ns3/callback.h"
+
+namespace ns3 {
+
+/**
+ * @brief Route event bus receiver reporting RIB changes to ns3.
+ * 
+ * Every best path change of the RIB is published on the route event bus by
+ * the FSMs. This receiver counts the prefixes in those events and passes the 
+ * counts to a callback. It never handles the events, so it does not interfere
+ * with the FSMs. (e.g. collision detection)
+ * 
+ */
+class BgpNs3RouteObserver : public libbgp::RouteEventReceiver {
+public:
+    BgpNs3RouteObserver(Callback<void, uint32_t, uint32_t> change_cb);
+
+protected:
+    bool handleRouteEvent(const libbgp::RouteEvent &ev);
+
+private:
+    Callback<void, uint32_t, uint32_t> _change_cb;
+};
+
+}
+
+#endif // BGP_NS3_ROUTE_OBSERVER_H
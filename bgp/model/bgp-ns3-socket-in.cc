@@ -17,25 +17,43 @@ namespace ns3 {
  * @brief Construct the container.
  * 
  * @param fsm FSM to use.
+ * @param read_cb Callback to notify that the FSM has run on received data.
  */
-BgpNs3SocketIn::BgpNs3SocketIn(Ptr<BgpNs3Fsm> fsm) {
+BgpNs3SocketIn::BgpNs3SocketIn(Ptr<BgpNs3Fsm> fsm, Callback<void, Ptr<Socket>> read_cb) {
     _fsm = fsm;
+    _read_cb = read_cb;
 }
 
 /**
  * @brief Handle reading from socket.
  * 
+ * All data available on the socket is read. The data of each packet is copied
+ * once into the receive buffer (ns3 packets do not expose their bytes), the 
+ * FSM then parses the complete BGP messages from there without copying them 
+ * again into its sink.
+ * 
  * @param socket socket to read from.
  */
 void BgpNs3SocketIn::HandleRead(Ptr<Socket> socket) {
-    int sz = socket->Recv(_recv_buffer, 65535, 0);
+    Ptr<Packet> packet = socket->Recv();
 
-    if (sz <= 0) {
+    if (packet == nullptr || packet->GetSize() == 0) {
         _fsm->resetHard(); 
+        if (!_read_cb.IsNull()) _read_cb(socket);
         return;
     }
 
-    _fsm->run(_recv_buffer, sz);
+    while (packet != nullptr && packet->GetSize() > 0) {
+        uint32_t sz = packet->GetSize();
+        if (_recv_buffer.size() < sz) _recv_buffer.resize(sz);
+
+        packet->CopyData(_recv_buffer.data(), sz);
+        _fsm->run(_recv_buffer.data(), sz);
+
+        packet = socket->Recv();
+    }
+
+    if (!_read_cb.IsNull()) _read_cb(socket);
 }
 
 }
\ No newline at end of file
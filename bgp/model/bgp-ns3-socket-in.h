@@ -10,10 +10,13 @@
  */
 #ifndef BGP_NS3_SOCKET_IN_H
 #define BGP_NS3_SOCKET_IN_H
+#include <vector>
 #include "bgp.h"
 #include "ns3/ptr.h"
 #include "ns3/simple-ref-count.h"
 #include "ns3/socket.h"
+#include "ns3/packet.h"
+#include "ns3/callback.h"
 
 namespace ns3 {
 
@@ -23,12 +26,13 @@ namespace ns3 {
  */
 class BgpNs3SocketIn : public SimpleRefCount<BgpNs3SocketIn> {
 public:
-    BgpNs3SocketIn(Ptr<BgpNs3Fsm> fsm);
+    BgpNs3SocketIn(Ptr<BgpNs3Fsm> fsm, Callback<void, Ptr<Socket>> read_cb);
     void HandleRead(Ptr<Socket> socket);
 
 private:
     Ptr<BgpNs3Fsm> _fsm;
-    uint8_t _recv_buffer[65535];
+    Callback<void, Ptr<Socket>> _read_cb;
+    std::vector<uint8_t> _recv_buffer;
 };
 
 }
@@ -13,6 +13,7 @@
 #include "ns3/log.h"
 #include "ns3/node.h"
 #include "ns3/simulator.h"
+#include "ns3/trace-source-accessor.h"
 
 namespace ns3 {
 
@@ -22,17 +23,48 @@ NS_OBJECT_ENSURE_REGISTERED(BgpRouting);
 BgpRouting::BgpRouting() {
     _ipv4 = nullptr;
     _rib = nullptr;
+    _lookup_misses = 0;
 }
 
 TypeId BgpRouting::GetTypeId (void) {
     static TypeId tid = TypeId ("ns3::BgpRouting")
         .SetParent<Ipv4RoutingProtocol>()
         .SetGroupName ("Internet")
-        .AddConstructor<BgpRouting>();
+        .AddConstructor<BgpRouting>()
+        .AddTraceSource("LookupMiss", "A destination was not found in the RIB.",
+            MakeTraceSourceAccessor(&BgpRouting::_lookup_miss_trace),
+            "ns3::BgpRouting::LookupMissTracedCallback");
 
     return tid;
 }
 
+/**
+ * @brief Lookup a destination in the RIB to route a packet, and count misses.
+ * 
+ * @param dst Destination.
+ * @return const libbgp::BgpRib4Entry* Matching entry.
+ * @retval nullptr no matching entry.
+ */
+const libbgp::BgpRib4Entry* BgpRouting::Lookup(const Ipv4Address &dst) {
+    const libbgp::BgpRib4Entry *rslt = _rib->lookup(htonl(dst.Get()));
+
+    if (rslt == nullptr) {
+        _lookup_misses++;
+        _lookup_miss_trace(dst);
+    }
+
+    return rslt;
+}
+
+/**
+ * @brief Get number of destinations not found in the RIB.
+ * 
+ * @return uint64_t Number of misses.
+ */
+uint64_t BgpRouting::GetLookupMisses(void) const {
+    return _lookup_misses;
+}
+
 Ptr<Ipv4Route> BgpRouting::RouteOutput (Ptr<Packet> p, const Ipv4Header &header, 
     Ptr<NetDevice> oif, Socket::SocketErrno &sockerr) {
     NS_ASSERT(_ipv4 != nullptr);
@@ -45,7 +77,7 @@ Ptr<Ipv4Route> BgpRouting::RouteOutput (Ptr<Packet> p, const Ipv4Header &header,
 
     NS_LOG_DEBUG("looking for destination " << dst << " in rib.");
 
-    const libbgp::BgpRib4Entry *rslt = _rib->lookup(htonl(dst.Get()));
+    const libbgp::BgpRib4Entry *rslt = Lookup(dst);
 
     if (rslt == nullptr) {
         NS_LOG_INFO("no matching entry in rib for destination " << dst << ".");
@@ -97,7 +129,7 @@ bool BgpRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header, Ptr<
         return true;
     }
 
-    const libbgp::BgpRib4Entry *rslt = _rib->lookup(htonl(dst.Get()));
+    const libbgp::BgpRib4Entry *rslt = Lookup(dst);
 
     if (rslt == nullptr) {
         NS_LOG_INFO("no matching entry in rib for destination " << dst << ".");
@@ -143,6 +175,7 @@ bool BgpRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header, Ptr<
 
 
 Ipv4Address BgpRouting::LookupAsnGateway (Ipv4Address dst) {
+	// not a routing decision, so not counted as a miss.
 	const libbgp::BgpRib4Entry *rslt = _rib->lookup(htonl(dst.Get()));
 
 	if (rslt == nullptr) {
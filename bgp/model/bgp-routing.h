@@ -13,6 +13,7 @@
 
 #include <libbgp/bgp-rib4.h>
 #include "ns3/ipv4-routing-protocol.h"
+#include "ns3/traced-callback.h"
 
 namespace ns3 {
 
@@ -45,9 +46,21 @@ public:
 
     Ptr<NetDevice> GetDeviceByNexthop(const Ipv4Address &nexthop) const;
     Ipv4InterfaceAddress GetAddressByNexthop(const Ipv4Address &nexthop) const;
+    uint64_t GetLookupMisses(void) const;
+
+    /**
+     * @brief TracedCallback signature for lookup misses.
+     * 
+     * @param dst Destination not found in the RIB.
+     */
+    typedef void (* LookupMissTracedCallback)(Ipv4Address dst);
 
 private:
+    const libbgp::BgpRib4Entry* Lookup(const Ipv4Address &dst);
+
     const libbgp::BgpRib4 *_rib;
+    uint64_t _lookup_misses;
+    TracedCallback<Ipv4Address> _lookup_miss_trace;
     Ptr<Ipv4> _ipv4;
 };
 
@@ -0,0 +1,274 @@
+/**
+ * @file bgp-routing6.cc
+ * @author Nato Morichika <nat@nat.moe>
+ * @brief ns3 BGP module: routing protocol (Ipv6RoutingProtocol)
+ * @version 0.1
+ * @date 2019-07-13
+ * 
+ * @copyright Copyright (c) 2019
+ * 
+ */
+#include <arpa/inet.h>
+#include <string.h>
+#include "bgp-routing6.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/ipv6.h"
+#include "ns3/ipv6-route.h"
+#include "ns3/log.h"
+#include "ns3/node.h"
+#include "ns3/simulator.h"
+#include "ns3/trace-source-accessor.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("BgpRouting6");
+NS_OBJECT_ENSURE_REGISTERED(BgpRouting6);
+
+BgpRouting6::BgpRouting6() {
+    _ipv6 = nullptr;
+    _rib = nullptr;
+    _lookup_misses = 0;
+}
+
+TypeId BgpRouting6::GetTypeId (void) {
+    static TypeId tid = TypeId ("ns3::BgpRouting6")
+        .SetParent<Ipv6RoutingProtocol>()
+        .SetGroupName ("Internet")
+        .AddConstructor<BgpRouting6>()
+        .AddTraceSource("LookupMiss", "A destination was not found in the RIB.",
+            MakeTraceSourceAccessor(&BgpRouting6::_lookup_miss_trace),
+            "ns3::BgpRouting6::LookupMissTracedCallback");
+
+    return tid;
+}
+
+/**
+ * @brief Lookup a destination in the RIB.
+ * 
+ * @param dst Destination.
+ * @return const libbgp::BgpRib6Entry* Matching entry.
+ * @retval nullptr no matching entry, or no RIB set.
+ */
+const libbgp::BgpRib6Entry* BgpRouting6::Find(const Ipv6Address &dst) const {
+    if (_rib == nullptr) return nullptr;
+
+    uint8_t dst_bytes[16];
+    dst.GetBytes(dst_bytes);
+
+    return _rib->lookup(dst_bytes);
+}
+
+/**
+ * @brief Lookup a destination in the RIB to route a packet, and count misses.
+ * 
+ * @param dst Destination.
+ * @return const libbgp::BgpRib6Entry* Matching entry.
+ * @retval nullptr no matching entry, or no RIB set.
+ */
+const libbgp::BgpRib6Entry* BgpRouting6::Lookup(const Ipv6Address &dst) {
+    const libbgp::BgpRib6Entry *rslt = Find(dst);
+
+    if (rslt == nullptr) {
+        _lookup_misses++;
+        _lookup_miss_trace(dst);
+    }
+
+    return rslt;
+}
+
+/**
+ * @brief Get number of destinations not found in the RIB.
+ * 
+ * @return uint64_t Number of misses.
+ */
+uint64_t BgpRouting6::GetLookupMisses(void) const {
+    return _lookup_misses;
+}
+
+Ptr<Ipv6Route> BgpRouting6::RouteOutput (Ptr<Packet> p, const Ipv6Header &header,
+    Ptr<NetDevice> oif, Socket::SocketErrno &sockerr) {
+    NS_ASSERT(_ipv6 != nullptr);
+    Ipv6Address dst = header.GetDestination();
+
+    if (dst.IsMulticast()) {
+        NS_LOG_INFO("multicast destination " << dst << " not supported by BgpRouting6.");
+        return nullptr;
+    }
+
+    NS_LOG_DEBUG("looking for destination " << dst << " in rib.");
+
+    const libbgp::BgpRib6Entry *rslt = Lookup(dst);
+
+    if (rslt == nullptr) {
+        NS_LOG_INFO("no matching entry in rib for destination " << dst << ".");
+        return nullptr;
+    }
+
+    uint8_t nexthop[16];
+    memcpy(nexthop, rslt->nexthop_global, 16);
+    Ipv6Address gateway (nexthop);
+
+    // oif not bonded, we need to find it ourself.
+    Ptr<NetDevice> dev = (oif == nullptr) ? GetDeviceByNexthop(gateway) : oif;
+
+    if (dev == nullptr) {
+        NS_LOG_WARN("no device found for nexthop " << gateway << ", and not bonded.");
+        return nullptr;
+    }
+
+    Ptr<Ipv6Route> route = Create<Ipv6Route>();
+    route->SetDestination(dst);
+    route->SetGateway(gateway);
+    route->SetOutputDevice(dev);
+
+    Ipv6Address source = header.GetSource();
+    if (source.IsAny()) source = _ipv6->SourceAddressSelection(_ipv6->GetInterfaceForDevice(dev), gateway);
+    route->SetSource(source);
+
+    return route;
+}
+
+bool BgpRouting6::RouteInput (Ptr<const Packet> p, const Ipv6Header &header, Ptr<const NetDevice> idev,
+    UnicastForwardCallback ucb, MulticastForwardCallback mcb, LocalDeliverCallback lcb,
+    ErrorCallback ecb) {
+    NS_ASSERT(_ipv6 != nullptr);
+    NS_ASSERT(_ipv6->GetInterfaceForDevice (idev) >= 0);
+
+    Ipv6Address dst = header.GetDestination();
+    uint32_t iface = _ipv6->GetInterfaceForDevice(idev);
+
+    // we don't do multicast
+    if (dst.IsMulticast()) {
+        NS_LOG_LOGIC("ignoring multicast destination " << dst << " .");
+        return false;
+    }
+
+    // to local?
+    if (_ipv6->GetInterfaceForAddress(dst) >= 0) {
+        NS_LOG_LOGIC("destination " << dst << " is local.");
+        lcb(p, header, iface);
+        return true;
+    }
+
+    const libbgp::BgpRib6Entry *rslt = Lookup(dst);
+
+    if (rslt == nullptr) {
+        NS_LOG_INFO("no matching entry in rib for destination " << dst << ".");
+        return false;
+    }
+
+    uint8_t nexthop[16];
+    memcpy(nexthop, rslt->nexthop_global, 16);
+    Ipv6Address gateway (nexthop);
+    NS_LOG_LOGIC("nexthop of " << dst << " is at " << gateway << ".");
+
+    // the nexthop may not be on-link (IBGP), resolve it with the node's
+    // routing protocol like BgpRouting does.
+    Ptr<Ipv6RoutingProtocol> tempRouter = _ipv6->GetRoutingProtocol();
+
+    Ipv6Header tempHeader;
+    tempHeader.SetDestination (gateway);
+    Socket::SocketErrno errno_;
+    Ptr<NetDevice> oif = nullptr;
+    Ptr<Ipv6Route> route = tempRouter->RouteOutput (Ptr<Packet> (), tempHeader, oif, errno_);
+
+    if (route == nullptr) {
+        return false;
+    }
+
+    ucb(idev, route, p, header);
+    return true;
+}
+
+Ipv6Address BgpRouting6::LookupAsnGateway (Ipv6Address dst) {
+    // not a routing decision, so not counted as a miss.
+    const libbgp::BgpRib6Entry *rslt = Find(dst);
+
+    if (rslt == nullptr) {
+        NS_LOG_INFO("no matching entry in rib for destination " << dst << ".");
+        return Ipv6Address::GetZero();
+    }
+
+    uint8_t nexthop[16];
+    memcpy(nexthop, rslt->nexthop_global, 16);
+
+    return Ipv6Address(nexthop);
+}
+
+/**
+ * @brief Look for device to output/forward packet by nexthop.
+ * 
+ * @param nexthop Nexthop.
+ * @return Ptr<NetDevice> Output device.
+ * @retval nullptr Device not found.
+ * @retval !=nullptr Output device.
+ */
+Ptr<NetDevice> BgpRouting6::GetDeviceByNexthop(const Ipv6Address &nexthop) const {
+    uint32_t n_ifaces = _ipv6->GetNInterfaces();
+
+    for (uint32_t iface_id = 0; iface_id < n_ifaces; iface_id++) {
+        uint32_t n_addrs = _ipv6->GetNAddresses(iface_id);
+        for (uint32_t addr_id = 0; addr_id < n_addrs; addr_id++) {
+            Ipv6InterfaceAddress addr = _ipv6->GetAddress(iface_id, addr_id);
+            Ipv6Prefix mask = addr.GetPrefix();
+            if (addr.GetAddress().IsLinkLocal() != nexthop.IsLinkLocal()) continue;
+            if (addr.GetAddress().CombinePrefix(mask) == nexthop.CombinePrefix(mask)) {
+                if (_ipv6->IsForwarding(iface_id) && _ipv6->IsUp(iface_id)) {
+                    return _ipv6->GetNetDevice(iface_id);
+                } else NS_LOG_INFO("interface " << iface_id << " has matching address but not up or not in forwarding mode.");
+            }
+        }
+    }
+
+    return nullptr;
+}
+
+/**
+ * @brief Set the libbgp IPv6 Routing Information Base to use.
+ * 
+ * @param rib The libbgp RIB.
+ */
+void BgpRouting6::SetRib(const libbgp::BgpRib6 *rib) {
+    _rib = rib;
+}
+
+/* things we don't care */
+void BgpRouting6::NotifyInterfaceUp (uint32_t interface) {}
+void BgpRouting6::NotifyInterfaceDown (uint32_t interface) {}
+void BgpRouting6::NotifyAddAddress (uint32_t interface, Ipv6InterfaceAddress address) {}
+void BgpRouting6::NotifyRemoveAddress (uint32_t interface, Ipv6InterfaceAddress address) {}
+void BgpRouting6::NotifyAddRoute (Ipv6Address dst, Ipv6Prefix mask, Ipv6Address nextHop, uint32_t interface, Ipv6Address prefixToUse) {}
+void BgpRouting6::NotifyRemoveRoute (Ipv6Address dst, Ipv6Prefix mask, Ipv6Address nextHop, uint32_t interface, Ipv6Address prefixToUse) {}
+
+/* this one we do care */
+void BgpRouting6::SetIpv6 (Ptr<Ipv6> ipv6) {
+    _ipv6 = ipv6;
+}
+
+void BgpRouting6::PrintRoutingTable (Ptr<OutputStreamWrapper> stream, Time::Unit unit) const {
+    std::ostream* os = stream->GetStream();
+
+    *os << "BGP IPv6 routing table for node" << _ipv6->GetObject<Node>()->GetId()
+        << ", time: " << Simulator::Now().As(unit) << std::endl;
+
+    if (_rib == nullptr) return;
+
+    uint8_t print_buffer[4096];
+
+    for (const std::pair<const libbgp::BgpRib6EntryKey, libbgp::BgpRib6Entry> &entry_pair : _rib->get()) {
+        const libbgp::BgpRib6Entry &entry = entry_pair.second;
+        uint8_t prefix[16], nexthop[16];
+        entry.route.getPrefix(prefix);
+        memcpy(nexthop, entry.nexthop_global, 16);
+        *os << Ipv6Address(prefix) << "/" << (int) entry.route.getLength()
+            << " via " << Ipv6Address(nexthop)
+            << " from " << Ipv4Address(ntohl(entry.src_router_id)) << std::endl
+            << "Attribues: " << std::endl;
+        for (const std::shared_ptr<libbgp::BgpPathAttrib> &attr : entry.attribs) {
+            attr->print(1, print_buffer, 4096);
+            *os << print_buffer;
+        }
+    }
+}
+
+}
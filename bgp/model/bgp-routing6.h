@@ -0,0 +1,75 @@
+/**
+ * @file bgp-routing6.h
+ * @author Nato Morichika <nat@nat.moe>
+ * @brief ns3 BGP module: routing protocol (Ipv6RoutingProtocol)
+ * @version 0.1
+ * @date 2019-07-13
+ * 
+ * @copyright Copyright (c) 2019
+ * 
+ */
+#ifndef BGP_ROUTING6_H
+#define BGP_ROUTING6_H
+
+#include <libbgp/bgp-rib6.h>
+#include "ns3/ipv6-routing-protocol.h"
+#include "ns3/traced-callback.h"
+
+namespace ns3 {
+
+/**
+ * @brief The Ipv6RoutingProtocol for Bgp module.
+ * 
+ * IPv6 counterpart of BgpRouting: forward packets with the routes of a libbgp
+ * IPv6 RIB. Lookups are done on the FIB of the RIB, so their cost does not
+ * depend on the size of the table.
+ * 
+ */
+class BgpRouting6 : public Ipv6RoutingProtocol {
+public:
+    BgpRouting6();
+
+    static TypeId GetTypeId (void);
+
+    Ptr<Ipv6Route> RouteOutput (Ptr<Packet> p, const Ipv6Header &header, Ptr<NetDevice> oif,
+                                Socket::SocketErrno &sockerr);
+
+    bool RouteInput (Ptr<const Packet> p, const Ipv6Header &header, Ptr<const NetDevice> idev,
+                     UnicastForwardCallback ucb, MulticastForwardCallback mcb,
+                     LocalDeliverCallback lcb, ErrorCallback ecb);
+
+    void NotifyInterfaceUp (uint32_t interface);
+    void NotifyInterfaceDown (uint32_t interface);
+    void NotifyAddAddress (uint32_t interface, Ipv6InterfaceAddress address);
+    void NotifyRemoveAddress (uint32_t interface, Ipv6InterfaceAddress address);
+    void NotifyAddRoute (Ipv6Address dst, Ipv6Prefix mask, Ipv6Address nextHop, uint32_t interface, Ipv6Address prefixToUse = Ipv6Address::GetZero ());
+    void NotifyRemoveRoute (Ipv6Address dst, Ipv6Prefix mask, Ipv6Address nextHop, uint32_t interface, Ipv6Address prefixToUse = Ipv6Address::GetZero ());
+    void PrintRoutingTable (Ptr<OutputStreamWrapper> stream, Time::Unit unit = Time::S) const;
+
+    void SetIpv6 (Ptr<Ipv6> ipv6);
+    void SetRib(const libbgp::BgpRib6 *rib);
+    Ipv6Address LookupAsnGateway (Ipv6Address dst);
+    uint64_t GetLookupMisses(void) const;
+
+    /**
+     * @brief TracedCallback signature for lookup misses.
+     * 
+     * @param dst Destination not found in the RIB.
+     */
+    typedef void (* LookupMissTracedCallback)(Ipv6Address dst);
+
+    Ptr<NetDevice> GetDeviceByNexthop(const Ipv6Address &nexthop) const;
+
+private:
+    const libbgp::BgpRib6Entry* Find(const Ipv6Address &dst) const;
+    const libbgp::BgpRib6Entry* Lookup(const Ipv6Address &dst);
+
+    const libbgp::BgpRib6 *_rib;
+    uint64_t _lookup_misses;
+    TracedCallback<Ipv6Address> _lookup_miss_trace;
+    Ptr<Ipv6> _ipv6;
+};
+
+}
+
+#endif // BGP_ROUTING6_H
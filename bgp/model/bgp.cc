@@ -9,14 +9,18 @@
  * 
  */
 #include <arpa/inet.h>
+#include <string.h>
 #include "bgp.h"
 #include "ns3/log.h"
 #include "ns3/enum.h"
 #include "ns3/ipv4-list-routing.h"
 #include "ns3/ipv4-static-routing.h"
+#include "ns3/ipv6.h"
+#include "ns3/ipv6-list-routing.h"
 #include "ns3/tcp-socket-factory.h"
 #include "ns3/simulator.h"
 #include "ns3/tcp-socket-base.h"
+#include "ns3/trace-source-accessor.h"
 
 namespace ns3 {
 
@@ -31,6 +35,9 @@ Peer::Peer() {
     forced_default_nexthop = false;
     ibgp_alter_nexthop = false;
     ebgp_multihop = 1;
+    mrai = Seconds(-1);
+    mp_bgp_ipv6 = false;
+    peering_prefix6 = Ipv6Prefix(64);
 }
 
 /**
@@ -38,6 +45,7 @@ Peer::Peer() {
  * 
  */
 void Session::Drop() {
+    timer.Cancel();
     socket->SetRecvCallback(MakeNullCallback<void, Ptr<Socket>>());
     socket->SetCloseCallbacks(
         MakeNullCallback<void, Ptr<Socket>>(),
@@ -74,24 +82,83 @@ TypeId Bgp::GetTypeId (void) {
         .AddAttribute("ClockInterval", "Time to wait between ticking FSMs",
             TimeValue(Seconds(1)),
             MakeTimeAccessor(&Bgp::_clock_interval),
-            MakeTimeChecker())
+            MakeTimeChecker(),
+            TypeId::DEPRECATED,
+            "FSMs are now ticked at their next deadline, the interval is not used.")
         .AddAttribute("ErrorHold", "Time to wait before retry.",
             TimeValue(Seconds(45)),
             MakeTimeAccessor(&Bgp::_error_hold),
-            MakeTimeChecker());
+            MakeTimeChecker())
+        .AddAttribute("MinRouteAdvertisementInterval", 
+            "Time to wait between sending route changes to a peer, changes are "
+            "batched in the Adj-RIB-Out of the session meanwhile. (0: send at once)",
+            TimeValue(Seconds(0)),
+            MakeTimeAccessor(&Bgp::_mrai),
+            MakeTimeChecker(Seconds(0)))
+        .AddTraceSource("UpdateSent", "UPDATE messages sent to a peer.",
+            MakeTraceSourceAccessor(&Bgp::_update_sent_trace),
+            "ns3::Bgp::UpdateTracedCallback")
+        .AddTraceSource("UpdateReceived", "UPDATE messages received from a peer.",
+            MakeTraceSourceAccessor(&Bgp::_update_received_trace),
+            "ns3::Bgp::UpdateTracedCallback")
+        .AddTraceSource("BestPathChange", "Best paths of prefixes changed in the RIB.",
+            MakeTraceSourceAccessor(&Bgp::_best_path_change_trace),
+            "ns3::Bgp::BestPathChangeTracedCallback")
+        .AddTraceSource("PeersChange", "Peers added or removed. (topology change)",
+            MakeTraceSourceAccessor(&Bgp::_peers_change_trace),
+            "ns3::Bgp::PeersChangeTracedCallback")
+        .AddTraceSource("FibSize", "Number of IPv4 prefixes in the FIB.",
+            MakeTraceSourceAccessor(&Bgp::_fib_size),
+            "ns3::TracedValueCallback::Uint32")
+        .AddTraceSource("FibSize6", "Number of IPv6 prefixes in the FIB.",
+            MakeTraceSourceAccessor(&Bgp::_fib_size6),
+            "ns3::TracedValueCallback::Uint32")
+        .AddTraceSource("LastRibChange", "Time of the last change of the RIB.",
+            MakeTraceSourceAccessor(&Bgp::_last_rib_change),
+            "ns3::TracedValueCallback::Time");
 
     return tid;
 }
 
-Bgp::Bgp() : _logger("(local)"), _rib(&_logger) {
+/**
+ * @brief Get the path attribute intern table shared by the RIBs of all Bgp
+ * applications.
+ * 
+ * @return libbgp::BgpAttribPool& The table.
+ */
+libbgp::BgpAttribPool& Bgp::GetAttribPool(void) {
+    static libbgp::BgpAttribPool pool;
+    return pool;
+}
+
+/**
+ * @brief Get memory accounting of the path attributes of all Bgp applications.
+ * 
+ * @return libbgp::BgpAttribPoolStats Stats.
+ */
+libbgp::BgpAttribPoolStats Bgp::GetAttribPoolStats(void) {
+    return GetAttribPool().getStats();
+}
+
+Bgp::Bgp() : _logger("(local)"), _rib(&_logger), _rib6(&_logger), _route_observer(MakeCallback(&Bgp::HandleRouteChange, this)) {
     _log_level = libbgp::INFO;
 
     _logger.setLogLevel(_log_level);
     //_routing = CreateObject<BgpRouting>();
     //_routing->SetRib(&_rib);
 
+    // routers of a simulation mostly learn the same path attributes, store
+    // them once for all.
+    _rib.setAttribPool(&GetAttribPool());
+    _rib6.setAttribPool(&GetAttribPool());
+
     _running = false;
     _listen_socket = nullptr;
+
+    _fib_size = 0;
+    _fib_size6 = 0;
+    _last_rib_change = Seconds(0);
+    _bus.subscribe(&_route_observer);
 }
 
 void Bgp::StartApplication(void) {
@@ -115,6 +182,21 @@ void Bgp::StartApplication(void) {
 
     _routing->SetRib(&_rib);
 
+    // the IPv6 data path is optional: use BgpRouting6 if the node has one.
+    Ptr<Ipv6> ipv6 = GetNode()->GetObject<Ipv6>();
+    Ptr<Ipv6ListRouting> routingList6 = ipv6 == nullptr ? nullptr : ipv6->GetRoutingProtocol()->GetObject<Ipv6ListRouting>();
+    if (routingList6 != nullptr) {
+        for (uint32_t i = 0; i < routingList6->GetNRoutingProtocols(); i++) {
+            int16_t priority;
+            Ptr<Ipv6RoutingProtocol> protocol = routingList6->GetRoutingProtocol(i, priority);
+            if (protocol->GetInstanceTypeId() == BgpRouting6::GetTypeId()) {
+                _routing6 = protocol->GetObject<BgpRouting6>();
+                _routing6->SetRib(&_rib6);
+                break;
+            }
+        }
+    }
+
 //    int16_t priority = 0;
 //    uint32_t index = GetNode()->GetObject<Ipv4>()->GetRoutingProtocol()->GetObject<Ipv4ListRouting>()->GetNRoutingProtocols();
 //    _routing = GetNode()->GetObject<Ipv4>()->GetRoutingProtocol()->GetObject<Ipv4ListRouting>()->GetRoutingProtocol(index-1,priority)->GetObject<BgpRouting>();
@@ -134,8 +216,10 @@ void Bgp::StartApplication(void) {
     _template.no_nexthop_check4 = false;
     _template.rev_bus = &_bus;
     _template.rib4 = &_rib;
+    _template.rib6 = &_rib6;
     _template.router_id = htonl(_bgp_id.Get());
     _template.use_4b_asn = true;
+    _template.mrai = (uint32_t) _mrai.GetSeconds();
 
     Ptr<Ipv4> ipv4 = GetNode()->GetObject<Ipv4>();
 
@@ -157,8 +241,6 @@ void Bgp::StartApplication(void) {
     NS_LOG_LOGIC("init complete.");
 
     _running = true;
-
-    Simulator::Schedule(_clock_interval, &Bgp::Tick, this);
 }
 
 // modify{
@@ -205,14 +287,63 @@ size_t Bgp::GetNumPeer(void) const {
 	return _peers.size();
 }
 
+/**
+ * @brief Delete a peer, and tear down its session.
+ * 
+ * @param i Index of the peer.
+ */
 void Bgp::DeletePeer(uint32_t i) {
 	if(i >= 0 && i < _peers.size()) {
-		_peers.erase(_peers.begin() + i);
+		RemovePeer(_peers[i]);
+		_peers_change_trace(0, 1);
+		RefreshSessions();
 	}
 	else{
 		std::cout << "failed to delete peer." << std::endl;
 	}
 }
+
+/**
+ * @brief Apply a topology change to the peers.
+ * 
+ * Only the sessions of the removed peers are torn down, and only the routes
+ * received from them are discarded from the RIB (and withdrawn from the other
+ * peers). Sessions with the other peers stay established. Added peers are
+ * connected at once.
+ * 
+ * @param added Peers added since the last update.
+ * @param removed Addresses of the peers removed since the last update.
+ * Addresses matching no configured peer are ignored.
+ */
+void Bgp::UpdatePeers(const std::vector<Peer> &added, const std::vector<Ipv4Address> &removed) {
+    uint32_t n_removed = 0;
+
+    for (const Ipv4Address &address : removed) {
+        for (const Ptr<Peer> &peer : _peers) {
+            if (peer->peer_address == address) {
+                RemovePeer(peer);
+                n_removed++;
+                break;
+            }
+        }
+    }
+
+    for (const Peer &peer : added) {
+        Ptr<Peer> new_peer = Create<Peer>(peer);
+        _peers.push_back(new_peer);
+
+        if (_running && !new_peer->passive) {
+            Simulator::ScheduleNow(&Bgp::ConnectPeer, this, new_peer);
+        }
+    }
+
+    // addresses of no configured peer change nothing.
+    if (added.size() == 0 && n_removed == 0) return;
+
+    _peers_change_trace(added.size(), n_removed);
+
+    RefreshSessions();
+}
 // }modify
 
 void Bgp::StopApplication(void) {
@@ -230,6 +361,10 @@ void Bgp::StopApplication(void) {
 
     NS_LOG_LOGIC("de-peering...");
 
+    for (Ptr<Peer> &peer : _peers) {
+        peer->connect_retry.Cancel();
+    }
+
     for (std::vector<Ptr<Session>>::iterator s = _sessions.begin(); s != _sessions.end();) {
         (*s)->Drop();
         _sessions.erase(s);
@@ -238,18 +373,125 @@ void Bgp::StopApplication(void) {
     NS_LOG_LOGIC("stopped.");
 }
 
-void Bgp::Tick() {
+/**
+ * @brief Reschedule the timers of all sessions, and trace their messages.
+ * 
+ * Called after any FSM has run: route events published on the bus may have
+ * changed the deadlines of the other sessions too. (e.g. changes queued in the
+ * Adj-RIB-Out, or updates sent)
+ * 
+ */
+void Bgp::RefreshSessions() {
     for (Ptr<Session> session : _sessions) {
-        session->fsm->tick();
+        TraceSession(session);
+        ScheduleTimer(session);
+    }
+}
+
+/**
+ * @brief Trace the UPDATE messages sent and received by a session since the
+ * last call.
+ * 
+ * @param session The session.
+ */
+void Bgp::TraceSession(Ptr<Session> session) {
+    const libbgp::BgpMessageStats &stats = session->fsm->getMessageStats();
+    libbgp::BgpMessageStats &traced = session->traced;
+
+    if (stats.updates_out != traced.updates_out) {
+        _update_sent_trace(session->peer->peer_address,
+            stats.updates_out - traced.updates_out, stats.routes_out - traced.routes_out,
+            stats.withdrawn_out - traced.withdrawn_out, stats.bytes_out - traced.bytes_out);
+    }
+
+    if (stats.updates_in != traced.updates_in) {
+        _update_received_trace(session->peer->peer_address,
+            stats.updates_in - traced.updates_in, stats.routes_in - traced.routes_in,
+            stats.withdrawn_in - traced.withdrawn_in, stats.bytes_in - traced.bytes_in);
+    }
+
+    traced = stats;
+}
+
+/**
+ * @brief Handle best path changes published on the route event bus.
+ * 
+ * @param changed4 Number of IPv4 prefixes changed.
+ * @param changed6 Number of IPv6 prefixes changed.
+ */
+void Bgp::HandleRouteChange(uint32_t changed4, uint32_t changed6) {
+    NotifyRibChange();
+    _best_path_change_trace(changed4, changed6);
+}
+
+/**
+ * @brief Update FIB sizes and time of last RIB change.
+ * 
+ */
+void Bgp::NotifyRibChange() {
+    _fib_size = _rib.getFib().size();
+    _fib_size6 = _rib6.getFib().size();
+    _last_rib_change = Simulator::Now();
+}
+
+/**
+ * @brief Get the time of the last change of the RIB.
+ * 
+ * @return Time Time of the last change.
+ */
+Time Bgp::GetLastRibChange(void) const {
+    return _last_rib_change;
+}
+
+/**
+ * @brief Get the time since the last change of the RIB.
+ * 
+ * @return Time Time since the last change.
+ */
+Time Bgp::GetTimeSinceLastRibChange(void) const {
+    return Simulator::Now() - _last_rib_change;
+}
+
+/**
+ * @brief Schedule the timer of a session at the next deadline of its FSM.
+ * 
+ * The pending event is kept if the deadline has not changed.
+ * 
+ * @param session The session.
+ */
+void Bgp::ScheduleTimer(Ptr<Session> session) {
+    uint64_t deadline = session->fsm->getNextDeadline();
+
+    if (deadline == 0) {
+        session->timer.Cancel();
+        return;
     }
 
-    if (_running) Simulator::Schedule(_clock_interval, &Bgp::Tick, this);
-    else NS_LOG_LOGIC("ticker stopped.");
+    Time now = Simulator::Now();
+    Time at = Seconds(deadline);
+    if (at < now) at = now;
+
+    if (session->timer.IsRunning() && session->timer.GetTs() == (uint64_t) at.GetTimeStep()) return;
+
+    session->timer.Cancel();
+    session->timer = Simulator::Schedule(at - now, &Bgp::HandleTimer, this, session);
+}
+
+/**
+ * @brief Tick the FSM of a session at its deadline.
+ * 
+ * @param session The session.
+ */
+void Bgp::HandleTimer(Ptr<Session> session) {
+    session->fsm->tick();
+    RefreshSessions();
 }
 
 bool Bgp::ConnectPeer(Ptr<Peer> peer) {
     //if (!_running) return false;
 
+    peer->connect_retry.Cancel();
+
     for (const Ptr<Session> &session : _sessions) {
         if (session->peer == peer) {
             NS_LOG_LOGIC("session or fsm for peer AS" << peer->peer_asn << " (" << peer->peer_address << ") already exist, skipping.");
@@ -295,6 +537,39 @@ bool Bgp::ConnectPeer(Ptr<Peer> peer) {
     return true;
 }
 
+/**
+ * @brief Remove a peer and tear down its sessions.
+ * 
+ * The FSMs drop the routes received from the peer (BgpRib4::discard) when 
+ * leaving ESTABLISHED, and the other sessions are told by route events.
+ * 
+ * @param peer The peer.
+ */
+void Bgp::RemovePeer(Ptr<Peer> peer) {
+    peer->connect_retry.Cancel();
+
+    for (std::vector<Ptr<Session>>::iterator session = _sessions.begin(); session != _sessions.end();) {
+        if ((*session)->peer != peer) {
+            session++;
+            continue;
+        }
+
+        NS_LOG_INFO("removing session of AS" << peer->peer_asn << "/" << ((*session)->local_init ? 'L' : 'R') << " (" << peer->peer_address << ").");
+
+        // closing the socket tells the peer, the FSM goes IDLE.
+        TraceSession(*session);
+        (*session)->Drop();
+        session = _sessions.erase(session);
+    }
+
+    for (std::vector<Ptr<Peer>>::iterator p = _peers.begin(); p != _peers.end(); p++) {
+        if (*p == peer) {
+            _peers.erase(p);
+            break;
+        }
+    }
+}
+
 bool Bgp::HandleConnectInRequest(Ptr<Socket> socket, const Address &src) {
     return true;
 }
@@ -310,20 +585,35 @@ void Bgp::HandleClose(Ptr<Socket> socket) {
          session != _sessions.end(); session++) {
         if ((*session)->socket == socket) {
             
-            if (_running && !(*session)->peer->passive) {
+            Ptr<Peer> peer = (*session)->peer;
+
+            if (_running && !peer->passive && !peer->connect_retry.IsRunning()) {
                 NS_LOG_LOGIC("scheduled retry in " << _error_hold.GetSeconds() << " seconds.");
-                Simulator::Schedule(_error_hold, &Bgp::ConnectPeer, this, (*session)->peer);
+                peer->connect_retry = Simulator::Schedule(_error_hold, &Bgp::ConnectPeer, this, peer);
             }
 
+            TraceSession(*session);
             NS_LOG_INFO("dropping session of AS" << (*session)->peer->peer_asn << "/" << ((*session)->local_init ? 'L' : 'R') << " (" << (*session)->peer->peer_address << ").");
             (*session)->Drop();
             _sessions.erase(session);
+
+            // routes of the session are withdrawn from the other sessions.
+            RefreshSessions();
             return;
         }
     }
 
 }
 
+/**
+ * @brief Reschedule timers after an FSM has run on received data.
+ * 
+ * @param socket The socket the data was received from.
+ */
+void Bgp::HandleRead(Ptr<Socket> socket) {
+    RefreshSessions();
+}
+
 void Bgp::HandleConnectIn(Ptr<Socket> socket, const Address &peer_addr) {
     NS_LOG_LOGIC("incoming connection.");
     SessionInit(false, socket);
@@ -411,10 +701,25 @@ bool Bgp::SessionInit(bool local_init, Ptr<Socket> socket) {
     peer_config.weight = peer->weight;
     peer_config.forced_default_nexthop4 = peer->forced_default_nexthop;
     peer_config.ibgp_alter_nexthop = peer->ibgp_alter_nexthop;
+    if (!peer->mrai.IsNegative()) peer_config.mrai = (uint32_t) peer->mrai.GetSeconds();
+
+    if (peer->mp_bgp_ipv6) {
+        // libbgp drops IPv4 from the session once MP-BGP IPv6 is on, unless
+        // IPv4 is negotiated with MP-BGP too.
+        uint8_t peering_lan6[16];
+        peer->local_address6.CombinePrefix(peer->peering_prefix6).GetBytes(peering_lan6);
+        peer_config.mp_bgp_ipv4 = true;
+        peer_config.mp_bgp_ipv6 = true;
+        peer_config.peering_lan6 = libbgp::Prefix6(peering_lan6, peer->peering_prefix6.GetPrefixLength());
+        peer->local_address6.GetBytes(peer_config.default_nexthop6_global);
+        memset(peer_config.default_nexthop6_linklocal, 0, sizeof(peer_config.default_nexthop6_linklocal));
+        peer_config.no_nexthop_check6 = peer->no_nexthop_check;
+        peer_config.forced_default_nexthop6 = peer->forced_default_nexthop;
+    }
 
     Ptr<BgpNs3Fsm> peer_fsm = Create<BgpNs3Fsm>(peer_config);
     Ptr<Session> peer_session = Create<Session>();
-    Ptr<BgpNs3SocketIn> in_handler = Create<BgpNs3SocketIn>(peer_fsm);
+    Ptr<BgpNs3SocketIn> in_handler = Create<BgpNs3SocketIn>(peer_fsm, MakeCallback(&Bgp::HandleRead, this));
     peer_session->peer = peer;
     peer_session->socket = socket;
     peer_session->fsm = peer_fsm;
@@ -422,6 +727,7 @@ bool Bgp::SessionInit(bool local_init, Ptr<Socket> socket) {
     peer_session->out_handler = peer_out_handler;
     peer_session->in_handler = in_handler;
     peer_session->local_init = local_init;
+    memset(&peer_session->traced, 0, sizeof(peer_session->traced));
     
     socket->SetRecvCallback(MakeCallback(&BgpNs3SocketIn::HandleRead, in_handler));
     socket->SetCloseCallbacks(
@@ -461,6 +767,7 @@ void Bgp::AddPeer(const Peer &peer) {
 void Bgp::AddRoute(libbgp::Prefix4 route, uint32_t nexthop) {
     //NS_ASSERT(!_running);
     _rib.insert(&_logger, route, nexthop);
+    NotifyRibChange();
 }
 
 /**
@@ -488,25 +795,67 @@ void Bgp::AddRoute(const Ipv4Address &prefix, const Ipv4Mask &mask, const Ipv4Ad
 }
 
 /**
- * @brief Remove all routes from RIB.
- *
+ * @brief Add an IPv6 route to BGP routing table.
+ * 
+ * @param route The route.
+ * @param nexthop Nexthop (global address) of the route.
+ */
+void Bgp::AddRoute6(const libbgp::Prefix6 &route, const Ipv6Address &nexthop) {
+    uint8_t nexthop_global[16];
+    uint8_t nexthop_linklocal[16] = { 0 };
+    nexthop.GetBytes(nexthop_global);
+    _rib6.insert(&_logger, route, nexthop_global, nexthop_linklocal);
+    NotifyRibChange();
+}
+
+/**
+ * @brief Add an IPv6 route to BGP routing table.
+ * 
+ * @param prefix Prefix of the route.
+ * @param mask Prefix length of the route.
+ * @param nexthop Nexthop (global address) of the route.
+ */
+void Bgp::AddRoute6(const Ipv6Address &prefix, const Ipv6Prefix &mask, const Ipv6Address &nexthop) {
+    uint8_t prefix_bytes[16];
+    prefix.GetBytes(prefix_bytes);
+    AddRoute6(libbgp::Prefix6(prefix_bytes, mask.GetPrefixLength()), nexthop);
+}
+
+/**
+ * @brief Remove all routes received from a BGP speaker from RIB.
+ * 
+ * The routes are withdrawn from the peers (or replaced by the routes of other
+ * speakers). Routes of other speakers are kept.
+ * 
  * @param src_router_id Originating BGP speaker's ID in host bytes order.
  */
 void Bgp::ClearRib4(uint32_t src_router_id) {
     //NS_ASSERT(!_running);
-	//auto htonl_src_router_id = htonl(src_router_id);
-	_rib.clear();
-    //std::cout << " > Delete Route  gnd router_id:" << htonl_src_router_id << "(in network bytes order)" << std::endl;
+    std::pair<std::vector<libbgp::Prefix4>, std::vector<libbgp::BgpRib4Entry>> discarded = _rib.discard(htonl(src_router_id));
+
+    if (discarded.first.size() > 0) {
+        libbgp::Route4WithdrawEvent withdraw_event;
+        withdraw_event.routes = &(discarded.first);
+        _bus.publish(NULL, withdraw_event);
+    }
+
+    if (discarded.second.size() > 0) {
+        libbgp::Route4AddEvent add_event;
+        add_event.replaced_entries = &(discarded.second);
+        _bus.publish(NULL, add_event);
+    }
+
+    RefreshSessions();
 }
 
 /**
  * @brief Print number of routes in RIB.
- *
+ * 
  * @param src_router_id Originating BGP speaker's ID in host bytes order.
  */
 void Bgp::PrintNumRib4(uint32_t src_router_id) {
 	auto htonl_src_router_id = htonl(src_router_id);
-	libbgp::rib4_t rib4_t = _rib.get();
+	const libbgp::rib4_t &rib4_t = _rib.get();
 	std::cout << "gnd router_id:" << htonl_src_router_id << " RIB size:" << rib4_t.size() << std::endl;
 }
 
@@ -532,7 +881,7 @@ void Bgp::SetBgpId(Ipv4Address bgp_id) {
 
 /**
  * @brief Get local router ID.
- *
+ * 
  * @return _uint_bgp_id Router ID in host bytes order.
  */
 uint32_t Bgp::GetBgpId(void) const {
@@ -552,7 +901,8 @@ void Bgp::SetHoldTimer(Time hold_timer) {
 }
 
 /**
- * @brief Set Tick() interval
+ * @brief Set FSM tick interval. (deprecated: FSMs are ticked at their next
+ * deadline, the interval is not used)
  * 
  * @param interval Tick interval.
  */
@@ -17,10 +17,17 @@
 #include "bgp-ns3-socket-out.h"
 #include "bgp-log.h"
 #include "bgp-routing.h"
+#include "bgp-routing6.h"
 #include "bgp-ns3-socket-in.h"
+#include "bgp-ns3-route-observer.h"
 #include "ns3/application.h"
 #include "ns3/ipv4-address.h"
+#include "ns3/ipv6-address.h"
 #include "ns3/socket.h"
+#include "ns3/event-id.h"
+#include "ns3/nstime.h"
+#include "ns3/traced-callback.h"
+#include "ns3/traced-value.h"
 #include "ns3/basic-simulation.h"
 
 namespace ns3 {
@@ -49,6 +56,11 @@ public:
     bool no_nexthop_check; //!< disable nexthop attribute validation
     bool forced_default_nexthop; //!< always use peering IP as nexthop.
     bool ibgp_alter_nexthop; //!< alter IBGP nexthop attribute the same way as EBGP.
+    Time mrai; //!< MinRouteAdvertisementInterval, negative to use the one of the application.
+    bool mp_bgp_ipv6; //!< also exchange IPv6 routes on this session (MP-BGP), IPv4 routes are still exchanged.
+    Ipv6Address local_address6; //!< local global IPv6 address on the peering LAN, used as the IPv6 nexthop.
+    Ipv6Prefix peering_prefix6; //!< prefix of the IPv6 peering LAN around local_address6.
+    EventId connect_retry; //!< pending connect retry after the session closed.
 
     uint8_t ebgp_multihop;
 
@@ -69,6 +81,9 @@ public:
 
     bool local_init;
 
+    EventId timer; //!< next time-based event of the FSM.
+    libbgp::BgpMessageStats traced; //!< message counters already traced.
+
     void Drop();
 };
 
@@ -88,26 +103,69 @@ public:
     void AddRoute(libbgp::Prefix4 route, uint32_t nexthop);
     void AddRoute(uint32_t prefix, uint8_t mask, uint32_t nexthop);
     void AddRoute(const Ipv4Address &prefix, const Ipv4Mask &mask, const Ipv4Address &nexthop);
+    void AddRoute6(const libbgp::Prefix6 &route, const Ipv6Address &nexthop);
+    void AddRoute6(const Ipv6Address &prefix, const Ipv6Prefix &mask, const Ipv6Address &nexthop);
     void SetLibbgpLogLevel(libbgp::LogLevel log_level);
     void SetBgpId(Ipv4Address bgp_id);
     void SetHoldTimer(Time hold_timer);
     void SetClockInterval(Time interval);
 
+    static libbgp::BgpAttribPoolStats GetAttribPoolStats(void);
+
+    Time GetLastRibChange(void) const;
+    Time GetTimeSinceLastRibChange(void) const;
+
+    /**
+     * @brief TracedCallback signature for UPDATE messages sent or received.
+     * 
+     * @param peer Address of the peer.
+     * @param updates Number of UPDATE messages.
+     * @param routes Number of routes (NLRI) in the messages.
+     * @param withdrawn Number of withdrawn routes in the messages.
+     * @param bytes Bytes of all messages (including OPEN, KEEPALIVE, etc.)
+     */
+    typedef void (* UpdateTracedCallback)(Ipv4Address peer, uint32_t updates, uint32_t routes, uint32_t withdrawn, uint32_t bytes);
+
+    /**
+     * @brief TracedCallback signature for best path changes.
+     * 
+     * @param changed4 Number of IPv4 prefixes with a new best path (or withdrawn).
+     * @param changed6 Number of IPv6 prefixes with a new best path (or withdrawn).
+     */
+    typedef void (* BestPathChangeTracedCallback)(uint32_t changed4, uint32_t changed6);
+
+    /**
+     * @brief TracedCallback signature for topology changes.
+     * 
+     * @param added Number of peers added.
+     * @param removed Number of peers removed.
+     */
+    typedef void (* PeersChangeTracedCallback)(uint32_t added, uint32_t removed);
+
     // modify{
     void MakeRegularConnectPeer(double time);
     void SetSimulation(int64_t simulation_end_time_ns, double dynamicStateUpdateIntervalNs);
     Ptr<Peer> GetPeer(uint32_t i) const;
     size_t GetNumPeer(void) const;
     void DeletePeer(uint32_t i);
+    void UpdatePeers(const std::vector<Peer> &added, const std::vector<Ipv4Address> &removed);
     uint32_t GetBgpId(void) const;
     void ClearRib4(uint32_t src_router_id);
     void PrintNumRib4(uint32_t src_router_id);
     // }modify
 
 private:
-    void Tick();
+    static libbgp::BgpAttribPool& GetAttribPool(void);
+
+    void RefreshSessions();
+    void ScheduleTimer(Ptr<Session> session);
+    void TraceSession(Ptr<Session> session);
+    void HandleRouteChange(uint32_t changed4, uint32_t changed6);
+    void NotifyRibChange();
+    void HandleTimer(Ptr<Session> session);
 
     bool ConnectPeer(Ptr<Peer> peer);
+    void RemovePeer(Ptr<Peer> peer);
     bool SessionInit(bool local_init, Ptr<Socket> socket);
 
     void HandleConnectIn(Ptr<Socket> socket, const Address &src);
@@ -115,17 +173,20 @@ private:
     void HandleConnectOut(Ptr<Socket> socket);
     void HandleConnectOutFailed(Ptr<Socket> socket);
     void HandleClose(Ptr<Socket> socket);
+    void HandleRead(Ptr<Socket> socket);
     void HandleStateChange(Ptr<Socket> socket, int old_state, int new_state);
 
     Time _hold_timer;
     Time _clock_interval;
     Time _error_hold;
+    Time _mrai;
 
     BgpLog _logger;
     BgpNs3Clock _clock;
     Ipv4Address _bgp_id;
 
     Ptr<BgpRouting> _routing;
+    Ptr<BgpRouting6> _routing6;
     Ptr<Socket> _listen_socket;
 
     std::vector<Ptr<Peer>> _peers;
@@ -133,11 +194,21 @@ private:
 
     libbgp::BgpConfig _template;
     libbgp::BgpRib4 _rib;
+    libbgp::BgpRib6 _rib6;
     libbgp::RouteEventBus _bus;
+    BgpNs3RouteObserver _route_observer;
     libbgp::LogLevel _log_level;
 
     bool _running;
 
+    TracedCallback<Ipv4Address, uint32_t, uint32_t, uint32_t, uint32_t> _update_sent_trace;
+    TracedCallback<Ipv4Address, uint32_t, uint32_t, uint32_t, uint32_t> _update_received_trace;
+    TracedCallback<uint32_t, uint32_t> _best_path_change_trace;
+    TracedCallback<uint32_t, uint32_t> _peers_change_trace;
+    TracedValue<uint32_t> _fib_size;
+    TracedValue<uint32_t> _fib_size6;
+    TracedValue<Time> _last_rib_change;
+
     // modify{
 	// Input
 	Ptr<BasicSimulation> m_basicSimulation; //<! Basic simulation instance.
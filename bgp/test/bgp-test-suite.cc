@@ -0,0 +1,404 @@
+/**
+ * @file bgp-test-suite.cc
+ * @author Nato Morichika <nat@nat.moe>
+ * @brief Tests of the BGP module.
+ * @version 0.1
+ * @date 2020-02-02
+ * 
+ * @copyright Copyright (c) 2020
+ * 
+ */
+#include "ns3/bgp.h"
+#include "ns3/bgp-routing.h"
+#include "ns3/bgp-routing6.h"
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/test.h"
+#include <libbgp/bgp-fsm.h>
+#include <libbgp/route-event-bus.h>
+#include <arpa/inet.h>
+
+using namespace ns3;
+
+/**
+ * @brief Out handler passing messages directly to another FSM.
+ * 
+ */
+class BgpTestPipe : public libbgp::BgpOutHandler {
+public:
+    BgpTestPipe() : _other(NULL) {}
+
+    void SetPeer(libbgp::BgpFsm *other) {
+        _other = other;
+    }
+
+    bool handleOut(const uint8_t *buffer, size_t length) {
+        return _other->run(buffer, length) >= 0;
+    }
+
+private:
+    libbgp::BgpFsm *_other;
+};
+
+/**
+ * @brief Clock moved forward by the test.
+ * 
+ */
+class BgpTestClock : public libbgp::Clock {
+public:
+    BgpTestClock() : now(1000) {}
+
+    uint64_t getTime() const {
+        return now;
+    }
+
+    uint64_t now;
+};
+
+/**
+ * @brief Create path attributes with the given nexthop.
+ * 
+ * @param logger Log handler.
+ * @param nexthop Nexthop, in network byte order.
+ * @return Path attributes.
+ */
+static std::vector<std::shared_ptr<libbgp::BgpPathAttrib>> MakeBgpTestAttribs(libbgp::BgpLogHandler *logger, uint32_t nexthop) {
+    std::vector<std::shared_ptr<libbgp::BgpPathAttrib>> attribs;
+    libbgp::BgpPathAttribOrigin *origin = new libbgp::BgpPathAttribOrigin(logger);
+    libbgp::BgpPathAttribNexthop *nexthop_attr = new libbgp::BgpPathAttribNexthop(logger);
+    libbgp::BgpPathAttribAsPath *as_path = new libbgp::BgpPathAttribAsPath(logger, true);
+
+    origin->origin = libbgp::IGP;
+    nexthop_attr->next_hop = nexthop;
+    as_path->prepend(64600);
+
+    attribs.push_back(std::shared_ptr<libbgp::BgpPathAttrib>(origin));
+    attribs.push_back(std::shared_ptr<libbgp::BgpPathAttrib>(nexthop_attr));
+    attribs.push_back(std::shared_ptr<libbgp::BgpPathAttrib>(as_path));
+
+    return attribs;
+}
+
+/**
+ * @brief Test that the Adj-RIB-Out drops superseded and redundant changes, and
+ * groups advertisements by attribute set.
+ * 
+ */
+class BgpAdjRibOutTestCase : public TestCase {
+public:
+    BgpAdjRibOutTestCase();
+    virtual ~BgpAdjRibOutTestCase();
+
+private:
+    virtual void DoRun(void);
+};
+
+BgpAdjRibOutTestCase::BgpAdjRibOutTestCase()
+    : TestCase("Test that the Adj-RIB-Out only keeps the changes the peer needs") {
+}
+
+BgpAdjRibOutTestCase::~BgpAdjRibOutTestCase() {
+}
+
+void BgpAdjRibOutTestCase::DoRun(void) {
+    libbgp::BgpLogHandler logger;
+    logger.setLogLevel(libbgp::FATAL);
+
+    libbgp::BgpAttribPool pool;
+    libbgp::BgpAttribSet a = pool.intern(MakeBgpTestAttribs(&logger, htonl(0x0a000001)));
+    libbgp::BgpAttribSet b = pool.intern(MakeBgpTestAttribs(&logger, htonl(0x0a000002)));
+    libbgp::Prefix4 p1(htonl(0x0a010000), 24), p2(htonl(0x0a020000), 24), p3(htonl(0x0a030000), 24);
+
+    libbgp::BgpAdjRibOut4 out;
+    std::vector<std::pair<libbgp::BgpAttribSet, std::vector<libbgp::Prefix4>>> updates;
+
+    // a superseded advertisement is dropped.
+    out.advertise(p1, a);
+    out.advertise(p1, b);
+    NS_TEST_EXPECT_MSG_EQ(out.pending(), 1, "Superseded advertisement is dropped");
+    NS_TEST_EXPECT_MSG_EQ(out.getSuperseded(), 1, "Superseded advertisement is counted");
+    NS_TEST_EXPECT_MSG_EQ(out.flush(updates), 1, "Latest advertisement is flushed");
+    NS_TEST_ASSERT_MSG_EQ(updates.size(), 1, "One attribute set is flushed");
+    NS_TEST_EXPECT_MSG_EQ((updates[0].first == b), true, "Latest attributes are flushed");
+    NS_TEST_EXPECT_MSG_EQ(out.size(), 1, "Flushed route is advertised");
+
+    // a route the peer already has is not advertised again.
+    out.advertise(p1, b);
+    NS_TEST_EXPECT_MSG_EQ(out.pending(), 0, "Route the peer has is suppressed");
+    NS_TEST_EXPECT_MSG_EQ(out.getSuperseded(), 2, "Suppressed advertisement is counted");
+
+    // a route never sent to the peer is not withdrawn.
+    out.advertise(p2, a);
+    NS_TEST_EXPECT_MSG_EQ(out.withdraw(p2), false, "Route never advertised is not withdrawn");
+    NS_TEST_EXPECT_MSG_EQ(out.pending(), 0, "Queued advertisement is dropped on withdrawal");
+
+    // but a route sent to the peer is.
+    NS_TEST_EXPECT_MSG_EQ(out.withdraw(p1), true, "Advertised route is withdrawn");
+    NS_TEST_EXPECT_MSG_EQ(out.size(), 0, "Withdrawn route is no longer advertised");
+
+    // advertisements are grouped by attribute set.
+    out.advertise(p1, a);
+    out.advertise(p2, b);
+    out.advertise(p3, a);
+    updates.clear();
+    NS_TEST_EXPECT_MSG_EQ(out.flush(updates), 3, "All advertisements are flushed");
+    NS_TEST_ASSERT_MSG_EQ(updates.size(), 2, "Advertisements are grouped by attribute set");
+
+    size_t a_index = updates[0].first == a ? 0 : 1;
+    NS_TEST_EXPECT_MSG_EQ((updates[a_index].first == a), true, "First attribute set is flushed");
+    NS_TEST_EXPECT_MSG_EQ(updates[a_index].second.size(), 2, "Routes with the same attributes are grouped");
+    NS_TEST_EXPECT_MSG_EQ((updates[1 - a_index].first == b), true, "Second attribute set is flushed");
+    NS_TEST_EXPECT_MSG_EQ(updates[1 - a_index].second.size(), 1, "Route with other attributes is alone");
+    NS_TEST_EXPECT_MSG_EQ(out.pending(), 0, "Nothing is left queued");
+    NS_TEST_EXPECT_MSG_EQ(out.size(), 3, "Flushed routes are advertised");
+}
+
+/**
+ * @brief Test that the FSM holds advertisements until the MRAI expires, but
+ * sends withdrawals at once.
+ * 
+ */
+class BgpMraiTestCase : public TestCase {
+public:
+    BgpMraiTestCase();
+    virtual ~BgpMraiTestCase();
+
+private:
+    virtual void DoRun(void);
+};
+
+BgpMraiTestCase::BgpMraiTestCase()
+    : TestCase("Test that the MRAI holds advertisements but not withdrawals") {
+}
+
+BgpMraiTestCase::~BgpMraiTestCase() {
+}
+
+void BgpMraiTestCase::DoRun(void) {
+    libbgp::BgpLogHandler logger;
+    logger.setLogLevel(libbgp::FATAL);
+
+    BgpTestClock clock;
+    libbgp::RouteEventBus bus;
+    libbgp::BgpRib4 rib(&logger);
+    BgpTestPipe pipe_local, pipe_remote;
+
+    libbgp::BgpConfig config[2];
+    const char *router_ids[2] = { "10.0.0.1", "10.0.0.2" };
+    for (int k = 0; k < 2; k++) {
+        config[k].asn = 65000 + k;
+        config[k].peer_asn = 65001 - k;
+        config[k].use_4b_asn = true;
+        config[k].hold_timer = 120;
+        config[k].no_collision_detection = true;
+        inet_pton(AF_INET, router_ids[k], &config[k].router_id);
+        inet_pton(AF_INET, router_ids[k], &config[k].default_nexthop4);
+        config[k].forced_default_nexthop4 = true;
+        config[k].no_nexthop_check4 = true;
+        config[k].log_handler = &logger;
+        config[k].clock = &clock;
+    }
+
+    config[0].out_handler = &pipe_local;
+    config[0].rib4 = &rib;
+    config[0].rev_bus = &bus;
+    config[0].mrai = 30;
+    config[1].out_handler = &pipe_remote;
+
+    libbgp::BgpFsm local(config[0]);
+    libbgp::BgpFsm remote(config[1]);
+    pipe_local.SetPeer(&remote);
+    pipe_remote.SetPeer(&local);
+
+    local.start();
+    NS_TEST_ASSERT_MSG_EQ(local.getState(), libbgp::ESTABLISHED, "Session is established");
+
+    uint32_t peer1 = htonl(0x0a010001), peer2 = htonl(0x0a010002);
+    std::vector<libbgp::Prefix4> routes1, routes2;
+    routes1.push_back(libbgp::Prefix4(htonl(0x64000000), 24));
+    routes2.push_back(libbgp::Prefix4(htonl(0x64000100), 24));
+
+    // an advertisement is held until last_advertised + mrai.
+    clock.now = 1010;
+    std::vector<std::shared_ptr<libbgp::BgpPathAttrib>> attribs1 = MakeBgpTestAttribs(&logger, peer1);
+    rib.insert(peer1, routes1, attribs1, 0, 0);
+    libbgp::Route4AddEvent add1;
+    add1.new_routes = &routes1;
+    add1.shared_attribs = &attribs1;
+    bus.publish(NULL, add1);
+
+    NS_TEST_EXPECT_MSG_EQ(local.getAdjRibOut4().pending(), 1, "Advertisement is queued");
+    NS_TEST_EXPECT_MSG_EQ(remote.getRib4().get().size(), 0, "Advertisement is held");
+    NS_TEST_EXPECT_MSG_EQ(local.getNextDeadline(), 1030, "Deadline is the MRAI expiry");
+
+    clock.now = 1029;
+    local.tick();
+    NS_TEST_EXPECT_MSG_EQ(remote.getRib4().get().size(), 0, "Advertisement is held before the MRAI expires");
+
+    clock.now = 1030;
+    local.tick();
+    NS_TEST_EXPECT_MSG_EQ(remote.getRib4().get().size(), 1, "Advertisement is sent when the MRAI expires");
+    NS_TEST_EXPECT_MSG_EQ(local.getAdjRibOut4().pending(), 0, "Nothing is left queued");
+
+    // the MRAI now runs from the last advertisement.
+    clock.now = 1035;
+    std::vector<std::shared_ptr<libbgp::BgpPathAttrib>> attribs2 = MakeBgpTestAttribs(&logger, peer2);
+    rib.insert(peer2, routes2, attribs2, 0, 0);
+    libbgp::Route4AddEvent add2;
+    add2.new_routes = &routes2;
+    add2.shared_attribs = &attribs2;
+    bus.publish(NULL, add2);
+
+    NS_TEST_EXPECT_MSG_EQ(local.getNextDeadline(), 1060, "Deadline follows the last advertisement");
+
+    // a withdrawal is sent at once, and leaves the advertisement queued.
+    std::pair<std::vector<libbgp::Prefix4>, std::vector<libbgp::BgpRib4Entry>> discarded = rib.discard(peer1);
+    libbgp::Route4WithdrawEvent withdraw;
+    withdraw.routes = &(discarded.first);
+    bus.publish(NULL, withdraw);
+
+    NS_TEST_EXPECT_MSG_EQ(remote.getRib4().get().size(), 0, "Withdrawal is not held");
+    NS_TEST_EXPECT_MSG_EQ(local.getAdjRibOut4().pending(), 1, "Advertisement is still queued");
+    NS_TEST_EXPECT_MSG_EQ(local.getNextDeadline(), 1060, "Withdrawal does not restart the MRAI");
+
+    clock.now = 1060;
+    local.tick();
+    NS_TEST_EXPECT_MSG_EQ(remote.getRib4().get().size(), 1, "Held advertisement is sent");
+    NS_TEST_EXPECT_MSG_EQ(local.getState(), libbgp::ESTABLISHED, "Session is still established");
+
+    local.stop();
+    remote.stop();
+}
+
+/**
+ * @brief Test that two speakers peering over IPv4 exchange IPv6 routes with
+ * MP-BGP, and still exchange IPv4 routes.
+ * 
+ */
+class BgpMpBgpIpv6TestCase : public TestCase {
+public:
+    BgpMpBgpIpv6TestCase();
+    virtual ~BgpMpBgpIpv6TestCase();
+
+private:
+    virtual void DoRun(void);
+    void Check(void);
+
+    Ptr<BgpRouting> _routing;
+    Ptr<BgpRouting6> _routing6;
+    Ipv4Address _nexthop;
+    Ipv6Address _nexthop6;
+};
+
+BgpMpBgpIpv6TestCase::BgpMpBgpIpv6TestCase()
+    : TestCase("Test that an IPv6 route is exchanged between two speakers with MP-BGP") {
+}
+
+BgpMpBgpIpv6TestCase::~BgpMpBgpIpv6TestCase() {
+}
+
+void BgpMpBgpIpv6TestCase::DoRun(void) {
+    NodeContainer n;
+    n.Create(2);
+
+    // BgpRouting6 is added to the IPv6 list routing of the nodes.
+    Ipv6StaticRoutingHelper static6;
+    Ipv6ListRoutingHelper list6;
+    list6.Add(static6, 0);
+
+    InternetStackHelper internet;
+    internet.SetRoutingHelper(list6);
+    internet.Install(n);
+
+    PointToPointHelper p2p;
+    NetDeviceContainer d = p2p.Install(n);
+
+    Ipv4AddressHelper ipv4;
+    ipv4.SetBase("10.0.0.0", "255.255.255.0");
+    Ipv4InterfaceContainer i = ipv4.Assign(d);
+
+    Ipv6AddressHelper ipv6;
+    ipv6.SetBase(Ipv6Address("2001:db8::"), Ipv6Prefix(64));
+    Ipv6InterfaceContainer i6 = ipv6.Assign(d);
+
+    std::vector<Ptr<Bgp>> apps;
+    for (uint32_t k = 0; k < 2; k++) {
+        Ptr<Node> node = n.Get(k);
+
+        // Bgp looks for its routing protocols in the list routings of the node.
+        Ptr<BgpRouting> routing = CreateObject<BgpRouting>();
+        node->GetObject<Ipv4>()->GetRoutingProtocol()->GetObject<Ipv4ListRouting>()->AddRoutingProtocol(routing, 10);
+        Ptr<BgpRouting6> routing6 = CreateObject<BgpRouting6>();
+        node->GetObject<Ipv6>()->GetRoutingProtocol()->GetObject<Ipv6ListRouting>()->AddRoutingProtocol(routing6, 10);
+        if (k == 0) {
+            _routing = routing;
+            _routing6 = routing6;
+        }
+
+        Ptr<Bgp> app = CreateObject<Bgp>();
+        app->SetAttribute("RouterID", Ipv4AddressValue(i.GetAddress(k)));
+        app->SetSimulation(Seconds(20).GetNanoSeconds(), Seconds(30).GetNanoSeconds());
+
+        Peer peer;
+        peer.peer_address = i.GetAddress(1 - k);
+        peer.local_address = i.GetAddress(k);
+        peer.peer_asn = 65000 + 1 - k;
+        peer.local_asn = 65000 + k;
+        peer.mp_bgp_ipv6 = true;
+        peer.local_address6 = i6.GetAddress(k, 1);
+        peer.peering_prefix6 = Ipv6Prefix(64);
+        app->AddPeer(peer);
+
+        node->AddApplication(app);
+        app->SetStartTime(Seconds(0));
+        app->SetStopTime(Seconds(20));
+        apps.push_back(app);
+    }
+
+    // the routes of the second speaker, learnt by the first one.
+    _nexthop = i.GetAddress(1);
+    _nexthop6 = i6.GetAddress(1, 1);
+    apps[1]->AddRoute(Ipv4Address("10.1.0.0"), Ipv4Mask("/24"), _nexthop);
+    apps[1]->AddRoute6(Ipv6Address("2001:db8:1::"), Ipv6Prefix(48), _nexthop6);
+
+    Simulator::Schedule(Seconds(10), &BgpMpBgpIpv6TestCase::Check, this);
+    Simulator::Stop(Seconds(20));
+    Simulator::Run();
+    Simulator::Destroy();
+}
+
+void BgpMpBgpIpv6TestCase::Check(void) {
+    NS_TEST_EXPECT_MSG_EQ(_routing6->LookupAsnGateway(Ipv6Address("2001:db8:1::1")), _nexthop6,
+        "IPv6 route is received with the nexthop of the peer");
+    NS_TEST_EXPECT_MSG_EQ(_routing6->LookupAsnGateway(Ipv6Address("2001:db8:2::1")), Ipv6Address::GetZero(),
+        "Only the advertised IPv6 route is received");
+    NS_TEST_EXPECT_MSG_EQ(_routing->LookupAsnGateway(Ipv4Address("10.1.0.1")), _nexthop,
+        "IPv4 route is still received");
+
+    // only lookups routing a packet count as misses.
+    uint64_t misses = _routing->GetLookupMisses();
+    NS_TEST_EXPECT_MSG_EQ(_routing->LookupAsnGateway(Ipv4Address("10.2.0.1")), Ipv4Address::GetZero(),
+        "Route not advertised is not found");
+    NS_TEST_EXPECT_MSG_EQ(_routing->GetLookupMisses(), misses, "LookupAsnGateway does not count misses");
+
+    Ipv4Header header;
+    header.SetDestination(Ipv4Address("10.2.0.1"));
+    Socket::SocketErrno sockerr;
+    NS_TEST_EXPECT_MSG_EQ((_routing->RouteOutput(Create<Packet>(), header, nullptr, sockerr) == nullptr), true,
+        "Packet to a route not advertised is not routed");
+    NS_TEST_EXPECT_MSG_EQ(_routing->GetLookupMisses(), misses + 1, "RouteOutput counts misses");
+}
+
+/**
+ * @brief BGP test suite.
+ * 
+ */
+static class BgpTestSuite : public TestSuite {
+public:
+    BgpTestSuite() : TestSuite("bgp", UNIT) {
+        AddTestCase(new BgpMpBgpIpv6TestCase(), TestCase::QUICK);
+        AddTestCase(new BgpAdjRibOutTestCase(), TestCase::QUICK);
+        AddTestCase(new BgpMraiTestCase(), TestCase::QUICK);
+    }
+} g_bgpTestSuite;
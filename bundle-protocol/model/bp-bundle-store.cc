@@ -0,0 +1,431 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 University of New Brunswick
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Dizhi Zhou <dizhi.zhou@gmail.com>
+ */
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/trace-source-accessor.h"
+#include "bp-bundle-store.h"
+#include "bp-v7-header.h"
+
+NS_LOG_COMPONENT_DEFINE ("BpBundleStore");
+
+namespace ns3 {
+
+BpBundleId::BpBundleId ()
+  : src (),
+    timestamp (0),
+    seq (0)
+{
+}
+
+BpBundleId::BpBundleId (const BpEndpointId &src, const Time &timestamp, const SequenceNumber32 &seq)
+  : src (src),
+    timestamp (timestamp),
+    seq (seq)
+{
+}
+
+BpBundleId::BpBundleId (const BpHeader &header)
+  : src (header.GetSourceEid ()),
+    timestamp (MilliSeconds (header.GetCreateTimestamp ().GetMilliSeconds ())), // as carried by the header
+    seq (header.GetSequenceNumber ())
+{
+}
+
+bool
+operator < (const BpBundleId &a, const BpBundleId &b)
+{
+  if (a.src != b.src)
+    return a.src < b.src;
+  if (a.timestamp != b.timestamp)
+    return a.timestamp < b.timestamp;
+  return a.seq.GetValue () < b.seq.GetValue ();
+}
+
+bool
+operator == (const BpBundleId &a, const BpBundleId &b)
+{
+  return a.src == b.src && a.timestamp == b.timestamp && a.seq == b.seq;
+}
+
+NS_OBJECT_ENSURE_REGISTERED (BpBundleStore);
+
+TypeId
+BpBundleStore::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::BpBundleStore")
+    .SetParent<Object> ()
+    .AddConstructor<BpBundleStore> ()
+    .AddAttribute ("MaxBytes", "Max number of bytes in the store, 0 for no limit",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&BpBundleStore::m_maxBytes),
+                   MakeUintegerChecker<uint64_t> ())
+    .AddAttribute ("MaxBundles", "Max number of bundles in the store, 0 for no limit",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&BpBundleStore::m_maxBundles),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("ExpiryResolution", "The time covered by a slot of the timer wheel of bundle lifetimes",
+                   TimeValue (Seconds (1.0)),
+                   MakeTimeAccessor (&BpBundleStore::m_resolution),
+                   MakeTimeChecker (TimeStep (1)))
+    .AddAttribute ("ExpirySlots", "Number of slots in the timer wheel of bundle lifetimes",
+                   UintegerValue (256),
+                   MakeUintegerAccessor (&BpBundleStore::m_nSlots),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddTraceSource ("Bytes", "Number of bytes in the store",
+                     MakeTraceSourceAccessor (&BpBundleStore::m_bytes),
+                     "ns3::TracedValueCallback::Uint64")
+    .AddTraceSource ("Bundles", "Number of bundles in the store",
+                     MakeTraceSourceAccessor (&BpBundleStore::m_bundles),
+                     "ns3::TracedValueCallback::Uint32")
+    .AddTraceSource ("Expired", "A bundle is removed at the end of its lifetime",
+                     MakeTraceSourceAccessor (&BpBundleStore::m_expiredTrace),
+                     "ns3::BpBundleStore::BundleTracedCallback")
+    .AddTraceSource ("Evicted", "A bundle is removed to make room for another bundle",
+                     MakeTraceSourceAccessor (&BpBundleStore::m_evictedTrace),
+                     "ns3::BpBundleStore::BundleTracedCallback")
+    .AddTraceSource ("Rejected", "A bundle is not accepted by the store",
+                     MakeTraceSourceAccessor (&BpBundleStore::m_rejectedTrace),
+                     "ns3::BpBundleStore::BundleTracedCallback")
+  ;
+  return tid;
+}
+
+BpBundleStore::BpBundleStore ()
+  : m_maxBytes (0),
+    m_maxBundles (0),
+    m_nSlots (256),
+    m_nExpiring (0),
+    m_order (0),
+    m_bytes (0),
+    m_bundles (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+BpBundleStore::~BpBundleStore ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+BpBundleStore::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_tickEvent.Cancel ();
+  m_entries.clear ();
+  m_queues.clear ();
+  m_evictOrder.clear ();
+  m_evictIndex.clear ();
+  m_wheel.clear ();
+  m_nExpiring = 0;
+  Object::DoDispose ();
+}
+
+bool
+BpBundleStore::Enqueue (const BpEndpointId &eid, Ptr<Packet> bundle)
+{
+  NS_LOG_FUNCTION (this << " " << eid.Uri () << " " << bundle);
+  BpHeader bpHeader;
+  BpV7Header::PeekBpHeader (bundle, bpHeader);
+  return Enqueue (eid, bundle, bpHeader);
+}
+
+bool
+BpBundleStore::Enqueue (const BpEndpointId &eid, Ptr<Packet> bundle, const BpHeader &bpHeader)
+{
+  NS_LOG_FUNCTION (this << " " << eid.Uri () << " " << bundle);
+  BpBundleId id (bpHeader);
+
+  if (m_entries.find (id) != m_entries.end ())
+    {
+      NS_LOG_DEBUG ("bundle " << id.src.Uri () << " " << id.seq << " is already stored");
+      m_rejectedTrace (bundle);
+      return false;
+    }
+
+  uint64_t expiryTick = 0;
+  if (bpHeader.GetLifeTime () > 0)
+    {
+      Time expiry = bpHeader.GetCreateTimestamp () + Seconds (bpHeader.GetLifeTime ());
+      if (expiry <= Simulator::Now ())
+        {
+          NS_LOG_DEBUG ("bundle " << id.src.Uri () << " " << id.seq << " is expired");
+          m_expiredTrace (bundle);
+          return false;
+        }
+
+      // round up, so that a bundle never expires before its lifetime
+      expiryTick = GetTick (expiry - TimeStep (1)) + 1;
+    }
+
+  uint8_t priority = bpHeader.Priority ();
+  if (!MakeRoom (bundle->GetSize (), priority))
+    {
+      NS_LOG_DEBUG ("no room for bundle " << id.src.Uri () << " " << id.seq);
+      m_rejectedTrace (bundle);
+      return false;
+    }
+
+  Entry entry;
+  entry.bundle = bundle;
+  entry.eid = eid;
+  entry.queued = true;
+  entry.priority = priority;
+  entry.custody = bpHeader.CustTxReq ();
+  entry.order = m_order++;
+  entry.expiryTick = expiryTick;
+
+  std::list<BpBundleId> &queue = m_queues[eid];
+  entry.queueIt = queue.insert (queue.end (), id);
+
+  if (expiryTick != 0)
+    {
+      if (m_wheel.empty ())
+        m_wheel.resize (m_nSlots);
+
+      std::list<BpBundleId> &slot = m_wheel[expiryTick % m_wheel.size ()];
+      entry.wheelIt = slot.insert (slot.end (), id);
+      m_nExpiring++;
+      ScheduleTick ();
+    }
+
+  if (!entry.custody)
+    {
+      m_evictOrder.insert (EvictKey (entry.priority, entry.order));
+      m_evictIndex[entry.order] = id;
+    }
+
+  m_entries.insert (std::make_pair (id, entry));
+  m_bytes += bundle->GetSize ();
+  m_bundles += 1;
+
+  return true;
+}
+
+Ptr<Packet>
+BpBundleStore::Dequeue (const BpEndpointId &eid)
+{
+  NS_LOG_FUNCTION (this << " " << eid.Uri ());
+  std::map<BpEndpointId, std::list<BpBundleId> >::iterator itQueue = m_queues.find (eid);
+  if (itQueue == m_queues.end ())
+    return 0;
+
+  EntryMap::iterator it = m_entries.find (itQueue->second.front ());
+  NS_ASSERT (it != m_entries.end ());
+  return Dequeue (it);
+}
+
+Ptr<Packet>
+BpBundleStore::Dequeue (const BpBundleId &id)
+{
+  NS_LOG_FUNCTION (this << " " << id.src.Uri () << " " << id.seq);
+  EntryMap::iterator it = m_entries.find (id);
+  if (it == m_entries.end () || !it->second.queued)
+    return 0;
+
+  return Dequeue (it);
+}
+
+Ptr<Packet>
+BpBundleStore::Dequeue (EntryMap::iterator it)
+{
+  NS_LOG_FUNCTION (this);
+  Ptr<Packet> bundle = it->second.bundle;
+
+  if (it->second.custody)
+    {
+      // keep the bundle until the custody is accepted
+      std::map<BpEndpointId, std::list<BpBundleId> >::iterator itQueue = m_queues.find (it->second.eid);
+      NS_ASSERT (itQueue != m_queues.end ());
+      itQueue->second.erase (it->second.queueIt);
+      it->second.queued = false;
+      if (itQueue->second.empty ())
+        m_queues.erase (itQueue);
+    }
+  else
+    {
+      Remove (it);
+    }
+
+  return bundle;
+}
+
+bool
+BpBundleStore::Release (const BpBundleId &id)
+{
+  NS_LOG_FUNCTION (this << " " << id.src.Uri () << " " << id.seq);
+  EntryMap::iterator it = m_entries.find (id);
+  if (it == m_entries.end ())
+    return false;
+
+  Remove (it);
+  return true;
+}
+
+Ptr<Packet>
+BpBundleStore::Find (const BpBundleId &id) const
+{
+  NS_LOG_FUNCTION (this << " " << id.src.Uri () << " " << id.seq);
+  EntryMap::const_iterator it = m_entries.find (id);
+  if (it == m_entries.end ())
+    return 0;
+
+  return it->second.bundle;
+}
+
+uint32_t
+BpBundleStore::GetQueueLength (const BpEndpointId &eid) const
+{
+  NS_LOG_FUNCTION (this << " " << eid.Uri ());
+  std::map<BpEndpointId, std::list<BpBundleId> >::const_iterator it = m_queues.find (eid);
+  if (it == m_queues.end ())
+    return 0;
+
+  return it->second.size ();
+}
+
+uint32_t
+BpBundleStore::GetNBundles (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_bundles;
+}
+
+uint64_t
+BpBundleStore::GetNBytes (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_bytes;
+}
+
+void
+BpBundleStore::Remove (EntryMap::iterator it)
+{
+  NS_LOG_FUNCTION (this);
+  Entry &entry = it->second;
+
+  if (entry.queued)
+    {
+      std::map<BpEndpointId, std::list<BpBundleId> >::iterator itQueue = m_queues.find (entry.eid);
+      NS_ASSERT (itQueue != m_queues.end ());
+      itQueue->second.erase (entry.queueIt);
+      if (itQueue->second.empty ())
+        m_queues.erase (itQueue);
+    }
+
+  if (entry.expiryTick != 0)
+    {
+      m_wheel[entry.expiryTick % m_wheel.size ()].erase (entry.wheelIt);
+      m_nExpiring--;
+      if (m_nExpiring == 0)
+        m_tickEvent.Cancel ();
+    }
+
+  if (!entry.custody)
+    {
+      m_evictOrder.erase (EvictKey (entry.priority, entry.order));
+      m_evictIndex.erase (entry.order);
+    }
+
+  m_bytes -= entry.bundle->GetSize ();
+  m_bundles -= 1;
+  m_entries.erase (it);
+}
+
+bool
+BpBundleStore::MakeRoom (uint32_t size, uint8_t priority)
+{
+  NS_LOG_FUNCTION (this << " " << size << " " << (uint16_t) priority);
+  if (m_maxBytes != 0 && size > m_maxBytes)
+    return false;
+
+  // check that enough bundles can be evicted before evicting any of them
+  uint64_t bytes = m_bytes;
+  uint32_t bundles = m_bundles;
+  std::set<EvictKey>::iterator itKey = m_evictOrder.begin ();
+  while ((m_maxBytes != 0 && bytes + size > m_maxBytes) || (m_maxBundles != 0 && bundles + 1 > m_maxBundles))
+    {
+      if (itKey == m_evictOrder.end () || itKey->first > priority)
+        return false;
+
+      bytes -= m_entries.find (m_evictIndex[itKey->second])->second.bundle->GetSize ();
+      bundles -= 1;
+      itKey++;
+    }
+
+  while (bundles != m_bundles)
+    {
+      EntryMap::iterator it = m_entries.find (m_evictIndex[m_evictOrder.begin ()->second]);
+      Ptr<Packet> bundle = it->second.bundle;
+      NS_LOG_DEBUG ("evict bundle " << it->first.src.Uri () << " " << it->first.seq);
+      Remove (it);
+      m_evictedTrace (bundle);
+    }
+
+  return true;
+}
+
+uint64_t
+BpBundleStore::GetTick (const Time &t) const
+{
+  return t.GetTimeStep () / m_resolution.GetTimeStep ();
+}
+
+void
+BpBundleStore::ScheduleTick (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_nExpiring == 0 || m_tickEvent.IsRunning ())
+    return;
+
+  Time next = TimeStep ((GetTick (Simulator::Now ()) + 1) * m_resolution.GetTimeStep ());
+  m_tickEvent = Simulator::Schedule (next - Simulator::Now (), &BpBundleStore::Tick, this);
+}
+
+void
+BpBundleStore::Tick (void)
+{
+  NS_LOG_FUNCTION (this);
+  uint64_t now = GetTick (Simulator::Now ());
+
+  // bundles of later rounds of the wheel share the slot, skip them
+  std::list<BpBundleId> &slot = m_wheel[now % m_wheel.size ()];
+  std::list<BpBundleId>::iterator itSlot = slot.begin ();
+  while (itSlot != slot.end ())
+    {
+      EntryMap::iterator it = m_entries.find (*itSlot);
+      itSlot++;
+
+      NS_ASSERT (it != m_entries.end ());
+      if (it->second.expiryTick > now)
+        continue;
+
+      Ptr<Packet> bundle = it->second.bundle;
+      NS_LOG_DEBUG ("bundle " << it->first.src.Uri () << " " << it->first.seq << " expired");
+      Remove (it);
+      m_expiredTrace (bundle);
+    }
+
+  ScheduleTick ();
+}
+
+}  // namespace ns3
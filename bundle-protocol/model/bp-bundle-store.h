@@ -0,0 +1,263 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 University of New Brunswick
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Dizhi Zhou <dizhi.zhou@gmail.com>
+ */
+#ifndef BP_BUNDLE_STORE_H
+#define BP_BUNDLE_STORE_H
+
+#include "bp-endpoint-id.h"
+#include "bp-header.h"
+#include "ns3/object.h"
+#include "ns3/packet.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/sequence-number.h"
+#include "ns3/traced-value.h"
+#include "ns3/traced-callback.h"
+#include <list>
+#include <map>
+#include <set>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \brief the unique id of a bundle, section 3.1 of RFC 5050
+ */
+struct BpBundleId {
+  BpBundleId ();
+  BpBundleId (const BpEndpointId &src, const Time &timestamp, const SequenceNumber32 &seq);
+
+  /**
+   * \brief get the id of a bundle from its primary bundle header
+   */
+  BpBundleId (const BpHeader &header);
+
+  BpEndpointId src;      /// source endpoint id
+  Time timestamp;        /// creation timestamp
+  SequenceNumber32 seq;  /// creation timestamp sequence number
+};
+
+bool operator < (const BpBundleId &a, const BpBundleId &b);
+bool operator == (const BpBundleId &a, const BpBundleId &b);
+
+/**
+ * \ingroup bundleprotocol
+ *
+ * \brief A bounded storage of bundles
+ *
+ * Bundles are kept in a FIFO queue per endpoint id (the source endpoint id for
+ * bundles to be sent, the destination endpoint id for bundles received), and are
+ * indexed by their bundle id and by their expiry time.
+ *
+ * The bundle lifetime is enforced by a single hashed timer wheel: one event
+ * walks the wheel at ExpiryResolution while the store holds bundles with a
+ * lifetime. A lifetime of 0 means that the bundle never expires.
+ *
+ * When MaxBytes or MaxBundles is exceeded, bundles are evicted in the order of
+ * priority (bulk first) and age (oldest first). Bundles requesting custody
+ * transfer are never evicted: a bundle that does not fit otherwise is rejected.
+ * A bundle requesting custody transfer also stays in the store after it is
+ * dequeued, until the custody is accepted by the next hop (Release) or the
+ * bundle expires.
+ */
+class BpBundleStore : public Object
+{
+public:
+  static TypeId GetTypeId (void);
+
+  /**
+   * Constructor
+   */
+  BpBundleStore ();
+
+  /**
+   * Destroy
+   */
+  virtual ~BpBundleStore ();
+
+  /**
+   * \brief Store a bundle at the end of the queue of an endpoint id
+   *
+   * \param eid the endpoint id of the queue
+   * \param bundle the bundle, starting with its primary bundle header
+   *
+   * \return false if the bundle is rejected, because it is already expired,
+   * it is already stored or it does not fit in the budget of the store
+   */
+  bool Enqueue (const BpEndpointId &eid, Ptr<Packet> bundle);
+
+  /**
+   * \brief Store a bundle whose primary bundle header is already decoded
+   *
+   * \param eid the endpoint id of the queue
+   * \param bundle the bundle, starting with its primary bundle header
+   * \param header the primary bundle header of the bundle, of either version
+   *
+   * \return false if the bundle is rejected, see Enqueue (eid, bundle)
+   */
+  bool Enqueue (const BpEndpointId &eid, Ptr<Packet> bundle, const BpHeader &header);
+
+  /**
+   * \brief Get the first bundle in the queue of an endpoint id
+   *
+   * The bundle is removed from the queue. It is also removed from the store,
+   * unless it requests custody transfer.
+   *
+   * \param eid the endpoint id of the queue
+   *
+   * \return the bundle, or 0 if the queue is empty
+   */
+  Ptr<Packet> Dequeue (const BpEndpointId &eid);
+
+  /**
+   * \brief Get a given bundle out of the queue of its endpoint id
+   *
+   * The bundle is removed from the queue as by Dequeue (eid), wherever it is in
+   * the queue, e.g. when it was held until a contact while later bundles were sent.
+   *
+   * \param id the bundle id
+   *
+   * \return the bundle, or 0 if the bundle is not queued in the store
+   */
+  Ptr<Packet> Dequeue (const BpBundleId &id);
+
+  /**
+   * \brief Remove a bundle from the store, e.g. once its custody is accepted
+   *
+   * \param id the bundle id
+   *
+   * \return false if the bundle is not in the store
+   */
+  bool Release (const BpBundleId &id);
+
+  /**
+   * \param id the bundle id
+   *
+   * \return the bundle, or 0 if the bundle is not in the store
+   */
+  Ptr<Packet> Find (const BpBundleId &id) const;
+
+  /**
+   * \param eid the endpoint id of the queue
+   *
+   * \return the number of bundles in the queue of an endpoint id
+   */
+  uint32_t GetQueueLength (const BpEndpointId &eid) const;
+
+  /**
+   * \return the number of bundles in the store
+   */
+  uint32_t GetNBundles (void) const;
+
+  /**
+   * \return the number of bytes in the store
+   */
+  uint64_t GetNBytes (void) const;
+
+  /**
+   * \brief TracedCallback signature for bundles leaving the store
+   *
+   * \param bundle the bundle
+   */
+  typedef void (* BundleTracedCallback)(Ptr<const Packet> bundle);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /**
+   * \brief a stored bundle
+   */
+  struct Entry {
+    Ptr<Packet> bundle;                        /// the bundle
+    BpEndpointId eid;                          /// endpoint id of the queue
+    bool queued;                               /// is the bundle in the queue?
+    std::list<BpBundleId>::iterator queueIt;   /// position in the queue
+    uint8_t priority;                          /// priority of bundle
+    bool custody;                              /// custody transfer requested?
+    uint64_t order;                            /// insertion order
+    uint64_t expiryTick;                       /// expiry tick, 0 if the bundle never expires
+    std::list<BpBundleId>::iterator wheelIt;   /// position in the timer wheel
+  };
+
+  /**
+   * \brief key of the eviction order: lower priority first, then older first
+   */
+  typedef std::pair<uint8_t, uint64_t> EvictKey;
+
+  typedef std::map<BpBundleId, Entry> EntryMap;
+
+  /**
+   * \brief Remove a bundle from all the indexes and the budget
+   */
+  void Remove (EntryMap::iterator it);
+
+  /**
+   * \brief Take a bundle out of its queue, and out of the store unless it
+   * requests custody transfer
+   */
+  Ptr<Packet> Dequeue (EntryMap::iterator it);
+
+  /**
+   * \brief Evict bundles with a priority not above the given one until
+   * size bytes and one more bundle fit in the budget
+   *
+   * \return false if there is no enough space even after eviction
+   */
+  bool MakeRoom (uint32_t size, uint8_t priority);
+
+  /**
+   * \brief Expire the bundles in the current slot of the timer wheel
+   */
+  void Tick (void);
+
+  /**
+   * \brief Schedule the next tick if the timer wheel is not empty
+   */
+  void ScheduleTick (void);
+
+  /**
+   * \return the tick of the timer wheel at time t
+   */
+  uint64_t GetTick (const Time &t) const;
+
+  uint64_t m_maxBytes;     /// budget in bytes, 0 for no limit
+  uint32_t m_maxBundles;   /// budget in bundles, 0 for no limit
+  Time m_resolution;       /// the time covered by a slot of the timer wheel
+  uint32_t m_nSlots;       /// number of slots in the timer wheel, used when the wheel is created
+
+  EntryMap m_entries;                                        /// index by bundle id
+  std::map<BpEndpointId, std::list<BpBundleId> > m_queues;   /// FIFO queues by endpoint id
+  std::set<EvictKey> m_evictOrder;                           /// evictable bundles
+  std::map<uint64_t, BpBundleId> m_evictIndex;               /// evictable bundles by insertion order
+  std::vector<std::list<BpBundleId> > m_wheel;               /// timer wheel, index by expiry tick
+  uint32_t m_nExpiring;                                      /// number of bundles in the timer wheel
+  EventId m_tickEvent;                                       /// the next tick of the timer wheel
+  uint64_t m_order;                                          /// insertion counter
+
+  TracedValue<uint64_t> m_bytes;     /// occupancy in bytes
+  TracedValue<uint32_t> m_bundles;   /// occupancy in bundles
+  TracedCallback<Ptr<const Packet> > m_expiredTrace;   /// bundles removed at the end of their lifetime
+  TracedCallback<Ptr<const Packet> > m_evictedTrace;   /// bundles evicted to make room
+  TracedCallback<Ptr<const Packet> > m_rejectedTrace;  /// bundles not accepted
+};
+
+}  // namespace ns3
+
+#endif /* BP_BUNDLE_STORE_H */
@@ -0,0 +1,571 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 University of New Brunswick
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Dizhi Zhou <dizhi.zhou@gmail.com>
+ */
+
+#include "bp-cgr-routing-protocol.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <map>
+#include <queue>
+#include <sstream>
+
+NS_LOG_COMPONENT_DEFINE ("BpCgrRoutingProtocol");
+
+namespace ns3 {
+
+BpCgrContact::BpCgrContact ()
+  : from (),
+    to (),
+    start (0),
+    end (0),
+    rate (0),
+    owlt (0)
+{
+}
+
+BpCgrRoute::BpCgrRoute ()
+  : firstContact (0),
+    nextHop (),
+    sendTime (0),
+    arrivalTime (0),
+    expiryTime (0),
+    hops (0)
+{
+}
+
+/**
+ * \brief order the contacts of a node by end time
+ */
+class BpCgrContactEndLess
+{
+public:
+  BpCgrContactEndLess (const std::vector<BpCgrContact> &contacts)
+    : m_contacts (contacts)
+  {
+  }
+
+  bool operator () (uint32_t a, uint32_t b) const
+  {
+    return m_contacts[a].end < m_contacts[b].end;
+  }
+
+  bool operator () (uint32_t a, const Time &t) const
+  {
+    return m_contacts[a].end <= t;
+  }
+
+private:
+  const std::vector<BpCgrContact> &m_contacts;
+};
+
+NS_OBJECT_ENSURE_REGISTERED (BpCgrRoutingProtocol);
+
+TypeId
+BpCgrRoutingProtocol::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::BpCgrRoutingProtocol")
+    .SetParent<BpRoutingProtocol> ()
+    .AddConstructor<BpCgrRoutingProtocol> ()
+    .AddAttribute ("MaxRoutes", "Max number of routes computed per destination",
+                   UintegerValue (3),
+                   MakeUintegerAccessor (&BpCgrRoutingProtocol::m_maxRoutes),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("BundleSize", "Nominal bundle size in bytes, used to account for the transmission time over a contact",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&BpCgrRoutingProtocol::m_bundleSize),
+                   MakeUintegerChecker<uint32_t> ())
+  ;
+  return tid;
+}
+
+BpCgrRoutingProtocol::BpCgrRoutingProtocol ()
+  : m_bp (0),
+    m_localEid (),
+    m_maxRoutes (3),
+    m_bundleSize (0),
+    m_sorted (true)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+BpCgrRoutingProtocol::~BpCgrRoutingProtocol ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+BpCgrRoutingProtocol::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_bp = 0;
+  m_routes.clear ();
+  BpRoutingProtocol::DoDispose ();
+}
+
+void
+BpCgrRoutingProtocol::SetBundleProtocol (Ptr<BundleProtocol> bundleProtocol)
+{
+  NS_LOG_FUNCTION (this << " " << bundleProtocol);
+  m_bp = bundleProtocol;
+  m_routes.clear ();
+}
+
+void
+BpCgrRoutingProtocol::SetLocalEid (const BpEndpointId &eid)
+{
+  NS_LOG_FUNCTION (this << " " << eid.Uri ());
+  m_localEid = eid;
+  m_routes.clear ();
+}
+
+int
+BpCgrRoutingProtocol::AddNode (const BpEndpointId &eid, InetSocketAddress address)
+{
+  NS_LOG_FUNCTION (this << " " << eid.Uri () << " " << address.GetIpv4 () << " " << address.GetPort ());
+  if (m_addresses.find (eid) != m_addresses.end ())
+    {
+      // duplicate node
+      return -1;
+    }
+
+  m_addresses.insert (std::pair<BpEndpointId, InetSocketAddress>(eid, address));
+  GetNodeIndex (eid);
+
+  return 0;
+}
+
+int
+BpCgrRoutingProtocol::AddContact (const BpCgrContact &contact)
+{
+  NS_LOG_FUNCTION (this << " " << contact.from.Uri () << " " << contact.to.Uri () << " " << contact.start << " " << contact.end);
+  if (contact.from == contact.to || contact.end <= contact.start ||
+      contact.rate < 0 || contact.owlt.IsStrictlyNegative ())
+    {
+      NS_LOG_WARN ("BpCgrRoutingProtocol::AddContact (): invalid contact");
+      return -1;
+    }
+
+  uint32_t from = GetNodeIndex (contact.from);
+  uint32_t to = GetNodeIndex (contact.to);
+
+  uint32_t index = m_contacts.size ();
+  m_contacts.push_back (contact);
+  m_contactNodes.push_back (std::make_pair (from, to));
+  m_outContacts[from].push_back (index);
+
+  // contacts are sorted by the first search, not one by one
+  m_sorted = false;
+  m_routes.clear ();
+
+  return index;
+}
+
+/**
+ * \brief a range of an ION contact plan: the one way light time between two
+ * nodes during [start, end), in both directions
+ */
+struct BpCgrRange
+{
+  Time start;    /// start of the range
+  Time end;      /// end of the range
+  Time owlt;     /// one way light time
+};
+
+/**
+ * \brief Parse an ION time, either +<seconds> or <seconds> relative to the
+ * start of the simulation; absolute ION times are not supported
+ */
+static bool
+ParseIonTime (const std::string &value, Time &t)
+{
+  std::istringstream iss (value[0] == '+' ? value.substr (1) : value);
+  double seconds;
+  if (!(iss >> seconds) || !iss.eof ())
+    return false;
+
+  t = Seconds (seconds);
+  return true;
+}
+
+/**
+ * \return the endpoint id of an ION node number
+ */
+static BpEndpointId
+GetIonEndpointId (uint64_t node)
+{
+  std::ostringstream ssp;
+  ssp << node << ".0";
+  return BpEndpointId ("ipn", ssp.str ());
+}
+
+int
+BpCgrRoutingProtocol::LoadContactPlan (const std::string &filename)
+{
+  NS_LOG_FUNCTION (this << " " << filename);
+  std::ifstream file (filename.c_str ());
+  if (!file.is_open ())
+    {
+      NS_LOG_WARN ("BpCgrRoutingProtocol::LoadContactPlan (): cannot open " << filename);
+      return -1;
+    }
+
+  // ranges may follow their contacts, so contacts are added at the end
+  std::vector<std::pair<BpCgrContact, uint32_t> > contacts;
+  std::map<std::pair<uint64_t, uint64_t>, std::vector<BpCgrRange> > ranges;
+  std::vector<std::pair<uint64_t, uint64_t> > contactNodes;
+
+  uint32_t lineNumber = 0;
+  std::string line;
+  while (std::getline (file, line))
+    {
+      lineNumber++;
+      std::istringstream iss (line);
+      std::string type;
+      if (!(iss >> type) || type[0] == '#')
+        continue;
+
+      if (type == "node")
+        {
+          std::string eid, ipv4;
+          uint16_t port;
+          if (!(iss >> eid >> ipv4 >> port))
+            {
+              NS_LOG_WARN ("BpCgrRoutingProtocol::LoadContactPlan (): malformed node at line " << lineNumber);
+              return -1;
+            }
+          AddNode (BpEndpointId (eid), InetSocketAddress (Ipv4Address (ipv4.c_str ()), port));
+          continue;
+        }
+
+      std::string object;
+      if (type != "a" || !(iss >> object) || (object != "contact" && object != "range"))
+        {
+          if (type.size () > 1)
+            {
+              NS_LOG_WARN ("BpCgrRoutingProtocol::LoadContactPlan (): unknown entry at line " << lineNumber);
+              return -1;
+            }
+
+          // other ionadmin commands do not change the contact graph
+          NS_LOG_DEBUG ("Ignore ionadmin command at line " << lineNumber);
+          continue;
+        }
+
+      std::string start, end;
+      uint64_t from, to;
+      double value;
+      Time startTime, endTime;
+      if (!(iss >> start >> end >> from >> to >> value) ||
+          !ParseIonTime (start, startTime) || !ParseIonTime (end, endTime))
+        {
+          NS_LOG_WARN ("BpCgrRoutingProtocol::LoadContactPlan (): malformed " << object << " at line " << lineNumber);
+          return -1;
+        }
+
+      if (object == "contact")
+        {
+          BpCgrContact contact;
+          contact.from = GetIonEndpointId (from);
+          contact.to = GetIonEndpointId (to);
+          contact.start = startTime;
+          contact.end = endTime;
+          contact.rate = value;
+          contacts.push_back (std::make_pair (contact, lineNumber));
+          contactNodes.push_back (std::make_pair (std::min (from, to), std::max (from, to)));
+        }
+      else
+        {
+          BpCgrRange range;
+          range.start = startTime;
+          range.end = endTime;
+          range.owlt = Seconds (value);
+          ranges[std::make_pair (std::min (from, to), std::max (from, to))].push_back (range);
+        }
+    }
+
+  for (uint32_t i = 0; i < contacts.size (); i++)
+    {
+      // the light time is the one of the range at the start of the contact,
+      // or 0 if there is no such range
+      BpCgrContact &contact = contacts[i].first;
+      std::map<std::pair<uint64_t, uint64_t>, std::vector<BpCgrRange> >::const_iterator it = ranges.find (contactNodes[i]);
+      if (it != ranges.end ())
+        {
+          for (std::vector<BpCgrRange>::const_iterator range = it->second.begin (); range != it->second.end (); range++)
+            {
+              if (range->start <= contact.start && contact.start < range->end)
+                {
+                  contact.owlt = range->owlt;
+                  break;
+                }
+            }
+        }
+
+      if (AddContact (contact) < 0)
+        {
+          NS_LOG_WARN ("BpCgrRoutingProtocol::LoadContactPlan (): invalid contact at line " << contacts[i].second);
+          return -1;
+        }
+    }
+
+  return contacts.size ();
+}
+
+uint32_t
+BpCgrRoutingProtocol::GetNContacts (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_contacts.size ();
+}
+
+const BpCgrContact &
+BpCgrRoutingProtocol::GetContact (uint32_t index) const
+{
+  NS_LOG_FUNCTION (this << " " << index);
+  NS_ASSERT (index < m_contacts.size ());
+  return m_contacts[index];
+}
+
+bool
+BpCgrRoutingProtocol::FindRoute (const BpEndpointId &dst, BpCgrRoute &route)
+{
+  NS_LOG_FUNCTION (this << " " << dst.Uri ());
+  uint32_t dstIndex = GetNodeIndex (dst);
+  Time now = Simulator::Now ();
+
+  std::map<uint32_t, std::vector<BpCgrRoute> >::iterator it = m_routes.find (dstIndex);
+  if (it != m_routes.end () && !it->second.empty ())
+    {
+      // drop the routes over contacts which are already closed
+      std::vector<BpCgrRoute> &routes = it->second;
+      uint32_t n = 0;
+      for (uint32_t i = 0; i < routes.size (); i++)
+        {
+          if (routes[i].expiryTime > now)
+            routes[n++] = routes[i];
+        }
+      routes.resize (n);
+
+      if (n == 0)
+        {
+          NS_LOG_DEBUG ("All routes to " << dst.Uri () << " expired, recompute");
+          ComputeRoutes (dstIndex, routes);
+        }
+    }
+  else if (it == m_routes.end ())
+    {
+      it = m_routes.insert (std::make_pair (dstIndex, std::vector<BpCgrRoute> ())).first;
+      ComputeRoutes (dstIndex, it->second);
+    }
+
+  // an empty route list stays valid until the contact plan changes, since
+  // contacts only close as time goes on
+  const std::vector<BpCgrRoute> &routes = it->second;
+  if (routes.empty ())
+    return false;
+
+  uint32_t best = 0;
+  for (uint32_t i = 1; i < routes.size (); i++)
+    {
+      if (routes[i].arrivalTime < routes[best].arrivalTime)
+        best = i;
+    }
+
+  route = routes[best];
+  return true;
+}
+
+InetSocketAddress
+BpCgrRoutingProtocol::GetRoute (BpEndpointId eid)
+{
+  NS_LOG_FUNCTION (this << " " << eid.Uri ());
+  InetSocketAddress defaultAddr ("127.0.0.1", 0);
+
+  BpEndpointId nextHop = eid;
+  if (GetNodeIndex (eid) != GetLocalIndex ())
+    {
+      BpCgrRoute route;
+      if (!FindRoute (eid, route))
+        return defaultAddr;
+
+      nextHop = route.nextHop;
+    }
+
+  std::map<BpEndpointId, InetSocketAddress>::iterator it = m_addresses.find (nextHop);
+  if (it == m_addresses.end ())
+    return defaultAddr;
+
+  return it->second;
+}
+
+Time
+BpCgrRoutingProtocol::GetSendTime (BpEndpointId eid)
+{
+  NS_LOG_FUNCTION (this << " " << eid.Uri ());
+  Time now = Simulator::Now ();
+  BpCgrRoute route;
+  if (!FindRoute (eid, route) || route.sendTime < now)
+    return now;
+
+  return route.sendTime;
+}
+
+void
+BpCgrRoutingProtocol::ComputeRoutes (uint32_t dst, std::vector<BpCgrRoute> &routes)
+{
+  NS_LOG_FUNCTION (this << " " << dst);
+  routes.clear ();
+
+  // each route starts with a different contact, by suppressing the first
+  // contact of the routes already found
+  std::vector<bool> suppressed (m_contacts.size (), false);
+  BpCgrRoute route;
+  while (routes.size () < m_maxRoutes && Search (dst, suppressed, route))
+    {
+      routes.push_back (route);
+      suppressed[route.firstContact] = true;
+    }
+
+  NS_LOG_DEBUG ("Computed " << routes.size () << " routes to " << m_nodes[dst].Uri ());
+}
+
+bool
+BpCgrRoutingProtocol::Search (uint32_t dst, const std::vector<bool> &suppressed, BpCgrRoute &route)
+{
+  NS_LOG_FUNCTION (this << " " << dst);
+  if (!m_sorted)
+    {
+      BpCgrContactEndLess less (m_contacts);
+      for (uint32_t i = 0; i < m_outContacts.size (); i++)
+        std::sort (m_outContacts[i].begin (), m_outContacts[i].end (), less);
+      m_sorted = true;
+    }
+
+  uint32_t local = GetLocalIndex ();
+  if (local == dst)
+    return false;
+
+  uint32_t nNodes = m_nodes.size ();
+  const int64_t infinity = std::numeric_limits<int64_t>::max ();
+  m_arrival.assign (nNodes, infinity);
+  m_pred.assign (nNodes, -1);
+  m_visited.assign (nNodes, false);
+
+  // earliest arrival time, node
+  typedef std::pair<int64_t, uint32_t> QueueItem;
+  std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem> > queue;
+
+  Time now = Simulator::Now ();
+  m_arrival[local] = now.GetTimeStep ();
+  queue.push (QueueItem (m_arrival[local], local));
+
+  while (!queue.empty ())
+    {
+      QueueItem item = queue.top ();
+      queue.pop ();
+      uint32_t u = item.second;
+      if (m_visited[u])
+        continue;
+      m_visited[u] = true;
+      if (u == dst)
+        break;
+
+      // only the contacts ending after the bundle is at u can be used
+      Time t = TimeStep (item.first);
+      const std::vector<uint32_t> &out = m_outContacts[u];
+      std::vector<uint32_t>::const_iterator first = std::lower_bound (out.begin (), out.end (), t, BpCgrContactEndLess (m_contacts));
+      for (std::vector<uint32_t>::const_iterator c = first; c != out.end (); c++)
+        {
+          if (u == local && suppressed[*c])
+            continue;
+
+          const BpCgrContact &contact = m_contacts[*c];
+          if (contact.rate == 0 && m_bundleSize > 0)
+            continue;
+
+          Time start = std::max (t, contact.start);
+          Time tx = contact.rate > 0 ? Seconds (m_bundleSize / contact.rate) : Seconds (0);
+          if (start + tx > contact.end)
+            continue;
+
+          uint32_t v = m_contactNodes[*c].second;
+          int64_t arrival = (start + tx + contact.owlt).GetTimeStep ();
+          if (!m_visited[v] && arrival < m_arrival[v])
+            {
+              m_arrival[v] = arrival;
+              m_pred[v] = *c;
+              queue.push (QueueItem (arrival, v));
+            }
+        }
+    }
+
+  if (m_arrival[dst] == infinity)
+    return false;
+
+  // walk back to the first contact
+  route.hops = 0;
+  route.expiryTime = Time::Max ();
+  uint32_t node = dst;
+  uint32_t contact = 0;
+  while (node != local)
+    {
+      contact = m_pred[node];
+      route.hops++;
+      route.expiryTime = std::min (route.expiryTime, m_contacts[contact].end);
+      node = m_contactNodes[contact].first;
+    }
+
+  route.firstContact = contact;
+  route.nextHop = m_contacts[contact].to;
+  route.sendTime = std::max (now, m_contacts[contact].start);
+  route.arrivalTime = TimeStep (m_arrival[dst]);
+
+  return true;
+}
+
+uint32_t
+BpCgrRoutingProtocol::GetNodeIndex (const BpEndpointId &eid)
+{
+  std::map<BpEndpointId, uint32_t>::iterator it = m_nodeIndex.find (eid);
+  if (it != m_nodeIndex.end ())
+    return it->second;
+
+  uint32_t index = m_nodes.size ();
+  m_nodeIndex.insert (std::pair<BpEndpointId, uint32_t>(eid, index));
+  m_nodes.push_back (eid);
+  m_outContacts.push_back (std::vector<uint32_t> ());
+
+  return index;
+}
+
+uint32_t
+BpCgrRoutingProtocol::GetLocalIndex (void)
+{
+  if (m_bp)
+    return GetNodeIndex (m_bp->GetBpEndpointId ());
+
+  return GetNodeIndex (m_localEid);
+}
+
+} // namespace ns3
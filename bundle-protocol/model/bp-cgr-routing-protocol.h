@@ -0,0 +1,235 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 University of New Brunswick
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Dizhi Zhou <dizhi.zhou@gmail.com>
+ */
+#ifndef BP_CGR_ROUTING_PROTOCOL_H
+#define BP_CGR_ROUTING_PROTOCOL_H
+
+#include "bp-routing-protocol.h"
+#include "bundle-protocol.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/nstime.h"
+#include <string>
+#include <map>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \brief a contact of the contact plan: node from can transmit to node to
+ * during [start, end)
+ */
+struct BpCgrContact
+{
+  BpCgrContact ();
+
+  BpEndpointId from;  /// the transmitting node
+  BpEndpointId to;    /// the receiving node
+  Time start;         /// start of the contact
+  Time end;           /// end of the contact
+  double rate;        /// transmission rate in bytes/s, as in ION
+  Time owlt;          /// one way light time
+};
+
+/**
+ * \brief a route of the contact graph
+ */
+struct BpCgrRoute
+{
+  BpCgrRoute ();
+
+  uint32_t firstContact;  /// index of the first contact of the route
+  BpEndpointId nextHop;   /// the receiving node of the first contact
+  Time sendTime;          /// the earliest time the bundle can be sent on the first contact
+  Time arrivalTime;       /// the earliest time the bundle arrives at the destination
+  Time expiryTime;        /// the end of the earliest ending contact of the route
+  uint32_t hops;          /// number of contacts of the route
+};
+
+/**
+ * \brief Contact graph routing
+ *
+ * Routes are computed from a contact plan, which lists the contacts between
+ * bundle nodes and the internet socket address of each bundle node. For each
+ * destination, a list of routes with different first contacts is computed by
+ * an earliest arrival variant of Dijkstra's algorithm: the cost of a contact
+ * is the time the bundle arrives at its receiving node, waiting for the start
+ * of the contact if necessary.
+ *
+ * The route lists are cached per destination. A route is dropped once one of
+ * its contacts ends, and the route list of a destination is only recomputed
+ * when it runs out of routes. Adding contacts clears the cache.
+ *
+ * Routes are computed from the local node, the endpoint id of the bundle
+ * protocol the routing protocol is set to, so each bundle node needs its own
+ * BpCgrRoutingProtocol.
+ */
+class BpCgrRoutingProtocol : public BpRoutingProtocol
+{
+public:
+  static TypeId GetTypeId (void);
+
+  /**
+   * Constructor
+   */
+  BpCgrRoutingProtocol ();
+
+  /**
+   * Destroy
+   */
+  virtual ~BpCgrRoutingProtocol ();
+
+  /**
+   * \brief Set bundle protocol of the local node
+   *
+   * \param bundleProtocol bundle protocol
+   */
+  virtual void SetBundleProtocol (Ptr<BundleProtocol> bundleProtocol);
+
+  /**
+   * \brief Set the local node, if there is no bundle protocol
+   *
+   * \param eid endpoint id of the local node
+   */
+  void SetLocalEid (const BpEndpointId &eid);
+
+  /**
+   * \brief Add a bundle node and its internet socket address
+   *
+   * \return -1 if the node is already added, otherwise 0
+   */
+  int AddNode (const BpEndpointId &eid, InetSocketAddress address);
+
+  /**
+   * \brief Add a contact to the contact plan
+   *
+   * \return the index of the contact, or -1 if the contact is invalid
+   */
+  int AddContact (const BpCgrContact &contact);
+
+  /**
+   * \brief Load an ION contact plan file
+   *
+   * Each line is either empty, a comment starting with '#', or one of
+   *
+   *   node <eid> <ipv4 address> <port>
+   *   a contact <start> <end> <from node> <to node> <rate bytes/s>
+   *   a range <start> <end> <from node> <to node> <owlt s>
+   *
+   * as written by ContactPlanGenerator::WriteIonContactPlan. Times are in
+   * seconds from the start of the simulation, with or without the leading
+   * '+' of ION relative times. ION node numbers stand for the endpoint ids
+   * ipn:<node>.0, which node lines map to internet socket addresses. Ranges
+   * hold in both directions, and a contact takes the light time of the range
+   * open at its start. Other ionadmin commands are ignored.
+   *
+   * \param filename the contact plan file
+   *
+   * \return the number of contacts loaded, or -1 if the file cannot be read
+   * or has a malformed line
+   */
+  int LoadContactPlan (const std::string &filename);
+
+  /**
+   * \return the number of contacts in the contact plan
+   */
+  uint32_t GetNContacts (void) const;
+
+  /**
+   * \param index index of the contact
+   *
+   * \return the contact
+   */
+  const BpCgrContact &GetContact (uint32_t index) const;
+
+  /**
+   * \brief Get the best route towards a destination at the current time
+   *
+   * \param dst the destination endpoint id
+   * \param route set to the route with the earliest arrival time
+   *
+   * \return false if there is no route
+   */
+  bool FindRoute (const BpEndpointId &dst, BpCgrRoute &route);
+
+  /**
+   * \return the internet socket address of the next hop towards eid, or the
+   * address of the local node if eid is the local node; If there is no route,
+   * return the 127.0.0.1 with port 0
+   */
+  virtual InetSocketAddress GetRoute (BpEndpointId eid);
+
+  /**
+   * \return the start of the first contact of the best route towards eid, or
+   * the current time if it is already open or there is no route
+   */
+  virtual Time GetSendTime (BpEndpointId eid);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /**
+   * \brief Compute the route list of a destination
+   */
+  void ComputeRoutes (uint32_t dst, std::vector<BpCgrRoute> &routes);
+
+  /**
+   * \brief Earliest arrival search over the contact graph from the local node
+   *
+   * \param dst index of the destination node
+   * \param suppressed contacts that cannot be the first contact of the route
+   * \param route set to the route found
+   *
+   * \return false if there is no route
+   */
+  bool Search (uint32_t dst, const std::vector<bool> &suppressed, BpCgrRoute &route);
+
+  /**
+   * \return the index of a node, added if unknown
+   */
+  uint32_t GetNodeIndex (const BpEndpointId &eid);
+
+  /**
+   * \return the index of the local node
+   */
+  uint32_t GetLocalIndex (void);
+
+  Ptr<BundleProtocol> m_bp;       /// bundle protocol of the local node
+  BpEndpointId m_localEid;        /// the local node, if there is no bundle protocol
+  uint32_t m_maxRoutes;           /// max number of routes per destination
+  uint32_t m_bundleSize;          /// nominal bundle size used for transmission times
+
+  std::vector<BpCgrContact> m_contacts;                        /// the contact plan
+  std::vector<std::pair<uint32_t, uint32_t> > m_contactNodes;  /// index of the transmitting and receiving nodes per contact
+  std::vector<std::vector<uint32_t> > m_outContacts;            /// contacts per transmitting node, by end time
+  std::map<BpEndpointId, uint32_t> m_nodeIndex;                /// node index by endpoint id
+  std::vector<BpEndpointId> m_nodes;                           /// endpoint id by node index
+  std::map<BpEndpointId, InetSocketAddress> m_addresses;       /// internet socket address of the nodes
+  std::map<uint32_t, std::vector<BpCgrRoute> > m_routes;       /// cached route lists per destination, empty if unreachable
+  bool m_sorted;                                               /// are m_outContacts sorted?
+
+  // reused by Search () to avoid allocations
+  std::vector<int64_t> m_arrival;      /// earliest arrival time per node, in time steps
+  std::vector<int32_t> m_pred;         /// contact used to reach each node
+  std::vector<bool> m_visited;         /// node settled
+};
+
+}  // namespace ns3
+
+#endif /* BP_CGR_ROUTING_PROTOCOL_H */
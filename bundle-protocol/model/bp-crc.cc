@@ -0,0 +1,111 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 University of New Brunswick
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Dizhi Zhou <dizhi.zhou@gmail.com>
+ */
+
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "bp-crc.h"
+
+NS_LOG_COMPONENT_DEFINE ("BpCrc");
+
+namespace ns3 {
+
+BpCrc::BpCrc ()
+{ 
+  NS_LOG_FUNCTION (this);
+}
+
+BpCrc::~BpCrc ()
+{ 
+  NS_LOG_FUNCTION (this);
+}
+
+uint32_t 
+BpCrc::GetSize (CrcType type)
+{ 
+  NS_LOG_FUNCTION (this << " " << type);
+  switch (type)
+    {
+    case CRC_16:
+      return 2;
+    case CRC_32C:
+      return 4;
+    default:
+      return 0;
+    }
+}
+
+const uint32_t *
+BpCrc::GetTable (CrcType type)
+{ 
+  // reflected polynomials of CRC-16/X-25 (0x1021) and CRC-32C (0x1edc6f41)
+  static uint32_t crc16Table[256];
+  static uint32_t crc32cTable[256];
+  static bool built = false;
+
+  if (!built)
+    {
+      for (uint32_t n = 0; n < 256; n++)
+        {
+          uint32_t crc16 = n;
+          uint32_t crc32c = n;
+          for (uint32_t k = 0; k < 8; k++)
+            {
+              crc16 = (crc16 & 1) ? (crc16 >> 1) ^ 0x8408 : crc16 >> 1;
+              crc32c = (crc32c & 1) ? (crc32c >> 1) ^ 0x82f63b78 : crc32c >> 1;
+            }
+          crc16Table[n] = crc16;
+          crc32cTable[n] = crc32c;
+        }
+      built = true;
+    }
+
+  return type == CRC_16 ? crc16Table : crc32cTable;
+}
+
+uint32_t 
+BpCrc::Calculate (CrcType type, const uint8_t *data, uint32_t size, uint32_t crc)
+{ 
+  NS_LOG_FUNCTION (this << " " << type << " " << size);
+  NS_ASSERT (type == CRC_16 || type == CRC_32C);
+  const uint32_t *table = GetTable (type);
+  uint32_t mask = type == CRC_16 ? 0xffff : 0xffffffff;
+
+  // both CRCs start from all ones and are inverted at the end
+  crc ^= mask;
+  for (uint32_t k = 0; k < size; k++)
+    crc = table[(crc ^ data[k]) & 0xff] ^ (crc >> 8);
+  return crc ^ mask;
+}
+
+uint32_t 
+BpCrc::Calculate (CrcType type, Buffer::Iterator start, uint32_t size, uint32_t crc)
+{ 
+  NS_LOG_FUNCTION (this << " " << type << " " << size);
+  NS_ASSERT (type == CRC_16 || type == CRC_32C);
+  const uint32_t *table = GetTable (type);
+  uint32_t mask = type == CRC_16 ? 0xffff : 0xffffffff;
+
+  crc ^= mask;
+  for (uint32_t k = 0; k < size; k++)
+    crc = table[(crc ^ start.ReadU8 ()) & 0xff] ^ (crc >> 8);
+  return crc ^ mask;
+}
+
+} // namespace ns3
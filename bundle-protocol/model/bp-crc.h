@@ -0,0 +1,94 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 University of New Brunswick
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Dizhi Zhou <dizhi.zhou@gmail.com>
+ */
+#ifndef BP_CRC_H
+#define BP_CRC_H
+
+#include <stdint.h>
+#include "ns3/buffer.h"
+
+namespace ns3 {
+
+/**
+ * \brief the cyclic redundancy checks of bundle blocks, section 4.2.1 of RFC 9171
+ *
+ * CRC-16 is the X-25 CRC and CRC-32 is the Castagnoli CRC-32C. Both are 
+ * computed a byte at a time from a lookup table. A CRC can be computed in 
+ * several steps, by passing the result of a step as the crc of the next one.
+ */
+class BpCrc
+{
+public:
+  /**
+   * CRC types, section 4.2.1 of RFC 9171
+   */
+  typedef enum {
+    CRC_NONE = 0,
+    CRC_16 = 1,
+    CRC_32C = 2
+  } CrcType;
+
+  /**
+   * Constructor
+   */
+  BpCrc ();
+
+  /**
+   * Destroy
+   */
+  virtual ~BpCrc ();
+
+  /**
+   * \param type the CRC type
+   * \return the number of bytes of a CRC value
+   */
+  uint32_t GetSize (CrcType type);
+
+  /**
+   * \brief compute the CRC of a byte array
+   *
+   * \param type the CRC type, either CRC_16 or CRC_32C
+   * \param data the byte array
+   * \param size the number of bytes
+   * \param crc the CRC of the preceding bytes, 0 if there are none
+   * \return the CRC of the preceding bytes and the byte array
+   */
+  uint32_t Calculate (CrcType type, const uint8_t *data, uint32_t size, uint32_t crc = 0);
+
+  /**
+   * \brief compute the CRC of bytes in a Buffer
+   *
+   * \param type the CRC type, either CRC_16 or CRC_32C
+   * \param start buffer iterator at the first byte
+   * \param size the number of bytes
+   * \param crc the CRC of the preceding bytes, 0 if there are none
+   * \return the CRC of the preceding bytes and the bytes in the buffer
+   */
+  uint32_t Calculate (CrcType type, Buffer::Iterator start, uint32_t size, uint32_t crc = 0);
+
+private:
+  /**
+   * \return the lookup table of a CRC type, built at the first call
+   */
+  const uint32_t *GetTable (CrcType type);
+};
+
+} // namespace ns3
+
+#endif /* BP_CRC_H */
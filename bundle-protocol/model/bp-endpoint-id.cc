@@ -33,7 +33,6 @@ BpEndpointId::BpEndpointId (const std::string scheme, const std::string ssp)
 { 
   NS_LOG_FUNCTION (this << " " << scheme << " " << ssp);
   ParseComponent (scheme, ssp);
-  m_uri = scheme + ":" + ssp;
 }
 
 BpEndpointId::BpEndpointId (const std::string uri)
@@ -41,7 +40,6 @@ BpEndpointId::BpEndpointId (const std::string uri)
 { 
   NS_LOG_FUNCTION (this << " " << uri);
   ParseUri (uri);
-  m_uri = uri;
 }
 
 void 
@@ -75,10 +73,11 @@ BpEndpointId::ParseComponent (const std::string &scheme, const std::string &ssp)
     }
 
   // build URI
+  m_uri = schemeStr + ":" + sspStr;
   m_scheme.offset = 0;
   m_scheme.length = schemeLen;
   m_ssp.offset = schemeLen + 1; 
-  m_ssp.length = m_uri.length () - m_ssp.offset;
+  m_ssp.length = sspLen;
 
 }
 
@@ -97,15 +96,16 @@ BpEndpointId::ParseUri (const std::string uri)
     }
 
   size_t semicolon_pos = 0; 
-  if((semicolon_pos = uri.find(':')) == std::string::npos)
+  if((semicolon_pos = uriStr.find(':')) == std::string::npos)
     {
       NS_LOG_WARN ("BpEndpointId::BuildUri (), uri must include semicolon ':'");
       uriStr = "dtn:none";
       uriLen = uriStr.length ();
+      semicolon_pos = uriStr.find(':');
     }
 
   std::string scheme = uriStr.substr(0, semicolon_pos);
-  std::string ssp = uriStr.substr(semicolon_pos, uriLen - semicolon_pos);
+  std::string ssp = uriStr.substr(semicolon_pos + 1, uriLen - semicolon_pos - 1);
 
   ParseComponent (scheme, ssp);
 }
@@ -43,7 +43,10 @@ BpHeader::BpHeader ()
     m_dictLength (0),
     m_dictionary (""),
     m_fragOffset (0),
-    m_aduLength (0)
+    m_aduLength (0),
+    m_encodedHead (0),
+    m_encodedTail (0),
+    m_encodedValid (false)
 { 
   NS_LOG_FUNCTION (this);
 }
@@ -85,82 +88,62 @@ BpHeader::Print (std::ostream &os) const
   NS_LOG_FUNCTION (this);
 }
 
+void
+BpHeader::Encode (void) const
+{ 
+  NS_LOG_FUNCTION (this);
+  Sdnv sdnv;
+  uint8_t *p = m_encoded;
+
+  *p++ = m_version;
+  p += sdnv.Encode (m_processingFlags, p);
+  p += sdnv.Encode (m_blockLength, p);
+  p += sdnv.Encode (m_dstSchemeOffset.offset, p);
+  p += sdnv.Encode (m_dstSchemeOffset.length, p);
+  p += sdnv.Encode (m_dstSspOffset.offset, p);
+  p += sdnv.Encode (m_dstSspOffset.length, p);
+  p += sdnv.Encode (m_srcSchemeOffset.offset, p);
+  p += sdnv.Encode (m_srcSchemeOffset.length, p);
+  p += sdnv.Encode (m_srcSspOffset.offset, p);
+  p += sdnv.Encode (m_srcSspOffset.length, p);
+  p += sdnv.Encode (m_reportSchemeOffset.offset, p);
+  p += sdnv.Encode (m_reportSchemeOffset.length, p);
+  p += sdnv.Encode (m_reportSspOffset.offset, p);
+  p += sdnv.Encode (m_reportSspOffset.length, p);
+  p += sdnv.Encode (m_custSchemeOffset.offset, p);
+  p += sdnv.Encode (m_custSchemeOffset.length, p);
+  p += sdnv.Encode (m_custSspOffset.offset, p);
+  p += sdnv.Encode (m_custSspOffset.length, p);
+  p += sdnv.Encode (m_createTimestamp.GetMilliSeconds (), p);
+  p += sdnv.Encode (m_timestampSeqNum.GetValue (), p);
+  p += sdnv.Encode ((uint64_t) m_lifeTime, p);
+  p += sdnv.Encode (m_dictLength, p);
+  m_encodedHead = p - m_encoded;
+
+  p += sdnv.Encode (m_fragOffset, p);
+  p += sdnv.Encode (m_aduLength, p);
+  m_encodedTail = p - m_encoded - m_encodedHead;
+
+  NS_ASSERT_MSG (m_encodedHead + m_encodedTail <= m_length, 
+                 "BpHeader::Encode (): the encoded fields exceed the primary bundle header length");
+  m_encodedValid = true;
+}
+
 void 
 BpHeader::Serialize (Buffer::Iterator start) const
 { 
   NS_LOG_FUNCTION (this);
   Buffer::Iterator i = start;
-  Sdnv sdnv;
-  std::vector<uint8_t> result; // store encoded results
-
-  std::vector<uint8_t> processingFlags = sdnv.Encode (m_processingFlags);
-  std::vector<uint8_t> blockLength = sdnv.Encode (m_blockLength);
-  std::vector<uint8_t> dstSchemeOffset = sdnv.Encode (m_dstSchemeOffset.offset);
-  std::vector<uint8_t> dstSchemeLength = sdnv.Encode (m_dstSchemeOffset.length);
-  std::vector<uint8_t> dstSspOffset = sdnv.Encode (m_dstSspOffset.offset);
-  std::vector<uint8_t> dstSspLength = sdnv.Encode (m_dstSspOffset.length);
-  std::vector<uint8_t> srcSchemeOffset = sdnv.Encode (m_srcSchemeOffset.offset);
-  std::vector<uint8_t> srcSchemeLength = sdnv.Encode (m_srcSchemeOffset.length);
-  std::vector<uint8_t> srcSspOffset = sdnv.Encode (m_srcSspOffset.offset);
-  std::vector<uint8_t> srcSspLength = sdnv.Encode (m_srcSspOffset.length);
-  std::vector<uint8_t> reportSchemeOffset = sdnv.Encode (m_reportSchemeOffset.offset);
-  std::vector<uint8_t> reportSchemeLength = sdnv.Encode (m_reportSchemeOffset.length);
-  std::vector<uint8_t> reportSspOffset = sdnv.Encode (m_reportSspOffset.offset);
-  std::vector<uint8_t> reportSspLength = sdnv.Encode (m_reportSspOffset.length);
-  std::vector<uint8_t> custSchemeOffset = sdnv.Encode (m_custSchemeOffset.offset);
-  std::vector<uint8_t> custSchemeLength = sdnv.Encode (m_custSchemeOffset.length);
-  std::vector<uint8_t> custSspOffset = sdnv.Encode (m_custSspOffset.offset);
-  std::vector<uint8_t> custSspLength = sdnv.Encode (m_custSspOffset.length);
-  std::vector<uint8_t> createTimestamp = sdnv.Encode (m_createTimestamp.GetSeconds () * 1000);
-  std::vector<uint8_t> timestampseqNum = sdnv.Encode (m_timestampSeqNum.GetValue ());
-  std::vector<uint8_t> lifeTime = sdnv.Encode (m_lifeTime);
-  std::vector<uint8_t> dictLength = sdnv.Encode (m_dictLength);
-  std::vector<uint8_t> fragOffset = sdnv.Encode (m_fragOffset);
-  std::vector<uint8_t> aduLength = sdnv.Encode (m_aduLength);
-
-  result.insert (result.end (), processingFlags.begin (), processingFlags.end ());
-  result.insert (result.end (), blockLength.begin (), blockLength.end ());
-  result.insert (result.end (), dstSchemeOffset.begin (), dstSchemeOffset.end ());
-  result.insert (result.end (), dstSchemeLength.begin (), dstSchemeLength.end ());
-  result.insert (result.end (), dstSspOffset.begin (), dstSspOffset.end ());
-  result.insert (result.end (), dstSspLength.begin (), dstSspLength.end ());
-  result.insert (result.end (), srcSchemeOffset.begin (), srcSchemeOffset.end ());
-  result.insert (result.end (), srcSchemeLength.begin (), srcSchemeLength.end ());
-  result.insert (result.end (), srcSspOffset.begin (), srcSspOffset.end ());
-  result.insert (result.end (), srcSspLength.begin (), srcSspLength.end ());
-  result.insert (result.end (), reportSchemeOffset.begin (), reportSchemeOffset.end ());
-  result.insert (result.end (), reportSchemeLength.begin (), reportSchemeLength.end ());
-  result.insert (result.end (), reportSspOffset.begin (), reportSspOffset.end ());
-  result.insert (result.end (), reportSspLength.begin (), reportSspLength.end ());
-  result.insert (result.end (), custSchemeOffset.begin (), custSchemeOffset.end ());
-  result.insert (result.end (), custSchemeLength.begin (), custSchemeLength.end ());
-  result.insert (result.end (), custSspOffset.begin (), custSspOffset.end ());
-  result.insert (result.end (), custSspLength.begin (), custSspLength.end ());
-  result.insert (result.end (), createTimestamp.begin (), createTimestamp.end ());
-  result.insert (result.end (), timestampseqNum.begin (), timestampseqNum.end ());
-  result.insert (result.end (), lifeTime.begin (), lifeTime.end ());
-  result.insert (result.end (), dictLength.begin (), dictLength.end ());
-
-  i.WriteU8 (m_version);
-
-  uint32_t last = 0;
-  for (; last < result.size (); last++)
-    i.WriteU8 (result.at (last));  
-
-  char *str = new char[m_dictLength+1];
-  memcpy (str, m_dictionary.c_str (), m_dictLength); 
-  for (uint32_t k = 0; k < m_dictLength; k++)
-    {
-      i.WriteU8 (str[k]);
-    }
-
-  result.insert (result.end (), fragOffset.begin (), fragOffset.end ());
-  result.insert (result.end (), aduLength.begin (), aduLength.end ());
-
-  for (; last < result.size (); last++)
-    i.WriteU8 (result.at (last));  
-
-  delete str;
+
+  if (!m_encodedValid)
+    Encode ();
+
+  i.Write (m_encoded, m_encodedHead);
+  i.Write ((const uint8_t *) m_dictionary.data (), m_dictLength);
+  i.Write (m_encoded + m_encodedHead, m_encodedTail);
+
+  // the header has a fixed length, whatever the length of the encoded fields
+  i.WriteU8 (0, m_length - m_encodedHead - m_encodedTail);
 }
 
 uint32_t 
@@ -171,7 +154,7 @@ BpHeader::Deserialize (Buffer::Iterator start)
   Sdnv sdnv;
 
   m_version = i.ReadU8 ();
-  m_processingFlags = (uint8_t) sdnv.Decode (i);
+  m_processingFlags = (uint32_t) sdnv.Decode (i);
   m_blockLength = (uint32_t) sdnv.Decode (i);
   m_dstSchemeOffset.offset = (uint16_t) sdnv.Decode (i);
   m_dstSchemeOffset.length = (uint16_t) sdnv.Decode (i);
@@ -189,22 +172,18 @@ BpHeader::Deserialize (Buffer::Iterator start)
   m_custSchemeOffset.length = (uint16_t) sdnv.Decode (i);
   m_custSspOffset.offset = (uint16_t) sdnv.Decode (i);
   m_custSspOffset.length = (uint16_t) sdnv.Decode (i);
-  m_createTimestamp = Seconds ((double) sdnv.Decode (i) / 1000.0);
+  m_createTimestamp = MilliSeconds (sdnv.Decode (i));
   m_timestampSeqNum = (uint32_t)sdnv.Decode (i);
   m_lifeTime = (uint64_t) sdnv.Decode (i);
   m_dictLength = (uint32_t) sdnv.Decode (i);
 
-  char *str = new char[m_dictLength + 1];
-  memcpy (str, "", m_dictLength); 
-  for (uint32_t k = 0; k < m_dictLength; k++)
-    {
-      str[k] = i.ReadU8 ();
-    }
-  str[m_dictLength] = '\0';
-  m_dictionary = std::string (str, m_dictLength);
+  m_dictionary.resize (m_dictLength);
+  if (m_dictLength > 0)
+    i.Read ((uint8_t *) &m_dictionary[0], m_dictLength);
 
   m_fragOffset = (uint32_t) sdnv.Decode (i);
   m_aduLength = (uint32_t) sdnv.Decode (i);
+  m_encodedValid = false;
 
   return GetSerializedSize ();
 }
@@ -214,6 +193,7 @@ void
 BpHeader::SetIsFragment (const bool value)
 { 
   NS_LOG_FUNCTION (this << " " << value);
+  m_encodedValid = false;
   if (value)
     m_processingFlags |= BUNDLE_IS_FRAGMENT;
   else
@@ -224,6 +204,7 @@ void
 BpHeader::SetIsAdmin (const bool value)
 { 
   NS_LOG_FUNCTION (this << " " << value);
+  m_encodedValid = false;
   if (value)
     m_processingFlags |= BUNDLE_IS_ADMIN;
   else
@@ -234,6 +215,7 @@ void
 BpHeader::SetDonotFragment (const bool value)
 { 
   NS_LOG_FUNCTION (this << " " << value);
+  m_encodedValid = false;
   if (value)
     m_processingFlags |= BUNDLE_DO_NOT_FRAGMENT;
   else
@@ -245,6 +227,7 @@ void
 BpHeader::SetCustTxReq (const bool value)
 { 
   NS_LOG_FUNCTION (this << " " << value);
+  m_encodedValid = false;
   if (value)
     m_processingFlags |= BUNDLE_CUSTODY_XFER_REQUESTED;
   else
@@ -256,6 +239,7 @@ void
 BpHeader::SetSingletonDest (const bool value)
 { 
   NS_LOG_FUNCTION (this << " " << value);
+  m_encodedValid = false;
   if (value)
     m_processingFlags |= BUNDLE_SINGLETON_DESTINATION;
   else
@@ -267,6 +251,7 @@ void
 BpHeader::SetAckbyAppReq (const bool value)
 { 
   NS_LOG_FUNCTION (this << " " << value);
+  m_encodedValid = false;
   if (value)
     m_processingFlags |= BUNDLE_ACK_BY_APP;
   else
@@ -278,12 +263,16 @@ void
 BpHeader::SetPriority (const uint8_t pri)
 { 
   NS_LOG_FUNCTION (this << " " << (uint16_t)pri);
+  m_encodedValid = false;
+  m_processingFlags &= (~(UNUSED));
+  m_processingFlags |= ((uint32_t)(pri & 0x3) << 7);
 }
 
 void 
 BpHeader::SetRecptionReport (const bool value)
 { 
   NS_LOG_FUNCTION (this << " " << value);
+  m_encodedValid = false;
   if (value)
     m_processingFlags |= REQ_REPORT_BUNDLE_RECEPTION;
   else
@@ -294,6 +283,7 @@ void
 BpHeader::SetCustAcceptReport (const bool value)
 { 
   NS_LOG_FUNCTION (this << " " << value);
+  m_encodedValid = false;
   if (value)
     m_processingFlags |= REQ_REPORT_COSTODY_ACCEPT;
   else
@@ -305,6 +295,7 @@ void
 BpHeader::SetForwardReport (const bool value)
 { 
   NS_LOG_FUNCTION (this << " " << value);
+  m_encodedValid = false;
   if (value)
     m_processingFlags |= REQ_REPORT_BUNDLE_FORWARD;
   else
@@ -316,6 +307,7 @@ void
 BpHeader::SetDeliveryReport (const bool value)
 { 
   NS_LOG_FUNCTION (this << " " << value);
+  m_encodedValid = false;
   if (value)
     m_processingFlags |= REQ_REPORT_BUNDLE_DELIVERY;
   else
@@ -327,6 +319,7 @@ void
 BpHeader::SetDeletionReport (const bool value)
 { 
   NS_LOG_FUNCTION (this << " " << value);
+  m_encodedValid = false;
   if (value)
     m_processingFlags |= REQ_REPORT_BUNDLE_DELETION;
   else
@@ -405,7 +398,7 @@ uint8_t
 BpHeader::Priority () const   
 { 
   NS_LOG_FUNCTION (this);
-  return BULK;
+  return (m_processingFlags & UNUSED) >> 7;
 }
 
 bool 
@@ -467,6 +460,7 @@ void
 BpHeader::SetCreateTimestamp (const Time &timestamp)
 { 
   NS_LOG_FUNCTION (this << " " << timestamp.GetSeconds ());
+  m_encodedValid = false;
   m_createTimestamp = timestamp;
 }
 
@@ -474,6 +468,7 @@ void
 BpHeader::SetSequenceNumber (const SequenceNumber32 &sequenceNumber)
 { 
   NS_LOG_FUNCTION (this << " " << sequenceNumber.GetValue ());
+  m_encodedValid = false;
   m_timestampSeqNum = sequenceNumber;
 }
 
@@ -496,6 +491,7 @@ void
 BpHeader::SetDestinationEid (const BpEndpointId &dst)
 { 
   NS_LOG_FUNCTION (this << " " << dst.Uri ());
+  m_encodedValid = false;
   std::string scheme = dst.Scheme ();
   std::string ssp = dst.Ssp ();
 
@@ -514,6 +510,7 @@ void
 BpHeader::SetSourceEid (const BpEndpointId &src)
 { 
   NS_LOG_FUNCTION (this << " " << src.Uri ());
+  m_encodedValid = false;
   std::string scheme = src.Scheme ();
   std::string ssp = src.Ssp ();
 
@@ -535,6 +532,7 @@ void
 BpHeader::SetReportEid (const BpEndpointId &report)
 { 
   NS_LOG_FUNCTION (this << " " << report.Uri ());
+  m_encodedValid = false;
   std::string scheme = report.Scheme ();
   std::string ssp = report.Ssp ();
 
@@ -553,6 +551,7 @@ void
 BpHeader::SetCustEid (const BpEndpointId &cust)
 { 
   NS_LOG_FUNCTION (this << " " << cust.Uri ());
+  m_encodedValid = false;
   std::string scheme = cust.Scheme ();
   std::string ssp = cust.Ssp ();
 
@@ -618,6 +617,7 @@ void
 BpHeader::SetLifeTime (double lifetime)
 { 
   NS_LOG_FUNCTION (this << " " << lifetime);
+  m_encodedValid = false;
   m_lifeTime = lifetime;
 }
 
@@ -633,6 +633,7 @@ void
 BpHeader::SetFragOffset (uint32_t offset)
 { 
   NS_LOG_FUNCTION (this << " " << offset);
+  m_encodedValid = false;
   m_fragOffset = offset;
 }
 
@@ -640,6 +641,7 @@ void
 BpHeader::SetAduLength (uint32_t len)
 { 
   NS_LOG_FUNCTION (this << " " << len);
+  m_encodedValid = false;
   m_aduLength = len;
 }
 
@@ -661,6 +663,7 @@ void
 BpHeader::SetBlockLength (uint32_t len)
 { 
   NS_LOG_FUNCTION (this << " " << len);
+  m_encodedValid = false;
   m_blockLength = len;
 }
 
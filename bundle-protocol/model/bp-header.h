@@ -27,6 +27,7 @@
 #include "ns3/buffer.h"
 #include "ns3/sequence-number.h"
 #include "bp-endpoint-id.h"
+#include "sdnv.h"
 
 namespace ns3 {
 
@@ -98,7 +99,7 @@ public:
   /**
    * \brief Set priority field
    *
-   * \param pri priority of bundle
+   * \param pri priority of bundle: 0 for bulk, 1 for normal and 2 for expedited
    */
   void SetPriority (const uint8_t pri);
 
@@ -245,7 +246,7 @@ public:
   /**
    * \brief Get priority of bundle
    *
-   * \return priority of bundle
+   * \return priority of bundle: 0 for bulk, 1 for normal and 2 for expedited
    */
   uint8_t Priority () const;  
 
@@ -365,6 +366,19 @@ public:
 
 
 private:
+  /**
+   * \brief Encode the fields before and after the dictionary into m_encoded
+   *
+   * The encoded fields are kept until a field changes, so that a header
+   * serialized several times, e.g. into each fragment, is encoded once
+   */
+  void Encode (void) const;
+
+  /**
+   * the max number of bytes of the encoded fields: the version and 24 SDNVs
+   */
+  static const uint32_t MAX_ENCODED_SIZE = 1 + 24 * Sdnv::MAX_LENGTH;
+
   uint16_t m_length;                      /// the length of header without string
 
   // primary bundle block, section 4.5.1, RFC 5050
@@ -386,6 +400,11 @@ private:
   std::string m_dictionary;               /// dictionary
   uint32_t m_fragOffset;                  /// fragementation offset
   uint32_t m_aduLength;                   /// application data unit length
+
+  mutable uint8_t m_encoded[MAX_ENCODED_SIZE];  /// the encoded fields before the dictionary, then after it
+  mutable uint32_t m_encodedHead;               /// number of encoded bytes before the dictionary
+  mutable uint32_t m_encodedTail;               /// number of encoded bytes after the dictionary
+  mutable bool m_encodedValid;                  /// are the encoded fields up to date?
 };
 
 
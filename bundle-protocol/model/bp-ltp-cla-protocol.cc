@@ -16,6 +16,7 @@
 #include "bundle-protocol.h"
 #include "bp-static-routing-protocol.h"
 #include "bp-header.h"
+#include "bp-v7-header.h"
 #include "bp-endpoint-id.h"
 #include "ns3/tcp-socket-factory.h"
 #include "ns3/inet-socket-address.h"
@@ -73,19 +74,24 @@ BpLtpClaProtocol::GetL4Socket (Ptr<Packet> packet)
 { 
   NS_LOG_FUNCTION (this << " " << packet);
   BpHeader bph;
-  packet->PeekHeader (bph);
+  BpV7Header::PeekBpHeader (packet, bph);
   BpEndpointId dst = bph.GetDestinationEid ();
   BpEndpointId src = bph.GetSourceEid ();
 
-  std::map<BpEndpointId, Ptr<Socket> >::iterator it = m_l4SendSockets.end ();
-  it = m_l4SendSockets.find (src);
+  // the sockets are kept by next hop, which may change from bundle to bundle
+  // as contacts open and close
+  Address nextHop = m_bpRouting->GetRoute (dst);
+  std::map<Address, Ptr<Socket> >::iterator it = m_l4SendSockets.find (nextHop);
   if (it == m_l4SendSockets.end ())
     {
       if (EnableSend (src, dst) < 0)
         return NULL;
-    }
 
-  it = m_l4SendSockets.find (src);
+      // update because EnableSend () adds the new socket into m_l4SendSockets
+      it = m_l4SendSockets.find (nextHop);
+      if (it == m_l4SendSockets.end ())
+        return NULL;
+    }
 
   return ((*it).second);
 }
@@ -94,8 +100,7 @@ int
 BpLtpClaProtocol::EnableReceive (const BpEndpointId &local)
 {
   NS_LOG_FUNCTION (this << " " << local.Uri ());
-  Ptr<BpStaticRoutingProtocol> route = DynamicCast <BpStaticRoutingProtocol> (m_bpRouting);
-  InetSocketAddress addr = route->GetRoute (local);
+  InetSocketAddress addr = m_bpRouting->GetRoute (local);
 
   uint16_t port;
   InetSocketAddress defaultAddr ("127.0.0.1", 0);
@@ -154,10 +159,10 @@ BpLtpClaProtocol::SendPacket (Ptr<Packet> packet)
 { 
   NS_LOG_FUNCTION (this << " " << packet);
 
+  // retreive the bundle itself, bundles held until a contact may be ahead of it
   BpHeader bph;
-  packet->PeekHeader (bph);
-  BpEndpointId src = bph.GetSourceEid ();
-  Ptr<Packet> pkt = m_bp->GetBundle (src);
+  BpV7Header::PeekBpHeader (packet, bph);
+  Ptr<Packet> pkt = m_bp->GetBundle (BpBundleId (bph));
 
   if (pkt)
     {
@@ -188,8 +193,7 @@ BpLtpClaProtocol::EnableSend (const BpEndpointId &src, const BpEndpointId &dst)
   if (!m_bpRouting)
     NS_FATAL_ERROR ("BpLtpClaProtocol::SendPacket (): cannot find bundle routing protocol");
 
-  Ptr<BpStaticRoutingProtocol> route = DynamicCast <BpStaticRoutingProtocol> (m_bpRouting);
-  InetSocketAddress address = route->GetRoute (dst);
+  InetSocketAddress address = m_bpRouting->GetRoute (dst);
 
   InetSocketAddress defaultAddr ("127.0.0.1", 0);
   if (address == defaultAddr)
@@ -198,6 +202,9 @@ BpLtpClaProtocol::EnableSend (const BpEndpointId &src, const BpEndpointId &dst)
       return -1;
     }
 
+  if (m_l4SendSockets.find (address) != m_l4SendSockets.end ())
+    return 0;
+
 //  Ptr<Socket> socket = Socket::CreateSocket (m_bp->GetNode (), ltp::LtpProtocol::GetTypeId ());
 //  if (socket->Bind () < 0)
 //    return -1;
@@ -208,12 +215,7 @@ BpLtpClaProtocol::EnableSend (const BpEndpointId &src, const BpEndpointId &dst)
 //
 //  SetL4SocketCallbacks (socket);
 //
-//  std::map<BpEndpointId, Ptr<Socket> >::iterator it = m_l4SendSockets.end ();
-//  it = m_l4SendSockets.find (src);
-//  if (it == m_l4SendSockets.end ())
-//    m_l4SendSockets.insert (std::pair<BpEndpointId, Ptr<Socket> >(src, socket));
-//  else
-//    return -1;
+//  m_l4SendSockets.insert (std::pair<Address, Ptr<Socket> >(address, socket));
 
   return 0;
 }
@@ -68,14 +68,15 @@ public:
   /**
    * \brief Get the transport layer socket
    *
-   * This method finds the socket by the source endpoint id of the bundle. 
-   * If it cannot find, which means that this bundle is the first bundle required
-   * to be transmitted for this source endpoint id, it start a LTP connection with
-   * the destination endpoint id.
+   * This method finds the socket by the next hop towards the destination 
+   * endpoint id of the bundle, as given by the routing protocol at the time of 
+   * the transmission. If it cannot find, which means that this bundle is the 
+   * first bundle required to be transmitted to this next hop, it start a LTP 
+   * connection with the next hop.
    *
    * \param packet the bundle required to be transmitted
    *
-   * \return return NULL if it cannot find a socket for the source endpoing id of 
+   * \return return NULL if there is no route or no socket for the next hop of
    * the bundle. Otherwise, it returns the socket.
    */
   virtual Ptr<Socket> GetL4Socket (Ptr<Packet> packet);
@@ -171,7 +172,7 @@ private:
 private:
   Ptr<BundleProtocol> m_bp;                             /// bundle protocol
   Ptr<LtpProtocol> m_ltp;                               /// ltp protocol
-  std::map<BpEndpointId, Ptr<Socket> > m_l4SendSockets; /// the transport layer sender sockets
+  std::map<Address, Ptr<Socket> > m_l4SendSockets;      /// the transport layer sender sockets, by next hop
   std::map<BpEndpointId, Ptr<Socket> > m_l4RecvSockets; /// the transport layer receiver sockets
 
   Ptr<BpRoutingProtocol> m_bpRouting;                   /// bundle routing protocol
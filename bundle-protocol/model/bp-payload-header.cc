@@ -79,17 +79,10 @@ BpPayloadHeader::Serialize (Buffer::Iterator start) const
   NS_LOG_FUNCTION (this);
   Buffer::Iterator i = start;
   Sdnv sdnv;
-  std::vector<uint8_t> result; // store encoded results
-
-  std::vector<uint8_t> processingControlFlags = sdnv.Encode (m_processingControlFlags);
-  std::vector<uint8_t> blockLength = sdnv.Encode (m_blockLength);
-  result.insert (result.end (), processingControlFlags.begin (), processingControlFlags.end ());
-  result.insert (result.end (), blockLength.begin (), blockLength.end ());
 
   i.WriteU8 (m_blockType);
-
-  for (uint32_t k = 0; k < result.size (); k++)
-    i.WriteU8 (result.at (k));  
+  sdnv.Encode (m_processingControlFlags, i);
+  sdnv.Encode (m_blockLength, i);
 }
 
 uint32_t 
@@ -20,6 +20,7 @@
 
 #include "bp-routing-protocol.h"
 #include "ns3/log.h"
+#include "ns3/simulator.h"
 
 NS_LOG_COMPONENT_DEFINE ("BpRoutingProtocol");
 
@@ -44,4 +45,11 @@ BpRoutingProtocol::~BpRoutingProtocol ()
   NS_LOG_FUNCTION (this);
 }
 
+Time
+BpRoutingProtocol::GetSendTime (BpEndpointId eid)
+{ 
+  NS_LOG_FUNCTION (this << " " << eid.Uri ());
+  return Simulator::Now ();
+}
+
 } // namespace ns3
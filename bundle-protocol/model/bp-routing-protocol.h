@@ -21,6 +21,9 @@
 #define BP_ROUTING_PROTOCOL_H
 
 #include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/inet-socket-address.h"
+#include "bp-endpoint-id.h"
 
 namespace ns3 {
 
@@ -51,6 +54,20 @@ public:
    * \param bundleProtocol bundle protocol
    */
   virtual void SetBundleProtocol (Ptr<BundleProtocol> bundleProtocol) = 0;
+
+  /**
+   *  \return the internet socket address of the next hop towards eid; If there 
+   *  is no route, return the 127.0.0.1 with port 0
+   */
+  virtual InetSocketAddress GetRoute (BpEndpointId eid) = 0;
+
+  /**
+   * \brief Get the time at which a bundle to eid can be handed to the convergence 
+   * layer, e.g. the start of the next contact towards eid
+   *
+   * \return the current time by default
+   */
+  virtual Time GetSendTime (BpEndpointId eid);
 };
 
 
@@ -36,6 +36,7 @@
 #include "bundle-protocol.h"
 #include "bp-static-routing-protocol.h"
 #include "bp-header.h"
+#include "bp-v7-header.h"
 #include "bp-endpoint-id.h"
 #include "ns3/tcp-socket-factory.h"
 //#include "ns3/ltp-socket-factory.h"
@@ -87,21 +88,24 @@ BpTcpClaProtocol::GetL4Socket (Ptr<Packet> packet)
 { 
   NS_LOG_FUNCTION (this << " " << packet);
   BpHeader bph;
-  packet->PeekHeader (bph);
+  BpV7Header::PeekBpHeader (packet, bph);
   BpEndpointId dst = bph.GetDestinationEid ();
   BpEndpointId src = bph.GetSourceEid ();
 
-  std::map<BpEndpointId, Ptr<Socket> >::iterator it = m_l4SendSockets.end ();
-  it = m_l4SendSockets.find (src);
+  // the sockets are kept by next hop, which may change from bundle to bundle
+  // as contacts open and close
+  Address nextHop = m_bpRouting->GetRoute (dst);
+  std::map<Address, Ptr<Socket> >::iterator it = m_l4SendSockets.find (nextHop);
   if (it == m_l4SendSockets.end ())
     {
-      // enable a tcp connection from the src endpoint id to the dst endpoint id
       if (EnableSend (src, dst) < 0)
         return NULL;
-    }
 
-  // update because EnableSende () add new socket into m_l4SendSockets
-  it = m_l4SendSockets.find (src);
+      // update because EnableSend () adds the new socket into m_l4SendSockets
+      it = m_l4SendSockets.find (nextHop);
+      if (it == m_l4SendSockets.end ())
+        return NULL;
+    }
 
   return ((*it).second);
 }
@@ -117,11 +121,11 @@ BpTcpClaProtocol::SendPacket (Ptr<Packet> packet)
     return -1;
 
 
-  // retreive bundles from queue in BundleProtocol
+  // retreive the bundle from the persistant storage in BundleProtocol, as
+  // bundles held until a contact may be ahead of it in the queue of its source
   BpHeader bph;
-  packet->PeekHeader (bph);
-  BpEndpointId src = bph.GetSourceEid ();
-  Ptr<Packet> pkt = m_bp->GetBundle (src);
+  BpV7Header::PeekBpHeader (packet, bph);
+  Ptr<Packet> pkt = m_bp->GetBundle (BpBundleId (bph));
  
   if (pkt)
     {
@@ -136,8 +140,7 @@ int
 BpTcpClaProtocol::EnableReceive (const BpEndpointId &local)
 { 
   NS_LOG_FUNCTION (this << " " << local.Uri ());
-  Ptr<BpStaticRoutingProtocol> route = DynamicCast <BpStaticRoutingProtocol> (m_bpRouting);
-  InetSocketAddress addr = route->GetRoute (local);
+  InetSocketAddress addr = m_bpRouting->GetRoute (local);
 
   uint16_t port;
   InetSocketAddress defaultAddr ("127.0.0.1", 0);
@@ -198,10 +201,8 @@ BpTcpClaProtocol::EnableSend (const BpEndpointId &src, const BpEndpointId &dst)
   if (!m_bpRouting)
     NS_FATAL_ERROR ("BpTcpClaProtocol::SendPacket (): cannot find bundle routing protocol");
 
-  // TBD: do not use dynamicast here
   // check route for destination endpoint id
-  Ptr<BpStaticRoutingProtocol> route = DynamicCast <BpStaticRoutingProtocol> (m_bpRouting);
-  InetSocketAddress address = route->GetRoute (dst);
+  InetSocketAddress address = m_bpRouting->GetRoute (dst);
 
   InetSocketAddress defaultAddr ("127.0.0.1", 0);
   if (address == defaultAddr)
@@ -210,6 +211,10 @@ BpTcpClaProtocol::EnableSend (const BpEndpointId &src, const BpEndpointId &dst)
       return -1;
     }
 
+  // bundles towards the same next hop share a tcp connection
+  if (m_l4SendSockets.find (address) != m_l4SendSockets.end ())
+    return 0;
+
   // start a tcp connection
   Ptr<Socket> socket = Socket::CreateSocket (m_bp->GetNode (), TcpSocketFactory::GetTypeId ());
   if (socket->Bind () < 0)
@@ -222,12 +227,7 @@ BpTcpClaProtocol::EnableSend (const BpEndpointId &src, const BpEndpointId &dst)
   SetL4SocketCallbacks (socket);
 
   // store the sending socket so that the convergence layer can dispatch the hundles to different tcp connections
-  std::map<BpEndpointId, Ptr<Socket> >::iterator it = m_l4SendSockets.end ();
-  it = m_l4SendSockets.find (src);
-  if (it == m_l4SendSockets.end ())
-    m_l4SendSockets.insert (std::pair<BpEndpointId, Ptr<Socket> >(src, socket));  
-  else
-    return -1;
+  m_l4SendSockets.insert (std::pair<Address, Ptr<Socket> >(address, socket));
 
   return 0;
 }
@@ -0,0 +1,592 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 University of New Brunswick
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Dizhi Zhou <dizhi.zhou@gmail.com>
+ */
+
+#include "ns3/log.h"
+#include "bp-v7-header.h"
+#include "cbor.h"
+#include <stdio.h>
+#include <string>
+
+NS_LOG_COMPONENT_DEFINE ("BpV7Header");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (BpV7Header);
+
+BpV7Header::BpV7Header ()
+  : m_processingFlags (0),
+    m_crcType (BpCrc::CRC_32C),
+    m_dst (),
+    m_src (),
+    m_report (),
+    m_createTimestamp (0),
+    m_timestampSeqNum (0),
+    m_lifeTime (0),
+    m_fragOffset (0),
+    m_aduLength (0),
+    m_valid (true)
+{ 
+  NS_LOG_FUNCTION (this);
+}
+
+BpV7Header::~BpV7Header ()
+{ 
+  NS_LOG_FUNCTION (this);
+}
+
+TypeId 
+BpV7Header::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::BpV7Header")
+    .SetParent<Header> ()
+    .AddConstructor<BpV7Header> ()
+  ;
+
+  return tid;
+}
+
+TypeId 
+BpV7Header::GetInstanceTypeId (void) const
+{ 
+  NS_LOG_FUNCTION (this);
+  return GetTypeId ();
+}
+
+void 
+BpV7Header::Print (std::ostream &os) const
+{ 
+  NS_LOG_FUNCTION (this);
+  os << "src " << GetSourceEid ().Uri () << " dst " << GetDestinationEid ().Uri () 
+     << " seq " << m_timestampSeqNum;
+}
+
+void 
+BpV7Header::SetBpHeader (const BpHeader &header)
+{ 
+  NS_LOG_FUNCTION (this);
+  uint64_t flags = 0;
+  if (header.IsFragment ())
+    flags |= BUNDLE_IS_FRAGMENT;
+  if (header.IsAdmin ())
+    flags |= BUNDLE_IS_ADMIN;
+  if (header.DonotFragment ())
+    flags |= BUNDLE_DO_NOT_FRAGMENT;
+  if (header.AckbyAppReq ())
+    flags |= BUNDLE_ACK_BY_APP;
+  if (header.RecptionReport ())
+    flags |= REQ_REPORT_BUNDLE_RECEPTION;
+  if (header.ForwardReport ())
+    flags |= REQ_REPORT_BUNDLE_FORWARD;
+  if (header.DeliveryReport ())
+    flags |= REQ_REPORT_BUNDLE_DELIVERY;
+  if (header.DeletionReport ())
+    flags |= REQ_REPORT_BUNDLE_DELETION;
+  m_processingFlags = flags;
+
+  SetDestinationEid (header.GetDestinationEid ());
+  SetSourceEid (header.GetSourceEid ());
+  SetReportEid (header.GetReportEid ());
+  SetCreateTimestamp (header.GetCreateTimestamp ());
+  SetSequenceNumber (header.GetSequenceNumber ());
+  SetLifeTime (header.GetLifeTime ());
+  SetFragOffset (header.GetFragOffset ());
+  SetAduLength (header.GetAduLength ());
+}
+
+BpHeader 
+BpV7Header::GetBpHeader () const
+{ 
+  NS_LOG_FUNCTION (this);
+  BpHeader header;
+  header.SetIsFragment (m_processingFlags & BUNDLE_IS_FRAGMENT);
+  header.SetIsAdmin (m_processingFlags & BUNDLE_IS_ADMIN);
+  header.SetDonotFragment (m_processingFlags & BUNDLE_DO_NOT_FRAGMENT);
+  header.SetAckbyAppReq (m_processingFlags & BUNDLE_ACK_BY_APP);
+  header.SetRecptionReport (m_processingFlags & REQ_REPORT_BUNDLE_RECEPTION);
+  header.SetForwardReport (m_processingFlags & REQ_REPORT_BUNDLE_FORWARD);
+  header.SetDeliveryReport (m_processingFlags & REQ_REPORT_BUNDLE_DELIVERY);
+  header.SetDeletionReport (m_processingFlags & REQ_REPORT_BUNDLE_DELETION);
+
+  header.SetDestinationEid (GetDestinationEid ());
+  header.SetSourceEid (GetSourceEid ());
+  header.SetReportEid (GetReportEid ());
+  header.SetCreateTimestamp (GetCreateTimestamp ());
+  header.SetSequenceNumber (GetSequenceNumber ());
+  header.SetLifeTime (GetLifeTime ());
+  header.SetFragOffset (GetFragOffset ());
+  header.SetAduLength (GetAduLength ());
+  return header;
+}
+
+bool 
+BpV7Header::PeekBpHeader (Ptr<const Packet> bundle, BpHeader &header)
+{ 
+  NS_LOG_FUNCTION (bundle);
+  if (!IsBpV7 (bundle))
+    {
+      bundle->PeekHeader (header);
+      return true;
+    }
+
+  BpV7Header bpv7Header;
+  bundle->PeekHeader (bpv7Header);
+  if (!bpv7Header.IsValid ())
+    return false;
+
+  header = bpv7Header.GetBpHeader ();
+  return true;
+}
+
+bool 
+BpV7Header::IsBpV7 (Ptr<const Packet> bundle)
+{ 
+  NS_LOG_FUNCTION (bundle);
+  uint8_t first = 0;
+  return bundle->CopyData (&first, 1) == 1 && first == Cbor::INDEFINITE_ARRAY;
+}
+
+void 
+BpV7Header::SetProcessingFlags (uint64_t flags)
+{ 
+  NS_LOG_FUNCTION (this << " " << flags);
+  m_processingFlags = flags;
+}
+
+void 
+BpV7Header::SetCrcType (BpCrc::CrcType type)
+{ 
+  NS_LOG_FUNCTION (this << " " << type);
+  NS_ASSERT_MSG (type == BpCrc::CRC_16 || type == BpCrc::CRC_32C, "the primary bundle block must have a CRC");
+  m_crcType = type;
+}
+
+void 
+BpV7Header::SetDestinationEid (const BpEndpointId &dst)
+{ 
+  NS_LOG_FUNCTION (this << " " << dst.Uri ());
+  SetEid (m_dst, dst);
+}
+
+void 
+BpV7Header::SetSourceEid (const BpEndpointId &src)
+{ 
+  NS_LOG_FUNCTION (this << " " << src.Uri ());
+  SetEid (m_src, src);
+}
+
+void 
+BpV7Header::SetReportEid (const BpEndpointId &report)
+{ 
+  NS_LOG_FUNCTION (this << " " << report.Uri ());
+  SetEid (m_report, report);
+}
+
+void 
+BpV7Header::SetCreateTimestamp (const Time &timestamp)
+{ 
+  NS_LOG_FUNCTION (this << " " << timestamp.GetSeconds ());
+  m_createTimestamp = timestamp.GetMilliSeconds ();
+}
+
+void
+BpV7Header::SetSequenceNumber (const SequenceNumber32 &sequenceNumber)
+{ 
+  NS_LOG_FUNCTION (this << " " << sequenceNumber.GetValue ());
+  m_timestampSeqNum = sequenceNumber.GetValue ();
+}
+
+void 
+BpV7Header::SetLifeTime (double lifetime)
+{ 
+  NS_LOG_FUNCTION (this << " " << lifetime);
+  m_lifeTime = (uint64_t) (lifetime * 1000);
+}
+
+void 
+BpV7Header::SetFragOffset (uint32_t offset)
+{ 
+  NS_LOG_FUNCTION (this << " " << offset);
+  m_fragOffset = offset;
+}
+
+void 
+BpV7Header::SetAduLength (uint32_t len)
+{ 
+  NS_LOG_FUNCTION (this << " " << len);
+  m_aduLength = len;
+}
+
+uint64_t 
+BpV7Header::GetProcessingFlags () const
+{ 
+  NS_LOG_FUNCTION (this);
+  return m_processingFlags;
+}
+
+BpCrc::CrcType 
+BpV7Header::GetCrcType () const
+{ 
+  NS_LOG_FUNCTION (this);
+  return m_crcType;
+}
+
+bool 
+BpV7Header::IsFragment () const
+{ 
+  NS_LOG_FUNCTION (this);
+  return (m_processingFlags & BUNDLE_IS_FRAGMENT) != 0;
+}
+
+BpEndpointId 
+BpV7Header::GetDestinationEid () const
+{ 
+  NS_LOG_FUNCTION (this);
+  return GetEid (m_dst);
+}
+
+BpEndpointId 
+BpV7Header::GetSourceEid () const
+{ 
+  NS_LOG_FUNCTION (this);
+  return GetEid (m_src);
+}
+
+BpEndpointId 
+BpV7Header::GetReportEid () const
+{ 
+  NS_LOG_FUNCTION (this);
+  return GetEid (m_report);
+}
+
+Time 
+BpV7Header::GetCreateTimestamp () const
+{ 
+  NS_LOG_FUNCTION (this);
+  return MilliSeconds (m_createTimestamp);
+}
+
+SequenceNumber32 
+BpV7Header::GetSequenceNumber () const
+{ 
+  NS_LOG_FUNCTION (this);
+  return SequenceNumber32 ((uint32_t) m_timestampSeqNum);
+}
+
+double
+BpV7Header::GetLifeTime () const
+{ 
+  NS_LOG_FUNCTION (this);
+  return m_lifeTime / 1000.0;
+}
+
+uint32_t
+BpV7Header::GetFragOffset () const
+{ 
+  NS_LOG_FUNCTION (this);
+  return (uint32_t) m_fragOffset;
+}
+
+uint32_t
+BpV7Header::GetAduLength () const
+{ 
+  NS_LOG_FUNCTION (this);
+  return (uint32_t) m_aduLength;
+}
+
+bool 
+BpV7Header::IsValid () const
+{ 
+  NS_LOG_FUNCTION (this);
+  return m_valid;
+}
+
+void 
+BpV7Header::SetEid (BpV7EndpointId &eid, const BpEndpointId &value)
+{ 
+  NS_LOG_FUNCTION (this << " " << value.Uri ());
+  std::string scheme = value.Scheme ();
+  std::string ssp = value.Ssp ();
+
+  eid = BpV7EndpointId ();
+  if (scheme == "dtn")
+    {
+      // dtn:none is encoded as 0, section 4.2.5.1.1 of RFC 9171
+      if (ssp != "none")
+        eid.ssp = ssp;
+    }
+  else if (scheme == "ipn")
+    {
+      unsigned long long node, service;
+      if (sscanf (ssp.c_str (), "%llu.%llu", &node, &service) == 2)
+        {
+          eid.scheme = BpV7EndpointId::IPN;
+          eid.node = node;
+          eid.service = service;
+        }
+      else
+        {
+          NS_LOG_WARN ("BpV7Header::SetEid (), malformed ipn endpoint id " << value.Uri () << ", use dtn:none");
+        }
+    }
+  else if (!value.Uri ().empty ())
+    {
+      NS_LOG_WARN ("BpV7Header::SetEid (), unsupported scheme of " << value.Uri () << ", use dtn:none");
+    }
+}
+
+BpEndpointId 
+BpV7Header::GetEid (const BpV7EndpointId &eid) const
+{ 
+  NS_LOG_FUNCTION (this);
+  if (eid.scheme == BpV7EndpointId::IPN)
+    {
+      return BpEndpointId ("ipn", std::to_string (eid.node) + "." + std::to_string (eid.service));
+    }
+
+  if (eid.ssp.empty ())
+    return BpEndpointId ("dtn", "none");
+
+  return BpEndpointId ("dtn", eid.ssp);
+}
+
+uint32_t 
+BpV7Header::GetEidSize (const BpV7EndpointId &eid) const
+{ 
+  NS_LOG_FUNCTION (this);
+  Cbor cbor;
+
+  // [scheme code, ssp]
+  uint32_t size = 2;
+  if (eid.scheme == BpV7EndpointId::IPN)
+    size += 1 + cbor.GetHeadSize (eid.node) + cbor.GetHeadSize (eid.service);
+  else if (eid.ssp.empty ())
+    size += 1;
+  else
+    size += cbor.GetHeadSize (eid.ssp.size ()) + eid.ssp.size ();
+  return size;
+}
+
+void 
+BpV7Header::EncodeEid (const BpV7EndpointId &eid, Buffer::Iterator &start) const
+{ 
+  NS_LOG_FUNCTION (this);
+  Cbor cbor;
+  cbor.EncodeHead (Cbor::ARRAY, 2, start);
+  cbor.EncodeHead (Cbor::UNSIGNED_INTEGER, eid.scheme, start);
+  if (eid.scheme == BpV7EndpointId::IPN)
+    {
+      cbor.EncodeHead (Cbor::ARRAY, 2, start);
+      cbor.EncodeHead (Cbor::UNSIGNED_INTEGER, eid.node, start);
+      cbor.EncodeHead (Cbor::UNSIGNED_INTEGER, eid.service, start);
+    }
+  else if (eid.ssp.empty ())
+    {
+      cbor.EncodeHead (Cbor::UNSIGNED_INTEGER, 0, start);
+    }
+  else
+    {
+      cbor.EncodeHead (Cbor::TEXT_STRING, eid.ssp.size (), start);
+      start.Write ((const uint8_t *) eid.ssp.data (), eid.ssp.size ());
+    }
+}
+
+bool 
+BpV7Header::DecodeEid (BpV7EndpointId &eid, Buffer::Iterator &start)
+{ 
+  NS_LOG_FUNCTION (this);
+  Cbor cbor;
+  uint64_t value;
+  if (!cbor.Decode (start, Cbor::ARRAY, value) || value != 2)
+    return false;
+  if (!cbor.Decode (start, Cbor::UNSIGNED_INTEGER, value))
+    return false;
+
+  eid.scheme = (uint8_t) value;
+  if (value == BpV7EndpointId::IPN)
+    {
+      return cbor.Decode (start, Cbor::ARRAY, value) && value == 2 &&
+             cbor.Decode (start, Cbor::UNSIGNED_INTEGER, eid.node) &&
+             cbor.Decode (start, Cbor::UNSIGNED_INTEGER, eid.service);
+    }
+  else if (value != BpV7EndpointId::DTN)
+    {
+      return false;
+    }
+
+  Cbor::MajorType type;
+  if (!cbor.DecodeHead (start, type, value))
+    return false;
+
+  if (type == Cbor::UNSIGNED_INTEGER && value == 0)
+    {
+      eid.ssp.clear ();
+      return true;
+    }
+  else if (type != Cbor::TEXT_STRING || value > start.GetRemainingSize ())
+    {
+      return false;
+    }
+
+  // the string keeps its capacity when the header is deserialized again
+  eid.ssp.resize (value);
+  if (value > 0)
+    start.Read ((uint8_t *) &eid.ssp[0], value);
+  return true;
+}
+
+uint32_t 
+BpV7Header::GetNItems () const
+{ 
+  NS_LOG_FUNCTION (this);
+  return 8 + (IsFragment () ? 2 : 0) + (m_crcType != BpCrc::CRC_NONE ? 1 : 0);
+}
+
+uint32_t 
+BpV7Header::GetSerializedSize (void) const
+{ 
+  NS_LOG_FUNCTION (this);
+  Cbor cbor;
+  BpCrc crc;
+
+  // head of the array of blocks, head of the block, version and CRC type
+  uint32_t size = 1 + cbor.GetHeadSize (GetNItems ()) + 1 + 1;
+  size += cbor.GetHeadSize (m_processingFlags);
+  size += GetEidSize (m_dst) + GetEidSize (m_src) + GetEidSize (m_report);
+  size += 1 + cbor.GetHeadSize (m_createTimestamp) + cbor.GetHeadSize (m_timestampSeqNum);
+  size += cbor.GetHeadSize (m_lifeTime);
+  if (IsFragment ())
+    size += cbor.GetHeadSize (m_fragOffset) + cbor.GetHeadSize (m_aduLength);
+  if (m_crcType != BpCrc::CRC_NONE)
+    size += 1 + crc.GetSize (m_crcType);
+  return size;
+}
+
+void 
+BpV7Header::Serialize (Buffer::Iterator start) const
+{ 
+  NS_LOG_FUNCTION (this);
+  Buffer::Iterator i = start;
+  Cbor cbor;
+  BpCrc crc;
+
+  i.WriteU8 (Cbor::INDEFINITE_ARRAY);
+
+  Buffer::Iterator block = i;
+  cbor.EncodeHead (Cbor::ARRAY, GetNItems (), i);
+  cbor.EncodeHead (Cbor::UNSIGNED_INTEGER, VERSION, i);
+  cbor.EncodeHead (Cbor::UNSIGNED_INTEGER, m_processingFlags, i);
+  cbor.EncodeHead (Cbor::UNSIGNED_INTEGER, m_crcType, i);
+  EncodeEid (m_dst, i);
+  EncodeEid (m_src, i);
+  EncodeEid (m_report, i);
+  cbor.EncodeHead (Cbor::ARRAY, 2, i);
+  cbor.EncodeHead (Cbor::UNSIGNED_INTEGER, m_createTimestamp, i);
+  cbor.EncodeHead (Cbor::UNSIGNED_INTEGER, m_timestampSeqNum, i);
+  cbor.EncodeHead (Cbor::UNSIGNED_INTEGER, m_lifeTime, i);
+  if (IsFragment ())
+    {
+      cbor.EncodeHead (Cbor::UNSIGNED_INTEGER, m_fragOffset, i);
+      cbor.EncodeHead (Cbor::UNSIGNED_INTEGER, m_aduLength, i);
+    }
+
+  if (m_crcType != BpCrc::CRC_NONE)
+    {
+      // the CRC is computed over the block with the CRC value set to zero
+      uint32_t size = crc.GetSize (m_crcType);
+      cbor.EncodeHead (Cbor::BYTE_STRING, size, i);
+      Buffer::Iterator value = i;
+      i.WriteU8 (0, size);
+
+      uint32_t blockCrc = crc.Calculate (m_crcType, block, i.GetDistanceFrom (block));
+      if (size == 2)
+        value.WriteHtonU16 ((uint16_t) blockCrc);
+      else
+        value.WriteHtonU32 (blockCrc);
+    }
+}
+
+uint32_t 
+BpV7Header::Deserialize (Buffer::Iterator start)
+{ 
+  NS_LOG_FUNCTION (this);
+  Buffer::Iterator i = start;
+
+  m_valid = i.ReadU8 () == Cbor::INDEFINITE_ARRAY && Decode (i);
+  if (!m_valid)
+    NS_LOG_WARN ("BpV7Header::Deserialize (), malformed primary bundle block");
+
+  return i.GetDistanceFrom (start);
+}
+
+bool 
+BpV7Header::Decode (Buffer::Iterator &start)
+{ 
+  NS_LOG_FUNCTION (this);
+  Buffer::Iterator &i = start;
+  Buffer::Iterator block = i;
+  Cbor cbor;
+  BpCrc crc;
+  uint64_t items, value;
+
+  if (!cbor.Decode (i, Cbor::ARRAY, items) || 
+      !cbor.Decode (i, Cbor::UNSIGNED_INTEGER, value) || value != VERSION ||
+      !cbor.Decode (i, Cbor::UNSIGNED_INTEGER, m_processingFlags) ||
+      !cbor.Decode (i, Cbor::UNSIGNED_INTEGER, value) || value > BpCrc::CRC_32C)
+    return false;
+
+  m_crcType = (BpCrc::CrcType) value;
+  if (items != GetNItems ())
+    return false;
+
+  if (!DecodeEid (m_dst, i) || !DecodeEid (m_src, i) || !DecodeEid (m_report, i) ||
+      !cbor.Decode (i, Cbor::ARRAY, value) || value != 2 ||
+      !cbor.Decode (i, Cbor::UNSIGNED_INTEGER, m_createTimestamp) ||
+      !cbor.Decode (i, Cbor::UNSIGNED_INTEGER, m_timestampSeqNum) ||
+      !cbor.Decode (i, Cbor::UNSIGNED_INTEGER, m_lifeTime))
+    return false;
+
+  if (IsFragment () && 
+      (!cbor.Decode (i, Cbor::UNSIGNED_INTEGER, m_fragOffset) || 
+       !cbor.Decode (i, Cbor::UNSIGNED_INTEGER, m_aduLength)))
+    return false;
+
+  if (m_crcType == BpCrc::CRC_NONE)
+    return true;
+
+  uint32_t size = crc.GetSize (m_crcType);
+  if (!cbor.Decode (i, Cbor::BYTE_STRING, value) || value != size)
+    return false;
+
+  uint32_t received = size == 2 ? i.ReadNtohU16 () : i.ReadNtohU32 ();
+
+  // the CRC is computed over the block with the CRC value set to zero
+  static const uint8_t zeros[4] = { 0, 0, 0, 0 };
+  uint32_t blockCrc = crc.Calculate (m_crcType, block, i.GetDistanceFrom (block) - size);
+  blockCrc = crc.Calculate (m_crcType, zeros, size, blockCrc);
+  if (blockCrc != received)
+    {
+      NS_LOG_WARN ("BpV7Header::Decode (), CRC mismatch");
+      return false;
+    }
+
+  return true;
+}
+
+} // namespace ns3
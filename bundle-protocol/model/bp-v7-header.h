@@ -0,0 +1,213 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 University of New Brunswick
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Dizhi Zhou <dizhi.zhou@gmail.com>
+ */
+#ifndef BP_V7_HEADER_H
+#define BP_V7_HEADER_H
+
+#include <stdint.h>
+#include <string>
+#include "ns3/header.h"
+#include "ns3/nstime.h"
+#include "ns3/buffer.h"
+#include "ns3/packet.h"
+#include "ns3/sequence-number.h"
+#include "bp-endpoint-id.h"
+#include "bp-header.h"
+#include "bp-crc.h"
+
+namespace ns3 {
+
+/**
+ * \brief an endpoint id as encoded in BPv7, section 4.2.5.1 of RFC 9171
+ *
+ * The ssp is kept as decoded, and only turned into a BpEndpointId on demand.
+ */
+struct BpV7EndpointId
+{
+  BpV7EndpointId ()
+    : scheme (DTN),
+      ssp (),
+      node (0),
+      service (0)
+    {
+    }
+
+  /**
+   * URI scheme codes
+   */
+  enum {
+    DTN = 1,
+    IPN = 2
+  };
+
+  uint8_t scheme;    /// URI scheme code
+  std::string ssp;   /// ssp of a dtn endpoint id, empty for dtn:none
+  uint64_t node;     /// node number of an ipn endpoint id
+  uint64_t service;  /// service number of an ipn endpoint id
+};
+
+/**
+ * \brief BPv7 primary bundle block
+ *
+ * The format of the primary bundle block, which is defined in section 4.3.1 of
+ * RFC 9171. The block is encoded in CBOR, and is preceded by the head of the 
+ * indefinite length array of the blocks of the bundle. It always carries a
+ * CRC, which is checked by Deserialize ().
+ *
+ * RFC 9171 has neither custody transfer nor class of service: those flags of 
+ * an RFC 5050 primary bundle header are dropped, and the dictionary is 
+ * replaced by the endpoint ids. Only the dtn and the ipn schemes are supported.
+ */
+class BpV7Header : public Header
+{
+public:
+  BpV7Header ();
+
+  virtual ~BpV7Header ();
+
+  /**
+   * \brief Set the fields from an RFC 5050 primary bundle header
+   *
+   * \param header the RFC 5050 primary bundle header
+   */
+  void SetBpHeader (const BpHeader &header);
+
+  /**
+   * \return the fields as an RFC 5050 primary bundle header
+   */
+  BpHeader GetBpHeader () const;
+
+  /**
+   * \brief Peek the primary bundle header of a bundle of either version
+   *
+   * A BPv7 primary bundle block is converted by GetBpHeader ().
+   *
+   * \param bundle the bundle, starting with its primary bundle header
+   * \param header set to the primary bundle header
+   *
+   * \return false if the bundle is BPv7 and its primary block is malformed or 
+   * fails its CRC
+   */
+  static bool PeekBpHeader (Ptr<const Packet> bundle, BpHeader &header);
+
+  /**
+   * \param bundle a bundle
+   * \return true if the bundle is encoded in BPv7
+   */
+  static bool IsBpV7 (Ptr<const Packet> bundle);
+
+  /**
+   * \brief Set the bundle processing control flags, section 4.2.3 of RFC 9171
+   */
+  void SetProcessingFlags (uint64_t flags);
+
+  /**
+   * \brief Set the CRC type of the block, either CRC_16 or CRC_32C
+   */
+  void SetCrcType (BpCrc::CrcType type);
+
+  void SetDestinationEid (const BpEndpointId &dst);
+  void SetSourceEid (const BpEndpointId &src);
+  void SetReportEid (const BpEndpointId &report);
+  void SetCreateTimestamp (const Time &timestamp);
+  void SetSequenceNumber (const SequenceNumber32 &sequenceNumber);
+
+  /**
+   * \param lifetime lifetime in seconds, carried in milliseconds
+   */
+  void SetLifeTime (double lifetime);
+  void SetFragOffset (uint32_t offset);
+  void SetAduLength (uint32_t len);
+
+  uint64_t GetProcessingFlags () const;
+  BpCrc::CrcType GetCrcType () const;
+  bool IsFragment () const;
+  BpEndpointId GetDestinationEid () const;
+  BpEndpointId GetSourceEid () const;
+  BpEndpointId GetReportEid () const;
+  Time GetCreateTimestamp () const;
+  SequenceNumber32 GetSequenceNumber () const;
+  double GetLifeTime () const;
+  uint32_t GetFragOffset () const;
+  uint32_t GetAduLength () const;
+
+  /**
+   * \return false if the last deserialized block is malformed or fails its CRC
+   */
+  bool IsValid () const;
+
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual void Print (std::ostream &os) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+
+  /**
+   * bundle processing control flags, section 4.2.3 of RFC 9171
+   */
+  typedef enum {
+    BUNDLE_IS_FRAGMENT             = 1 << 0,
+    BUNDLE_IS_ADMIN                = 1 << 1,
+    BUNDLE_DO_NOT_FRAGMENT         = 1 << 2,
+    BUNDLE_ACK_BY_APP              = 1 << 5,
+    BUNDLE_STATUS_TIME             = 1 << 6,
+    REQ_REPORT_BUNDLE_RECEPTION    = 1 << 14,
+    REQ_REPORT_BUNDLE_FORWARD      = 1 << 16,
+    REQ_REPORT_BUNDLE_DELIVERY     = 1 << 17,
+    REQ_REPORT_BUNDLE_DELETION     = 1 << 18
+  } ProcessingFlags;
+
+private:
+  /**
+   * \brief Decode the block, after the head of the array of blocks
+   *
+   * \return false if the block is malformed or fails its CRC
+   */
+  bool Decode (Buffer::Iterator &start);
+
+  void SetEid (BpV7EndpointId &eid, const BpEndpointId &value);
+  BpEndpointId GetEid (const BpV7EndpointId &eid) const;
+  uint32_t GetEidSize (const BpV7EndpointId &eid) const;
+  void EncodeEid (const BpV7EndpointId &eid, Buffer::Iterator &start) const;
+  bool DecodeEid (BpV7EndpointId &eid, Buffer::Iterator &start);
+
+  /**
+   * \return the number of items of the block
+   */
+  uint32_t GetNItems () const;
+
+  uint64_t m_processingFlags;             /// bundle processing control flags
+  BpCrc::CrcType m_crcType;               /// CRC type
+  BpV7EndpointId m_dst;                   /// destination endpoint id
+  BpV7EndpointId m_src;                   /// source endpoint id
+  BpV7EndpointId m_report;                /// report-to endpoint id
+  uint64_t m_createTimestamp;             /// creation time in milliseconds
+  uint64_t m_timestampSeqNum;             /// sequence number
+  uint64_t m_lifeTime;                    /// lifetime in milliseconds
+  uint64_t m_fragOffset;                  /// fragment offset
+  uint64_t m_aduLength;                   /// total application data unit length
+  bool m_valid;                           /// is the last deserialized block valid?
+
+  static const uint8_t VERSION = 7;       /// the version of bundle protocol
+};
+
+} // namespace ns3
+
+#endif /* BP_V7_HEADER_H */
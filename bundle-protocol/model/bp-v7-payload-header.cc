@@ -0,0 +1,169 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 University of New Brunswick
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Dizhi Zhou <dizhi.zhou@gmail.com>
+ */
+
+#include "ns3/log.h"
+#include "bp-v7-payload-header.h"
+#include "cbor.h"
+
+NS_LOG_COMPONENT_DEFINE ("BpV7PayloadHeader");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (BpV7PayloadHeader);
+
+BpV7PayloadHeader::BpV7PayloadHeader ()
+  : m_processingFlags (0),
+    m_crcType (BpCrc::CRC_32C),
+    m_blockLength (0),
+    m_valid (true)
+{ 
+  NS_LOG_FUNCTION (this);
+}
+
+BpV7PayloadHeader::~BpV7PayloadHeader ()
+{ 
+  NS_LOG_FUNCTION (this);
+}
+
+TypeId 
+BpV7PayloadHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::BpV7PayloadHeader")
+    .SetParent<Header> ()
+    .AddConstructor<BpV7PayloadHeader> ()
+  ;
+
+  return tid;
+}
+
+TypeId 
+BpV7PayloadHeader::GetInstanceTypeId (void) const
+{ 
+  NS_LOG_FUNCTION (this);
+  return GetTypeId ();
+}
+
+void 
+BpV7PayloadHeader::Print (std::ostream &os) const
+{ 
+  NS_LOG_FUNCTION (this);
+  os << "payload " << m_blockLength;
+}
+
+void 
+BpV7PayloadHeader::SetProcessingFlags (uint64_t flags)
+{ 
+  NS_LOG_FUNCTION (this << " " << flags);
+  m_processingFlags = flags;
+}
+
+void 
+BpV7PayloadHeader::SetCrcType (BpCrc::CrcType type)
+{ 
+  NS_LOG_FUNCTION (this << " " << type);
+  m_crcType = type;
+}
+
+void 
+BpV7PayloadHeader::SetBlockLength (uint32_t len)
+{ 
+  NS_LOG_FUNCTION (this << " " << len);
+  m_blockLength = len;
+}
+
+uint64_t 
+BpV7PayloadHeader::GetProcessingFlags () const
+{ 
+  NS_LOG_FUNCTION (this);
+  return m_processingFlags;
+}
+
+BpCrc::CrcType 
+BpV7PayloadHeader::GetCrcType () const
+{ 
+  NS_LOG_FUNCTION (this);
+  return m_crcType;
+}
+
+uint32_t 
+BpV7PayloadHeader::GetBlockLength () const
+{ 
+  NS_LOG_FUNCTION (this);
+  return (uint32_t) m_blockLength;
+}
+
+bool 
+BpV7PayloadHeader::IsValid () const
+{ 
+  NS_LOG_FUNCTION (this);
+  return m_valid;
+}
+
+uint32_t 
+BpV7PayloadHeader::GetSerializedSize (void) const
+{ 
+  NS_LOG_FUNCTION (this);
+  Cbor cbor;
+
+  // head of the block, block type, block number, flags, CRC type and head of the payload
+  return 1 + 1 + 1 + cbor.GetHeadSize (m_processingFlags) + 1 + cbor.GetHeadSize (m_blockLength);
+}
+
+void 
+BpV7PayloadHeader::Serialize (Buffer::Iterator start) const
+{ 
+  NS_LOG_FUNCTION (this);
+  Buffer::Iterator i = start;
+  Cbor cbor;
+
+  // [type, number, flags, CRC type, payload, CRC if any]
+  cbor.EncodeHead (Cbor::ARRAY, m_crcType != BpCrc::CRC_NONE ? 6 : 5, i);
+  cbor.EncodeHead (Cbor::UNSIGNED_INTEGER, PAYLOAD_BLOCK, i);
+  cbor.EncodeHead (Cbor::UNSIGNED_INTEGER, PAYLOAD_BLOCK, i);
+  cbor.EncodeHead (Cbor::UNSIGNED_INTEGER, m_processingFlags, i);
+  cbor.EncodeHead (Cbor::UNSIGNED_INTEGER, m_crcType, i);
+  cbor.EncodeHead (Cbor::BYTE_STRING, m_blockLength, i);
+}
+
+uint32_t 
+BpV7PayloadHeader::Deserialize (Buffer::Iterator start)
+{ 
+  NS_LOG_FUNCTION (this);
+  Buffer::Iterator i = start;
+  Cbor cbor;
+  uint64_t items, type, number, crcType;
+
+  m_valid = cbor.Decode (i, Cbor::ARRAY, items) &&
+            cbor.Decode (i, Cbor::UNSIGNED_INTEGER, type) && type == PAYLOAD_BLOCK &&
+            cbor.Decode (i, Cbor::UNSIGNED_INTEGER, number) && number == PAYLOAD_BLOCK &&
+            cbor.Decode (i, Cbor::UNSIGNED_INTEGER, m_processingFlags) &&
+            cbor.Decode (i, Cbor::UNSIGNED_INTEGER, crcType) && crcType <= BpCrc::CRC_32C &&
+            items == (crcType != BpCrc::CRC_NONE ? 6u : 5u) &&
+            cbor.Decode (i, Cbor::BYTE_STRING, m_blockLength);
+
+  if (m_valid)
+    m_crcType = (BpCrc::CrcType) crcType;
+  else
+    NS_LOG_WARN ("BpV7PayloadHeader::Deserialize (), malformed bundle payload block");
+
+  return i.GetDistanceFrom (start);
+}
+
+} // namespace ns3
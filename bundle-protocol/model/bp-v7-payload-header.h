@@ -0,0 +1,87 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 University of New Brunswick
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Dizhi Zhou <dizhi.zhou@gmail.com>
+ */
+#ifndef BP_V7_PAYLOAD_HEADER_H
+#define BP_V7_PAYLOAD_HEADER_H
+
+#include <stdint.h>
+#include "ns3/header.h"
+#include "ns3/buffer.h"
+#include "bp-crc.h"
+
+namespace ns3 {
+
+/**
+ * \brief BPv7 bundle payload block header
+ *
+ * The leading part of the bundle payload block, which is defined in section 
+ * 4.3.3 of RFC 9171: the head of the block, the block type, number, flags and
+ * CRC type, and the head of the byte string of the payload. The payload 
+ * follows, then the BpV7PayloadTrailer.
+ */
+class BpV7PayloadHeader : public Header
+{
+public:
+  BpV7PayloadHeader ();
+
+  virtual ~BpV7PayloadHeader ();
+
+  /**
+   * \brief Set the block processing control flags, section 4.2.4 of RFC 9171
+   */
+  void SetProcessingFlags (uint64_t flags);
+
+  /**
+   * \brief Set the CRC type of the block
+   */
+  void SetCrcType (BpCrc::CrcType type);
+
+  /**
+   * \brief Set the length of the payload
+   */
+  void SetBlockLength (uint32_t len);
+
+  uint64_t GetProcessingFlags () const;
+  BpCrc::CrcType GetCrcType () const;
+  uint32_t GetBlockLength () const;
+
+  /**
+   * \return false if the last deserialized header is malformed
+   */
+  bool IsValid () const;
+
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual void Print (std::ostream &os) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+
+  static const uint8_t PAYLOAD_BLOCK = 1;   /// block type and block number of the payload block
+
+private:
+  uint64_t m_processingFlags;   /// block processing control flags
+  BpCrc::CrcType m_crcType;     /// CRC type
+  uint64_t m_blockLength;       /// length of the payload
+  bool m_valid;                 /// is the last deserialized header valid?
+};
+
+} // namespace ns3
+
+#endif /* BP_V7_PAYLOAD_HEADER_H */
@@ -0,0 +1,166 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 University of New Brunswick
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Dizhi Zhou <dizhi.zhou@gmail.com>
+ */
+
+#include "ns3/log.h"
+#include "bp-v7-payload-trailer.h"
+#include "cbor.h"
+
+NS_LOG_COMPONENT_DEFINE ("BpV7PayloadTrailer");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (BpV7PayloadTrailer);
+
+BpV7PayloadTrailer::BpV7PayloadTrailer ()
+  : m_crcType (BpCrc::CRC_32C),
+    m_blockSize (0),
+    m_valid (true)
+{ 
+  NS_LOG_FUNCTION (this);
+}
+
+BpV7PayloadTrailer::~BpV7PayloadTrailer ()
+{ 
+  NS_LOG_FUNCTION (this);
+}
+
+TypeId 
+BpV7PayloadTrailer::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::BpV7PayloadTrailer")
+    .SetParent<Trailer> ()
+    .AddConstructor<BpV7PayloadTrailer> ()
+  ;
+
+  return tid;
+}
+
+TypeId 
+BpV7PayloadTrailer::GetInstanceTypeId (void) const
+{ 
+  NS_LOG_FUNCTION (this);
+  return GetTypeId ();
+}
+
+void 
+BpV7PayloadTrailer::Print (std::ostream &os) const
+{ 
+  NS_LOG_FUNCTION (this);
+  os << "crc type " << m_crcType;
+}
+
+void 
+BpV7PayloadTrailer::SetPayloadHeader (const BpV7PayloadHeader &header)
+{ 
+  NS_LOG_FUNCTION (this);
+  m_crcType = header.GetCrcType ();
+  m_blockSize = header.GetSerializedSize () + header.GetBlockLength ();
+}
+
+bool 
+BpV7PayloadTrailer::IsValid () const
+{ 
+  NS_LOG_FUNCTION (this);
+  return m_valid;
+}
+
+uint32_t 
+BpV7PayloadTrailer::GetSerializedSize (void) const
+{ 
+  NS_LOG_FUNCTION (this);
+  BpCrc crc;
+
+  // CRC, if any, and the end of the array of blocks
+  return (m_crcType != BpCrc::CRC_NONE ? 1 + crc.GetSize (m_crcType) : 0) + 1;
+}
+
+void 
+BpV7PayloadTrailer::Serialize (Buffer::Iterator start) const
+{ 
+  NS_LOG_FUNCTION (this);
+  Buffer::Iterator i = start;
+  i.Prev (GetSerializedSize ());
+  Cbor cbor;
+  BpCrc crc;
+
+  if (m_crcType != BpCrc::CRC_NONE)
+    {
+      // the CRC is computed over the block with the CRC value set to zero
+      Buffer::Iterator block = i;
+      block.Prev (m_blockSize);
+
+      uint32_t size = crc.GetSize (m_crcType);
+      cbor.EncodeHead (Cbor::BYTE_STRING, size, i);
+      Buffer::Iterator value = i;
+      i.WriteU8 (0, size);
+
+      uint32_t blockCrc = crc.Calculate (m_crcType, block, i.GetDistanceFrom (block));
+      if (size == 2)
+        value.WriteHtonU16 ((uint16_t) blockCrc);
+      else
+        value.WriteHtonU32 (blockCrc);
+    }
+
+  i.WriteU8 (Cbor::BREAK);
+}
+
+uint32_t 
+BpV7PayloadTrailer::Deserialize (Buffer::Iterator start)
+{ 
+  NS_LOG_FUNCTION (this);
+  Buffer::Iterator i = start;
+  uint32_t trailerSize = GetSerializedSize ();
+  i.Prev (trailerSize);
+  Cbor cbor;
+  BpCrc crc;
+
+  m_valid = true;
+  if (m_crcType != BpCrc::CRC_NONE)
+    {
+      Buffer::Iterator block = i;
+      block.Prev (m_blockSize);
+
+      uint64_t value;
+      uint32_t size = crc.GetSize (m_crcType);
+      if (!cbor.Decode (i, Cbor::BYTE_STRING, value) || value != size)
+        {
+          m_valid = false;
+          return trailerSize;
+        }
+
+      uint32_t received = size == 2 ? i.ReadNtohU16 () : i.ReadNtohU32 ();
+
+      static const uint8_t zeros[4] = { 0, 0, 0, 0 };
+      uint32_t blockCrc = crc.Calculate (m_crcType, block, i.GetDistanceFrom (block) - size);
+      blockCrc = crc.Calculate (m_crcType, zeros, size, blockCrc);
+      if (blockCrc != received)
+        {
+          NS_LOG_WARN ("BpV7PayloadTrailer::Deserialize (), CRC mismatch");
+          m_valid = false;
+        }
+    }
+
+  if (i.ReadU8 () != Cbor::BREAK)
+    m_valid = false;
+
+  return trailerSize;
+}
+
+} // namespace ns3
@@ -0,0 +1,74 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 University of New Brunswick
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Dizhi Zhou <dizhi.zhou@gmail.com>
+ */
+#ifndef BP_V7_PAYLOAD_TRAILER_H
+#define BP_V7_PAYLOAD_TRAILER_H
+
+#include <stdint.h>
+#include "ns3/trailer.h"
+#include "ns3/buffer.h"
+#include "bp-crc.h"
+#include "bp-v7-payload-header.h"
+
+namespace ns3 {
+
+/**
+ * \brief BPv7 bundle payload block trailer
+ *
+ * The end of the bundle payload block, section 4.3.3 of RFC 9171: the CRC of
+ * the block, if any, and the end of the array of the blocks of the bundle.
+ *
+ * The CRC covers the whole payload block, which precedes the trailer in the 
+ * packet, so the trailer must know the payload block header both to add and 
+ * to remove it.
+ */
+class BpV7PayloadTrailer : public Trailer
+{
+public:
+  BpV7PayloadTrailer ();
+
+  virtual ~BpV7PayloadTrailer ();
+
+  /**
+   * \brief Set the payload block header, which gives the CRC type and the 
+   * length of the block covered by the CRC
+   */
+  void SetPayloadHeader (const BpV7PayloadHeader &header);
+
+  /**
+   * \return false if the last deserialized trailer is malformed or fails its CRC
+   */
+  bool IsValid () const;
+
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual void Print (std::ostream &os) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+
+private:
+  BpCrc::CrcType m_crcType;     /// CRC type
+  uint32_t m_blockSize;         /// bytes of the payload block before the trailer
+  bool m_valid;                 /// is the last deserialized trailer valid?
+};
+
+} // namespace ns3
+
+#endif /* BP_V7_PAYLOAD_TRAILER_H */
@@ -25,13 +25,20 @@
 #include "ns3/uinteger.h"
 #include "ns3/simulator.h"
 #include "ns3/string.h"
+#include "ns3/pointer.h"
 #include "ns3/buffer.h"
 #include "bp-tcp-cla-protocol.h"
 #include "bp-ltp-cla-protocol.h"
 #include "bundle-protocol.h"
 #include "bp-header.h"
 #include "bp-payload-header.h"
+#include "bp-v7-header.h"
+#include "bp-v7-payload-header.h"
+#include "bp-v7-payload-trailer.h"
+#include "sdnv.h"
+#include "cbor.h"
 #include <algorithm>
+#include <limits>
 #include <map>
 
 NS_LOG_COMPONENT_DEFINE ("BundleProtocol");
@@ -50,6 +57,19 @@ BundleProtocol::GetTypeId (void)
            UintegerValue (512),
            MakeUintegerAccessor (&BundleProtocol::m_bundleSize),
            MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("BundleVersion", "Version of the bundles sent: 6 for RFC 5050, 7 for RFC 9171; bundles of both versions are received",
+           UintegerValue (6),
+           MakeUintegerAccessor (&BundleProtocol::m_bundleVersion),
+           MakeUintegerChecker<uint32_t> (6, 7))
+    .AddAttribute ("CrcType", "CRC type of the blocks of RFC 9171 bundles sent: 1 for CRC-16, 2 for CRC-32C",
+           UintegerValue (BpCrc::CRC_32C),
+           MakeUintegerAccessor (&BundleProtocol::m_crcType),
+           MakeUintegerChecker<uint32_t> (BpCrc::CRC_16, BpCrc::CRC_32C))
+    .AddAttribute ("MaxBlocksSize", "Max size in bytes of the blocks ahead of the payload of an RFC 9171 bundle received; "
+                   "larger bundles are dropped as malformed, together with the rest of the receive buffer",
+           UintegerValue (65536),
+           MakeUintegerAccessor (&BundleProtocol::m_rxMaxBlocksSize),
+           MakeUintegerChecker<uint32_t> (1024))
     .AddAttribute ("L4Type", "The type of transport layer protocol",
            //StringValue ("Tcp"),
 		   StringValue ("Ltp"),
@@ -63,6 +83,14 @@ BundleProtocol::GetTypeId (void)
                    TimeValue (TimeStep (0)),
                    MakeTimeAccessor (&BundleProtocol::m_stopTime),
                    MakeTimeChecker ())
+    .AddAttribute ("SendBundleStore", "The persistant storage of sent bundles",
+                   PointerValue (),
+                   MakePointerAccessor (&BundleProtocol::m_sendBundleStore),
+                   MakePointerChecker<BpBundleStore> ())
+    .AddAttribute ("RecvBundleStore", "The persistant storage of received bundles",
+                   PointerValue (),
+                   MakePointerAccessor (&BundleProtocol::m_recvBundleStore),
+                   MakePointerChecker<BpBundleStore> ())
   ;
   return tid;
 }
@@ -70,7 +98,16 @@ BundleProtocol::GetTypeId (void)
 BundleProtocol::BundleProtocol ()
   : m_node (0),
     m_cla (0),
+    m_sendBundleStore (CreateObject<BpBundleStore> ()),
+    m_recvBundleStore (CreateObject<BpBundleStore> ()),
     m_bpRxBufferPacket (Create<Packet> (0)),
+    m_rxHeader (1024),
+    m_rxMaxBlocksSize (65536),
+    m_rxPrimaryHeaderSize (BpHeader ().GetSerializedSize ()),
+    m_rxPayloadHeaderSize (BpPayloadHeader ().GetSerializedSize ()),
+    m_rxBundleLength (0),
+    m_rxExtensionStart (0),
+    m_rxExtensionLength (0),
     m_seq (0),
     m_eid ("dtn:none"),
     m_bpRegInfo (),
@@ -224,6 +261,7 @@ BundleProtocol::Send (Ptr<Packet> p, const BpEndpointId &src, const BpEndpointId
       // TBD: the lifetime of the eid is expired?
     }
 
+  int ret = 0;
   uint32_t total = p->GetSize ();
   bool fragment =  ( total > m_bundleSize ) ? true : false;
 
@@ -231,7 +269,6 @@ BundleProtocol::Send (Ptr<Packet> p, const BpEndpointId &src, const BpEndpointId
   std::vector<Ptr<Packet>> allPackets;
 
   // a simple fragementation: ensure a bundle is transmittd by one packet at the transport layer
-  uint32_t num = 0;
   while ( total > 0 )   
     { 
       Ptr<Packet> packet = NULL;
@@ -244,7 +281,9 @@ BundleProtocol::Send (Ptr<Packet> p, const BpEndpointId &src, const BpEndpointId
       BpHeader bph;
       bph.SetDestinationEid (dst);
       bph.SetSourceEid (src);
-      bph.SetCreateTimestamp (Simulator::Now ());
+      // timestamps are sent in milliseconds: bph then gives the same bundle id
+      // as the header that the CLA decodes from the bundle
+      bph.SetCreateTimestamp (MilliSeconds (Simulator::Now ().GetMilliSeconds ()));
       bph.SetSequenceNumber (m_seq);
       m_seq++;
 
@@ -267,8 +306,28 @@ BundleProtocol::Send (Ptr<Packet> p, const BpEndpointId &src, const BpEndpointId
       bpph.SetBlockLength (size);
 
       packet = Create<Packet> (size);
-      packet->AddHeader (bpph);
-      packet->AddHeader (bph);
+      if (m_bundleVersion == 7)
+        {
+          BpCrc::CrcType crcType = (BpCrc::CrcType) m_crcType;
+          BpV7PayloadHeader bpv7ph;
+          bpv7ph.SetCrcType (crcType);
+          bpv7ph.SetBlockLength (size);
+          BpV7PayloadTrailer bpv7pt;
+          bpv7pt.SetPayloadHeader (bpv7ph);
+
+          BpV7Header bpv7h;
+          bpv7h.SetBpHeader (bph);
+          bpv7h.SetCrcType (crcType);
+
+          packet->AddHeader (bpv7ph);
+          packet->AddTrailer (bpv7pt);
+          packet->AddHeader (bpv7h);
+        }
+      else
+        {
+          packet->AddHeader (bpph);
+          packet->AddHeader (bph);
+        }
 
       NS_LOG_DEBUG ("Send bundle:" << " seq " << bph.GetSequenceNumber ().GetValue () << 
                                  " src eid " << bph.GetSourceEid ().Uri () << 
@@ -278,35 +337,30 @@ BundleProtocol::Send (Ptr<Packet> p, const BpEndpointId &src, const BpEndpointId
 
       allPackets.push_back(packet);
 
+      total = total - size;
+
       // store the bundle into persistant sent storage
-      std::map<BpEndpointId, std::queue<Ptr<Packet> > >::iterator it = BpSendBundleStore.end ();
-      it = BpSendBundleStore.find (src);
-      if ( it == BpSendBundleStore.end ())
+      if (!m_sendBundleStore->Enqueue (src, packet, bph))
         {
-          // this is the first packet sent by this source endpoint id
-          std::queue<Ptr<Packet> > qu;
-          qu.push (packet);
-          BpSendBundleStore.insert (std::pair<BpEndpointId, std::queue<Ptr<Packet> > > (src, qu) );
+          NS_LOG_DEBUG ("Send bundle: seq " << bph.GetSequenceNumber ().GetValue () << " is not stored");
+          ret = -1;
+          continue;
         }
-      else
+
+      // hold the bundle in the persistant storage until the contact towards dst opens
+      Ptr<BpRoutingProtocol> route = m_cla ? m_cla->GetRoutingProtocol () : 0;
+      Time sendTime = route ? route->GetSendTime (dst) : Simulator::Now ();
+      if (m_cla && sendTime > Simulator::Now ())
         {
-          // ongoing packet
-          (*it).second.push (packet);
+          NS_LOG_DEBUG ("Send bundle: seq " << bph.GetSequenceNumber ().GetValue () << " is queued until " << sendTime);
+          Simulator::Schedule (sendTime - Simulator::Now (), &BpClaProtocol::SendPacket, m_cla, packet);
+          continue;
         }
 
       if (m_cla)
-        {
-           m_cla->SendPacket (packet);
-           num++;
-        }
+        m_cla->SendPacket (packet);
       else
         NS_FATAL_ERROR ("BundleProtocol::Send (): undefined m_cla");
-
-      total = total - size;
-
-      // force the convergence layer to send the packet
-      if (num == 1)
-       m_cla->SendPacket (packet);
     }
 
 //  // Combine all small packets into a large packet
@@ -321,7 +375,7 @@ BundleProtocol::Send (Ptr<Packet> p, const BpEndpointId &src, const BpEndpointId
 //  m_block.resize(size);
 //  largePacket->CopyData(m_block.data(), size);
 
-  return 0;
+  return ret;
 }
 
 int
@@ -348,57 +402,194 @@ void
 BundleProtocol::RetreiveBundle ()
 { 
   NS_LOG_FUNCTION (this);
-  BpHeader bpHeader;         // primary bundle header
-  BpPayloadHeader bppHeader; // bundle payload header
- 
-  // continue to retreive a bundle from buffer until the buffer size is smaller than a bundle or a bundle header 
-  if (m_bpRxBufferPacket->GetSize () > (bpHeader.GetSerializedSize () + bppHeader.GetSerializedSize ()))
-    {
-      // since BpHeader's length is a variable, we must also read data buffer size to guarantee that the node 
-      // receives a complete primary bundle header and bundle payload header
-
-      // copy m_bpRxBufferPacket into a Buffer
-      uint32_t size = m_bpRxBufferPacket->GetSize();
-      uint8_t *buffer = (uint8_t*)std::malloc(size);
-      m_bpRxBufferPacket->CopyData (buffer, size); 
-      Buffer buf;
-      buf.AddAtStart (size);
-      Buffer::Iterator start = buf.Begin ();
-      start.Write (buffer, size);
- 
-      // if there is not data, we cannot call PeekHeader, since we cannot guarantee a complete primary bundle header and 
-      // bundle header is received
-      if (buf.GetSize () == 0 )
-        return;
 
-      m_bpRxBufferPacket->PeekHeader (bpHeader);
-      m_bpRxBufferPacket->PeekHeader (bppHeader);
+  // continue to retreive bundles from buffer until the buffer is smaller than a bundle or a bundle header 
+  while (true)
+    {
+      if (m_rxBundleLength == 0)
+        {
+          // the leading bytes of the bundle tell where it ends: the fixed part of an RFC 5050 
+          // primary bundle header, or the blocks of a BPv7 bundle up to the head of its payload
+          uint32_t available = m_bpRxBufferPacket->GetSize ();
+          if (available == 0)
+            return;
+
+          m_bpRxBufferPacket->CopyData (&m_rxHeader[0], 1);
+          bool v7 = m_rxHeader[0] == Cbor::INDEFINITE_ARRAY;
+
+          // the blocks ahead of the payload of a BPv7 bundle have no bound of their own: start
+          // with a small window and double it while they go beyond it, up to m_rxMaxBlocksSize
+          uint32_t window = v7 ? 1024 : m_rxPrimaryHeaderSize;
+          while (true)
+            {
+              if (m_rxHeader.size () < window)
+                m_rxHeader.resize (window);
+
+              bool complete = available >= window;
+              uint32_t size = std::min (window, available);
+              m_bpRxBufferPacket->CopyData (&m_rxHeader[0], size);
+
+              bool parsed = ParseBundleLength (&m_rxHeader[0], size, m_rxBundleLength);
+              if (parsed && (m_rxBundleLength > 0 || !complete))
+                break;
+
+              if (!parsed || !v7 || window >= m_rxMaxBlocksSize)
+                {
+                  // we cannot find the start of the next bundle in the stream anymore
+                  NS_LOG_WARN ("malformed primary bundle header, drop " << m_bpRxBufferPacket->GetSize () << " bytes");
+                  m_bpRxBufferPacket = Create<Packet> (0);
+                  m_rxBundleLength = 0;
+                  return;
+                }
+
+              window = (window > m_rxMaxBlocksSize / 2) ? m_rxMaxBlocksSize : 2 * window;
+            }
+
+          if (m_rxBundleLength == 0)
+            return;
+        }
 
-      uint32_t total =  bpHeader.GetBlockLength ()
-                      + bpHeader.GetSerializedSize () 
-                      + bppHeader.GetSerializedSize ();
+      if (m_bpRxBufferPacket->GetSize () < m_rxBundleLength)
+        return;
 
-      if (m_bpRxBufferPacket->GetSize () >= total)
+      Ptr<Packet> bundle;
+      if (m_rxExtensionLength > 0)
         {
-          Ptr<Packet> bundle = m_bpRxBufferPacket->CreateFragment (0, total) ;
-          m_bpRxBufferPacket->RemoveAtStart (total);
-
-          ProcessBundle (bundle);
-          
-          // continue to check bundles
-          Simulator::ScheduleNow (&BundleProtocol::RetreiveBundle, this);
+          // extension blocks are not processed by this node, they are discarded so that
+          // the payload block follows the primary block
+          uint32_t payloadStart = m_rxExtensionStart + m_rxExtensionLength;
+          bundle = m_bpRxBufferPacket->CreateFragment (0, m_rxExtensionStart);
+          bundle->AddAtEnd (m_bpRxBufferPacket->CreateFragment (payloadStart, m_rxBundleLength - payloadStart));
         }
       else
         {
-          //NS_LOG_DEBUG ("no enough space for a bundle");
+          bundle = m_bpRxBufferPacket->CreateFragment (0, m_rxBundleLength);
         }
 
-    } 
-  else
+      m_bpRxBufferPacket->RemoveAtStart (m_rxBundleLength);
+      m_rxBundleLength = 0;
+      m_rxExtensionLength = 0;
+
+      ProcessBundle (bundle);
+    }
+}
+
+bool
+BundleProtocol::ParseBundleLength (const uint8_t *data, uint32_t size, uint32_t &length)
+{ 
+  NS_LOG_FUNCTION (this << " " << size);
+  length = 0;
+  m_rxExtensionLength = 0;
+  if (size > 0 && data[0] == Cbor::INDEFINITE_ARRAY)
+    return ParseBpV7BundleLength (data, size, length);
+
+  if (size < m_rxPrimaryHeaderSize)
+    return true;
+
+  Sdnv sdnv;
+  uint32_t offset = 1; // version
+  uint32_t read = 0;
+  uint64_t blockLength = 0;
+  uint64_t dictLength = 0;
+
+  // processing flags, block length, 16 endpoint id offsets, creation timestamp, 
+  // sequence number, lifetime and dictionary length, see BpHeader::Serialize ()
+  for (uint32_t field = 0; field < 22; field++)
+    {
+      uint64_t value = sdnv.Decode (data + offset, m_rxPrimaryHeaderSize - offset, read);
+      if (read == 0)
+        return false;
+
+      offset += read;
+
+      if (field == 1)
+        blockLength = value;
+      else if (field == 21)
+        dictLength = value;
+    }
+
+  uint64_t total = m_rxPrimaryHeaderSize + dictLength + m_rxPayloadHeaderSize + blockLength;
+  if (total > std::numeric_limits<uint32_t>::max ())
+    return false;
+
+  length = (uint32_t) total;
+  return true;
+}
+
+bool
+BundleProtocol::ParseBpV7BundleLength (const uint8_t *data, uint32_t size, uint32_t &length)
+{ 
+  NS_LOG_FUNCTION (this << " " << size);
+  Cbor cbor;
+  Cbor::MajorType type;
+  uint64_t value;
+  length = 0;
+
+  // the head of the array of blocks, then the primary block
+  uint32_t offset = 1;
+  int32_t read = cbor.GetItemSize (data + offset, size - offset);
+  if (read <= 0)
+    return read == 0;
+  offset += read;
+  m_rxExtensionStart = offset;
+
+  // the canonical blocks, up to the payload block which is the last one, section 4.1 of RFC 9171
+  while (true)
+    {
+      uint32_t block = offset;
+      read = cbor.DecodeHead (data + offset, size - offset, type, value);
+      if (read <= 0)
+        return read == 0;
+      if (type != Cbor::ARRAY)
+        return false;
+      offset += read;
+
+      read = cbor.DecodeHead (data + offset, size - offset, type, value);
+      if (read <= 0)
+        return read == 0;
+      if (type != Cbor::UNSIGNED_INTEGER)
+        return false;
+      offset += read;
+
+      if (value == BpV7PayloadHeader::PAYLOAD_BLOCK)
+        {
+          m_rxExtensionLength = block - m_rxExtensionStart;
+          break;
+        }
+
+      // skip an extension block
+      read = cbor.GetItemSize (data + block, size - block);
+      if (read <= 0)
+        return read == 0;
+      offset = block + read;
+    }
+
+  // block number, block processing flags, CRC type and the head of the payload
+  uint64_t crcType = 0;
+  for (uint32_t field = 0; field < 4; field++)
     {
-      //NS_LOG_DEBUG ("no enough space for a bundle header");
+      read = cbor.DecodeHead (data + offset, size - offset, type, value);
+      if (read <= 0)
+        return read == 0;
+      if (type != (field < 3 ? Cbor::UNSIGNED_INTEGER : Cbor::BYTE_STRING))
+        return false;
+      offset += read;
+
+      if (field == 2)
+        crcType = value;
     }
 
+  if (crcType > BpCrc::CRC_32C)
+    return false;
+
+  // the payload, the CRC of the payload block if any, and the end of the array of blocks
+  BpCrc crc;
+  uint64_t total = offset + value + (crcType != BpCrc::CRC_NONE ? 1 + crc.GetSize ((BpCrc::CrcType) crcType) : 0) + 1;
+  if (total > std::numeric_limits<uint32_t>::max ())
+    return false;
+
+  length = (uint32_t) total;
+  return true;
 }
 
 void 
@@ -408,7 +599,7 @@ BundleProtocol::ReceivePacket (Ptr<Packet> packet)
   // add packets ino receive buffer
   m_bpRxBufferPacket->AddAtEnd (packet);
 
-  Simulator::ScheduleNow (&BundleProtocol::RetreiveBundle, this);
+  RetreiveBundle ();
 }
 
 void 
@@ -416,10 +607,42 @@ BundleProtocol::ProcessBundle (Ptr<Packet> bundle)
 { 
   NS_LOG_FUNCTION (this << " " << bundle);
   BpHeader bpHeader;         // primary bundle header
-  BpPayloadHeader bppHeader; // bundle payload header
 
-  bundle->PeekHeader (bpHeader);
-  bundle->PeekHeader (bppHeader);
+  if (BpV7Header::IsBpV7 (bundle))
+    {
+      // decode the primary block once, then check the CRC of the payload block
+      Ptr<Packet> copy = bundle->Copy ();
+      BpV7Header bpv7h;
+      BpV7PayloadHeader bpv7ph;
+      BpV7PayloadTrailer bpv7pt;
+      copy->RemoveHeader (bpv7h);
+      if (!bpv7h.IsValid ())
+        {
+          NS_LOG_WARN ("Recv bundle: malformed primary bundle block, drop");
+          return;
+        }
+
+      bpHeader = bpv7h.GetBpHeader ();
+      copy->PeekHeader (bpv7ph);
+      bpv7pt.SetPayloadHeader (bpv7ph);
+      if (!bpv7ph.IsValid () || 
+          bpv7ph.GetSerializedSize () + bpv7ph.GetBlockLength () + bpv7pt.GetSerializedSize () != copy->GetSize ())
+        {
+          NS_LOG_WARN ("Recv bundle: malformed payload block, drop");
+          return;
+        }
+
+      copy->PeekTrailer (bpv7pt);
+      if (!bpv7pt.IsValid ())
+        {
+          NS_LOG_WARN ("Recv bundle: malformed payload block, drop");
+          return;
+        }
+    }
+  else
+    {
+      bundle->PeekHeader (bpHeader);
+    }
   
   BpEndpointId dst = bpHeader.GetDestinationEid ();
   BpEndpointId src = bpHeader.GetSourceEid ();
@@ -444,21 +667,7 @@ BundleProtocol::ProcessBundle (Ptr<Packet> bundle)
     }
 
   // store the bundle into persistant received storage
-  std::map<BpEndpointId, std::queue<Ptr<Packet> > >::iterator itMap = BpRecvBundleStore.end ();
-  itMap = BpRecvBundleStore.find (dst);
-  if ( itMap == BpRecvBundleStore.end ())
-    {
-      // this is the first bundle received by this destination endpoint id
-      std::queue<Ptr<Packet> > qu;
-      qu.push (bundle);
-      BpRecvBundleStore.insert (std::pair<BpEndpointId, std::queue<Ptr<Packet> > > (dst, qu) );
-    }
-  else
-    {
-      // ongoing bundles
-      (*itMap).second.push (bundle);
-    }
-
+  m_recvBundleStore->Enqueue (dst, bundle, bpHeader);
 }
 
 Ptr<Packet>
@@ -479,32 +688,31 @@ BundleProtocol::Receive (const BpEndpointId &eid)
       // TBD: the lifetime of the eid is expired?
      
       // return all the bundles with dst eid = eid
-      std::map<BpEndpointId, std::queue<Ptr<Packet> > >::iterator itMap = BpRecvBundleStore.end ();
-      itMap = BpRecvBundleStore.find (eid);
-      if ( itMap == BpRecvBundleStore.end ())
+      Ptr<Packet> packet = m_recvBundleStore->Dequeue (eid);
+      if (packet)
         {
-          // do not receive any bundle with this dst eid
-          return emptyPacket;
-        }
-      else if ( (*itMap).second.size () > 0)
-        {
-          Ptr<Packet> packet = ((*itMap).second).front ();
-          ((*itMap).second).pop ();
-
           // remove bundle header before forwarding to applications
-          BpHeader bpHeader;         // primary bundle header
-          BpPayloadHeader bppHeader; // bundle payload header
-          packet->RemoveHeader (bpHeader);
-          packet->RemoveHeader (bppHeader);
-    
-          return packet;
-        }
-      else
-        {
-          // has already fetched all bundles with this dst eid
-          BpRecvBundleStore.erase (itMap);
-          return emptyPacket;
+          if (BpV7Header::IsBpV7 (packet))
+            {
+              BpV7Header bpv7h;
+              BpV7PayloadHeader bpv7ph;
+              BpV7PayloadTrailer bpv7pt;
+              packet->RemoveHeader (bpv7h);
+              packet->PeekHeader (bpv7ph);
+              bpv7pt.SetPayloadHeader (bpv7ph);
+              packet->RemoveTrailer (bpv7pt);
+              packet->RemoveHeader (bpv7ph);
+            }
+          else
+            {
+              BpHeader bpHeader;         // primary bundle header
+              BpPayloadHeader bppHeader; // bundle payload header
+              packet->RemoveHeader (bpHeader);
+              packet->RemoveHeader (bppHeader);
+            }
         }
+
+      return packet;
     }
 
 }
@@ -522,6 +730,7 @@ BundleProtocol::SetRoutingProtocol (Ptr<BpRoutingProtocol> route)
 { 
   NS_LOG_FUNCTION (this << " " << route);
   m_cla->SetRoutingProtocol (route);
+  route->SetBundleProtocol (this);
 }
 
 Ptr<BpRoutingProtocol> 
@@ -542,22 +751,38 @@ Ptr<Packet>
 BundleProtocol::GetBundle (const BpEndpointId &src)
 { 
   NS_LOG_FUNCTION (this << " " << src.Uri ());
-  std::map<BpEndpointId, std::queue<Ptr<Packet> > >::iterator it = BpSendBundleStore.end ();
-  it = BpSendBundleStore.find (src);
-  if ( it == BpSendBundleStore.end ())
-    {
-      return NULL;
-    }
-  else
-    {
-      if ( ((*it).second).size () == 0)
-        return NULL;
+  return m_sendBundleStore->Dequeue (src);
+}
 
-      Ptr<Packet> packet = ((*it).second).front ();
-      ((*it).second).pop ();
+Ptr<Packet> 
+BundleProtocol::GetBundle (const BpBundleId &id)
+{ 
+  NS_LOG_FUNCTION (this << " " << id.src.Uri () << " " << id.seq);
+  return m_sendBundleStore->Dequeue (id);
+}
 
-      return packet;
-    }
+int
+BundleProtocol::CustodyAccepted (const BpBundleId &id)
+{ 
+  NS_LOG_FUNCTION (this << " " << id.src.Uri () << " " << id.seq);
+  if (!m_sendBundleStore->Release (id))
+    return -1;
+
+  return 0;
+}
+
+Ptr<BpBundleStore>
+BundleProtocol::GetSendBundleStore () const
+{ 
+  NS_LOG_FUNCTION (this);
+  return m_sendBundleStore;
+}
+
+Ptr<BpBundleStore>
+BundleProtocol::GetRecvBundleStore () const
+{ 
+  NS_LOG_FUNCTION (this);
+  return m_recvBundleStore;
 }
 
 std::vector<uint8_t>
@@ -627,6 +852,10 @@ BundleProtocol::DoDispose (void)
   m_node = 0;
   m_cla = 0;
   m_bpRoutingProtocol = 0;
+  m_sendBundleStore->Dispose ();
+  m_sendBundleStore = 0;
+  m_recvBundleStore->Dispose ();
+  m_recvBundleStore = 0;
   m_startEvent.Cancel ();
   m_stopEvent.Cancel ();
   Object::DoDispose ();
@@ -23,6 +23,7 @@
 #include "bp-cla-protocol.h"
 #include "bp-endpoint-id.h"
 #include "bp-routing-protocol.h"
+#include "bp-bundle-store.h"
 #include "ns3/sequence-number.h"
 #include "ns3/object.h"
 #include "ns3/event-id.h"
@@ -213,6 +214,40 @@ public:
    */
   virtual Ptr<Packet> GetBundle (const BpEndpointId &src);
 
+  /**
+   * Get and delete a given bundle from the persistant storage
+   *
+   * This method is called by BpClaProtocol to get the bundle it is asked to 
+   * send, which is not the first stored bundle of its source endpoint id when
+   * earlier bundles are held until their contacts open
+   *
+   * \param id the bundle id
+   *
+   * \return the bundle, or 0 if it is no longer in the persistant storage
+   */
+  virtual Ptr<Packet> GetBundle (const BpBundleId &id);
+
+  /**
+   * Delete a sent bundle from the persistant storage once its custody is 
+   * accepted by the next hop
+   *
+   * \param id the bundle id
+   *
+   * \return returns -1 if the bundle is not in the persistant storage. Otherwise,
+   * it returns 0.
+   */
+  virtual int CustodyAccepted (const BpBundleId &id);
+
+  /**
+   * \return the persistant storage of sent bundles
+   */
+  Ptr<BpBundleStore> GetSendBundleStore () const;
+
+  /**
+   * \return the persistant storage of received bundles
+   */
+  Ptr<BpBundleStore> GetRecvBundleStore () const;
+
   std::vector<uint8_t> GetBlock();
 
   /**
@@ -283,10 +318,34 @@ private:
   void ProcessBundle (Ptr<Packet> bundle);
 
   /**
-   * Retreive bundle from rx buffer
+   * Retreive all the complete bundles from rx buffer
+   *
+   * The length of the bundle at the head of rx buffer is parsed once from
+   * the leading bytes of its primary bundle header and kept until the whole
+   * bundle is received, so that the rx buffer is never copied. The leading
+   * bytes of a BPv7 bundle are read in a window that doubles while its blocks
+   * ahead of the payload go beyond it, up to the MaxBlocksSize attribute.
    */
   void RetreiveBundle ();
 
+  /**
+   * Parse the length of a bundle from the leading bytes of its primary 
+   * bundle header, in either version of the bundle protocol
+   *
+   * \param data the first bytes of the bundle
+   * \param size number of bytes at data
+   * \param length set to the length of the bundle including all the headers,
+   *        or 0 if more bytes are needed
+   * \return false if the bundle is malformed
+   */
+  bool ParseBundleLength (const uint8_t *data, uint32_t size, uint32_t &length);
+
+  /**
+   * Parse the length of a BPv7 bundle from its blocks up to the head of its 
+   * payload, see ParseBundleLength (), and locate its extension blocks
+   */
+  bool ParseBpV7BundleLength (const uint8_t *data, uint32_t size, uint32_t &length);
+
   /**
    * \brief Bundle protocol specific startup code
    *
@@ -309,14 +368,23 @@ private:
   Ptr<BpClaProtocol>  m_cla;   /// convergence layer adapter (CLA)
 
   uint32_t m_bundleSize;       /// bundle size
+  uint32_t m_bundleVersion;    /// version of the bundles sent: 6 for RFC 5050, 7 for RFC 9171
+  uint32_t m_crcType;          /// CRC type of the blocks of BPv7 bundles sent
   std::string m_l4Type;        /// the transport layer type
   std::string m_rtType;        /// the bundle routing protocol type
 
-  std::map<BpEndpointId, std::queue<Ptr<Packet> > > BpSendBundleStore; /// persistant storage of sent bundles: map (source endpoint id, bundle packet queue )
-  std::map<BpEndpointId, std::queue<Ptr<Packet> > > BpRecvBundleStore; /// persistant storage of received bundles: map (destination endpoint id, bundle packet queue )
+  Ptr<BpBundleStore> m_sendBundleStore; /// persistant storage of sent bundles, queued by source endpoint id
+  Ptr<BpBundleStore> m_recvBundleStore; /// persistant storage of received bundles, queued by destination endpoint id
   std::map<BpEndpointId, BpRegisterInfo> BpRegistration; /// persistant storage of registrations: map (local endpoint id, registration information)
 
   Ptr<Packet> m_bpRxBufferPacket; /// a buffer for all packets received from the CLA; bundles are retreived from this buffer
+  std::vector<uint8_t> m_rxHeader; /// leading bytes of the bundle at the head of m_bpRxBufferPacket
+  uint32_t m_rxMaxBlocksSize;      /// max size of the blocks ahead of the payload of a BPv7 bundle received
+  uint32_t m_rxPrimaryHeaderSize;  /// serialized size of the RFC 5050 primary bundle header without dictionary
+  uint32_t m_rxPayloadHeaderSize;  /// serialized size of the RFC 5050 bundle payload header
+  uint32_t m_rxBundleLength;       /// length of the bundle at the head of m_bpRxBufferPacket, 0 if not parsed yet
+  uint32_t m_rxExtensionStart;     /// offset of the extension blocks of the BPv7 bundle at the head of m_bpRxBufferPacket
+  uint32_t m_rxExtensionLength;    /// length of these extension blocks, 0 if there is none
 
   SequenceNumber32 m_seq;         /// the bundle sequence number
 
@@ -0,0 +1,206 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 University of New Brunswick
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Dizhi Zhou <dizhi.zhou@gmail.com>
+ */
+
+#include <stdint.h>
+#include "ns3/log.h"
+#include "cbor.h"
+
+NS_LOG_COMPONENT_DEFINE ("Cbor");
+
+namespace ns3 {
+
+Cbor::Cbor ()
+{ 
+  NS_LOG_FUNCTION (this);
+}
+
+Cbor::~Cbor ()
+{ 
+  NS_LOG_FUNCTION (this);
+}
+
+uint32_t 
+Cbor::GetHeadSize (uint64_t value)
+{ 
+  NS_LOG_FUNCTION (this << " " << value);
+  if (value < 24)
+    return 1;
+  else if (value <= 0xff)
+    return 2;
+  else if (value <= 0xffff)
+    return 3;
+  else if (value <= 0xffffffffULL)
+    return 5;
+  else
+    return 9;
+}
+
+uint32_t 
+Cbor::EncodeHead (MajorType type, uint64_t value, uint8_t *data)
+{ 
+  NS_LOG_FUNCTION (this << " " << type << " " << value);
+  uint32_t len = GetHeadSize (value);
+  uint8_t major = (uint8_t) type << 5;
+
+  // section 3 of RFC 8949: the additional information is the value itself, or 
+  // 24 to 27 for a value in the following 1, 2, 4 or 8 bytes in network order
+  switch (len)
+    {
+    case 1:
+      data[0] = major | (uint8_t) value;
+      return len;
+    case 2:
+      data[0] = major | 24;
+      break;
+    case 3:
+      data[0] = major | 25;
+      break;
+    case 5:
+      data[0] = major | 26;
+      break;
+    default:
+      data[0] = major | 27;
+      break;
+    }
+
+  for (uint32_t k = len - 1; k > 0; k--)
+    {
+      data[k] = value & 0xff;
+      value >>= 8;
+    }
+  return len;
+}
+
+void 
+Cbor::EncodeHead (MajorType type, uint64_t value, Buffer::Iterator &start)
+{ 
+  NS_LOG_FUNCTION (this << " " << type << " " << value);
+  uint8_t data[MAX_HEAD_LENGTH];
+  uint32_t len = EncodeHead (type, value, data);
+  start.Write (data, len);
+}
+
+bool 
+Cbor::DecodeHead (Buffer::Iterator &start, MajorType &type, uint64_t &value)
+{ 
+  NS_LOG_FUNCTION (this);
+  uint8_t initial = start.ReadU8 ();
+  uint8_t info = initial & 0x1f;
+  type = (MajorType) (initial >> 5);
+
+  if (info < 24)
+    {
+      value = info;
+      return true;
+    }
+  else if (info > 27)
+    {
+      // reserved or indefinite length
+      return false;
+    }
+
+  value = 0;
+  for (uint32_t k = 0; k < (1u << (info - 24)); k++)
+    value = (value << 8) | start.ReadU8 ();
+  return true;
+}
+
+bool 
+Cbor::Decode (Buffer::Iterator &start, MajorType type, uint64_t &value)
+{ 
+  NS_LOG_FUNCTION (this << " " << type);
+  MajorType decoded;
+  return DecodeHead (start, decoded, value) && decoded == type;
+}
+
+int32_t 
+Cbor::DecodeHead (const uint8_t *data, uint32_t size, MajorType &type, uint64_t &value)
+{ 
+  NS_LOG_FUNCTION (this << " " << size);
+  if (size == 0)
+    return 0;
+
+  uint8_t info = data[0] & 0x1f;
+  type = (MajorType) (data[0] >> 5);
+
+  if (info < 24)
+    {
+      value = info;
+      return 1;
+    }
+  else if (info > 27)
+    {
+      return -1;
+    }
+
+  uint32_t len = 1 + (1u << (info - 24));
+  if (size < len)
+    return 0;
+
+  value = 0;
+  for (uint32_t k = 1; k < len; k++)
+    value = (value << 8) | data[k];
+  return len;
+}
+
+int32_t 
+Cbor::GetItemSize (const uint8_t *data, uint32_t size)
+{ 
+  NS_LOG_FUNCTION (this << " " << size);
+  uint32_t offset = 0;
+  uint64_t items = 1;  // data items left to skip, including those nested in arrays and maps
+
+  while (items > 0)
+    {
+      MajorType type;
+      uint64_t value;
+      int32_t read = DecodeHead (data + offset, size - offset, type, value);
+      if (read <= 0)
+        return read;
+
+      offset += read;
+      items--;
+
+      switch (type)
+        {
+        case BYTE_STRING:
+        case TEXT_STRING:
+          if (value > size - offset)
+            return 0;
+          offset += value;
+          break;
+        case ARRAY:
+          items += value;
+          break;
+        case MAP:
+          items += 2 * value;
+          break;
+        case TAG:
+          items++;
+          break;
+        default:
+          break;
+        }
+    }
+
+  return offset;
+}
+
+} // namespace ns3
@@ -0,0 +1,140 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 University of New Brunswick
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Dizhi Zhou <dizhi.zhou@gmail.com>
+ */
+#ifndef CBOR_H
+#define CBOR_H
+
+#include <stdint.h>
+#include "ns3/buffer.h"
+
+namespace ns3 {
+
+/**
+ * \brief an implementation class of the concise binary object representation 
+ * based on RFC 8949, limited to what RFC 9171 needs to encode bundles
+ *
+ * Only the heads of the data items are encoded and decoded here: the content 
+ * of strings is written and read by the caller, straight from the Buffer. 
+ * Indefinite length items are not supported, except the array of the blocks 
+ * of a bundle, which starts with INDEFINITE_ARRAY and ends with BREAK.
+ */
+class Cbor
+{
+public:
+  /**
+   * major types, section 3.1 of RFC 8949
+   */
+  typedef enum {
+    UNSIGNED_INTEGER = 0,
+    NEGATIVE_INTEGER = 1,
+    BYTE_STRING = 2,
+    TEXT_STRING = 3,
+    ARRAY = 4,
+    MAP = 5,
+    TAG = 6,
+    SIMPLE = 7
+  } MajorType;
+
+  /**
+   * Constructor
+   */
+  Cbor ();
+
+  /**
+   * Destroy
+   */
+  virtual ~Cbor ();
+
+  /**
+   * \param value the argument of the head
+   * \return the number of bytes of an encoded head
+   */
+  uint32_t GetHeadSize (uint64_t value);
+
+  /**
+   * \brief encode the head of a data item into a byte array
+   *
+   * \param type major type of the data item
+   * \param value the argument of the head: the value of an integer, the length 
+   *        of a string or the number of items of an array
+   * \param data the byte array, with room for at least MAX_HEAD_LENGTH bytes
+   * \return the number of bytes written at data
+   */
+  uint32_t EncodeHead (MajorType type, uint64_t value, uint8_t *data);
+
+  /**
+   * \brief encode the head of a data item into a Buffer
+   *
+   * \param type major type of the data item
+   * \param value the argument of the head
+   * \param start buffer start iterator reference, moved after the head
+   */
+  void EncodeHead (MajorType type, uint64_t value, Buffer::Iterator &start);
+
+  /**
+   * \brief decode the head of a data item from a Buffer
+   *
+   * \param start buffer start iterator reference, moved after the head
+   * \param type set to the major type of the data item
+   * \param value set to the argument of the head
+   * \return false if the head is malformed or indefinite
+   */
+  bool DecodeHead (Buffer::Iterator &start, MajorType &type, uint64_t &value);
+
+  /**
+   * \brief decode the head of a data item of an expected major type from a Buffer
+   *
+   * \param start buffer start iterator reference, moved after the head
+   * \param type the expected major type
+   * \param value set to the argument of the head
+   * \return false if the head is malformed or of another major type
+   */
+  bool Decode (Buffer::Iterator &start, MajorType type, uint64_t &value);
+
+  /**
+   * \brief decode the head of a data item from a byte array
+   *
+   * \param data the first byte of the head
+   * \param size number of bytes available at data
+   * \param type set to the major type of the data item
+   * \param value set to the argument of the head
+   * \return the number of bytes of the head, 0 if the head does not end 
+   *         within size bytes, or -1 if it is malformed or indefinite
+   */
+  int32_t DecodeHead (const uint8_t *data, uint32_t size, MajorType &type, uint64_t &value);
+
+  /**
+   * \brief get the size of a complete data item in a byte array, including the 
+   * content of strings and the items of arrays and maps
+   *
+   * \param data the first byte of the data item
+   * \param size number of bytes available at data
+   * \return the number of bytes of the data item, 0 if it does not end within 
+   *         size bytes, or -1 if it is malformed or indefinite
+   */
+  int32_t GetItemSize (const uint8_t *data, uint32_t size);
+
+  static const uint8_t INDEFINITE_ARRAY = 0x9f;  /// head of an indefinite length array
+  static const uint8_t BREAK = 0xff;             /// end of an indefinite length array
+  static const uint32_t MAX_HEAD_LENGTH = 9;     /// max number of bytes of a head
+};
+
+} // namespace ns3
+
+#endif /* CBOR_H */
@@ -20,7 +20,6 @@
  */
 
 
-#include <algorithm>
 #include <stdint.h>
 #include "ns3/log.h"
 #include "sdnv.h"
@@ -43,28 +42,44 @@ std::vector<uint8_t>
 Sdnv::Encode (uint64_t val)
 { 
   NS_LOG_FUNCTION (this << " " << val);
-  std::vector<uint8_t> data;
+  uint8_t data[MAX_LENGTH];
+  uint32_t len = Encode (val, data);
+  return std::vector<uint8_t> (data, data + len);
+}
+
+uint32_t 
+Sdnv::Encode (uint64_t val, uint8_t *data)
+{ 
+  NS_LOG_FUNCTION (this << " " << val);
+  uint32_t len = GetEncodedSize (val);
 
-  if (val == 0)
+  // the last byte holds the lowest 7 bits, without the continuation bit
+  data[len - 1] = val & 0x7F;
+  for (uint32_t k = len - 1; k > 0; k--)
     {
-      data.push_back (0);
-      return data;
+      val >>= 7;
+      data[k - 1] = (val & 0x7F) | 0x80;
     }
+  return len;
+}
 
-  uint8_t encoded;
+void 
+Sdnv::Encode (uint64_t val, Buffer::Iterator &start)
+{ 
+  NS_LOG_FUNCTION (this << " " << val);
+  uint8_t data[MAX_LENGTH];
+  uint32_t len = Encode (val, data);
+  start.Write (data, len);
+}
 
-  encoded = val & 0x7F;
-  val >>= 7;
-  data.push_back (encoded);
-  while (val)
-  {
-	  encoded = val & 0x7F;
-      val >>= 7;
-      encoded |= 0x80;
-      data.push_back (encoded);
-  }
-  std::reverse (data.begin (), data.end ());
-  return data;
+uint32_t 
+Sdnv::GetEncodedSize (uint64_t val)
+{ 
+  NS_LOG_FUNCTION (this << " " << val);
+  uint32_t len = 1;
+  while (val >>= 7)
+    len++;
+  return len;
 }
 
 uint64_t 
@@ -89,18 +104,36 @@ uint64_t
 Sdnv::Decode (Buffer::Iterator &start)
 { 
   NS_LOG_FUNCTION (this);
-  std::vector<uint8_t> vec;
+  uint64_t decoded = 0;
 
   // check the last byte of a variable in the buffer
+  uint8_t val;
   do {
-    uint8_t val = start.ReadU8 ();
-    vec.push_back (val);
+    val = start.ReadU8 ();
+    decoded <<= 7;
+    decoded += val & 0x7F;
+  } while (!IsLast (val));
 
-    if (IsLast (val))
-      break;
-  } while (1);
+  return decoded;
+}
 
-  return Decode (vec);
+uint64_t 
+Sdnv::Decode (const uint8_t *data, uint32_t size, uint32_t &read)
+{ 
+  NS_LOG_FUNCTION (this << " " << size);
+  uint64_t decoded = 0;
+  for (uint32_t k = 0; k < size; k++)
+    {
+      decoded <<= 7;
+      decoded += data[k] & 0x7F;
+      if ((data[k] & 0x80) == 0)
+        {
+          read = k + 1;
+          return decoded;
+        }
+    }
+  read = 0;
+  return decoded;
 }
 
 bool 
@@ -53,6 +53,29 @@ public:
    */
   std::vector<uint8_t> Encode (uint64_t val);
 
+  /**
+   * \brief SDNV encoding algorithm into a byte array
+   *
+   * \param val value need to be encoded
+   * \param data the byte array, with room for at least MAX_LENGTH bytes
+   * \return the number of bytes written at data
+   */
+  uint32_t Encode (uint64_t val, uint8_t *data);
+
+  /**
+   * \brief SDNV encoding algorithm into a Buffer
+   *
+   * \param val value need to be encoded
+   * \param start buffer start iterator reference, moved after the encoded integer
+   */
+  void Encode (uint64_t val, Buffer::Iterator &start);
+
+  /**
+   * \param val value need to be encoded
+   * \return the number of bytes of the encoded integer
+   */
+  uint32_t GetEncodedSize (uint64_t val);
+
   /**
    * \brief SDNV decoding algorithm for an integer
    *
@@ -67,8 +90,7 @@ public:
   /**
    * \brief SDNV decoding algorithm for a Buffer
    *
-   * This method read an integer from the Buffer and decodes it by 
-   * Decode (std::vector<uint8_t val>)
+   * This method reads an integer from the Buffer and decodes it in place
    *
    * \param start buffer start iterator reference
    * \return uint64_t decoded integer; It is user's responsibility to 
@@ -76,6 +98,21 @@ public:
    */
   uint64_t Decode (Buffer::Iterator &start);
 
+  /**
+   * \brief SDNV decoding algorithm for a byte array
+   *
+   * This method decodes an integer in place, without copying its bytes
+   * into a vector. It is used to parse bundle headers that have not been
+   * completely received yet.
+   *
+   * \param data the first byte of the encoded integer
+   * \param size number of bytes available at data
+   * \param read set to the number of bytes of the encoded integer, or 0 if
+   *        the integer does not end within size bytes
+   * \return uint64_t decoded integer
+   */
+  uint64_t Decode (const uint8_t *data, uint32_t size, uint32_t &read);
+
   /**
    * \brief is this the bolder of an encoded integer?
    *
@@ -83,6 +120,11 @@ public:
    * \return return true if it is the bolder
    */
   bool IsLast (uint8_t &val);
+
+  /**
+   * the max number of bytes of an encoded 64 bits integer
+   */
+  static const uint32_t MAX_LENGTH = 10;
 };
 
 } // namespace ns3
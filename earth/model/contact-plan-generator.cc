@@ -0,0 +1,703 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 INESC TEC
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "contact-plan-generator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <unistd.h>
+#include <utility>
+
+#include "ns3/assert.h"
+#include "ns3/double.h"
+#include "ns3/log.h"
+#include "ns3/system-thread.h"
+#include "ns3/uinteger.h"
+#include "ns3/vector-extensions.h"
+#include "ns3/visibility-index.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("ContactPlanGenerator");
+
+NS_OBJECT_ENSURE_REGISTERED (ContactPlanGenerator);
+
+namespace {
+
+/// speed of light (m/s)
+const double SpeedOfLight = 299792458.0;
+/// Earth's equatorial radius (m)
+const double EarthRadius = 6378137.0;
+
+/**
+ * @brief Get the Julian date of a POSIX time.
+ * @param t the POSIX time (ms).
+ * @return the Julian date.
+ */
+JulianDate
+FromPosixMilliseconds (uint64_t t)
+{
+  return JulianDate (
+    static_cast<uint32_t> (t/JulianDate::DayToMs),
+    static_cast<uint32_t> (t%JulianDate::DayToMs)
+  );
+}
+
+/**
+ * @brief Order contacts by start time and node indexes.
+ * @param a the first contact.
+ * @param b the second contact.
+ * @return a boolean indicating whether a comes before b.
+ */
+bool
+CompareContacts (const ContactPlanGenerator::Contact &a,
+                 const ContactPlanGenerator::Contact &b)
+{
+  if (a.start != b.start)
+    return a.start < b.start;
+
+  if (a.from != b.from)
+    return a.from < b.from;
+
+  return a.to < b.to;
+}
+
+}
+
+/**
+ * @brief Finds the contact windows within a range of samples.
+ *
+ * Each worker keeps its own copy of the SGP4/SDP4 records, as SGP4/SDP4
+ * updates them, and computes frame transformations anew rather than through
+ * the (process-wide) FrameTransform cache.
+ */
+class ContactPlanGenerator::Worker {
+public:
+  /// part of a contact window found by a worker
+  struct Segment {
+    uint64_t key;                                 //!< node indexes.
+    uint64_t start;                               //!< start (POSIX ms).
+    uint64_t end;                                 //!< end (POSIX ms).
+    double minRange;                              //!< smallest range (m).
+    double maxRange;                              //!< largest range (m).
+    bool continued;                               //!< open at first sample.
+    bool open;                                    //!< open at last sample.
+  };
+
+  /**
+   * @brief Constructor.
+   * @param gen the generator.
+   * @param times the sample times (POSIX ms).
+   * @param first the first sample of the worker.
+   * @param last the last sample of the worker.
+   * @param tolerance the bisection tolerance (ms).
+   */
+  Worker (const ContactPlanGenerator *gen, const std::vector<uint64_t> &times,
+          uint32_t first, uint32_t last, uint64_t tolerance);
+
+  /**
+   * @brief Find the contact windows of the worker's samples.
+   */
+  void Run (void);
+
+  std::vector<Segment> segments;                  //!< windows found.
+
+private:
+  /// pairs of nodes in contact (node indexes and range)
+  typedef std::vector<std::pair<uint64_t, double> > ContactList;
+
+  /**
+   * @brief Find the pairs of nodes in contact at a sample.
+   * @param k the sample.
+   * @param contacts the pairs in contact, sorted by node indexes.
+   */
+  void Sample (uint32_t k, ContactList &contacts);
+
+  /**
+   * @brief Compute the positions of two nodes.
+   * @param i the first node.
+   * @param j the second node.
+   * @param t When (POSIX ms).
+   * @param pi the position of the first node.
+   * @param pj the position of the second node.
+   */
+  void Evaluate (uint32_t i, uint32_t j, uint64_t t,
+                 Vector3D &pi, Vector3D &pj);
+
+  /**
+   * @brief Find when the visibility of two nodes changes by bisection.
+   * @param i the first node.
+   * @param j the second node.
+   * @param lo the time before the change (POSIX ms).
+   * @param hi the time after the change (POSIX ms).
+   * @param up whether the nodes are in contact after the change.
+   * @param range the range at the returned time.
+   * @return the time closest to the change at which the nodes are in contact.
+   */
+  uint64_t Refine (uint32_t i, uint32_t j, uint64_t lo, uint64_t hi, bool up,
+                   double &range);
+
+  const ContactPlanGenerator *m_gen;              //!< generator.
+  const std::vector<uint64_t> *m_times;           //!< sample times.
+  uint32_t m_first;                               //!< first sample.
+  uint32_t m_last;                                //!< last sample.
+  uint64_t m_tolerance;                           //!< bisection tolerance.
+  std::vector<elsetrec> m_records;                //!< SGP4/SDP4 records.
+  std::vector<Vector3D> m_positions;              //!< node positions.
+  VisibilityIndex m_index;                        //!< node position index.
+  std::vector<uint32_t> m_near;                   //!< nodes within range.
+};
+
+ContactPlanGenerator::Worker::Worker (
+  const ContactPlanGenerator *gen, const std::vector<uint64_t> &times,
+  uint32_t first, uint32_t last, uint64_t tolerance
+) :
+  m_gen (gen), m_times (&times), m_first (first), m_last (last),
+  m_tolerance (tolerance), m_positions (gen->m_nodes.size ()),
+  m_index (gen->m_maxRange/2)
+{
+  for (uint32_t i = 0; i < gen->m_nodes.size (); ++i)
+    m_records.push_back (gen->m_nodes[i].record);
+}
+
+void
+ContactPlanGenerator::Worker::Run (void)
+{
+  const std::vector<uint64_t> &times = *m_times;
+  std::map<uint64_t, uint32_t> open;
+  ContactList prev, cur;
+
+  Sample (m_first, prev);
+
+  for (uint32_t n = 0; n < prev.size (); ++n)
+    {
+      const Segment s = {
+        prev[n].first, times[m_first], times[m_first],
+        prev[n].second, prev[n].second, m_first > 0, false
+      };
+
+      open[s.key] = segments.size ();
+      segments.push_back (s);
+    }
+
+  for (uint32_t k = m_first + 1; k <= m_last; ++k)
+    {
+      Sample (k, cur);
+
+      // both lists are sorted by node indexes
+      uint32_t a = 0, b = 0;
+
+      while (a < prev.size () || b < cur.size ())
+        {
+          const bool fromPrev = (
+            b == cur.size () ||
+            (a < prev.size () && prev[a].first < cur[b].first)
+          );
+          const uint64_t key = (fromPrev ? prev[a].first : cur[b].first);
+          const uint32_t i = key >> 32, j = key & 0xffffffff;
+          const bool before = (a < prev.size () && prev[a].first == key);
+          const bool after = (b < cur.size () && cur[b].first == key);
+          double range;
+
+          if (before && after)
+            {
+              Segment &s = segments[open[key]];
+
+              s.end = times[k];
+              s.minRange = std::min (s.minRange, cur[b].second);
+              s.maxRange = std::max (s.maxRange, cur[b].second);
+            }
+          else if (after)
+            {
+              const uint64_t t = Refine (
+                i, j, times[k-1], times[k], true, range
+              );
+              const Segment s = {
+                key, t, times[k], std::min (range, cur[b].second),
+                std::max (range, cur[b].second), false, false
+              };
+
+              open[key] = segments.size ();
+              segments.push_back (s);
+            }
+          else
+            {
+              const uint64_t t = Refine (
+                i, j, times[k-1], times[k], false, range
+              );
+              std::map<uint64_t, uint32_t>::iterator it = open.find (key);
+              Segment &s = segments[it->second];
+
+              s.end = t;
+              s.minRange = std::min (s.minRange, range);
+              s.maxRange = std::max (s.maxRange, range);
+              open.erase (it);
+            }
+
+          a += before;
+          b += after;
+        }
+
+      prev.swap (cur);
+    }
+
+  // windows still open continue into the next worker's samples, if any
+  const bool more = (m_last + 1 < times.size ());
+
+  for (std::map<uint64_t, uint32_t>::const_iterator it = open.begin ();
+       it != open.end (); ++it)
+    segments[it->second].open = more;
+}
+
+void
+ContactPlanGenerator::Worker::Sample (uint32_t k, ContactList &contacts)
+{
+  const uint64_t t = (*m_times)[k];
+  const FrameTransform ft = FrameTransform::Compute (FromPosixMilliseconds (t));
+  const uint32_t n = m_positions.size ();
+
+  for (uint32_t i = 0; i < n; ++i)
+    m_positions[i] = ComputePosition (m_gen->m_nodes[i], m_records[i], t, ft);
+
+  m_index.Build (m_positions);
+  contacts.clear ();
+
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      m_index.FindInRange (m_positions[i], m_gen->m_maxRange, m_near);
+
+      for (uint32_t m = 0; m < m_near.size (); ++m)
+        {
+          const uint32_t j = m_near[m];
+
+          const Vector3D &pi = m_positions[i], &pj = m_positions[j];
+
+          if (j > i && m_gen->IsInContact (i, pi, j, pj))
+            contacts.push_back (std::make_pair (
+              (static_cast<uint64_t> (i) << 32) | j, CalculateDistance (pi, pj)
+            ));
+        }
+    }
+}
+
+void
+ContactPlanGenerator::Worker::Evaluate (uint32_t i, uint32_t j, uint64_t t,
+                                        Vector3D &pi, Vector3D &pj)
+{
+  const FrameTransform ft = FrameTransform::Compute (FromPosixMilliseconds (t));
+
+  pi = ComputePosition (m_gen->m_nodes[i], m_records[i], t, ft);
+  pj = ComputePosition (m_gen->m_nodes[j], m_records[j], t, ft);
+}
+
+uint64_t
+ContactPlanGenerator::Worker::Refine (uint32_t i, uint32_t j,
+                                      uint64_t lo, uint64_t hi, bool up,
+                                      double &range)
+{
+  Vector3D pi, pj;
+
+  while (hi - lo > m_tolerance)
+    {
+      const uint64_t mid = lo + (hi - lo)/2;
+
+      Evaluate (i, j, mid, pi, pj);
+
+      if (m_gen->IsInContact (i, pi, j, pj) == up)
+        hi = mid;
+      else
+        lo = mid;
+    }
+
+  const uint64_t t = (up ? hi : lo);
+
+  Evaluate (i, j, t, pi, pj);
+  range = CalculateDistance (pi, pj);
+
+  return t;
+}
+
+TypeId
+ContactPlanGenerator::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ContactPlanGenerator")
+    .SetParent<Object> ()
+    .SetGroupName ("Earth")
+    .AddConstructor<ContactPlanGenerator> ()
+    .AddAttribute ("Step",
+                   "Time between visibility samples.",
+                   TimeValue (Seconds (60)),
+                   MakeTimeAccessor (&ContactPlanGenerator::m_step),
+                   MakeTimeChecker (MilliSeconds (1)))
+    .AddAttribute ("Tolerance",
+                   "Precision of the start and end of contact windows.",
+                   TimeValue (Seconds (1)),
+                   MakeTimeAccessor (&ContactPlanGenerator::m_tolerance),
+                   MakeTimeChecker (MilliSeconds (1)))
+    .AddAttribute ("Threads",
+                   "Number of worker threads (0 for one per processor).",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&ContactPlanGenerator::m_threads),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("MaxRange",
+                   "Largest range of any contact (m).",
+                   DoubleValue (10000e3),
+                   MakeDoubleAccessor (&ContactPlanGenerator::m_maxRange),
+                   MakeDoubleChecker<double> (1))
+    .AddAttribute ("MaxIslRange",
+                   "Largest range of inter-satellite contacts (m).",
+                   DoubleValue (5000e3),
+                   MakeDoubleAccessor (&ContactPlanGenerator::m_maxIslRange),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("GrazingAltitude",
+                   "Smallest altitude of inter-satellite lines of sight (m).",
+                   DoubleValue (80e3),
+                   MakeDoubleAccessor (
+                     &ContactPlanGenerator::m_grazingAltitude
+                   ),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("MinElevation",
+                   "Elevation mask of ground stations (degrees).",
+                   DoubleValue (10),
+                   MakeDoubleAccessor (&ContactPlanGenerator::m_minElevation),
+                   MakeDoubleChecker<double> (-90, 90))
+    .AddAttribute ("DataRate",
+                   "Transmission rate of contacts in ION contact plans "
+                   "(bytes/s).",
+                   UintegerValue (125000),
+                   MakeUintegerAccessor (&ContactPlanGenerator::m_dataRate),
+                   MakeUintegerChecker<uint64_t> ());
+
+  return tid;
+}
+
+ContactPlanGenerator::ContactPlanGenerator (void) :
+  m_threads (0), m_maxRange (10000e3), m_maxIslRange (5000e3),
+  m_grazingAltitude (80e3), m_minElevation (10), m_dataRate (125000)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+ContactPlanGenerator::~ContactPlanGenerator (void)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+ContactPlanGenerator::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_predicate.Nullify ();
+  m_nodes.clear ();
+  m_contacts.clear ();
+
+  Object::DoDispose ();
+}
+
+uint32_t
+ContactPlanGenerator::AddSatellite (Ptr<Satellite> sat, uint32_t nodeNumber)
+{
+  NS_LOG_FUNCTION (this << sat << nodeNumber);
+  NS_ASSERT_MSG (sat && sat->IsInitialized (), "Satellite is not initialized!");
+
+  Node node = Node ();
+
+  node.satellite = true;
+  node.number = (nodeNumber ? nodeNumber : m_nodes.size () + 1);
+  node.record = sat->m_sgp4_record;
+  node.epoch = sat->GetTleEpoch ().GetPosixMilliseconds ();
+
+  m_nodes.push_back (node);
+
+  return m_nodes.size () - 1;
+}
+
+uint32_t
+ContactPlanGenerator::AddGroundStation (Ptr<Earth> station, uint32_t nodeNumber)
+{
+  NS_LOG_FUNCTION (this << station << nodeNumber);
+  NS_ASSERT_MSG (station, "Null ground station!");
+
+  Node node = Node ();
+
+  node.satellite = false;
+  node.number = (nodeNumber ? nodeNumber : m_nodes.size () + 1);
+  node.position = station->m_position;
+
+  m_nodes.push_back (node);
+
+  return m_nodes.size () - 1;
+}
+
+uint32_t
+ContactPlanGenerator::GetNNodes (void) const
+{
+  return m_nodes.size ();
+}
+
+bool
+ContactPlanGenerator::IsSatellite (uint32_t i) const
+{
+  NS_ASSERT (i < m_nodes.size ());
+
+  return m_nodes[i].satellite;
+}
+
+uint32_t
+ContactPlanGenerator::GetNodeNumber (uint32_t i) const
+{
+  NS_ASSERT (i < m_nodes.size ());
+
+  return m_nodes[i].number;
+}
+
+Vector3D
+ContactPlanGenerator::GetPosition (uint32_t i, const JulianDate &t) const
+{
+  NS_ASSERT (i < m_nodes.size ());
+
+  elsetrec record = m_nodes[i].record;
+
+  return ComputePosition (
+    m_nodes[i], record, t.GetPosixMilliseconds (), FrameTransform::Compute (t)
+  );
+}
+
+void
+ContactPlanGenerator::SetVisibilityPredicate (VisibilityPredicate predicate)
+{
+  m_predicate = predicate;
+}
+
+bool
+ContactPlanGenerator::IsVisible (uint32_t i, const Vector3D &pi,
+                                 uint32_t j, const Vector3D &pj) const
+{
+  if (!m_predicate.IsNull ())
+    return m_predicate (i, pi, j, pj);
+
+  const Node &a = m_nodes[i], &b = m_nodes[j];
+
+  if (!a.satellite && !b.satellite)
+    return false;
+
+  if (a.satellite && b.satellite)
+    {
+      const Vector3D d = pj - pi;
+      const double d2 = MagnitudeSquared (d);
+
+      if (d2 > m_maxIslRange*m_maxIslRange)
+        return false;
+
+      // point of the line of sight closest to the Earth's center
+      const double s = (d2 > 0 ? -DotProduct (pi, d)/d2 : 0);
+      const Vector3D c = pi + std::min (std::max (s, 0.0), 1.0)*d;
+
+      return (Magnitude (c) >= EarthRadius + m_grazingAltitude);
+    }
+
+  const double mask = m_minElevation*M_PI/180;
+
+  return (a.satellite ? VisibilityIndex::IsVisible (pj, mask, pi) :
+                        VisibilityIndex::IsVisible (pi, mask, pj));
+}
+
+bool
+ContactPlanGenerator::IsInContact (uint32_t i, const Vector3D &pi,
+                                   uint32_t j, const Vector3D &pj) const
+{
+  return (CalculateDistance (pi, pj) <= m_maxRange && IsVisible (i, pi, j, pj));
+}
+
+uint32_t
+ContactPlanGenerator::Generate (const JulianDate &start, const JulianDate &stop)
+{
+  NS_LOG_FUNCTION (this << start << stop);
+  NS_ASSERT_MSG (start <= stop, "Interval must not be negative!");
+
+  const uint64_t t0 = start.GetPosixMilliseconds ();
+  const uint64_t t1 = stop.GetPosixMilliseconds ();
+  const uint64_t step = m_step.GetMilliSeconds ();
+  const uint64_t tolerance = std::max<int64_t> (
+    m_tolerance.GetMilliSeconds (), 1
+  );
+  std::vector<uint64_t> times;
+
+  for (uint64_t t = t0; t < t1; t += step)
+    times.push_back (t);
+
+  times.push_back (t1);
+
+  m_start = start;
+  m_stop = stop;
+  m_contacts.clear ();
+
+  // split the intervals between samples evenly among the workers
+  const uint32_t intervals = times.size () - 1;
+  uint32_t threads = m_threads;
+
+  if (threads == 0)
+    threads = std::max<long> (sysconf (_SC_NPROCESSORS_ONLN), 1);
+
+  threads = std::max<uint32_t> (std::min (threads, intervals), 1);
+
+  std::vector<Worker> workers;
+
+  workers.reserve (threads);
+  for (uint32_t c = 0; c < threads; ++c)
+    workers.push_back (Worker (
+      this, times, static_cast<uint64_t> (intervals)*c/threads,
+      static_cast<uint64_t> (intervals)*(c + 1)/threads, tolerance
+    ));
+
+  NS_LOG_INFO ("Sampling " << m_nodes.size () << " nodes " << times.size ()
+               << " times on " << threads << " threads");
+
+  if (threads == 1)
+    workers[0].Run ();
+  else
+    {
+      std::vector<Ptr<SystemThread> > running;
+
+      for (uint32_t c = 0; c < threads; ++c)
+        {
+          running.push_back (
+            Create<SystemThread> (MakeCallback (&Worker::Run, &workers[c]))
+          );
+          running.back ()->Start ();
+        }
+
+      for (uint32_t c = 0; c < threads; ++c)
+        running[c]->Join ();
+    }
+
+  // join the windows spanning several workers
+  std::map<uint64_t, uint32_t> pending;
+
+  for (uint32_t c = 0; c < threads; ++c)
+    for (uint32_t n = 0; n < workers[c].segments.size (); ++n)
+      {
+        const Worker::Segment &s = workers[c].segments[n];
+
+        if (s.continued)
+          {
+            std::map<uint64_t, uint32_t>::iterator it = pending.find (s.key);
+
+            NS_ASSERT_MSG (it != pending.end (), "Unmatched contact segment!");
+
+            Contact &contact = m_contacts[it->second];
+
+            contact.end = FromPosixMilliseconds (s.end);
+            contact.minRange = std::min (contact.minRange, s.minRange);
+            contact.maxRange = std::max (contact.maxRange, s.maxRange);
+
+            if (!s.open)
+              pending.erase (it);
+
+            continue;
+          }
+
+        Contact contact;
+
+        contact.from = s.key >> 32;
+        contact.to = s.key & 0xffffffff;
+        contact.start = FromPosixMilliseconds (s.start);
+        contact.end = FromPosixMilliseconds (s.end);
+        contact.minRange = s.minRange;
+        contact.maxRange = s.maxRange;
+
+        if (s.open)
+          pending[s.key] = m_contacts.size ();
+
+        m_contacts.push_back (contact);
+      }
+
+  for (uint32_t n = 0; n < m_contacts.size (); ++n)
+    m_contacts[n].owlt = Seconds (m_contacts[n].maxRange/SpeedOfLight);
+
+  std::sort (m_contacts.begin (), m_contacts.end (), CompareContacts);
+
+  NS_LOG_INFO ("Found " << m_contacts.size () << " contacts");
+
+  return m_contacts.size ();
+}
+
+const std::vector<ContactPlanGenerator::Contact>&
+ContactPlanGenerator::GetContacts (void) const
+{
+  return m_contacts;
+}
+
+bool
+ContactPlanGenerator::WriteIonContactPlan (const std::string &filename) const
+{
+  NS_LOG_FUNCTION (this << filename);
+
+  std::ofstream f (filename.c_str ());
+
+  if (!f.is_open ())
+    {
+      NS_LOG_WARN ("Unable to open " << filename << " for writing");
+      return false;
+    }
+
+  f << "# contact plan from " << m_start << " to " << m_stop << std::endl;
+
+  for (uint32_t n = 0; n < m_contacts.size (); ++n)
+    {
+      const Contact &c = m_contacts[n];
+      const uint32_t from = m_nodes[c.from].number, to = m_nodes[c.to].number;
+      const int64_t start = floor ((c.start - m_start).GetSeconds ());
+      const int64_t end = ceil ((c.end - m_start).GetSeconds ());
+      const int64_t owlt = ceil (c.owlt.GetSeconds ());
+
+      f << "a contact +" << start << " +" << end << " " << from << " " << to
+        << " " << m_dataRate << std::endl;
+      f << "a contact +" << start << " +" << end << " " << to << " " << from
+        << " " << m_dataRate << std::endl;
+      f << "a range +" << start << " +" << end << " " << from << " " << to
+        << " " << owlt << std::endl;
+    }
+
+  return f.good ();
+}
+
+Vector3D
+ContactPlanGenerator::ComputePosition (const Node &node, elsetrec &record,
+                                       uint64_t t, const FrameTransform &ft)
+{
+  if (!node.satellite)
+    return 1000*ft.rTemeTorItrf (node.position);
+
+  const double tsince = (static_cast<double> (t) - node.epoch)/60000.0;
+  double r[3], v[3];
+
+  sgp4 (Satellite::WGeoSys, record, tsince, r, v);
+
+  // reported at the origin on failure, as Satellite does
+  if (record.error != 0)
+    return Vector3D ();
+
+  return 1000*ft.rTemeTorItrf (Vector3D (r[0], r[1], r[2]));
+}
+
+}
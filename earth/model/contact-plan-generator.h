@@ -0,0 +1,249 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 INESC TEC
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef CONTACT_PLAN_GENERATOR_H
+#define CONTACT_PLAN_GENERATOR_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "ns3/callback.h"
+#include "ns3/frame-transform.h"
+#include "ns3/julian-date.h"
+#include "ns3/nstime.h"
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "ns3/satellite.h"
+#include "ns3/sgp4unit.h"
+#include "ns3/type-id.h"
+#include "ns3/vector.h"
+
+#include "earth.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup earth
+ * @brief Computes the contact windows of a set of satellites and ground
+ *        stations over a time interval.
+ *
+ * Delay tolerant networking and routing studies need to know in advance when
+ * each pair of nodes can communicate. Stepping the simulation to find out is
+ * far too slow for scenarios spanning days or weeks, so this class samples
+ * the node positions itself, at a fixed Step, on several threads, each taking
+ * a contiguous part of the time interval. At each sample, the pairs of nodes
+ * within MaxRange are found with a VisibilityIndex and tested by the
+ * visibility predicate, and whenever the visibility of a pair changes
+ * between two samples the time of the change is refined by bisection down to
+ * Tolerance. Visibility changes lasting less than a step may thus be missed.
+ *
+ * By default, two satellites see each other if they are within MaxIslRange
+ * and the line between them clears the Earth by GrazingAltitude, a satellite
+ * and a ground station if the satellite is at least MinElevation above the
+ * station's horizon, and ground stations never see each other. A custom
+ * predicate can be set instead; it is called from several threads at once
+ * and must thus not modify shared state.
+ *
+ * The result is a table of contacts, one per window and pair of nodes,
+ * sorted by start time, and can be written as an ION contact plan. Node
+ * states are copied when nodes are added, so that worker threads do not
+ * touch the Satellite and Earth objects (nor their caches).
+ */
+class ContactPlanGenerator : public Object {
+public:
+  /// contact window between two nodes
+  struct Contact {
+    uint32_t from;                                //!< first node index.
+    uint32_t to;                                  //!< second node index.
+    JulianDate start;                             //!< start of the window.
+    JulianDate end;                               //!< end of the window.
+    double minRange;                              //!< smallest range (m).
+    double maxRange;                              //!< largest range (m).
+    Time owlt;                                    //!< light time at maxRange.
+  };
+
+  /**
+   * Visibility predicate, called with the index and ITRF position (m) of two
+   * nodes, the first index being the smallest.
+   */
+  typedef Callback<bool, uint32_t, const Vector3D &,
+                   uint32_t, const Vector3D &> VisibilityPredicate;
+
+  /**
+   * @brief Get the type ID.
+   * @return the object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * @brief Default constructor.
+   */
+  ContactPlanGenerator (void);
+
+  /**
+   * @brief Destructor.
+   */
+  virtual ~ContactPlanGenerator (void);
+
+  /**
+   * @brief Add a satellite.
+   * @param sat the (initialized) satellite.
+   * @param nodeNumber the node number in the contact plan file (or 0 to use
+   *        the node index plus one).
+   * @return the node index.
+   */
+  uint32_t AddSatellite (Ptr<Satellite> sat, uint32_t nodeNumber = 0);
+
+  /**
+   * @brief Add a ground station.
+   * @param station the ground station.
+   * @param nodeNumber the node number in the contact plan file (or 0 to use
+   *        the node index plus one).
+   * @return the node index.
+   */
+  uint32_t AddGroundStation (Ptr<Earth> station, uint32_t nodeNumber = 0);
+
+  /**
+   * @brief Get the number of nodes.
+   * @return the number of nodes.
+   */
+  uint32_t GetNNodes (void) const;
+
+  /**
+   * @brief Check if a node is a satellite.
+   * @param i the node index.
+   * @return a boolean indicating whether node i is a satellite.
+   */
+  bool IsSatellite (uint32_t i) const;
+
+  /**
+   * @brief Get the contact plan node number of a node.
+   * @param i the node index.
+   * @return the node number.
+   */
+  uint32_t GetNodeNumber (uint32_t i) const;
+
+  /**
+   * @brief Get the position of a node, as the generator computes it.
+   * @param i the node index.
+   * @param t When.
+   * @return the node's position, in meters, on ITRF coordinate frame.
+   */
+  Vector3D GetPosition (uint32_t i, const JulianDate &t) const;
+
+  /**
+   * @brief Set a custom visibility predicate.
+   * @param predicate the predicate, or a null callback to use the default one.
+   */
+  void SetVisibilityPredicate (VisibilityPredicate predicate);
+
+  /**
+   * @brief Check if two nodes see each other.
+   * @param i the index of the first node.
+   * @param pi the position of the first node (m, ITRF).
+   * @param j the index of the second node.
+   * @param pj the position of the second node (m, ITRF).
+   * @return a boolean indicating whether the nodes are in contact.
+   */
+  bool IsVisible (uint32_t i, const Vector3D &pi,
+                  uint32_t j, const Vector3D &pj) const;
+
+  /**
+   * @brief Compute the contact windows within a time interval.
+   * @param start the start of the interval.
+   * @param stop the end of the interval.
+   * @return the number of contacts.
+   */
+  uint32_t Generate (const JulianDate &start, const JulianDate &stop);
+
+  /**
+   * @brief Get the contacts found by the last call to Generate.
+   * @return the contacts, sorted by start time and node indexes.
+   */
+  const std::vector<Contact>& GetContacts (void) const;
+
+  /**
+   * @brief Write the contacts as an ION contact plan.
+   *
+   * Each contact yields a contact command in each direction (at DataRate) and
+   * a range command, with times in seconds relative to the start of the
+   * interval given to Generate. Contacts are widened to whole seconds, and
+   * light times are rounded up.
+   *
+   * @param filename the name of the file.
+   * @return a boolean indicating whether the file was written.
+   */
+  bool WriteIonContactPlan (const std::string &filename) const;
+
+private:
+  virtual void DoDispose (void);
+
+  class Worker;
+  friend class Worker;
+
+  /// node state, copied when the node is added
+  struct Node {
+    bool satellite;                               //!< satellite or ground.
+    uint32_t number;                              //!< contact plan number.
+    elsetrec record;                              //!< SGP4/SDP4 record.
+    uint64_t epoch;                               //!< TLE epoch (POSIX ms).
+    Vector3D position;                            //!< ground (km, TEME).
+  };
+
+  /**
+   * @brief Compute the position of a node.
+   * @param node the node.
+   * @param record the node's SGP4/SDP4 record (modified by SGP4/SDP4).
+   * @param t When (POSIX ms).
+   * @param ft the frame transformation at t.
+   * @return the node's position (m, ITRF).
+   */
+  static Vector3D ComputePosition (const Node &node, elsetrec &record,
+                                   uint64_t t, const FrameTransform &ft);
+
+  /**
+   * @brief Check if two nodes are in contact, including the MaxRange limit.
+   * @param i the index of the first node.
+   * @param pi the position of the first node (m, ITRF).
+   * @param j the index of the second node.
+   * @param pj the position of the second node (m, ITRF).
+   * @return a boolean indicating whether the nodes are in contact.
+   */
+  bool IsInContact (uint32_t i, const Vector3D &pi,
+                    uint32_t j, const Vector3D &pj) const;
+
+  Time m_step;                                    //!< sampling step.
+  Time m_tolerance;                               //!< bisection tolerance.
+  uint32_t m_threads;                             //!< worker threads.
+  double m_maxRange;                              //!< largest range (m).
+  double m_maxIslRange;                           //!< largest ISL range (m).
+  double m_grazingAltitude;                       //!< ISL clearance (m).
+  double m_minElevation;                          //!< elevation mask (deg).
+  uint64_t m_dataRate;                            //!< ION rate (bytes/s).
+  VisibilityPredicate m_predicate;                //!< custom predicate.
+  std::vector<Node> m_nodes;                      //!< nodes.
+  JulianDate m_start;                             //!< start of last run.
+  JulianDate m_stop;                              //!< end of last run.
+  std::vector<Contact> m_contacts;                //!< last run's contacts.
+};
+
+}
+
+#endif /* CONTACT_PLAN_GENERATOR_H */
@@ -89,49 +89,8 @@ public:
 
 
 private:
-  /// row of a Matrix
-  struct Row {
-    double r[3];
-
-    double& operator[] (uint32_t i) { return r[i]; }
-    const double& operator[] (uint32_t i) const { return r[i]; }
-  };
-
-  /// Matrix data structure to make coordinate conversion code clearer and
-  /// less verbose
-  struct Matrix {
-  public:
-    Matrix (void) { }
-    Matrix (
-      double c00, double c01, double c02,
-      double c10, double c11, double c12,
-      double c20, double c21, double c22
-    );
-
-    Row& operator[] (uint32_t i) { return m[i]; }
-    const Row& operator[] (uint32_t i) const { return m[i]; }
-
-    Vector3D operator* (const Vector3D &v) const;
-
-    Matrix Transpose (void) const;
-
-  private:
-    Row m[3];
-  };
-
-  /**
-   * @brief Retrieve the matrix for converting from PEF to ITRF at a given time.
-   * @param t When.
-   * @return the PEF-ITRF conversion matrix.
-   */
-  static Matrix PefToItrf (const JulianDate &t);
-
-  /**
-   * @brief Retrieve the matrix for converting from TEME to PEF at a given time.
-   * @param t When.
-   * @return the TEME-PEF conversion matrix.
-   */
-  static Matrix TemeToPef (const JulianDate &t);
+  /// the contact plan generator copies the position
+  friend class ContactPlanGenerator;
 
   /**
    * @brief Retrieve the satellite's position vector in ITRF coordinates.
@@ -0,0 +1,292 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 INESC TEC
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "ns3/contact-plan-generator.h"
+#include "ns3/double.h"
+#include "ns3/earth.h"
+#include "ns3/julian-date.h"
+#include "ns3/log.h"
+#include "ns3/nstime.h"
+#include "ns3/ptr.h"
+#include "ns3/satellite.h"
+#include "ns3/test.h"
+#include "ns3/uinteger.h"
+
+NS_LOG_COMPONENT_DEFINE ("EarthTestSuite");
+
+using namespace ns3;
+
+// objects from the SGP4 verification set (AIAA-2006-6753) with close epochs:
+// low earth orbit, sun-synchronous, Molniya and GEO
+static const char *g_tles[][2] = {
+  { "1 06251U 62025E   06176.82412014  .00008885  00000-0  12808-3 0  3985",
+    "2 06251  58.0579  54.0425 0030035 139.1568 221.1854 15.56387291  6774" },
+  { "1 28057U 03049A   06177.78615833  .00000060  00000-0  35940-4 0  1836",
+    "2 28057  98.4283 247.6961 0000884  88.1964 272.0001 14.34920402143719" },
+  { "1 08195U 75081A   06176.33215444  .00000099  00000-0  11873-3 0   813",
+    "2 08195  64.1586 279.0717 6877146 264.7651  20.2257  2.00491383225656" },
+  { "1 28626U 05008A   06176.46683397 -.00000205  00000-0  10000-3 0  2190",
+    "2 28626   0.0019 286.9433 0000335  13.7918  55.6504  1.00270176  4891" },
+};
+
+static const uint32_t g_nTles = sizeof (g_tles) / sizeof (g_tles[0]);
+
+/**
+ * Check that the contact plan generator finds the same contact windows as
+ * sampling every pair of nodes through Satellite and Earth, with boundaries
+ * refined to the tolerance, whatever the number of threads.
+ */
+class ContactPlanGeneratorTestCase : public TestCase
+{
+public:
+  ContactPlanGeneratorTestCase ();
+  virtual ~ContactPlanGeneratorTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+ContactPlanGeneratorTestCase::ContactPlanGeneratorTestCase ()
+  : TestCase ("Check the contact plan generator")
+{
+}
+
+ContactPlanGeneratorTestCase::~ContactPlanGeneratorTestCase ()
+{
+}
+
+void
+ContactPlanGeneratorTestCase::DoRun (void)
+{
+  std::vector<Ptr<Satellite> > sats;
+  std::vector<Ptr<Earth> > stations;
+  Ptr<ContactPlanGenerator> gen = CreateObject<ContactPlanGenerator> ();
+
+  gen->SetAttribute ("Step", TimeValue (Seconds (20)));
+  gen->SetAttribute ("Tolerance", TimeValue (Seconds (1)));
+  gen->SetAttribute ("Threads", UintegerValue (1));
+  gen->SetAttribute ("MaxRange", DoubleValue (100000e3));
+  gen->SetAttribute ("MaxIslRange", DoubleValue (50000e3));
+
+  for (uint32_t i = 0; i < g_nTles; ++i)
+    {
+      Ptr<Satellite> sat = CreateObject<Satellite> ();
+
+      sat->SetTleInfo (g_tles[i][0], g_tles[i][1]);
+      sats.push_back (sat);
+
+      NS_TEST_ASSERT_MSG_EQ (gen->AddSatellite (sat), i, "Wrong node index");
+    }
+
+  for (uint32_t i = 0; i < 3; ++i)
+    {
+      Ptr<Earth> station = CreateObject<Earth> ();
+      const double lon = 2*M_PI*i/3;
+
+      station->SetPosition (Vector3D (
+        6378.137*cos (lon)*cos (0.7), 6378.137*sin (lon)*cos (0.7),
+        6378.137*sin (0.7)
+      ));
+      stations.push_back (station);
+
+      NS_TEST_ASSERT_MSG_EQ (gen->AddGroundStation (station, 100 + i),
+                             g_nTles + i, "Wrong node index");
+    }
+
+  const uint32_t n = gen->GetNNodes ();
+  const JulianDate start ("2006-06-26 00:00:00");
+  const JulianDate stop = start + Hours (12);
+
+  NS_TEST_ASSERT_MSG_EQ (gen->GetNodeNumber (0), 1, "Wrong node number");
+  NS_TEST_ASSERT_MSG_EQ (gen->GetNodeNumber (n - 1), 102, "Wrong node number");
+
+  // sample every pair at the generator's steps through Satellite and Earth
+  std::vector<JulianDate> times;
+  std::vector<std::vector<bool> > visible (n*n);
+
+  for (JulianDate t = start; t < stop; t += Seconds (20))
+    times.push_back (t);
+  times.push_back (stop);
+
+  for (uint32_t k = 0; k < times.size (); ++k)
+    {
+      std::vector<Vector3D> p;
+
+      for (uint32_t i = 0; i < sats.size (); ++i)
+        p.push_back (sats[i]->GetPosition (times[k]));
+      for (uint32_t i = 0; i < stations.size (); ++i)
+        p.push_back (stations[i]->GetPosition (times[k]));
+
+      for (uint32_t i = 0; i < n; ++i)
+        {
+          NS_TEST_ASSERT_MSG_LT (
+            CalculateDistance (p[i], gen->GetPosition (i, times[k])), 1e-6,
+            "Position of node " << i << " differs"
+          );
+
+          for (uint32_t j = i + 1; j < n; ++j)
+            visible[i*n + j].push_back (
+              CalculateDistance (p[i], p[j]) <= 100000e3 &&
+              gen->IsVisible (i, p[i], j, p[j])
+            );
+        }
+    }
+
+  gen->Generate (start, stop);
+
+  const std::vector<ContactPlanGenerator::Contact> contacts =
+    gen->GetContacts ();
+  uint32_t expected = 0;
+
+  // every run of visible samples is a contact whose boundaries lie between
+  // the run's first/last sample and the adjacent ones
+  for (uint32_t i = 0; i < n; ++i)
+    for (uint32_t j = i + 1; j < n; ++j)
+      {
+        const std::vector<bool> &v = visible[i*n + j];
+
+        for (uint32_t k = 0; k < v.size (); ++k)
+          {
+            if (!v[k] || (k > 0 && v[k-1]))
+              continue;
+
+            uint32_t last = k;
+
+            while (last + 1 < v.size () && v[last+1])
+              ++last;
+
+            bool found = false;
+
+            for (uint32_t c = 0; c < contacts.size () && !found; ++c)
+              {
+                const ContactPlanGenerator::Contact &contact = contacts[c];
+
+                found = (contact.from == i && contact.to == j &&
+                         contact.start <= times[k] &&
+                         (k == 0 || contact.start > times[k-1]) &&
+                         contact.end >= times[last] &&
+                         (last + 1 == v.size () ||
+                          contact.end < times[last+1]));
+              }
+
+            NS_TEST_ASSERT_MSG_EQ (found, true, "Missing contact " << i << "-"
+                                   << j << " at " << times[k]);
+            ++expected;
+          }
+      }
+
+  NS_TEST_ASSERT_MSG_EQ (contacts.size (), expected,
+                         "Wrong number of contacts");
+  NS_TEST_ASSERT_MSG_GT (expected, 10, "Too few contacts to be meaningful");
+
+  for (uint32_t c = 0; c < contacts.size (); ++c)
+    {
+      const ContactPlanGenerator::Contact &contact = contacts[c];
+
+      NS_TEST_ASSERT_MSG_EQ ((c == 0 || !(contact.start < contacts[c-1].start)),
+                             true, "Contacts are not sorted");
+      NS_TEST_ASSERT_MSG_EQ ((contact.minRange <= contact.maxRange), true,
+                             "Wrong ranges");
+      NS_TEST_ASSERT_MSG_EQ_TOL (contact.owlt.GetSeconds (),
+                                 contact.maxRange/299792458.0, 1e-6,
+                                 "Wrong light time");
+
+      // boundaries are within the tolerance of a visibility change
+      const uint32_t i = contact.from, j = contact.to;
+
+      if (contact.start != start)
+        {
+          const JulianDate t = contact.start - Seconds (1);
+          const Vector3D pi = gen->GetPosition (i, t);
+          const Vector3D pj = gen->GetPosition (j, t);
+
+          NS_TEST_ASSERT_MSG_EQ (gen->IsVisible (i, pi, j, pj), false,
+                                 "Contact " << c << " starts too late");
+        }
+
+      if (contact.end != stop)
+        {
+          const JulianDate t = contact.end + Seconds (1);
+          const Vector3D pi = gen->GetPosition (i, t);
+          const Vector3D pj = gen->GetPosition (j, t);
+
+          NS_TEST_ASSERT_MSG_EQ (gen->IsVisible (i, pi, j, pj), false,
+                                 "Contact " << c << " ends too early");
+        }
+    }
+
+  // the result does not depend on how the interval is split among threads
+  gen->SetAttribute ("Threads", UintegerValue (3));
+  gen->Generate (start, stop);
+
+  const std::vector<ContactPlanGenerator::Contact> &threaded =
+    gen->GetContacts ();
+
+  NS_TEST_ASSERT_MSG_EQ (threaded.size (), contacts.size (),
+                         "Threads changed the number of contacts");
+
+  for (uint32_t c = 0; c < threaded.size (); ++c)
+    {
+      NS_TEST_ASSERT_MSG_EQ ((threaded[c].from == contacts[c].from &&
+                              threaded[c].to == contacts[c].to &&
+                              threaded[c].start == contacts[c].start &&
+                              threaded[c].end == contacts[c].end), true,
+                             "Threads changed contact " << c);
+      NS_TEST_ASSERT_MSG_EQ_TOL (threaded[c].maxRange, contacts[c].maxRange,
+                                 1e-6, "Threads changed contact " << c);
+    }
+
+  // one comment line, and two contact lines and a range line per contact
+  const std::string filename = CreateTempDirFilename ("contact-plan.txt");
+
+  NS_TEST_ASSERT_MSG_EQ (gen->WriteIonContactPlan (filename), true,
+                         "Unable to write the contact plan");
+
+  std::ifstream f (filename.c_str ());
+  std::string line;
+  uint32_t lines = 0, ranges = 0;
+
+  while (std::getline (f, line))
+    {
+      ++lines;
+      ranges += (line.compare (0, 8, "a range ") == 0);
+    }
+
+  NS_TEST_ASSERT_MSG_EQ (lines, 1 + 3*contacts.size (), "Wrong line count");
+  NS_TEST_ASSERT_MSG_EQ (ranges, contacts.size (), "Wrong range count");
+
+  gen->Dispose ();
+}
+
+static class EarthTestSuite : public TestSuite
+{
+public:
+  EarthTestSuite ()
+  : TestSuite ("earth", UNIT)
+    {
+      NS_LOG_INFO ("creating EarthTestSuite");
+
+      AddTestCase (new ContactPlanGeneratorTestCase (), TestCase::QUICK);
+    }
+
+} g_earthTestSuite;
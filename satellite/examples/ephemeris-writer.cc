@@ -0,0 +1,122 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 INESC TEC
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Propagate every satellite of a TLE file over a time interval and store the
+// result in a constellation ephemeris file (see EphemerisFile), to be mapped
+// by simulations instead of parsing and propagating the TLE set on each run.
+//
+// The TLE file is in the usual three-line format (name, line 1, line 2), as
+// provided by https://celestrak.com/NORAD/elements/, e.g.:
+//
+// ./waf --run "ephemeris-writer --tle=starlink.txt --output=starlink.eph
+//              --start='2020-06-01 00:00:00' --duration=1d --step=10s"
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/ephemeris-file.h"
+#include "ns3/julian-date.h"
+#include "ns3/satellite.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("EphemerisWriter");
+
+/**
+ * Read the satellites of a three-line TLE file.
+ */
+static std::vector<Ptr<Satellite> >
+ReadTleFile (const std::string &filename)
+{
+  std::vector<Ptr<Satellite> > sats;
+  std::ifstream f (filename.c_str ());
+  std::string name, line1, line2;
+
+  while (std::getline (f, name) && std::getline (f, line1) &&
+         std::getline (f, line2))
+    {
+      // tolerate DOS line endings
+      line1 = line1.substr (0, line1.find_last_not_of ("\r") + 1);
+      line2 = line2.substr (0, line2.find_last_not_of ("\r") + 1);
+      name = name.substr (0, name.find_last_not_of ("\r ") + 1);
+
+      if (line1.size () != Satellite::TleSatInfoWidth ||
+          line2.size () != Satellite::TleSatInfoWidth)
+        {
+          std::cerr << "Skipping malformed entry '" << name << "'" << std::endl;
+          continue;
+        }
+
+      Ptr<Satellite> sat = CreateObject<Satellite> ();
+
+      if (!sat->SetTleInfo (line1, line2))
+        {
+          std::cerr << "Skipping '" << name << "': SGP4/SDP4 failed" << std::endl;
+          continue;
+        }
+
+      if (!name.empty ())
+        sat->SetName (name.substr (0, Satellite::TleSatNameWidth));
+
+      sats.push_back (sat);
+    }
+
+  return sats;
+}
+
+int
+main (int argc, char *argv[])
+{
+  std::string tle, output = "constellation.eph";
+  std::string start = "2016-06-20 00:00:00";
+  Time duration = Days (1), step = Seconds (10);
+
+  CommandLine cmd;
+  cmd.AddValue ("tle", "Three-line TLE file of the constellation", tle);
+  cmd.AddValue ("output", "Ephemeris file to write", output);
+  cmd.AddValue ("start", "Time of the first sample (UTC)", start);
+  cmd.AddValue ("duration", "Length of the ephemeris", duration);
+  cmd.AddValue ("step", "Time between samples", step);
+  cmd.Parse (argc, argv);
+
+  if (tle.empty ())
+    {
+      std::cerr << "A TLE file must be given (--tle)" << std::endl;
+      return 1;
+    }
+
+  std::vector<Ptr<Satellite> > sats = ReadTleFile (tle);
+  const JulianDate t0 (start);
+
+  std::cout << "Propagating " << sats.size () << " satellites from " << t0
+            << " to " << t0 + duration << " every " << step.GetSeconds ()
+            << " s" << std::endl;
+
+  if (!EphemerisFile::Write (output, sats, t0, t0 + duration, step))
+    {
+      std::cerr << "Unable to write " << output << std::endl;
+      return 1;
+    }
+
+  std::cout << "Wrote " << output << std::endl;
+
+  return 0;
+}
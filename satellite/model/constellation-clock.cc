@@ -0,0 +1,137 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 INESC TEC
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "constellation-clock.h"
+
+#include "ns3/assert.h"
+#include "ns3/boolean.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("ConstellationClock");
+
+NS_OBJECT_ENSURE_REGISTERED (ConstellationClock);
+
+TypeId
+ConstellationClock::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ConstellationClock")
+    .SetParent<Object> ()
+    .SetGroupName ("Satellite")
+    .AddConstructor<ConstellationClock> ()
+    .AddAttribute ("Interval",
+                   "Simulation time between position updates.",
+                   TimeValue (MilliSeconds (100)),
+                   MakeTimeAccessor (&ConstellationClock::m_interval),
+                   MakeTimeChecker (MilliSeconds (1)))
+    .AddAttribute ("Extrapolate",
+                   "Extrapolate positions between updates using the velocity.",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&ConstellationClock::m_extrapolate),
+                   MakeBooleanChecker ());
+
+  return tid;
+}
+
+ConstellationClock::ConstellationClock (void) :
+  m_interval (MilliSeconds (100)), m_extrapolate (true)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+ConstellationClock::~ConstellationClock (void)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+ConstellationClock::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Simulator::Cancel (m_event);
+  m_models.clear ();
+
+  Object::DoDispose ();
+}
+
+void
+ConstellationClock::Add (Ptr<SatellitePositionMobilityModel> model)
+{
+  NS_LOG_FUNCTION (this << model);
+  NS_ASSERT_MSG (model, "Null mobility model!");
+
+  m_models.push_back (model);
+
+  if (IsRunning ())
+    model->Tick (m_extrapolate);
+}
+
+uint32_t
+ConstellationClock::GetNModels (void) const
+{
+  return m_models.size ();
+}
+
+Time
+ConstellationClock::GetInterval (void) const
+{
+  return m_interval;
+}
+
+void
+ConstellationClock::Start (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Simulator::Cancel (m_event);
+  Tick ();
+}
+
+void
+ConstellationClock::Stop (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Simulator::Cancel (m_event);
+
+  for (uint32_t i = 0; i < m_models.size (); ++i)
+    m_models[i]->StopTicks ();
+}
+
+bool
+ConstellationClock::IsRunning (void) const
+{
+  return m_event.IsRunning ();
+}
+
+void
+ConstellationClock::Tick (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  for (uint32_t i = 0; i < m_models.size (); ++i)
+    m_models[i]->Tick (m_extrapolate);
+
+  m_event = Simulator::Schedule (m_interval, &ConstellationClock::Tick, this);
+}
+
+}
@@ -0,0 +1,126 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 INESC TEC
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef CONSTELLATION_CLOCK_H
+#define CONSTELLATION_CLOCK_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "ns3/event-id.h"
+#include "ns3/nstime.h"
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "ns3/type-id.h"
+
+#include "satellite-position-mobility-model.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup satellite
+ * @brief Periodic, event-driven update of satellite positions.
+ *
+ * By default, every query to a SatellitePositionMobilityModel computes the
+ * satellite's state at the current simulation time. With many satellites and
+ * frequent queries (e.g., by propagation loss models), this dominates the
+ * simulation time. A constellation clock instead updates all the models it
+ * was given from a single event, scheduled every Interval of simulation time:
+ * on each tick, the state of every satellite is computed once and its
+ * CourseChange trace is fired. Queries between ticks are answered from that
+ * snapshot, extrapolating the position linearly with the snapshot's velocity
+ * (if Extrapolate is set) or holding it (otherwise).
+ *
+ * The extrapolation error grows as a*dt^2/2, where a is the satellite's
+ * acceleration and dt the time since the last tick; for LEO satellites
+ * (a of about 8 m/s^2) and the default 100 ms interval, it stays below 4 cm.
+ */
+class ConstellationClock : public Object {
+public:
+  /**
+   * @brief Get the type ID.
+   * @return the object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * @brief Default constructor.
+   */
+  ConstellationClock (void);
+
+  /**
+   * @brief Destructor.
+   */
+  virtual ~ConstellationClock (void);
+
+  /**
+   * @brief Add a mobility model to be updated by the clock.
+   *
+   * If the clock is running, the model is ticked right away.
+   *
+   * @param model the mobility model.
+   */
+  void Add (Ptr<SatellitePositionMobilityModel> model);
+
+  /**
+   * @brief Get the number of mobility models updated by the clock.
+   * @return the number of mobility models.
+   */
+  uint32_t GetNModels (void) const;
+
+  /**
+   * @brief Get the time between ticks.
+   * @return the tick interval.
+   */
+  Time GetInterval (void) const;
+
+  /**
+   * @brief Start ticking, the first tick taking place at the current time.
+   */
+  void Start (void);
+
+  /**
+   * @brief Stop ticking and return all mobility models to computing their
+   *        state on every query.
+   */
+  void Stop (void);
+
+  /**
+   * @brief Check if the clock is ticking.
+   * @return a boolean indicating whether the clock is ticking.
+   */
+  bool IsRunning (void) const;
+
+private:
+  virtual void DoDispose (void);
+
+  /**
+   * @brief Update all mobility models and schedule the next tick.
+   */
+  void Tick (void);
+
+  Time m_interval;                                //!< time between ticks.
+  bool m_extrapolate;                             //!< extrapolate positions.
+  EventId m_event;                                //!< next tick.
+  std::vector<Ptr<SatellitePositionMobilityModel> > m_models; //!< models.
+};
+
+}
+
+#endif /* CONSTELLATION_CLOCK_H */
@@ -0,0 +1,259 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 INESC TEC
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "constellation-propagator.h"
+
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include "ns3/type-id.h"
+#include "ns3/vector.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("ConstellationPropagator");
+
+NS_OBJECT_ENSURE_REGISTERED (ConstellationPropagator);
+
+TypeId
+ConstellationPropagator::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ConstellationPropagator")
+    .SetParent<Object> ()
+    .SetGroupName ("Satellite")
+    .AddConstructor<ConstellationPropagator> ();
+
+  return tid;
+}
+
+ConstellationPropagator::ConstellationPropagator (void) :
+  m_valid (false)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+ConstellationPropagator::~ConstellationPropagator (void)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+ConstellationPropagator::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_satellites.clear ();
+  m_indexes.clear ();
+  m_records.clear ();
+  m_epochs.clear ();
+  m_tsince.clear ();
+  m_r.clear ();
+  m_v.clear ();
+  m_valid = false;
+
+  Object::DoDispose ();
+}
+
+uint32_t
+ConstellationPropagator::AddSatellite (Ptr<Satellite> sat)
+{
+  NS_LOG_FUNCTION (this << sat);
+  NS_ASSERT_MSG (sat && sat->IsInitialized (), "Satellite is not initialized!");
+
+  std::map<Ptr<Satellite>, uint32_t>::const_iterator it = m_indexes.find (sat);
+
+  if (it != m_indexes.end ())
+    return it->second;
+
+  uint32_t index = m_satellites.size ();
+
+  m_satellites.push_back (sat);
+  m_indexes[sat] = index;
+  m_records.push_back (sat->m_sgp4_record);
+  m_epochs.push_back (sat->GetTleEpoch ());
+
+  m_tsince.resize (index + 1);
+  m_r.resize (3*(index + 1));
+  m_v.resize (3*(index + 1));
+  m_itrf.Resize (index + 1);
+  m_eci.Resize (index + 1);
+
+  // the new entry has not been propagated yet
+  m_valid = false;
+
+  return index;
+}
+
+uint32_t
+ConstellationPropagator::GetNSatellites (void) const
+{
+  return m_satellites.size ();
+}
+
+Ptr<Satellite>
+ConstellationPropagator::GetSatellite (uint32_t i) const
+{
+  NS_ASSERT (i < m_satellites.size ());
+
+  return m_satellites[i];
+}
+
+JulianDate
+ConstellationPropagator::GetTime (void) const
+{
+  return m_time;
+}
+
+int
+ConstellationPropagator::GetError (uint32_t i) const
+{
+  NS_ASSERT (i < m_records.size ());
+
+  return m_records[i].error;
+}
+
+void
+ConstellationPropagator::Propagate (const JulianDate &t)
+{
+  if (m_valid && t == m_time)
+    return;
+
+  NS_LOG_FUNCTION (this << t);
+
+  // the frame transformation is the same for every satellite at instant t
+  const FrameTransform ft = FrameTransform::Get (t);
+  const uint32_t n = m_records.size ();
+
+  for (uint32_t i = 0; i < n; ++i)
+    m_tsince[i] = (t - m_epochs[i]).GetMinutes ();
+
+  double (*r)[3] = reinterpret_cast<double (*)[3]> (m_r.data ());
+  double (*v)[3] = reinterpret_cast<double (*)[3]> (m_v.data ());
+
+  sgp4simd (Satellite::WGeoSys, m_records.data (), m_tsince.data (), n, r, v);
+
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      if (m_records[i].error != 0)
+        {
+          r[i][0] = r[i][1] = r[i][2] = 0;
+          v[i][0] = v[i][1] = v[i][2] = 0;
+        }
+
+      const Vector3D rteme (r[i][0], r[i][1], r[i][2]);
+      const Vector3D vteme (v[i][0], v[i][1], v[i][2]);
+      Vector3D ritrf, vitrf;
+
+      // vectors are in km and km/s so they need to be converted to m and m/s
+      ft.TemeToItrf (rteme, vteme, ritrf, vitrf);
+
+      m_eci.x[i] = 1000*r[i][0];
+      m_eci.y[i] = 1000*r[i][1];
+      m_eci.z[i] = 1000*r[i][2];
+      m_eci.vx[i] = 1000*v[i][0];
+      m_eci.vy[i] = 1000*v[i][1];
+      m_eci.vz[i] = 1000*v[i][2];
+
+      m_itrf.x[i] = 1000*ritrf.x;
+      m_itrf.y[i] = 1000*ritrf.y;
+      m_itrf.z[i] = 1000*ritrf.z;
+      m_itrf.vx[i] = 1000*vitrf.x;
+      m_itrf.vy[i] = 1000*vitrf.y;
+      m_itrf.vz[i] = 1000*vitrf.z;
+    }
+
+  m_time = t;
+  m_valid = true;
+}
+
+Vector3D
+ConstellationPropagator::GetPosition (uint32_t i, const JulianDate &t)
+{
+  NS_ASSERT (i < m_satellites.size ());
+
+  Propagate (t);
+
+  return m_itrf.GetPosition (i);
+}
+
+Vector3D
+ConstellationPropagator::GetVelocity (uint32_t i, const JulianDate &t)
+{
+  NS_ASSERT (i < m_satellites.size ());
+
+  Propagate (t);
+
+  return m_itrf.GetVelocity (i);
+}
+
+Vector3D
+ConstellationPropagator::GetPositionInECI (uint32_t i, const JulianDate &t)
+{
+  NS_ASSERT (i < m_satellites.size ());
+
+  Propagate (t);
+
+  return m_eci.GetPosition (i);
+}
+
+Vector3D
+ConstellationPropagator::GetVelocityInECI (uint32_t i, const JulianDate &t)
+{
+  NS_ASSERT (i < m_satellites.size ());
+
+  Propagate (t);
+
+  return m_eci.GetVelocity (i);
+}
+
+const ConstellationPropagator::StateTable&
+ConstellationPropagator::GetItrfTable (void) const
+{
+  return m_itrf;
+}
+
+const ConstellationPropagator::StateTable&
+ConstellationPropagator::GetEciTable (void) const
+{
+  return m_eci;
+}
+
+void
+ConstellationPropagator::StateTable::Resize (uint32_t n)
+{
+  x.resize (n);
+  y.resize (n);
+  z.resize (n);
+  vx.resize (n);
+  vy.resize (n);
+  vz.resize (n);
+}
+
+Vector3D
+ConstellationPropagator::StateTable::GetPosition (uint32_t i) const
+{
+  return Vector3D (x[i], y[i], z[i]);
+}
+
+Vector3D
+ConstellationPropagator::StateTable::GetVelocity (uint32_t i) const
+{
+  return Vector3D (vx[i], vy[i], vz[i]);
+}
+
+}
@@ -0,0 +1,219 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 INESC TEC
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef CONSTELLATION_PROPAGATOR_H
+#define CONSTELLATION_PROPAGATOR_H
+
+#include <map>
+#include <stdint.h>
+#include <vector>
+
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "ns3/type-id.h"
+#include "ns3/vector.h"
+
+#include "frame-transform.h"
+#include "julian-date.h"
+#include "satellite.h"
+#include "sgp4simd.h"
+#include "sgp4unit.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup satellite
+ * @brief Propagates every satellite of a constellation in a single pass.
+ *
+ * Each Satellite object runs SGP4/SDP4 and the TEME->ITRF conversion on its
+ * own, and does so every time a position or velocity is requested. For large
+ * constellations this dominates the simulation time, since the same instant is
+ * usually requested several times per node (e.g., once for the position and
+ * once for the velocity, or once per packet for delay computations).
+ *
+ * This class keeps its own copy of the SGP4/SDP4 records of all satellites
+ * added to it and, whenever a time instant different from the last one is
+ * requested, propagates all of them at once into a structure-of-arrays table
+ * holding position and velocity in both ITRF and ECI (TEME) frames. Near
+ * earth satellites are propagated several at a time by the sgp4simd kernel,
+ * and the frame transformation is obtained only once per pass.
+ * Subsequent queries for the same instant are served directly from the table.
+ *
+ * Satellites must be initialized (i.e., have their TLE set) before being
+ * added. Satellites whose propagation fails at a given instant are reported at
+ * the origin, as Satellite does.
+ */
+class ConstellationPropagator : public Object {
+public:
+  /**
+   * @brief Get the type ID.
+   * @return the object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * @brief Default constructor.
+   */
+  ConstellationPropagator (void);
+
+  /**
+   * @brief Destructor.
+   */
+  virtual ~ConstellationPropagator (void);
+
+  /**
+   * @brief Add a satellite to the constellation.
+   *
+   * Adding the same satellite more than once has no effect other than
+   * returning the index it was first given.
+   *
+   * @param sat the (initialized) satellite to add.
+   * @return the index of the satellite in the position/velocity table.
+   */
+  uint32_t AddSatellite (Ptr<Satellite> sat);
+
+  /**
+   * @brief Get the number of satellites in the constellation.
+   * @return the number of satellites.
+   */
+  uint32_t GetNSatellites (void) const;
+
+  /**
+   * @brief Get a satellite of the constellation.
+   * @param i the index of the satellite.
+   * @return the satellite with index i.
+   */
+  Ptr<Satellite> GetSatellite (uint32_t i) const;
+
+  /**
+   * @brief Get the time instant of the last propagation pass.
+   * @return the time instant the table currently refers to.
+   */
+  JulianDate GetTime (void) const;
+
+  /**
+   * @brief Get the SGP4/SDP4 error code of a satellite in the last pass.
+   * @param i the index of the satellite.
+   * @return zero if the state vectors of satellite i are valid, or the error
+   * code of the propagator otherwise, in which case they are null.
+   */
+  int GetError (uint32_t i) const;
+
+  /**
+   * @brief Propagate all satellites to a given time instant.
+   *
+   * This is a no-op if the table already refers to time instant t.
+   *
+   * @param t When.
+   */
+  void Propagate (const JulianDate &t);
+
+  /**
+   * @brief Get the position of a satellite at a given time.
+   * @param i the index of the satellite.
+   * @param t When.
+   * @return the satellite's position, in meters, on ITRF coordinate frame.
+   */
+  Vector3D GetPosition (uint32_t i, const JulianDate &t);
+
+  /**
+   * @brief Get the velocity of a satellite at a given time.
+   * @param i the index of the satellite.
+   * @param t When.
+   * @return the satellite's velocity, in m/s, on ITRF coordinate frame.
+   */
+  Vector3D GetVelocity (uint32_t i, const JulianDate &t);
+
+  /**
+   * @brief Get the position of a satellite at a given time in ECI.
+   * @param i the index of the satellite.
+   * @param t When.
+   * @return the satellite's position, in meters, on TEME coordinate frame.
+   */
+  Vector3D GetPositionInECI (uint32_t i, const JulianDate &t);
+
+  /**
+   * @brief Get the velocity of a satellite at a given time in ECI.
+   * @param i the index of the satellite.
+   * @param t When.
+   * @return the satellite's velocity, in m/s, on TEME coordinate frame.
+   */
+  Vector3D GetVelocityInECI (uint32_t i, const JulianDate &t);
+
+  /**
+   * @brief Structure-of-arrays table of state vectors in a given frame.
+   *
+   * Entry i of every array refers to the satellite with index i.
+   */
+  struct StateTable {
+    std::vector<double> x, y, z;                //!< position (m)
+    std::vector<double> vx, vy, vz;             //!< velocity (m/s)
+
+    /**
+     * @brief Resize all arrays.
+     * @param n the new number of entries.
+     */
+    void Resize (uint32_t n);
+
+    /**
+     * @brief Get the position stored at a given entry.
+     * @param i the entry.
+     * @return the position vector.
+     */
+    Vector3D GetPosition (uint32_t i) const;
+
+    /**
+     * @brief Get the velocity stored at a given entry.
+     * @param i the entry.
+     * @return the velocity vector.
+     */
+    Vector3D GetVelocity (uint32_t i) const;
+  };
+
+  /**
+   * @brief Get the table of ITRF state vectors of the last propagation pass.
+   * @return the ITRF state vector table.
+   */
+  const StateTable& GetItrfTable (void) const;
+
+  /**
+   * @brief Get the table of ECI state vectors of the last propagation pass.
+   * @return the ECI (TEME) state vector table.
+   */
+  const StateTable& GetEciTable (void) const;
+
+private:
+  virtual void DoDispose (void);
+
+  std::vector<Ptr<Satellite> > m_satellites;      //!< satellites, by index.
+  std::map<Ptr<Satellite>, uint32_t> m_indexes;   //!< indexes, by satellite.
+  std::vector<elsetrec> m_records;                //!< SGP4/SDP4 records.
+  std::vector<JulianDate> m_epochs;               //!< TLE epochs.
+  std::vector<double> m_tsince;                   //!< minutes since epochs.
+  std::vector<double> m_r, m_v;                   //!< TEME output (km, km/s).
+
+  bool m_valid;                                   //!< whether tables are set.
+  JulianDate m_time;                              //!< time of the tables.
+  StateTable m_itrf;                              //!< ITRF state vectors.
+  StateTable m_eci;                               //!< ECI state vectors.
+};
+
+}
+
+#endif /* CONSTELLATION_PROPAGATOR_H */
@@ -0,0 +1,470 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 INESC TEC
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ephemeris-file.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ns3/assert.h"
+#include "ns3/log.h"
+
+#include "constellation-propagator.h"
+#include "ephemeris.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("EphemerisFile");
+
+NS_OBJECT_ENSURE_REGISTERED (EphemerisFile);
+
+// "NS3CEPH1" in ASCII
+const uint64_t EphemerisFile::FileMagic = 0x3148504543334e53ULL;
+const uint32_t EphemerisFile::FileVersion = 2;
+const uint32_t EphemerisFile::NameWidth = sizeof (EphemerisFile::Entry::name) - 1;
+
+TypeId
+EphemerisFile::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::EphemerisFile")
+    .SetParent<Object> ()
+    .SetGroupName ("Satellite")
+    .AddConstructor<EphemerisFile> ();
+
+  return tid;
+}
+
+EphemerisFile::EphemerisFile (void) :
+  m_data (0), m_size (0), m_header (0), m_entries (0), m_samples (0), m_h (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+EphemerisFile::~EphemerisFile (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Close ();
+}
+
+void
+EphemerisFile::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Close ();
+
+  Object::DoDispose ();
+}
+
+size_t
+EphemerisFile::GetFileSize (uint32_t satellites, uint32_t samples)
+{
+  return sizeof (Header) + satellites*sizeof (Entry) +
+         static_cast<size_t> (satellites)*samples*sizeof (Sample);
+}
+
+bool
+EphemerisFile::Write (
+  const std::string &filename, const std::vector<Ptr<Satellite> > &sats,
+  const JulianDate &start, const JulianDate &stop, const Time &step
+)
+{
+  NS_LOG_FUNCTION (filename << sats.size () << start << stop << step);
+  NS_ASSERT_MSG (step.IsStrictlyPositive (), "Step must be positive!");
+
+  if (stop <= start)
+    {
+      NS_LOG_WARN ("Stop must be after start");
+      return false;
+    }
+
+  if (step.GetMilliSeconds () < 1)
+    {
+      NS_LOG_WARN ("Step must be at least 1 ms");
+      return false;
+    }
+
+  Ptr<ConstellationPropagator> prop = CreateObject<ConstellationPropagator> ();
+
+  for (uint32_t i = 0; i < sats.size (); ++i)
+    {
+      if (!sats[i]->IsInitialized ())
+        {
+          NS_LOG_WARN ("Satellite " << i << " is not initialized");
+          return false;
+        }
+
+      prop->AddSatellite (sats[i]);
+    }
+
+  const uint32_t n = prop->GetNSatellites ();
+  const int64_t span = (stop - start).GetMilliSeconds ();
+  const int64_t ms = step.GetMilliSeconds ();
+  const uint32_t samples = (span + ms - 1)/ms + 1;  // last sample at or after stop
+  const size_t size = GetFileSize (n, samples);
+
+  int fd = open (filename.c_str (), O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+  if (fd < 0)
+    {
+      NS_LOG_WARN ("Unable to open " << filename << " for writing");
+      return false;
+    }
+
+  if (ftruncate (fd, size) != 0)
+    {
+      NS_LOG_WARN ("Unable to resize " << filename);
+      close (fd);
+      return false;
+    }
+
+  // samples are written satellite by satellite but computed instant by
+  // instant, so the file is filled through a shared mapping
+  void *data = mmap (0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+  close (fd);
+
+  if (data == MAP_FAILED)
+    {
+      NS_LOG_WARN ("Unable to map " << filename);
+      return false;
+    }
+
+  Header *header = static_cast<Header *> (data);
+  Entry *entries = reinterpret_cast<Entry *> (header + 1);
+  Sample *table = reinterpret_cast<Sample *> (entries + n);
+
+  header->magic = FileMagic;
+  header->version = FileVersion;
+  header->satellites = n;
+  header->samples = samples;
+  header->reserved = 0;
+  header->start = start.GetPosixMilliseconds ();
+  header->step = ms;
+
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      const std::string name = prop->GetSatellite (i)->GetName ();
+
+      memset (entries[i].name, 0, sizeof (entries[i].name));
+      strncpy (entries[i].name, name.c_str (), NameWidth);
+      entries[i].satnum = prop->GetSatellite (i)->GetSatelliteNumber ();
+      entries[i].samples = samples;
+    }
+
+  for (uint32_t k = 0; k < samples; ++k)
+    {
+      prop->Propagate (start + MilliSeconds (ms*k));
+
+      const ConstellationPropagator::StateTable &itrf = prop->GetItrfTable ();
+      const ConstellationPropagator::StateTable &eci = prop->GetEciTable ();
+
+      for (uint32_t i = 0; i < n; ++i)
+        {
+          if (prop->GetError (i) != 0 && entries[i].samples == samples)
+            {
+              NS_LOG_WARN ("Satellite " << entries[i].satnum <<
+                           " failed to propagate at sample " << k <<
+                           " (error " << prop->GetError (i) << ")");
+              entries[i].samples = k;
+            }
+
+          Sample &sample = table[static_cast<size_t> (i)*samples + k];
+
+          sample.ritrf[0] = itrf.x[i];
+          sample.ritrf[1] = itrf.y[i];
+          sample.ritrf[2] = itrf.z[i];
+          sample.vitrf[0] = itrf.vx[i];
+          sample.vitrf[1] = itrf.vy[i];
+          sample.vitrf[2] = itrf.vz[i];
+          sample.reci[0] = eci.x[i];
+          sample.reci[1] = eci.y[i];
+          sample.reci[2] = eci.z[i];
+          sample.veci[0] = eci.vx[i];
+          sample.veci[1] = eci.vy[i];
+          sample.veci[2] = eci.vz[i];
+        }
+    }
+
+  bool ok = (msync (data, size, MS_SYNC) == 0);
+
+  munmap (data, size);
+  prop->Dispose ();
+
+  return ok;
+}
+
+bool
+EphemerisFile::Open (const std::string &filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+
+  Close ();
+
+  int fd = open (filename.c_str (), O_RDONLY);
+  struct stat st;
+
+  if (fd < 0)
+    {
+      NS_LOG_WARN ("Unable to open " << filename << " for reading");
+      return false;
+    }
+
+  if (fstat (fd, &st) != 0 || static_cast<size_t> (st.st_size) < sizeof (Header))
+    {
+      NS_LOG_WARN (filename << " is not a valid ephemeris file");
+      close (fd);
+      return false;
+    }
+
+  const size_t size = st.st_size;
+  void *data = mmap (0, size, PROT_READ, MAP_SHARED, fd, 0);
+
+  close (fd);
+
+  if (data == MAP_FAILED)
+    {
+      NS_LOG_WARN ("Unable to map " << filename);
+      return false;
+    }
+
+  const Header *header = static_cast<const Header *> (data);
+
+  if (header->magic != FileMagic || header->version != FileVersion ||
+      header->step <= 0 || header->samples < 2 ||
+      GetFileSize (header->satellites, header->samples) != size)
+    {
+      NS_LOG_WARN (filename << " is not a valid ephemeris file");
+      munmap (data, size);
+      return false;
+    }
+
+  const Entry *entries = reinterpret_cast<const Entry *> (header + 1);
+
+  for (uint32_t i = 0; i < header->satellites; ++i)
+    {
+      if (entries[i].samples > header->samples)
+        {
+          NS_LOG_WARN (filename << " is not a valid ephemeris file");
+          munmap (data, size);
+          return false;
+        }
+    }
+
+  m_data = data;
+  m_size = size;
+  m_header = header;
+  m_entries = entries;
+  m_samples = reinterpret_cast<const Sample *> (m_entries + header->satellites);
+  m_start = JulianDate (
+    static_cast<uint32_t> (header->start/JulianDate::DayToMs),
+    static_cast<uint32_t> (header->start%JulianDate::DayToMs)
+  );
+  m_h = header->step/1000.0;
+
+  return true;
+}
+
+void
+EphemerisFile::Close (void)
+{
+  if (!m_data)
+    return;
+
+  NS_LOG_FUNCTION (this);
+
+  munmap (m_data, m_size);
+
+  m_data = 0;
+  m_size = 0;
+  m_header = 0;
+  m_entries = 0;
+  m_samples = 0;
+}
+
+bool
+EphemerisFile::IsOpen (void) const
+{
+  return (m_data != 0);
+}
+
+uint32_t
+EphemerisFile::GetNSatellites (void) const
+{
+  return (m_header ? m_header->satellites : 0);
+}
+
+uint32_t
+EphemerisFile::GetNSamples (void) const
+{
+  return (m_header ? m_header->samples : 0);
+}
+
+uint32_t
+EphemerisFile::GetSatelliteNumber (uint32_t i) const
+{
+  NS_ASSERT (i < GetNSatellites ());
+
+  return m_entries[i].satnum;
+}
+
+std::string
+EphemerisFile::GetSatelliteName (uint32_t i) const
+{
+  NS_ASSERT (i < GetNSatellites ());
+
+  const char *name = m_entries[i].name;
+
+  return std::string (name, strnlen (name, sizeof (m_entries[i].name)));
+}
+
+bool
+EphemerisFile::FindSatellite (uint32_t satnum, uint32_t &i) const
+{
+  for (i = 0; i < GetNSatellites (); ++i)
+    if (m_entries[i].satnum == satnum)
+      return true;
+
+  return false;
+}
+
+JulianDate
+EphemerisFile::GetStart (void) const
+{
+  return m_start;
+}
+
+JulianDate
+EphemerisFile::GetStop (void) const
+{
+  if (!m_header)
+    return m_start;
+
+  return m_start + MilliSeconds (m_header->step*(m_header->samples - 1));
+}
+
+Time
+EphemerisFile::GetStep (void) const
+{
+  return MilliSeconds (m_header ? m_header->step : 0);
+}
+
+bool
+EphemerisFile::Covers (const JulianDate &t) const
+{
+  return (IsOpen () && t >= m_start && t <= GetStop ());
+}
+
+bool
+EphemerisFile::Covers (uint32_t i, const JulianDate &t) const
+{
+  if (!Covers (t))
+    return false;
+
+  NS_ASSERT (i < GetNSatellites ());
+
+  const uint32_t valid = m_entries[i].samples;
+
+  // interpolation needs both ends of a segment
+  return (valid >= 2 &&
+          t <= m_start + MilliSeconds (m_header->step*(valid - 1)));
+}
+
+const EphemerisFile::Sample*
+EphemerisFile::Locate (uint32_t i, const JulianDate &t, double &s) const
+{
+  NS_ASSERT (i < GetNSatellites ());
+  NS_ASSERT_MSG (Covers (i, t), "Time " << t << " is not covered!");
+
+  const double dt = (t - m_start).GetSeconds ();
+  const uint32_t k = std::min (
+    static_cast<uint32_t> (dt/m_h), m_entries[i].samples - 2
+  );
+
+  s = dt/m_h - k;
+
+  return m_samples + static_cast<size_t> (i)*m_header->samples + k;
+}
+
+Vector3D
+EphemerisFile::GetPosition (uint32_t i, const JulianDate &t) const
+{
+  double s;
+  const Sample *p = Locate (i, t, s);
+
+  return Ephemeris::HermitePosition (
+    Vector3D (p[0].ritrf[0], p[0].ritrf[1], p[0].ritrf[2]),
+    Vector3D (p[0].vitrf[0], p[0].vitrf[1], p[0].vitrf[2]),
+    Vector3D (p[1].ritrf[0], p[1].ritrf[1], p[1].ritrf[2]),
+    Vector3D (p[1].vitrf[0], p[1].vitrf[1], p[1].vitrf[2]),
+    s, m_h
+  );
+}
+
+Vector3D
+EphemerisFile::GetVelocity (uint32_t i, const JulianDate &t) const
+{
+  double s;
+  const Sample *p = Locate (i, t, s);
+
+  return Ephemeris::HermiteVelocity (
+    Vector3D (p[0].ritrf[0], p[0].ritrf[1], p[0].ritrf[2]),
+    Vector3D (p[0].vitrf[0], p[0].vitrf[1], p[0].vitrf[2]),
+    Vector3D (p[1].ritrf[0], p[1].ritrf[1], p[1].ritrf[2]),
+    Vector3D (p[1].vitrf[0], p[1].vitrf[1], p[1].vitrf[2]),
+    s, m_h
+  );
+}
+
+Vector3D
+EphemerisFile::GetPositionInECI (uint32_t i, const JulianDate &t) const
+{
+  double s;
+  const Sample *p = Locate (i, t, s);
+
+  return Ephemeris::HermitePosition (
+    Vector3D (p[0].reci[0], p[0].reci[1], p[0].reci[2]),
+    Vector3D (p[0].veci[0], p[0].veci[1], p[0].veci[2]),
+    Vector3D (p[1].reci[0], p[1].reci[1], p[1].reci[2]),
+    Vector3D (p[1].veci[0], p[1].veci[1], p[1].veci[2]),
+    s, m_h
+  );
+}
+
+Vector3D
+EphemerisFile::GetVelocityInECI (uint32_t i, const JulianDate &t) const
+{
+  double s;
+  const Sample *p = Locate (i, t, s);
+
+  return Ephemeris::HermiteVelocity (
+    Vector3D (p[0].reci[0], p[0].reci[1], p[0].reci[2]),
+    Vector3D (p[0].veci[0], p[0].veci[1], p[0].veci[2]),
+    Vector3D (p[1].reci[0], p[1].reci[1], p[1].reci[2]),
+    Vector3D (p[1].veci[0], p[1].veci[1], p[1].veci[2]),
+    s, m_h
+  );
+}
+
+}
@@ -0,0 +1,283 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 INESC TEC
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef EPHEMERIS_FILE_H
+#define EPHEMERIS_FILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "ns3/nstime.h"
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "ns3/type-id.h"
+#include "ns3/vector.h"
+
+#include "julian-date.h"
+#include "satellite.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup satellite
+ * @brief Read-only, memory-mapped ephemeris of a whole constellation.
+ *
+ * An ephemeris file holds the position and velocity of a set of satellites,
+ * in both ITRF and ECI (TEME) frames, sampled at a fixed step over a time
+ * interval. It is generated once (see Write and the ephemeris-writer program)
+ * and then mapped into memory by every simulation using it, so that no TLE is
+ * parsed and no SGP4/SDP4 run is needed at all. Being a read-only shared
+ * mapping, the file is kept only once in the operating system's page cache
+ * regardless of how many processes (e.g., MPI ranks) use it. Position and
+ * velocity between samples are interpolated with the cubic Hermite polynomials
+ * of Ephemeris (see there for the error bounds).
+ *
+ * The file is laid out as follows, in the host's byte order:
+ *
+ *   - header (40 bytes): magic number ("NS3CEPH1"), format version, number of
+ *     satellites, number of samples per satellite, time of the first sample
+ *     (milliseconds since the Unix/POSIX epoch) and step (milliseconds);
+ *   - satellite table (40 bytes per satellite): satellite number, number of
+ *     valid samples and name;
+ *   - samples, satellite by satellite, 12 doubles per sample: ITRF position
+ *     (m) and velocity (m/s), and ECI position (m) and velocity (m/s).
+ *
+ * The ephemeris of a satellite ends at its last sample before SGP4/SDP4 first
+ * failed for it (e.g., on decay): later samples are not valid and times past
+ * that sample are not covered for that satellite (see Covers).
+ */
+class EphemerisFile : public Object {
+public:
+  /// Magic number identifying constellation ephemeris files.
+  static const uint64_t FileMagic;
+  /// Version of the file format.
+  static const uint32_t FileVersion;
+  /// Maximum length of a satellite's name in the file.
+  static const uint32_t NameWidth;
+
+  /**
+   * @brief Get the type ID.
+   * @return the object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * @brief Default constructor.
+   */
+  EphemerisFile (void);
+
+  /**
+   * @brief Destructor.
+   */
+  virtual ~EphemerisFile (void);
+
+  /**
+   * @brief Propagate a set of satellites and write their ephemeris to a file.
+   * @param filename the name of the file.
+   * @param sats the (initialized) satellites.
+   * @param start the time of the first sample.
+   * @param stop the time up to which samples are taken.
+   * @param step the time between samples (at least 1 ms).
+   * @return a boolean indicating whether the file was written, which requires
+   * stop to be after start.
+   */
+  static bool Write (
+    const std::string &filename, const std::vector<Ptr<Satellite> > &sats,
+    const JulianDate &start, const JulianDate &stop, const Time &step
+  );
+
+  /**
+   * @brief Map an ephemeris file into memory.
+   *
+   * Any previously mapped file is unmapped first.
+   *
+   * @param filename the name of the file.
+   * @return a boolean indicating whether the file is valid and was mapped.
+   */
+  bool Open (const std::string &filename);
+
+  /**
+   * @brief Unmap the ephemeris file.
+   */
+  void Close (void);
+
+  /**
+   * @brief Check if a file is mapped.
+   * @return a boolean indicating whether a file is mapped.
+   */
+  bool IsOpen (void) const;
+
+  /**
+   * @brief Get the number of satellites in the file.
+   * @return the number of satellites.
+   */
+  uint32_t GetNSatellites (void) const;
+
+  /**
+   * @brief Get the number of samples per satellite.
+   * @return the number of samples.
+   */
+  uint32_t GetNSamples (void) const;
+
+  /**
+   * @brief Get the number (NORAD ID) of a satellite.
+   * @param i the index of the satellite in the file.
+   * @return the satellite's number.
+   */
+  uint32_t GetSatelliteNumber (uint32_t i) const;
+
+  /**
+   * @brief Get the name of a satellite.
+   * @param i the index of the satellite in the file.
+   * @return the satellite's name.
+   */
+  std::string GetSatelliteName (uint32_t i) const;
+
+  /**
+   * @brief Find a satellite by its number.
+   * @param satnum the satellite's number (NORAD ID).
+   * @param i the index of the satellite in the file, if found.
+   * @return a boolean indicating whether the satellite was found.
+   */
+  bool FindSatellite (uint32_t satnum, uint32_t &i) const;
+
+  /**
+   * @brief Get the time of the first sample.
+   * @return the start of the ephemeris interval.
+   */
+  JulianDate GetStart (void) const;
+
+  /**
+   * @brief Get the time of the last sample.
+   * @return the end of the ephemeris interval.
+   */
+  JulianDate GetStop (void) const;
+
+  /**
+   * @brief Get the time between samples.
+   * @return the sampling step.
+   */
+  Time GetStep (void) const;
+
+  /**
+   * @brief Check if the ephemeris can be evaluated at a given time.
+   * @param t When.
+   * @return a boolean indicating whether t is within the ephemeris interval.
+   */
+  bool Covers (const JulianDate &t) const;
+
+  /**
+   * @brief Check if a satellite's ephemeris can be evaluated at a given time.
+   * @param i the index of the satellite in the file.
+   * @param t When.
+   * @return a boolean indicating whether t is within the ephemeris interval
+   * and before the first sample at which the satellite failed to propagate.
+   */
+  bool Covers (uint32_t i, const JulianDate &t) const;
+
+  /**
+   * @brief Get the position of a satellite at a given time.
+   * @param i the index of the satellite in the file.
+   * @param t When (must be covered for satellite i).
+   * @return the satellite's position, in meters, on ITRF coordinate frame.
+   */
+  Vector3D GetPosition (uint32_t i, const JulianDate &t) const;
+
+  /**
+   * @brief Get the velocity of a satellite at a given time.
+   * @param i the index of the satellite in the file.
+   * @param t When (must be covered for satellite i).
+   * @return the satellite's velocity, in m/s, on ITRF coordinate frame.
+   */
+  Vector3D GetVelocity (uint32_t i, const JulianDate &t) const;
+
+  /**
+   * @brief Get the position of a satellite at a given time in ECI.
+   * @param i the index of the satellite in the file.
+   * @param t When (must be covered for satellite i).
+   * @return the satellite's position, in meters, on TEME coordinate frame.
+   */
+  Vector3D GetPositionInECI (uint32_t i, const JulianDate &t) const;
+
+  /**
+   * @brief Get the velocity of a satellite at a given time in ECI.
+   * @param i the index of the satellite in the file.
+   * @param t When (must be covered for satellite i).
+   * @return the satellite's velocity, in m/s, on TEME coordinate frame.
+   */
+  Vector3D GetVelocityInECI (uint32_t i, const JulianDate &t) const;
+
+  /// header of ephemeris files
+  struct Header {
+    uint64_t magic;                               //!< FileMagic.
+    uint32_t version;                             //!< FileVersion.
+    uint32_t satellites;                          //!< number of satellites.
+    uint32_t samples;                             //!< samples per satellite.
+    uint32_t reserved;                            //!< padding (zero).
+    uint64_t start;                               //!< first sample (POSIX ms).
+    int64_t step;                                 //!< step (ms).
+  };
+
+  /// entry of the satellite table
+  struct Entry {
+    uint32_t satnum;                              //!< satellite number.
+    uint32_t samples;                             //!< valid samples.
+    char name[32];                                //!< null-terminated name.
+  };
+
+  /// sample of a satellite
+  struct Sample {
+    double ritrf[3], vitrf[3];                    //!< ITRF (m, m/s).
+    double reci[3], veci[3];                      //!< TEME (m, m/s).
+  };
+
+private:
+  virtual void DoDispose (void);
+
+  /**
+   * @brief Locate the samples of a satellite around a given time.
+   * @param i the index of the satellite in the file.
+   * @param t When.
+   * @param s the normalized time within the segment, in [0, 1].
+   * @return a pointer to the sample at the start of the segment.
+   */
+  const Sample* Locate (uint32_t i, const JulianDate &t, double &s) const;
+
+  /**
+   * @brief Compute the size of a file.
+   * @param satellites the number of satellites.
+   * @param samples the number of samples per satellite.
+   * @return the size of the file in bytes.
+   */
+  static size_t GetFileSize (uint32_t satellites, uint32_t samples);
+
+  void *m_data;                                   //!< mapped file.
+  size_t m_size;                                  //!< size of the mapping.
+  const Header *m_header;                         //!< file header.
+  const Entry *m_entries;                         //!< satellite table.
+  const Sample *m_samples;                        //!< samples.
+  JulianDate m_start;                             //!< time of first sample.
+  double m_h;                                     //!< step (s).
+};
+
+}
+
+#endif /* EPHEMERIS_FILE_H */
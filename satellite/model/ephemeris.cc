@@ -0,0 +1,380 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 INESC TEC
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ephemeris.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+#include "ns3/assert.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("Ephemeris");
+
+// "NS3EPH01" in ASCII
+const uint64_t Ephemeris::FileMagic = 0x3130485045334e53ULL;
+
+namespace {
+
+/// fixed-size header of ephemeris files
+struct FileHeader {
+  uint64_t magic;                                 //!< Ephemeris::FileMagic.
+  uint32_t satnum;                                //!< satellite number.
+  uint32_t nodes;                                 //!< number of nodes.
+  uint64_t start;                                 //!< first node (POSIX ms).
+  int64_t step;                                   //!< node step (ms).
+  double epoch;                                   //!< TLE epoch.
+  double positionError;                           //!< position bound (m).
+  double velocityError;                           //!< velocity bound (m/s).
+};
+
+}
+
+Ephemeris::Ephemeris (void) :
+  m_h (0), m_satnum (0), m_epoch (0), m_positionError (0), m_velocityError (0)
+{
+}
+
+void
+Ephemeris::Reset (
+  const JulianDate &start, const Time &step, uint32_t satnum, double epoch
+)
+{
+  NS_LOG_FUNCTION (this << start << step << satnum << epoch);
+  NS_ASSERT_MSG (step.IsStrictlyPositive (), "Step must be positive!");
+
+  m_nodes.clear ();
+  m_start = start;
+  m_step = step;
+  m_h = step.GetSeconds ();
+  m_satnum = satnum;
+  m_epoch = epoch;
+  m_positionError = 0;
+  m_velocityError = 0;
+}
+
+void
+Ephemeris::Clear (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_nodes.clear ();
+}
+
+void
+Ephemeris::AddNode (
+  const Vector3D &ritrf, const Vector3D &vitrf,
+  const Vector3D &reci, const Vector3D &veci
+)
+{
+  Node node;
+
+  node.ritrf = ritrf;
+  node.vitrf = vitrf;
+  node.reci = reci;
+  node.veci = veci;
+
+  m_nodes.push_back (node);
+}
+
+void
+Ephemeris::SetErrorBounds (double position, double velocity)
+{
+  m_positionError = position;
+  m_velocityError = velocity;
+}
+
+bool
+Ephemeris::IsEmpty (void) const
+{
+  return (m_nodes.size () < 2);
+}
+
+bool
+Ephemeris::Covers (const JulianDate &t) const
+{
+  return (!IsEmpty () && t >= m_start && t <= GetStop ());
+}
+
+JulianDate
+Ephemeris::GetStart (void) const
+{
+  return m_start;
+}
+
+JulianDate
+Ephemeris::GetStop (void) const
+{
+  if (m_nodes.empty ())
+    return m_start;
+
+  return m_start + MilliSeconds (m_step.GetMilliSeconds ()*(m_nodes.size () - 1));
+}
+
+Time
+Ephemeris::GetStep (void) const
+{
+  return m_step;
+}
+
+uint32_t
+Ephemeris::GetNNodes (void) const
+{
+  return m_nodes.size ();
+}
+
+uint32_t
+Ephemeris::GetSatelliteNumber (void) const
+{
+  return m_satnum;
+}
+
+double
+Ephemeris::GetTleEpoch (void) const
+{
+  return m_epoch;
+}
+
+double
+Ephemeris::GetPositionErrorBound (void) const
+{
+  return m_positionError;
+}
+
+double
+Ephemeris::GetVelocityErrorBound (void) const
+{
+  return m_velocityError;
+}
+
+Vector3D
+Ephemeris::GetPosition (const JulianDate &t) const
+{
+  uint32_t i;
+  double s;
+
+  Locate (t, i, s);
+
+  const Node &n0 = m_nodes[i], &n1 = m_nodes[i+1];
+
+  return HermitePosition (n0.ritrf, n0.vitrf, n1.ritrf, n1.vitrf, s, m_h);
+}
+
+Vector3D
+Ephemeris::GetVelocity (const JulianDate &t) const
+{
+  uint32_t i;
+  double s;
+
+  Locate (t, i, s);
+
+  const Node &n0 = m_nodes[i], &n1 = m_nodes[i+1];
+
+  return HermiteVelocity (n0.ritrf, n0.vitrf, n1.ritrf, n1.vitrf, s, m_h);
+}
+
+Vector3D
+Ephemeris::GetPositionInECI (const JulianDate &t) const
+{
+  uint32_t i;
+  double s;
+
+  Locate (t, i, s);
+
+  const Node &n0 = m_nodes[i], &n1 = m_nodes[i+1];
+
+  return HermitePosition (n0.reci, n0.veci, n1.reci, n1.veci, s, m_h);
+}
+
+Vector3D
+Ephemeris::GetVelocityInECI (const JulianDate &t) const
+{
+  uint32_t i;
+  double s;
+
+  Locate (t, i, s);
+
+  const Node &n0 = m_nodes[i], &n1 = m_nodes[i+1];
+
+  return HermiteVelocity (n0.reci, n0.veci, n1.reci, n1.veci, s, m_h);
+}
+
+bool
+Ephemeris::Save (const std::string &filename) const
+{
+  NS_LOG_FUNCTION (this << filename);
+
+  std::ofstream f (filename.c_str (), std::ios::out | std::ios::binary);
+
+  if (!f.is_open ())
+    {
+      NS_LOG_WARN ("Unable to open " << filename << " for writing");
+      return false;
+    }
+
+  FileHeader header;
+
+  header.magic = FileMagic;
+  header.satnum = m_satnum;
+  header.nodes = m_nodes.size ();
+  header.start = m_start.GetPosixMilliseconds ();
+  header.step = m_step.GetMilliSeconds ();
+  header.epoch = m_epoch;
+  header.positionError = m_positionError;
+  header.velocityError = m_velocityError;
+
+  f.write (reinterpret_cast<const char *> (&header), sizeof (header));
+
+  if (!m_nodes.empty ())
+    f.write (
+      reinterpret_cast<const char *> (&m_nodes[0]),
+      m_nodes.size ()*sizeof (Node)
+    );
+
+  return f.good ();
+}
+
+bool
+Ephemeris::Load (const std::string &filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+
+  std::ifstream f (filename.c_str (), std::ios::in | std::ios::binary);
+  FileHeader header;
+
+  m_nodes.clear ();
+
+  if (!f.is_open ())
+    {
+      NS_LOG_WARN ("Unable to open " << filename << " for reading");
+      return false;
+    }
+
+  f.read (reinterpret_cast<char *> (&header), sizeof (header));
+
+  if (!f.good () || header.magic != FileMagic || header.step <= 0)
+    {
+      NS_LOG_WARN (filename << " is not a valid ephemeris file");
+      return false;
+    }
+
+  const uint64_t days = header.start/JulianDate::DayToMs;
+  const uint64_t ms_day = header.start%JulianDate::DayToMs;
+
+  Reset (
+    JulianDate (static_cast<uint32_t> (days), static_cast<uint32_t> (ms_day)),
+    MilliSeconds (header.step), header.satnum, header.epoch
+  );
+  SetErrorBounds (header.positionError, header.velocityError);
+
+  m_nodes.resize (header.nodes);
+
+  if (header.nodes > 0)
+    f.read (
+      reinterpret_cast<char *> (&m_nodes[0]), header.nodes*sizeof (Node)
+    );
+
+  if (!f.good ())
+    {
+      NS_LOG_WARN (filename << " is truncated");
+      m_nodes.clear ();
+      return false;
+    }
+
+  return true;
+}
+
+void
+Ephemeris::ComputeErrorBounds (
+  const Time &step, double a, double e, double n,
+  double &position, double &velocity
+)
+{
+  const double h = step.GetSeconds ();
+  const double omegaEarth = 7.2921151467064e-5;   // rad/s
+
+  // angular velocity at perigee and radius at apogee
+  const double w = n*(1 + e)*(1 + e)/pow (1 - e*e, 1.5) + omegaEarth;
+  const double r = a*(1 + e);
+  const double f4 = r*w*w*w*w;
+
+  // the bounds hold for each coordinate, hence the sqrt(3) factor for the
+  // length of the error vector
+  position = sqrt (3.0)*h*h*h*h/384*f4;
+  velocity = 3.0/216*h*h*h*f4;
+}
+
+void
+Ephemeris::Locate (const JulianDate &t, uint32_t &i, double &s) const
+{
+  NS_ASSERT_MSG (Covers (t), "Time " << t << " is not covered!");
+
+  const double dt = (t - m_start).GetSeconds ();
+  const uint32_t last = m_nodes.size () - 2;
+
+  i = std::min (static_cast<uint32_t> (dt/m_h), last);
+  s = dt/m_h - i;
+}
+
+Vector3D
+Ephemeris::HermitePosition (
+  const Vector3D &r0, const Vector3D &v0,
+  const Vector3D &r1, const Vector3D &v1, double s, double h
+)
+{
+  const double s2 = s*s, s3 = s2*s;
+
+  // cubic Hermite basis functions (velocities scaled by the step)
+  const double h00 = 2*s3 - 3*s2 + 1;
+  const double h10 = (s3 - 2*s2 + s)*h;
+  const double h01 = -2*s3 + 3*s2;
+  const double h11 = (s3 - s2)*h;
+
+  return Vector3D (
+    h00*r0.x + h10*v0.x + h01*r1.x + h11*v1.x,
+    h00*r0.y + h10*v0.y + h01*r1.y + h11*v1.y,
+    h00*r0.z + h10*v0.z + h01*r1.z + h11*v1.z
+  );
+}
+
+Vector3D
+Ephemeris::HermiteVelocity (
+  const Vector3D &r0, const Vector3D &v0,
+  const Vector3D &r1, const Vector3D &v1, double s, double h
+)
+{
+  const double s2 = s*s;
+
+  // derivatives of the cubic Hermite basis functions with respect to time
+  const double d00 = (6*s2 - 6*s)/h;
+  const double d10 = 3*s2 - 4*s + 1;
+  const double d01 = (-6*s2 + 6*s)/h;
+  const double d11 = 3*s2 - 2*s;
+
+  return Vector3D (
+    d00*r0.x + d10*v0.x + d01*r1.x + d11*v1.x,
+    d00*r0.y + d10*v0.y + d01*r1.y + d11*v1.y,
+    d00*r0.z + d10*v0.z + d01*r1.z + d11*v1.z
+  );
+}
+
+}
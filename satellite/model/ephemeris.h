@@ -0,0 +1,288 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 INESC TEC
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef EPHEMERIS_H
+#define EPHEMERIS_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "ns3/nstime.h"
+#include "ns3/vector.h"
+
+#include "julian-date.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup satellite
+ * @brief Piecewise cubic Hermite ephemeris of a satellite.
+ *
+ * The ephemeris holds position and velocity samples (nodes), in both ITRF and
+ * ECI (TEME) frames, taken at a fixed step over a time interval. Between two
+ * consecutive nodes, each coordinate is interpolated by the cubic Hermite
+ * polynomial matching the positions and velocities at both ends, and the
+ * velocity by its derivative. Each evaluation is thus a handful of multiply
+ * and add operations, as opposed to a full SGP4/SDP4 run and frame conversion.
+ *
+ * For a step h, the interpolation error of a coordinate f is bounded by
+ * h^4/384*max|f''''| for the position and by sqrt(3)/216*h^3*max|f''''| for
+ * the velocity. For a circular orbit, max|f''''| is at most r*w^4, where r is
+ * the orbit radius and w the angular velocity of the satellite plus that of
+ * the Earth (for ITRF coordinates). For eccentric orbits, the bounds use the
+ * apogee radius and the perigee angular velocity, which makes them an estimate
+ * rather than a strict bound. The bounds of each ephemeris, given by
+ * GetPositionErrorBound and GetVelocityErrorBound, refer to the length of the
+ * error vector and are thus sqrt(3) times the coordinate bounds. For LEO
+ * satellites, a 60 s step yields errors of about 1 m and 5 cm/s, and a 20 s
+ * step of about 1 cm and 2 mm/s, well below the accuracy of SGP4/SDP4 itself.
+ * Note that the velocities output by SGP4/SDP4 are not exactly the derivative
+ * of its positions, especially far from the TLE epoch (where they may differ
+ * by about 1 m/s), and that interpolated values between nodes can be off by as
+ * much.
+ *
+ * Ephemerides can be saved to and loaded from binary files (in the host's
+ * byte order), which identify the satellite number and TLE epoch they were
+ * generated from. Each node takes 96 bytes of memory and disk.
+ */
+class Ephemeris {
+public:
+  /// Magic number identifying ephemeris files.
+  static const uint64_t FileMagic;
+
+  /**
+   * @brief Default constructor (empty ephemeris).
+   */
+  Ephemeris (void);
+
+  /**
+   * @brief Discard all nodes and set the sampling parameters.
+   * @param start the time of the first node.
+   * @param step the time between consecutive nodes.
+   * @param satnum the number of the satellite.
+   * @param epoch the Julian date of the TLE epoch.
+   */
+  void Reset (
+    const JulianDate &start, const Time &step, uint32_t satnum, double epoch
+  );
+
+  /**
+   * @brief Discard all nodes.
+   */
+  void Clear (void);
+
+  /**
+   * @brief Append a node to the ephemeris.
+   * @param ritrf the position, in meters, on ITRF coordinate frame.
+   * @param vitrf the velocity, in m/s, on ITRF coordinate frame.
+   * @param reci the position, in meters, on TEME coordinate frame.
+   * @param veci the velocity, in m/s, on TEME coordinate frame.
+   */
+  void AddNode (
+    const Vector3D &ritrf, const Vector3D &vitrf,
+    const Vector3D &reci, const Vector3D &veci
+  );
+
+  /**
+   * @brief Set the interpolation error bounds.
+   * @param position the position error bound (m).
+   * @param velocity the velocity error bound (m/s).
+   */
+  void SetErrorBounds (double position, double velocity);
+
+  /**
+   * @brief Check if the ephemeris has at least one segment.
+   * @return a boolean indicating whether the ephemeris is empty.
+   */
+  bool IsEmpty (void) const;
+
+  /**
+   * @brief Check if the ephemeris can be evaluated at a given time.
+   * @param t When.
+   * @return a boolean indicating whether t is within the ephemeris interval.
+   */
+  bool Covers (const JulianDate &t) const;
+
+  /**
+   * @brief Get the time of the first node.
+   * @return the start of the ephemeris interval.
+   */
+  JulianDate GetStart (void) const;
+
+  /**
+   * @brief Get the time of the last node.
+   * @return the end of the ephemeris interval.
+   */
+  JulianDate GetStop (void) const;
+
+  /**
+   * @brief Get the time between consecutive nodes.
+   * @return the sampling step.
+   */
+  Time GetStep (void) const;
+
+  /**
+   * @brief Get the number of nodes.
+   * @return the number of nodes.
+   */
+  uint32_t GetNNodes (void) const;
+
+  /**
+   * @brief Get the number of the satellite the ephemeris refers to.
+   * @return the satellite's number (NORAD ID).
+   */
+  uint32_t GetSatelliteNumber (void) const;
+
+  /**
+   * @brief Get the TLE epoch the ephemeris was generated from.
+   * @return the Julian date of the TLE epoch.
+   */
+  double GetTleEpoch (void) const;
+
+  /**
+   * @brief Get the bound of the position interpolation error.
+   * @return the position error bound (m).
+   */
+  double GetPositionErrorBound (void) const;
+
+  /**
+   * @brief Get the bound of the velocity interpolation error.
+   * @return the velocity error bound (m/s).
+   */
+  double GetVelocityErrorBound (void) const;
+
+  /**
+   * @brief Interpolate the position at a given time.
+   * @param t When (must be covered by the ephemeris).
+   * @return the position, in meters, on ITRF coordinate frame.
+   */
+  Vector3D GetPosition (const JulianDate &t) const;
+
+  /**
+   * @brief Interpolate the velocity at a given time.
+   * @param t When (must be covered by the ephemeris).
+   * @return the velocity, in m/s, on ITRF coordinate frame.
+   */
+  Vector3D GetVelocity (const JulianDate &t) const;
+
+  /**
+   * @brief Interpolate the position at a given time in ECI.
+   * @param t When (must be covered by the ephemeris).
+   * @return the position, in meters, on TEME coordinate frame.
+   */
+  Vector3D GetPositionInECI (const JulianDate &t) const;
+
+  /**
+   * @brief Interpolate the velocity at a given time in ECI.
+   * @param t When (must be covered by the ephemeris).
+   * @return the velocity, in m/s, on TEME coordinate frame.
+   */
+  Vector3D GetVelocityInECI (const JulianDate &t) const;
+
+  /**
+   * @brief Save the ephemeris to a binary file.
+   * @param filename the name of the file.
+   * @return a boolean indicating whether the file was written.
+   */
+  bool Save (const std::string &filename) const;
+
+  /**
+   * @brief Load the ephemeris from a binary file.
+   *
+   * The ephemeris is left empty if the file cannot be read or is not valid.
+   *
+   * @param filename the name of the file.
+   * @return a boolean indicating whether the file was read.
+   */
+  bool Load (const std::string &filename);
+
+  /**
+   * @brief Compute the interpolation error bounds for a Keplerian orbit.
+   * @param step the time between consecutive nodes.
+   * @param a the semi-major axis (m).
+   * @param e the eccentricity.
+   * @param n the mean motion (rad/s).
+   * @param position the position error bound (m).
+   * @param velocity the velocity error bound (m/s).
+   */
+  static void ComputeErrorBounds (
+    const Time &step, double a, double e, double n,
+    double &position, double &velocity
+  );
+
+  /**
+   * @brief Evaluate the cubic Hermite polynomial of a segment.
+   * @param r0 the position at the start of the segment.
+   * @param v0 the velocity at the start of the segment.
+   * @param r1 the position at the end of the segment.
+   * @param v1 the velocity at the end of the segment.
+   * @param s the normalized time within the segment, in [0, 1].
+   * @param h the duration of the segment (s).
+   * @return the interpolated position.
+   */
+  static Vector3D HermitePosition (
+    const Vector3D &r0, const Vector3D &v0,
+    const Vector3D &r1, const Vector3D &v1, double s, double h
+  );
+
+  /**
+   * @brief Evaluate the derivative of the cubic Hermite polynomial of a
+   *        segment.
+   * @param r0 the position at the start of the segment.
+   * @param v0 the velocity at the start of the segment.
+   * @param r1 the position at the end of the segment.
+   * @param v1 the velocity at the end of the segment.
+   * @param s the normalized time within the segment, in [0, 1].
+   * @param h the duration of the segment (s).
+   * @return the interpolated velocity.
+   */
+  static Vector3D HermiteVelocity (
+    const Vector3D &r0, const Vector3D &v0,
+    const Vector3D &r1, const Vector3D &v1, double s, double h
+  );
+
+private:
+  /// node data
+  struct Node {
+    Vector3D ritrf, vitrf;                        //!< ITRF (m, m/s).
+    Vector3D reci, veci;                          //!< TEME (m, m/s).
+  };
+
+  /**
+   * @brief Locate the segment of a given time.
+   * @param t When.
+   * @param i the index of the first node of the segment.
+   * @param s the normalized time within the segment, in [0, 1].
+   */
+  void Locate (const JulianDate &t, uint32_t &i, double &s) const;
+
+  JulianDate m_start;                             //!< time of first node.
+  Time m_step;                                    //!< time between nodes.
+  double m_h;                                     //!< time between nodes (s).
+  uint32_t m_satnum;                              //!< satellite number.
+  double m_epoch;                                 //!< TLE epoch.
+  double m_positionError;                         //!< position bound (m).
+  double m_velocityError;                         //!< velocity bound (m/s).
+  std::vector<Node> m_nodes;                      //!< nodes.
+};
+
+}
+
+#endif /* EPHEMERIS_H */
@@ -0,0 +1,269 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 INESC TEC
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "frame-transform.h"
+
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include "ns3/log.h"
+#include "ns3/vector.h"
+
+#include "vector-extensions.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("FrameTransform");
+
+const uint32_t FrameTransform::CacheSize = 64;
+
+namespace {
+
+/// entry of the transformation cache
+struct CacheEntry {
+  bool valid;                                     //!< whether it is set.
+  uint64_t key;                                   //!< time instant key.
+  FrameTransform transform;                       //!< cached transformation.
+
+  CacheEntry (void) : valid (false), key (0) { }
+};
+
+/// process-wide transformation cache and its statistics
+struct Cache {
+  std::vector<CacheEntry> entries;                //!< direct-mapped entries.
+  uint64_t hits;                                  //!< lookups found.
+  uint64_t misses;                                //!< lookups computed.
+
+  Cache (void) : entries (FrameTransform::CacheSize), hits (0), misses (0) { }
+};
+
+/// construct on first use, so that it is available during static
+/// initialization of other translation units
+Cache&
+GetCache (void)
+{
+  static Cache cache;
+
+  return cache;
+}
+
+}
+
+FrameTransform::FrameTransform (void) :
+  m_pmt (1, 0, 0, 0, 1, 0, 0, 0, 1),
+  m_tmt (1, 0, 0, 0, 1, 0, 0, 0, 1),
+  m_omega (0)
+{
+}
+
+FrameTransform
+FrameTransform::Compute (const JulianDate &t)
+{
+  NS_LOG_FUNCTION (t);
+
+  FrameTransform ft;
+  std::pair<double, double> eop = t.GetPolarMotion ();
+
+  const double &xp = eop.first, &yp = eop.second;
+  const double cosxp = cos (xp), cosyp = cos (yp);
+  const double sinxp = sin (xp), sinyp = sin (yp);
+
+  // [from AIAA-2006-6753 Report, Page 32, Appendix C - TEME Coordinate System]
+  //
+  // Matrix(ITRF<->PEF) = ROT1(yp)*ROT2(xp) [using c for cos, and s for sin]
+  //
+  // | 1    0     0   |*| c(xp) 0 -s(xp) |=|    c(xp)       0      -s(xp)   |
+  // | 0  c(yp) s(yp) | |   0   1    0   | | s(yp)*s(xp)  c(yp) s(yp)*c(xp) |
+  // | 0 -s(yp) c(yp) | | s(xp) 0  c(xp) | | c(yp)*s(xp) -s(yp) c(yp)*c(xp) |
+  //
+
+  // we keep the transpose because it is what's needed
+  ft.m_pmt = Matrix(
+     cosxp, sinyp*sinxp, cosyp*sinxp,
+       0,      cosyp,      -sinyp,
+    -sinxp, sinyp*cosxp, cosyp*cosxp
+  );
+
+  const double gmst = t.GetGmst ();
+  const double cosg = cos (gmst), sing = sin (gmst);
+
+  // [from AIAA-2006-6753 Report, Page 32, Appendix C - TEME Coordinate System]
+  //
+  // rPEF = ROT3(gmst)*rTEME
+  //
+  // |  cos(gmst) sin(gmst) 0 |
+  // | -sin(gmst) cos(gmst) 0 |
+  // |      0         0     1 |
+  //
+
+  ft.m_tmt = Matrix(
+     cosg, sing, 0,
+    -sing, cosg, 0,
+       0,    0,  1
+  );
+
+  ft.m_omega = t.GetOmegaEarth ();
+  ft.m_time = t;
+
+  return ft;
+}
+
+FrameTransform
+FrameTransform::Get (const JulianDate &t)
+{
+  Cache &cache = GetCache ();
+  const uint64_t key = t.GetPosixMilliseconds ();
+
+  // simulation time usually advances in steps of whole milliseconds, so the
+  // low-order bits are the ones that tell consecutive instants apart
+  CacheEntry &entry = cache.entries[key % CacheSize];
+
+  if (entry.valid && entry.key == key)
+    {
+      ++cache.hits;
+      return entry.transform;
+    }
+
+  ++cache.misses;
+
+  entry.transform = Compute (t);
+  entry.key = key;
+  entry.valid = true;
+
+  return entry.transform;
+}
+
+uint64_t
+FrameTransform::GetCacheHits (void)
+{
+  return GetCache ().hits;
+}
+
+uint64_t
+FrameTransform::GetCacheMisses (void)
+{
+  return GetCache ().misses;
+}
+
+void
+FrameTransform::ClearCache (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+
+  Cache &cache = GetCache ();
+
+  for (uint32_t i = 0; i < cache.entries.size (); ++i)
+    cache.entries[i].valid = false;
+
+  cache.hits = 0;
+  cache.misses = 0;
+}
+
+JulianDate
+FrameTransform::GetTime (void) const
+{
+  return m_time;
+}
+
+const FrameTransform::Matrix&
+FrameTransform::GetPefToItrf (void) const
+{
+  return m_pmt;
+}
+
+const FrameTransform::Matrix&
+FrameTransform::GetTemeToPef (void) const
+{
+  return m_tmt;
+}
+
+double
+FrameTransform::GetOmegaEarth (void) const
+{
+  return m_omega;
+}
+
+Vector3D
+FrameTransform::rTemeTorItrf (const Vector3D &rteme) const
+{
+  return m_pmt*(m_tmt*rteme);
+}
+
+Vector3D
+FrameTransform::rvTemeTovItrf (
+  const Vector3D &rteme, const Vector3D &vteme
+) const
+{
+  Vector3D w (0.0, 0.0, m_omega);
+
+  return m_pmt*((m_tmt*vteme) - CrossProduct (w, m_tmt*rteme));
+}
+
+void
+FrameTransform::TemeToItrf (
+  const Vector3D &rteme, const Vector3D &vteme,
+  Vector3D &ritrf, Vector3D &vitrf
+) const
+{
+  const Vector3D w (0.0, 0.0, m_omega);
+  const Vector3D rpef = m_tmt*rteme;
+
+  ritrf = m_pmt*rpef;
+  vitrf = m_pmt*((m_tmt*vteme) - CrossProduct (w, rpef));
+}
+
+FrameTransform::Matrix::Matrix (
+  double c00, double c01, double c02,
+  double c10, double c11, double c12,
+  double c20, double c21, double c22
+)
+{
+  m[0][0] = c00;
+  m[0][1] = c01;
+  m[0][2] = c02;
+  m[1][0] = c10;
+  m[1][1] = c11;
+  m[1][2] = c12;
+  m[2][0] = c20;
+  m[2][1] = c21;
+  m[2][2] = c22;
+}
+
+Vector3D
+FrameTransform::Matrix::operator* (const Vector3D& v) const
+{
+  return Vector3D (
+    m[0][0]*v.x + m[0][1]*v.y + m[0][2]*v.z,
+    m[1][0]*v.x + m[1][1]*v.y + m[1][2]*v.z,
+    m[2][0]*v.x + m[2][1]*v.y + m[2][2]*v.z
+  );
+}
+
+FrameTransform::Matrix
+FrameTransform::Matrix::Transpose (void) const
+{
+  return Matrix(
+    m[0][0], m[1][0], m[2][0],
+    m[0][1], m[1][1], m[2][1],
+    m[0][2], m[1][2], m[2][2]
+  );
+}
+
+}
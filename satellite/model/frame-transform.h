@@ -0,0 +1,186 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 INESC TEC
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef FRAME_TRANSFORM_H
+#define FRAME_TRANSFORM_H
+
+#include <stdint.h>
+
+#include "ns3/vector.h"
+
+#include "julian-date.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup satellite
+ * @brief TEME to ITRF coordinate frame transformation at a given time.
+ *
+ * The transformation from TEME (true equator, mean equinox) to ITRF depends
+ * only on the time instant: a rotation by the Greenwich Mean Sidereal Time
+ * (TEME->PEF), a rotation by the polar motion coefficients (PEF->ITRF), and
+ * the Earth's angular velocity for velocity vectors. Obtaining these requires
+ * the DUT1 and EOP lookups performed by JulianDate and four trigonometric
+ * calls, and the result is the same for every object in the simulation.
+ *
+ * Get () keeps the transformations of the last distinct time instants in a
+ * process-wide, direct-mapped cache keyed by JulianDate, so that every
+ * satellite and ground station requesting its position at the same simulation
+ * time shares one computation. The cache is not thread-safe (as is the case of
+ * the simulator itself); code running outside the simulation thread should use
+ * Compute () instead, which has no side effects.
+ */
+class FrameTransform {
+public:
+  /// row of a Matrix
+  struct Row {
+    double r[3];
+
+    double& operator[] (uint32_t i) { return r[i]; }
+    const double& operator[] (uint32_t i) const { return r[i]; }
+  };
+
+  /// Matrix data structure to make coordinate conversion code clearer and
+  /// less verbose
+  struct Matrix {
+  public:
+    Matrix (void) { }
+    Matrix (
+      double c00, double c01, double c02,
+      double c10, double c11, double c12,
+      double c20, double c21, double c22
+    );
+
+    Row& operator[] (uint32_t i) { return m[i]; }
+    const Row& operator[] (uint32_t i) const { return m[i]; }
+
+    Vector3D operator* (const Vector3D &v) const;
+
+    Matrix Transpose (void) const;
+
+  private:
+    Row m[3];
+  };
+
+  /// Number of time instants kept by the cache.
+  static const uint32_t CacheSize;
+
+  /**
+   * @brief Default constructor (identity transformation).
+   */
+  FrameTransform (void);
+
+  /**
+   * @brief Compute the transformation at a given time, bypassing the cache.
+   * @param t When.
+   * @return the TEME-ITRF transformation at time t.
+   */
+  static FrameTransform Compute (const JulianDate &t);
+
+  /**
+   * @brief Retrieve the transformation at a given time from the cache,
+   *        computing it only if it is not there.
+   * @param t When.
+   * @return the TEME-ITRF transformation at time t.
+   */
+  static FrameTransform Get (const JulianDate &t);
+
+  /**
+   * @brief Get the number of cache lookups that found the time instant.
+   * @return the number of cache hits.
+   */
+  static uint64_t GetCacheHits (void);
+
+  /**
+   * @brief Get the number of cache lookups that had to compute the
+   *        transformation.
+   * @return the number of cache misses.
+   */
+  static uint64_t GetCacheMisses (void);
+
+  /**
+   * @brief Empty the cache and reset the hit/miss counters.
+   */
+  static void ClearCache (void);
+
+  /**
+   * @brief Get the time instant of the transformation.
+   * @return the time instant.
+   */
+  JulianDate GetTime (void) const;
+
+  /**
+   * @brief Retrieve the matrix for converting from PEF to ITRF.
+   * @return the PEF-ITRF conversion matrix (transposed).
+   */
+  const Matrix& GetPefToItrf (void) const;
+
+  /**
+   * @brief Retrieve the matrix for converting from TEME to PEF.
+   * @return the TEME-PEF conversion matrix.
+   */
+  const Matrix& GetTemeToPef (void) const;
+
+  /**
+   * @brief Retrieve the Earth's angular velocity.
+   * @return the Earth's angular velocity (rad/s).
+   */
+  double GetOmegaEarth (void) const;
+
+  /**
+   * @brief Convert a position vector from TEME to ITRF coordinates.
+   * @param rteme the position vector in TEME coordinates.
+   * @return the position vector in ITRF coordinates (same units as rteme).
+   */
+  Vector3D rTemeTorItrf (const Vector3D &rteme) const;
+
+  /**
+   * @brief Convert a velocity vector from TEME to ITRF coordinates.
+   * @param rteme the position vector in TEME coordinates (km).
+   * @param vteme the velocity vector in TEME coordinates (km/s).
+   * @return the velocity vector in ITRF coordinates (km/s).
+   */
+  Vector3D rvTemeTovItrf (const Vector3D &rteme, const Vector3D &vteme) const;
+
+  /**
+   * @brief Convert a state vector from TEME to ITRF coordinates.
+   *
+   * Equivalent to calling rTemeTorItrf and rvTemeTovItrf, but rotating the
+   * position vector into PEF only once.
+   *
+   * @param rteme the position vector in TEME coordinates (km).
+   * @param vteme the velocity vector in TEME coordinates (km/s).
+   * @param ritrf the position vector in ITRF coordinates (km).
+   * @param vitrf the velocity vector in ITRF coordinates (km/s).
+   */
+  void TemeToItrf (
+    const Vector3D &rteme, const Vector3D &vteme,
+    Vector3D &ritrf, Vector3D &vitrf
+  ) const;
+
+private:
+  JulianDate m_time;                              //!< time instant.
+  Matrix m_pmt;                                   //!< PEF->ITRF (transposed).
+  Matrix m_tmt;                                   //!< TEME->PEF.
+  double m_omega;                                 //!< Earth's angular velocity.
+};
+
+}
+
+#endif /* FRAME_TRANSFORM_H */
@@ -209,6 +209,12 @@ JulianDate::GetGmst (void) const
   //return (gmst < 0 ? gmst+2*M_PI : gmst);
 }
 
+uint64_t
+JulianDate::GetPosixMilliseconds (void) const
+{
+  return static_cast<uint64_t> (m_days)*DayToMs + m_ms_day;
+}
+
 void
 JulianDate::SetDate (double jd)
 {
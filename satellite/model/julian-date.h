@@ -174,6 +174,17 @@ public:
    */
   double GetGmst (void) const;
 
+  /**
+   * @brief Get the time elapsed since the Unix/POSIX epoch.
+   *
+   * The value identifies the Julian date uniquely (up to its millisecond
+   * resolution) regardless of the time system used to set it, and is thus
+   * suitable as a key for caching time dependent values.
+   *
+   * @return the milliseconds since 1 January 1970, 0h.
+   */
+  uint64_t GetPosixMilliseconds (void) const;
+
   /**
    * @brief Set the Julian days.
    *
@@ -22,6 +22,7 @@
 
 #include "satellite-position-helper.h"
 
+#include "ns3/assert.h"
 #include "ns3/simulator.h"
 #include "ns3/nstime.h"
 
@@ -29,12 +30,14 @@ namespace ns3 {
 
 ATTRIBUTE_HELPER_CPP (SatellitePositionHelper);
 
-SatellitePositionHelper::SatellitePositionHelper (void)
+SatellitePositionHelper::SatellitePositionHelper (void) :
+  m_index (0), m_fileIndex (0)
 {
   SetStartTime (JulianDate ());
 }
 
-SatellitePositionHelper::SatellitePositionHelper (Ptr<Satellite> sat)
+SatellitePositionHelper::SatellitePositionHelper (Ptr<Satellite> sat) :
+  m_index (0), m_fileIndex (0)
 {
   SetSatellite (sat);
   SetStartTime (sat->GetTleEpoch ());
@@ -42,7 +45,8 @@ SatellitePositionHelper::SatellitePositionHelper (Ptr<Satellite> sat)
 
 SatellitePositionHelper::SatellitePositionHelper(
   Ptr<Satellite> sat, const JulianDate &t
-)
+) :
+  m_index (0), m_fileIndex (0)
 {
   SetSatellite (sat);
   SetStartTime (t);
@@ -51,22 +55,32 @@ SatellitePositionHelper::SatellitePositionHelper(
 Vector3D
 SatellitePositionHelper::GetPosition (void) const
 {
+  JulianDate cur = m_start + Simulator::Now ();
+
+  if (m_file && m_file->Covers (m_fileIndex, cur))
+    return m_file->GetPosition (m_fileIndex, cur);
+
   if (!m_sat)
     return Vector3D (0,0,0);
 
-  JulianDate cur = m_start + Simulator::Now ();
-
+  if (m_propagator)
+    return m_propagator->GetPosition (m_index, cur);
 
   return m_sat->GetPosition (cur);
 }
 
 Vector3D
 SatellitePositionHelper::GetPositionInECI (void) const{
+	JulianDate cur = m_start + Simulator::Now ();
+
+	if (m_file && m_file->Covers (m_fileIndex, cur))
+		return m_file->GetPositionInECI (m_fileIndex, cur);
+
 	if (!m_sat)
 		return Vector3D (0,0,0);
 
-	JulianDate cur = m_start + Simulator::Now ();
-
+	if (m_propagator)
+		return m_propagator->GetPositionInECI (m_index, cur);
 
 	return m_sat->GetPositionInECI (cur);
 }
@@ -74,10 +88,16 @@ SatellitePositionHelper::GetPositionInECI (void) const{
 Vector3D
 SatellitePositionHelper::GetVelocity (void) const
 {
+  JulianDate cur = m_start + Simulator::Now ();
+
+  if (m_file && m_file->Covers (m_fileIndex, cur))
+    return m_file->GetVelocity (m_fileIndex, cur);
+
   if (!m_sat)
     return Vector3D (0,0,0);
 
-  JulianDate cur = m_start + Simulator::Now ();
+  if (m_propagator)
+    return m_propagator->GetVelocity (m_index, cur);
 
   return m_sat->GetVelocity (cur);
 }
@@ -85,10 +105,16 @@ SatellitePositionHelper::GetVelocity (void) const
 Vector3D
 SatellitePositionHelper::GetVelocityInECI (void) const
 {
+  JulianDate cur = m_start + Simulator::Now ();
+
+  if (m_file && m_file->Covers (m_fileIndex, cur))
+    return m_file->GetVelocityInECI (m_fileIndex, cur);
+
   if (!m_sat)
     return Vector3D (0,0,0);
 
-  JulianDate cur = m_start + Simulator::Now ();
+  if (m_propagator)
+    return m_propagator->GetVelocityInECI (m_index, cur);
 
   return m_sat->GetVelocityInECI (cur);
 }
@@ -99,6 +125,24 @@ SatellitePositionHelper::GetSatellite (void) const
   return m_sat;
 }
 
+Ptr<ConstellationPropagator>
+SatellitePositionHelper::GetPropagator (void) const
+{
+  return m_propagator;
+}
+
+Ptr<EphemerisFile>
+SatellitePositionHelper::GetEphemerisFile (void) const
+{
+  return m_file;
+}
+
+uint32_t
+SatellitePositionHelper::GetEphemerisFileIndex (void) const
+{
+  return m_fileIndex;
+}
+
 JulianDate
 SatellitePositionHelper::GetStartTime (void) const
 {
@@ -108,13 +152,41 @@ SatellitePositionHelper::GetStartTime (void) const
 std::string
 SatellitePositionHelper::GetSatelliteName (void) const
 {
-  return (!m_sat ? m_sat->GetName () : "");
+  if (m_sat)
+    return m_sat->GetName ();
+
+  if (m_file)
+    return m_file->GetSatelliteName (m_fileIndex);
+
+  return "";
 }
 
 void
 SatellitePositionHelper::SetSatellite (Ptr<Satellite> sat)
 {
   m_sat = sat;
+
+  if (m_propagator && m_sat)
+    m_index = m_propagator->AddSatellite (m_sat);
+}
+
+void
+SatellitePositionHelper::SetPropagator (Ptr<ConstellationPropagator> prop)
+{
+  m_propagator = prop;
+  m_index = 0;
+
+  if (m_propagator && m_sat)
+    m_index = m_propagator->AddSatellite (m_sat);
+}
+
+void
+SatellitePositionHelper::SetEphemerisFile (Ptr<EphemerisFile> file, uint32_t index)
+{
+  NS_ASSERT_MSG (!file || index < file->GetNSatellites (), "Invalid index!");
+
+  m_file = file;
+  m_fileIndex = index;
 }
 
 void
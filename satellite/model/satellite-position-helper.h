@@ -29,6 +29,8 @@
 #include "ns3/attribute-helper.h"
 
 #include "ns3/satellite.h"
+#include "ns3/constellation-propagator.h"
+#include "ns3/ephemeris-file.h"
 
 namespace ns3 {
 
@@ -95,6 +97,24 @@ public:
    */
   Ptr<Satellite> GetSatellite (void) const;
 
+  /**
+   * @brief Get the constellation propagator serving this satellite, if any.
+   * @return the constellation propagator or a null pointer if none is set.
+   */
+  Ptr<ConstellationPropagator> GetPropagator (void) const;
+
+  /**
+   * @brief Get the ephemeris file serving this satellite, if any.
+   * @return the ephemeris file or a null pointer if none is set.
+   */
+  Ptr<EphemerisFile> GetEphemerisFile (void) const;
+
+  /**
+   * @brief Get the index of this satellite in the ephemeris file.
+   * @return the index of the satellite in the ephemeris file.
+   */
+  uint32_t GetEphemerisFileIndex (void) const;
+
   /**
    * @brief Get the time set to be considered as simulation's start time.
    * @return the absolute time set to be considered as simulation's start time.
@@ -107,6 +127,29 @@ public:
    */
   void SetSatellite (Ptr<Satellite> sat);
 
+  /**
+   * @brief Serve position and velocity from a constellation propagator.
+   *
+   * The satellite is added to the propagator (if not there already) and all
+   * subsequent queries are answered from the propagator's table instead of
+   * running SGP4/SDP4 for this satellite alone.
+   *
+   * @param prop constellation propagator (a null pointer disables it).
+   */
+  void SetPropagator (Ptr<ConstellationPropagator> prop);
+
+  /**
+   * @brief Serve position and velocity from a (memory-mapped) ephemeris file.
+   *
+   * Queries at instants covered by the file are interpolated from its samples
+   * and take precedence over the propagator and the satellite object, which
+   * need not be set at all.
+   *
+   * @param file ephemeris file (a null pointer disables it).
+   * @param index the index of the satellite in the file.
+   */
+  void SetEphemerisFile (Ptr<EphemerisFile> file, uint32_t index);
+
   /**
    * @brief Set simulation's absolute start time.
    * @param t time instant to be consider as simulation's start.
@@ -116,6 +159,10 @@ public:
 private:
   Ptr<Satellite> m_sat;               //!< pointer to the Satellite object.
   JulianDate m_start;                         //!< simulation's absolute start time.
+  Ptr<ConstellationPropagator> m_propagator;  //!< constellation propagator.
+  uint32_t m_index;                           //!< index on the propagator.
+  Ptr<EphemerisFile> m_file;                  //!< ephemeris file.
+  uint32_t m_fileIndex;                       //!< index on the file.
 };
 
 /**
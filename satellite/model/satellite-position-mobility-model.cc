@@ -26,7 +26,9 @@
 #include "ns3/mobility-model.h"
 #include "ns3/ptr.h"
 #include "ns3/satellite.h"
+#include "ns3/simulator.h"
 #include "ns3/type-id.h"
+#include "ns3/vector-extensions.h"
 
 #define pi 3.14159265358979323846
 
@@ -52,7 +54,11 @@ SatellitePositionMobilityModel::GetTypeId (void) {
   return tid;
 }
 
-SatellitePositionMobilityModel::SatellitePositionMobilityModel (void) { }
+SatellitePositionMobilityModel::SatellitePositionMobilityModel (void) :
+  m_ticked (false), m_extrapolate (true)
+{
+}
+
 SatellitePositionMobilityModel::~SatellitePositionMobilityModel (void) { }
 
 std::string
@@ -85,19 +91,84 @@ SatellitePositionMobilityModel::SetStartTime (const JulianDate &t)
   m_helper.SetStartTime (t);
 }
 
+Ptr<ConstellationPropagator>
+SatellitePositionMobilityModel::GetPropagator (void) const
+{
+  return m_helper.GetPropagator ();
+}
+
+void
+SatellitePositionMobilityModel::SetPropagator (Ptr<ConstellationPropagator> prop)
+{
+  NS_ASSERT_MSG (!prop || m_helper.GetSatellite (), "Satellite is not set!");
+
+  m_helper.SetPropagator (prop);
+}
+
+Ptr<EphemerisFile>
+SatellitePositionMobilityModel::GetEphemerisFile (void) const
+{
+  return m_helper.GetEphemerisFile ();
+}
+
+void
+SatellitePositionMobilityModel::SetEphemerisFile (
+  Ptr<EphemerisFile> file, uint32_t index
+)
+{
+  m_helper.SetEphemerisFile (file, index);
+}
+
+void
+SatellitePositionMobilityModel::Tick (bool extrapolate)
+{
+  NS_LOG_FUNCTION (this << extrapolate);
 
+  m_ticked = true;
+  m_extrapolate = extrapolate;
+  m_tickTime = Simulator::Now ();
+  m_tickPosition = m_helper.GetPosition ();
+  m_tickVelocity = m_helper.GetVelocity ();
+  m_tickPositionEci = m_helper.GetPositionInECI ();
+  m_tickVelocityEci = m_helper.GetVelocityInECI ();
+
+  NotifyCourseChange ();
+}
 
+void
+SatellitePositionMobilityModel::StopTicks (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_ticked = false;
+}
 
 Vector3D
 SatellitePositionMobilityModel::DoGetPosition (void) const
 {
-  return m_helper.GetPosition ();
+  if (!m_ticked)
+    return m_helper.GetPosition ();
+
+  if (!m_extrapolate)
+    return m_tickPosition;
+
+  const double dt = (Simulator::Now () - m_tickTime).GetSeconds ();
+
+  return m_tickPosition + dt*m_tickVelocity;
 }
 
 Vector3D
 SatellitePositionMobilityModel::DoGetPositionInECI (void) const
 {
-  return m_helper.GetPositionInECI ();
+  if (!m_ticked)
+    return m_helper.GetPositionInECI ();
+
+  if (!m_extrapolate)
+    return m_tickPositionEci;
+
+  const double dt = (Simulator::Now () - m_tickTime).GetSeconds ();
+
+  return m_tickPositionEci + dt*m_tickVelocityEci;
 }
 
 void
@@ -110,12 +181,18 @@ SatellitePositionMobilityModel::DoSetPosition (const Vector3D &position)
 Vector3D
 SatellitePositionMobilityModel::DoGetVelocity (void) const
 {
+  if (m_ticked)
+    return m_tickVelocity;
+
   return m_helper.GetVelocity ();
 }
 
 Vector3D
 SatellitePositionMobilityModel::DoGetVelocityInECI (void) const
 {
+  if (m_ticked)
+    return m_tickVelocityEci;
+
   return m_helper.GetVelocityInECI ();
 }
 
@@ -24,6 +24,8 @@
 
 #include <string>
 
+#include "ns3/constellation-propagator.h"
+#include "ns3/ephemeris-file.h"
 #include "ns3/julian-date.h"
 #include "ns3/mobility-model.h"
 #include "ns3/ptr.h"
@@ -96,6 +98,63 @@ public:
    */
   void SetStartTime (const JulianDate &t);
 
+  /**
+   * @brief Get the constellation propagator serving this model, if any.
+   * @return a pointer to the propagator or a null pointer if none is set.
+   */
+  Ptr<ConstellationPropagator> GetPropagator (void) const;
+
+  /**
+   * @brief Serve position and velocity from a constellation propagator.
+   *
+   * The underlying Satellite object must be set beforehand. All satellites of
+   * a constellation should share the same propagator and start time, so that
+   * they are all propagated in a single pass per time instant.
+   *
+   * @param prop a pointer to the propagator (a null pointer disables it).
+   */
+  void SetPropagator (Ptr<ConstellationPropagator> prop);
+
+  /**
+   * @brief Get the ephemeris file serving this model, if any.
+   * @return a pointer to the ephemeris file or a null pointer if none is set.
+   */
+  Ptr<EphemerisFile> GetEphemerisFile (void) const;
+
+  /**
+   * @brief Serve position and velocity from a (memory-mapped) ephemeris file.
+   *
+   * No Satellite object is needed in this case: position and velocity are
+   * interpolated from the file's samples without parsing TLE data or running
+   * SGP4/SDP4. All satellites of a constellation should share the same
+   * EphemerisFile object, and the start time must be set as usual. Instants
+   * not covered by the file fall back to the propagator or Satellite object,
+   * if set.
+   *
+   * @param file a pointer to the ephemeris file (a null pointer disables it).
+   * @param index the index of the satellite in the file.
+   */
+  void SetEphemerisFile (Ptr<EphemerisFile> file, uint32_t index);
+
+  /**
+   * @brief Take a snapshot of the state and notify course change listeners.
+   *
+   * This is meant to be called periodically by a ConstellationClock. Until
+   * the next tick, the position is extrapolated linearly from the snapshot
+   * using its velocity (or held, if extrapolate is false), and the velocity
+   * is that of the snapshot, so that no orbit computation takes place between
+   * ticks.
+   *
+   * @param extrapolate whether to extrapolate the position between ticks.
+   */
+  void Tick (bool extrapolate = true);
+
+  /**
+   * @brief Discard the snapshot taken by Tick, so that every query computes
+   *        the state at the current time again.
+   */
+  void StopTicks (void);
+
 
   virtual Vector DoGetVelocityInECI (void) const;
   virtual Vector DoGetPositionInECI (void) const;
@@ -106,6 +165,14 @@ private:
   virtual Vector DoGetVelocity (void) const;
 
   SatellitePositionHelper m_helper;     //!< helper for orbital computations
+
+  bool m_ticked;                        //!< whether a snapshot is set
+  bool m_extrapolate;                   //!< whether to extrapolate it
+  Time m_tickTime;                      //!< simulation time of the snapshot
+  Vector m_tickPosition;                //!< ITRF position at the snapshot
+  Vector m_tickVelocity;                //!< ITRF velocity at the snapshot
+  Vector m_tickPositionEci;             //!< ECI position at the snapshot
+  Vector m_tickVelocityEci;             //!< ECI velocity at the snapshot
 };
 
 } // namespace ns3
@@ -54,13 +54,22 @@ Satellite::GetTypeId (void)
   static TypeId tid = TypeId ("ns3::Satellite")
     .SetParent<Object> ()
     .SetGroupName ("Satellite")
-    .AddConstructor<Satellite> ();
+    .AddConstructor<Satellite> ()
+    .AddAttribute ("TimeQuantum",
+                   "Resolution of the time keys of the state cache: the state "
+                   "is computed at the start of each quantum and reused for "
+                   "every query within it. Zero (or anything up to 1 ms) keys "
+                   "the cache on the exact query time.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&Satellite::m_timeQuantum),
+                   MakeTimeChecker (Seconds (0)));
 
   return tid;
 }
 
 Satellite::Satellite (void) :
-  m_name (""), m_tle1 (""), m_tle2 ("")
+  m_name (""), m_tle1 (""), m_tle2 (""), m_cacheValid (false),
+  m_timeQuantum (Seconds (0))
 {
   NS_LOG_FUNCTION_NOARGS ();
 
@@ -94,24 +103,9 @@ Satellite::GetTleEpoch (void) const {
 }
 
 void
-Satellite::SetPosition (const JulianDate &t){
-	double r[3], v[3];
-	//double delta = (t - GetTleEpoch ())*1440;
-	double delta = (t - GetTleEpoch ()).GetMinutes();
-
-	if (!IsInitialized ())
-		return;
-
-	sgp4 (WGeoSys, m_sgp4_record, delta, r, v);
-
-
-	if (m_sgp4_record.error != 0)
-		return;
-
-	// vector r is in km so it needs to be converted to meters
-	m_position_eci = Vector3D (r[0], r[1], r[2])*1000;
-	m_position = rTemeTorItrf (Vector3D (r[0], r[1], r[2]), t)*1000;
-
+Satellite::SetPosition (const JulianDate &t)
+{
+  Update (t);
 }
 
 OrbitalElementsRecord
@@ -131,121 +125,51 @@ Satellite::GetOrbitalElements(){
 Vector3D
 Satellite::GetPosition (const JulianDate &t) const
 {
-	if(m_position == Vector3D()){
-		double r[3], v[3];
-		//double delta = (t - GetTleEpoch ())*1440;
-		double delta = (t - GetTleEpoch ()).GetMinutes();
-
-		if (!IsInitialized ())
-		return Vector3D ();
-
-		sgp4 (WGeoSys, m_sgp4_record, delta, r, v);
+  if (m_ephemeris.Covers (t))
+    return m_ephemeris.GetPosition (t);
 
-		if (m_sgp4_record.error != 0)
-		return Vector3D ();
+  Update (t);
 
-		// vector r is in km so it needs to be converted to meters
-		return rTemeTorItrf (Vector3D (r[0], r[1], r[2]), t)*1000;
-	}
-	else{
-		return m_position;
-	}
+  return m_position;
 }
 
 Vector3D
-Satellite::GetPositionInECI (const JulianDate &t) const{
-	if(m_position_eci == Vector3D()){
-		double r[3], v[3];
-		//double delta = (t - GetTleEpoch ())*1440;
-		double delta = (t - GetTleEpoch ()).GetMinutes();
-
-		if (!IsInitialized ())
-		return Vector3D ();
-
-		sgp4 (WGeoSys, m_sgp4_record, delta, r, v);
-
-		if (m_sgp4_record.error != 0)
-		return Vector3D ();
-
-		// vector r is in km so it needs to be converted to meters
-		return Vector3D (r[0], r[1], r[2])*1000;
-	}
-	else{
-		return m_position_eci;
-	}
-}
-
-void
-Satellite::SetVelocity (const JulianDate &t){
-	double r[3], v[3];
-	//double delta = (t - GetTleEpoch ())*1440;
-	double delta = (t - GetTleEpoch ()).GetMinutes();
-
-	if (!IsInitialized ())
-	return;
-
-	sgp4 (WGeoSys, m_sgp4_record, delta, r, v);
+Satellite::GetPositionInECI (const JulianDate &t) const
+{
+  if (m_ephemeris.Covers (t))
+    return m_ephemeris.GetPositionInECI (t);
 
-	if (m_sgp4_record.error != 0)
-	return;
+  Update (t);
 
-	// velocity vector is in km/s so it needs to be converted to m/s
-	m_velocity_eci = 1000*Vector3D (v[0], v[1], v[2]);
-	m_velocity =  1000*rvTemeTovItrf (
-	Vector3D (r[0], r[1], r[2]), Vector3D (v[0], v[1], v[2]), t
-	);
+  return m_position_eci;
+}
 
+void
+Satellite::SetVelocity (const JulianDate &t)
+{
+  Update (t);
 }
 
 Vector3D
 Satellite::GetVelocity (const JulianDate &t) const
 {
-	if(m_velocity == Vector3D()){
-		double r[3], v[3];
-		//double delta = (t - GetTleEpoch ())*1440;
-		double delta = (t - GetTleEpoch ()).GetMinutes();
+  if (m_ephemeris.Covers (t))
+    return m_ephemeris.GetVelocity (t);
 
-		if (!IsInitialized ())
-		return Vector3D ();
-
-		sgp4 (WGeoSys, m_sgp4_record, delta, r, v);
-
-		if (m_sgp4_record.error != 0)
-		return Vector3D ();
-
-		// velocity vector is in km/s so it needs to be converted to m/s
-		return 1000*rvTemeTovItrf (
-		Vector3D (r[0], r[1], r[2]), Vector3D (v[0], v[1], v[2]), t
-		);
-	}
-	else{
-		return m_velocity;
-	}
+  Update (t);
 
+  return m_velocity;
 }
 
 Vector3D
 Satellite::GetVelocityInECI (const JulianDate &t) const
 {
-	if(m_velocity_eci == Vector3D()){
-		double r[3], v[3];
-		//double delta = (t - GetTleEpoch ())*1440;
-		double delta = (t - GetTleEpoch ()).GetMinutes();
-
-		if (!IsInitialized ())
-		return Vector3D ();
-
-		sgp4 (WGeoSys, m_sgp4_record, delta, r, v);
+  if (m_ephemeris.Covers (t))
+    return m_ephemeris.GetVelocityInECI (t);
 
-		if (m_sgp4_record.error != 0)
-		return Vector3D ();
+  Update (t);
 
-		// velocity vector is in km/s so it needs to be converted to m/s
-		return 1000*Vector3D (v[0], v[1], v[2]);
-	}
-	else{
-		return m_velocity_eci;
-	}
+  return m_velocity_eci;
 }
 
 /*
@@ -320,6 +244,10 @@ Satellite::SetTleInfo (const std::string &line1, const std::string &line2)
     "Two-Line Element info lines must be of length" << TleSatInfoWidth << "!"
   );
 
+  // a previously computed ephemeris or state no longer applies
+  m_ephemeris.Clear ();
+  m_cacheValid = false;
+
   m_tle1 = std::string (line1.c_str ());
   m_tle2 = std::string (line2.c_str ());
 
@@ -365,115 +293,183 @@ Satellite::ExtractTleSatInfo (const std::string &info)
 }
 
 bool
-Satellite::IsInitialized (void) const
+Satellite::PrecomputeEphemeris (
+  const JulianDate &start, const JulianDate &stop, const Time &step
+)
 {
-  return ((m_sgp4_record.jdsatepoch > 0) && (m_tle1 != "") && (m_tle2 != ""));
+  NS_LOG_FUNCTION (this << start << stop << step);
+  NS_ASSERT_MSG (step.IsStrictlyPositive (), "Step must be positive!");
+
+  m_ephemeris.Clear ();
+
+  if (!IsInitialized () || stop <= start)
+    return false;
+
+  double tumin, mu, radiusearthkm, xke, j2, j3, j4, j3oj2;
+  double position, velocity;
+  elsetrec record = m_sgp4_record;
+  const int64_t span = (stop - start).GetMilliSeconds ();
+  const int64_t ms = step.GetMilliSeconds ();
+  const uint32_t n = (span + ms - 1)/ms + 1;  // last node at or after stop
+
+  getgravconst (
+    WGeoSys, tumin, mu, radiusearthkm, xke, j2, j3, j4, j3oj2
+  );
+
+  // semi-major axis is in Earth radii and mean motion in rad/min
+  Ephemeris::ComputeErrorBounds (
+    step, 1000*radiusearthkm*record.a, record.ecco, record.no/60,
+    position, velocity
+  );
+
+  m_ephemeris.Reset (start, step, record.satnum, record.jdsatepoch);
+  m_ephemeris.SetErrorBounds (position, velocity);
+
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      const JulianDate t = start + MilliSeconds (ms*i);
+      double r[3], v[3];
+
+      sgp4 (WGeoSys, record, (t - GetTleEpoch ()).GetMinutes (), r, v);
+
+      if (record.error != 0)
+        {
+          NS_LOG_WARN ("SGP4/SDP4 failed at " << t << " (" << record.error << ")");
+          m_ephemeris.Clear ();
+          return false;
+        }
+
+      const Vector3D rteme (r[0], r[1], r[2]), vteme (v[0], v[1], v[2]);
+      Vector3D ritrf, vitrf;
+
+      // the transformation of each sample is only needed once
+      FrameTransform::Compute (t).TemeToItrf (rteme, vteme, ritrf, vitrf);
+
+      // vectors are in km and km/s so they need to be converted to m and m/s
+      m_ephemeris.AddNode (1000*ritrf, 1000*vitrf, 1000*rteme, 1000*vteme);
+    }
+
+  return true;
 }
 
-Satellite::Matrix
-Satellite::PefToItrf (const JulianDate &t)
+bool
+Satellite::SaveEphemeris (const std::string &filename) const
 {
-  std::pair<double, double> eop = t.GetPolarMotion ();
-
-  const double &xp = eop.first, &yp = eop.second;
-  const double cosxp = cos (xp), cosyp = cos (yp);
-  const double sinxp = sin (xp), sinyp = sin (yp);
-
-  // [from AIAA-2006-6753 Report, Page 32, Appendix C - TEME Coordinate System]
-  //
-  // Matrix(ITRF<->PEF) = ROT1(yp)*ROT2(xp) [using c for cos, and s for sin]
-  //
-  // | 1    0     0   |*| c(xp) 0 -s(xp) |=|    c(xp)       0      -s(xp)   |
-  // | 0  c(yp) s(yp) | |   0   1    0   | | s(yp)*s(xp)  c(yp) s(yp)*c(xp) |
-  // | 0 -s(yp) c(yp) | | s(xp) 0  c(xp) | | c(yp)*s(xp) -s(yp) c(yp)*c(xp) |
-  //
-
-  // we return the transpose because it is what's needed
-  return Matrix(
-     cosxp, sinyp*sinxp, cosyp*sinxp,
-       0,      cosyp,      -sinyp,
-    -sinxp, sinyp*cosxp, cosyp*cosxp
-  );
+  NS_LOG_FUNCTION (this << filename);
+
+  if (m_ephemeris.IsEmpty ())
+    return false;
+
+  return m_ephemeris.Save (filename);
 }
 
-Satellite::Matrix
-Satellite::TemeToPef (const JulianDate &t)
+bool
+Satellite::LoadEphemeris (const std::string &filename)
 {
-  const double gmst = t.GetGmst ();
-  const double cosg = cos (gmst), sing = sin (gmst);
-
-  // [from AIAA-2006-6753 Report, Page 32, Appendix C - TEME Coordinate System]
-  //
-  // rPEF = ROT3(gmst)*rTEME
-  //
-  // |  cos(gmst) sin(gmst) 0 |
-  // | -sin(gmst) cos(gmst) 0 |
-  // |      0         0     1 |
-  //
-
-  return Matrix(
-     cosg, sing, 0,
-    -sing, cosg, 0,
-       0,    0,  1
-  );
+  NS_LOG_FUNCTION (this << filename);
+
+  if (!IsInitialized () || !m_ephemeris.Load (filename))
+    return false;
+
+  // reject ephemerides generated from a different TLE
+  if (m_ephemeris.GetSatelliteNumber () != GetSatelliteNumber () ||
+      m_ephemeris.GetTleEpoch () != m_sgp4_record.jdsatepoch)
+    {
+      NS_LOG_WARN (filename << " does not match the satellite's TLE");
+      m_ephemeris.Clear ();
+      return false;
+    }
+
+  return true;
 }
 
-Vector3D
-Satellite::rTemeTorItrf (const Vector3D &rteme, const JulianDate &t)
+void
+Satellite::ClearEphemeris (void)
 {
-  Matrix pmt = PefToItrf (t);                   // PEF->ITRF matrix transposed
-  Matrix tmt = TemeToPef (t);                   // TEME->PEF matrix
+  NS_LOG_FUNCTION (this);
 
-  return pmt*(tmt*rteme);
+  m_ephemeris.Clear ();
 }
 
-Vector3D
-Satellite::rvTemeTovItrf(
-  const Vector3D &rteme, const Vector3D &vteme, const JulianDate &t
-)
+const Ephemeris&
+Satellite::GetEphemeris (void) const
 {
-  Matrix pmt = PefToItrf (t);                   // PEF->ITRF matrix transposed
-  Matrix tmt = TemeToPef (t);                   // TEME->PEF matrix
-  Vector3D w (0.0, 0.0, t.GetOmegaEarth ());
+  return m_ephemeris;
+}
 
-  return pmt*((tmt*vteme) - CrossProduct (w, tmt*rteme));
+bool
+Satellite::IsInitialized (void) const
+{
+  // TLE lines are not kept by all initialization paths (see TleCatalog)
+  return (m_sgp4_record.jdsatepoch > 0);
 }
 
-Satellite::Matrix::Matrix (
-  double c00, double c01, double c02,
-  double c10, double c11, double c12,
-  double c20, double c21, double c22
-)
+JulianDate
+Satellite::GetCacheKey (const JulianDate &t) const
 {
-  m[0][0] = c00;
-  m[0][1] = c01;
-  m[0][2] = c02;
-  m[1][0] = c10;
-  m[1][1] = c11;
-  m[1][2] = c12;
-  m[2][0] = c20;
-  m[2][1] = c21;
-  m[2][2] = c22;
+  const int64_t quantum = m_timeQuantum.GetMilliSeconds ();
+
+  if (quantum <= 1)
+    return t;
+
+  const uint64_t ms = t.GetPosixMilliseconds ();
+  const uint64_t key = ms - ms%quantum;
+
+  return JulianDate (
+    static_cast<uint32_t> (key/JulianDate::DayToMs),
+    static_cast<uint32_t> (key%JulianDate::DayToMs)
+  );
+}
+
+void
+Satellite::Update (const JulianDate &t) const
+{
+  const JulianDate key = GetCacheKey (t);
+
+  if (m_cacheValid && key == m_cacheTime)
+    return;
+
+  NS_LOG_FUNCTION (this << t);
+
+  double r[3], v[3];
+
+  m_cacheTime = key;
+  m_cacheValid = true;
+  m_position = m_velocity = Vector3D ();
+  m_position_eci = m_velocity_eci = Vector3D ();
+
+  if (!IsInitialized ())
+    return;
+
+  sgp4 (WGeoSys, m_sgp4_record, (key - GetTleEpoch ()).GetMinutes (), r, v);
+
+  if (m_sgp4_record.error != 0)
+    return;
+
+  const Vector3D rteme (r[0], r[1], r[2]), vteme (v[0], v[1], v[2]);
+  Vector3D ritrf, vitrf;
+
+  FrameTransform::Get (key).TemeToItrf (rteme, vteme, ritrf, vitrf);
+
+  // vectors are in km and km/s so they need to be converted to m and m/s
+  m_position = 1000*ritrf;
+  m_velocity = 1000*vitrf;
+  m_position_eci = 1000*rteme;
+  m_velocity_eci = 1000*vteme;
 }
 
 Vector3D
-Satellite::Matrix::operator* (const Vector3D& v) const
+Satellite::rTemeTorItrf (const Vector3D &rteme, const JulianDate &t)
 {
-  return Vector3D (
-    m[0][0]*v.x + m[0][1]*v.y + m[0][2]*v.z,
-    m[1][0]*v.x + m[1][1]*v.y + m[1][2]*v.z,
-    m[2][0]*v.x + m[2][1]*v.y + m[2][2]*v.z
-  );
+  return FrameTransform::Get (t).rTemeTorItrf (rteme);
 }
 
-Satellite::Matrix
-Satellite::Matrix::Transpose (void) const
+Vector3D
+Satellite::rvTemeTovItrf(
+  const Vector3D &rteme, const Vector3D &vteme, const JulianDate &t
+)
 {
-  return Matrix(
-    m[0][0], m[1][0], m[2][0],
-    m[0][1], m[1][1], m[2][1],
-    m[0][2], m[1][2], m[2][2]
-  );
+  return FrameTransform::Get (t).rvTemeTovItrf (rteme, vteme);
 }
 
 }
@@ -32,6 +32,8 @@
 #include "ns3/vector.h"
 #include "ns3/walker-constellation-structure.h"
 
+#include "ephemeris.h"
+#include "frame-transform.h"
 #include "julian-date.h"
 #include "sgp4ext.h"
 #include "sgp4io.h"
@@ -39,6 +41,8 @@
 
 namespace ns3 {
 
+class ConstellationPropagator;
+
 typedef std::tuple<double, 	//<! Semi-Major Axis
 		  double,			//<! Eccentricity
 		  double,			//<! Inclination
@@ -117,10 +121,17 @@ public:
   /**
    * @brief Retrieve the TLE information used to initialize this satellite.
    * @return an std::pair with the two lines used to initialize this satellite,
-   *         or an std::pair with two empty strings if it has not yet been set.
+   *         or an std::pair with two empty strings if it has not yet been set
+   *         or was loaded by a TleCatalog that does not keep TLE lines.
    */
   std::pair<std::string, std::string> GetTleInfo (void) const;
 
+  /**
+   * @brief Check if the satellite has already been initialized.
+   * @return a boolean indicating whether the satellite is initialized.
+   */
+  bool IsInitialized (void) const;
+
   /**
    * @brief Retrieve the TLE epoch time.
    * @return the TLE epoch time or 0h, 1 January 1992 if the satellite has not
@@ -128,24 +139,53 @@ public:
    */
   JulianDate GetTleEpoch (void) const;
 
+  /**
+   * @brief Propagate the satellite to a given time and cache its state.
+   *
+   * The position and velocity, in both ITRF and ECI frames, are obtained from
+   * a single SGP4/SDP4 run and kept until a query for a different time key
+   * (see the TimeQuantum attribute) is made. SetVelocity is equivalent.
+   *
+   * @param t When.
+   */
+  void SetPosition (const JulianDate &t);
+
   /**
    * @brief Get the prediction for the satellite's position at a given time.
    * @param t When.
    * @return an ns3::Vector3D object containing the satellite's position,
    *         in meters, on ITRF coordinate frame.
    */
-  void SetPosition (const JulianDate &t);
   Vector3D GetPosition (const JulianDate &t) const;
+
+  /**
+   * @brief Get the prediction for the satellite's position at a given time.
+   * @param t When.
+   * @return an ns3::Vector3D object containing the satellite's position,
+   *         in meters, on TEME coordinate frame.
+   */
   Vector3D GetPositionInECI (const JulianDate &t) const;
 
+  /**
+   * @brief Propagate the satellite to a given time and cache its state.
+   * @param t When.
+   */
+  void SetVelocity (const JulianDate &t);
+
   /**
    * @brief Get the prediction for the satellite's velocity at a given time.
    * @param t When.
    * @return an ns3::Vector3D object containing the satellite's velocity,
    *         in m/s, on ITRF coordinate frame.
    */
-  void SetVelocity (const JulianDate &t);
   Vector3D GetVelocity (const JulianDate &t) const;
+
+  /**
+   * @brief Get the prediction for the satellite's velocity at a given time.
+   * @param t When.
+   * @return an ns3::Vector3D object containing the satellite's velocity,
+   *         in m/s, on TEME coordinate frame.
+   */
   Vector3D GetVelocityInECI (const JulianDate &t) const;
 
   /**
@@ -201,62 +241,83 @@ public:
   }
 
   /**
-   * @brief Get the orbital six elements at the current moment.
-   * @return Semi-Major Axis, Eccentricity, Inclination, Right Ascension of the Ascending Node,
-   *         Argument of Periapsis, Mean Anomaly.
+   * @brief Precompute the satellite's ephemeris over a time interval.
+   *
+   * SGP4/SDP4 is run once per step over [start, stop], and position and
+   * velocity queries within that interval are answered by interpolating the
+   * samples (see Ephemeris for the error bounds). Queries outside the interval
+   * still run SGP4/SDP4.
+   *
+   * @param start the start of the interval.
+   * @param stop the end of the interval.
+   * @param step the time between samples.
+   * @return a boolean indicating whether the ephemeris was computed (it is
+   *         not if the satellite is not initialized or SGP4/SDP4 fails).
    */
-  OrbitalElementsRecord GetOrbitalElements();
-
-private:
-  /// row of a Matrix
-  struct Row {
-    double r[3];
-
-    double& operator[] (uint32_t i) { return r[i]; }
-    const double& operator[] (uint32_t i) const { return r[i]; }
-  };
-
-  /// Matrix data structure to make coordinate conversion code clearer and
-  /// less verbose
-  struct Matrix {
-  public:
-    Matrix (void) { }
-    Matrix (
-      double c00, double c01, double c02,
-      double c10, double c11, double c12,
-      double c20, double c21, double c22
-    );
+  bool PrecomputeEphemeris (
+    const JulianDate &start, const JulianDate &stop, const Time &step
+  );
 
-    Row& operator[] (uint32_t i) { return m[i]; }
-    const Row& operator[] (uint32_t i) const { return m[i]; }
+  /**
+   * @brief Save the precomputed ephemeris to a binary file.
+   * @param filename the name of the file.
+   * @return a boolean indicating whether the file was written.
+   */
+  bool SaveEphemeris (const std::string &filename) const;
 
-    Vector3D operator* (const Vector3D &v) const;
+  /**
+   * @brief Load a precomputed ephemeris from a binary file.
+   *
+   * The ephemeris is only accepted if it was generated from the TLE this
+   * satellite was initialized with.
+   *
+   * @param filename the name of the file.
+   * @return a boolean indicating whether the ephemeris was loaded.
+   */
+  bool LoadEphemeris (const std::string &filename);
 
-    Matrix Transpose (void) const;
+  /**
+   * @brief Discard the precomputed ephemeris.
+   */
+  void ClearEphemeris (void);
 
-  private:
-    Row m[3];
-  };
+  /**
+   * @brief Retrieve the precomputed ephemeris.
+   * @return the satellite's ephemeris (empty if it has not been computed).
+   */
+  const Ephemeris& GetEphemeris (void) const;
 
   /**
-   * @brief Check if the satellite has already been initialized.
-   * @return a boolean indicating whether the satellite is initialized.
+   * @brief Get the orbital six elements at the current moment.
+   * @return Semi-Major Axis, Eccentricity, Inclination, Right Ascension of the Ascending Node,
+   *         Argument of Periapsis, Mean Anomaly.
    */
-  bool IsInitialized (void) const;
+  OrbitalElementsRecord GetOrbitalElements();
+
+private:
+  /// the propagator and contact plan generator copy SGP4/SDP4 records, and
+  /// the catalog loader sets them
+  friend class ConstellationPropagator;
+  friend class ContactPlanGenerator;
+  friend class TleCatalog;
 
   /**
-   * @brief Retrieve the matrix for converting from PEF to ITRF at a given time.
+   * @brief Get the state cache key of a given time.
    * @param t When.
-   * @return the PEF-ITRF conversion matrix.
+   * @return t rounded down to a multiple of the time quantum.
    */
-  static Matrix PefToItrf (const JulianDate &t);
+  JulianDate GetCacheKey (const JulianDate &t) const;
 
   /**
-   * @brief Retrieve the matrix for converting from TEME to PEF at a given time.
+   * @brief Fill the state cache for a given time, unless it already is.
+   *
+   * A single SGP4/SDP4 run and frame transformation yields the position and
+   * velocity in both ITRF and ECI frames. These are null vectors if the
+   * satellite is not initialized or the propagation fails.
+   *
    * @param t When.
-   * @return the TEME-PEF conversion matrix.
    */
-  static Matrix TemeToPef (const JulianDate &t);
+  void Update (const JulianDate &t) const;
 
   /**
    * @brief Retrieve the satellite's position vector in ITRF coordinates.
@@ -277,12 +338,16 @@ private:
   std::string m_name;                               //!< satellite's name.
   std::string m_tle1, m_tle2;                       //!< satellite's TLE data.
   mutable elsetrec m_sgp4_record;                   //!< SGP4/SDP4 record.
+  Ephemeris m_ephemeris;                            //!< precomputed samples.
 
   Ptr<Constellation> m_cons;  						//!< constellation it belong to
-  Vector3D m_position;  							//!< m
-  Vector3D m_velocity;  							//!< m/s
-  Vector3D m_position_eci;  						//!< m in eci
-  Vector3D m_velocity_eci;  						//!< m/s in eci
+  mutable bool m_cacheValid;                        //!< whether state is set.
+  mutable JulianDate m_cacheTime;                   //!< time key of state.
+  mutable Vector3D m_position;                      //!< m
+  mutable Vector3D m_velocity;                      //!< m/s
+  mutable Vector3D m_position_eci;                  //!< m in eci
+  mutable Vector3D m_velocity_eci;                  //!< m/s in eci
+  Time m_timeQuantum;                               //!< state cache key step.
 };
 
 }
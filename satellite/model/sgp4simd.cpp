@@ -0,0 +1,491 @@
+/*     ----------------------------------------------------------------
+*
+*                               sgp4simd.cpp
+*
+*    this file contains a data-parallel version of the near earth branch of
+*    the sgp4 propagator (see sgp4unit.cpp). the equations and their order
+*    are those of the scalar code, with every branch replaced by per lane
+*    masks so that SGP4_SIMD_LANES satellites are propagated at once.
+*
+*    sin, cos and atan2 are evaluated with the cephes polynomial and rational
+*    approximations (moshier, 1992) on reduced arguments, since the standard
+*    math library only provides scalar versions of these functions.
+*
+*       ----------------------------------------------------------------      */
+
+#include "sgp4simd.h"
+
+#include <math.h>
+
+#if defined (__AVX512F__) || defined (__AVX2__)
+#include <immintrin.h>
+#endif
+
+#define pi 3.14159265358979323846
+
+namespace {
+
+// one double per lane, and the result of comparing two of those
+typedef double vdouble __attribute__ ((vector_size (SGP4_SIMD_LANES*8)));
+typedef long long vmask __attribute__ ((vector_size (SGP4_SIMD_LANES*8)));
+
+inline vdouble
+vset (double x)
+{
+  vdouble v;
+  for (int i = 0; i < SGP4_SIMD_LANES; ++i)
+    v[i] = x;
+  return v;
+}
+
+inline vdouble
+vselect (vmask m, vdouble a, vdouble b)
+{
+  return m ? a : b;
+}
+
+inline bool
+vany (vmask m)
+{
+  for (int i = 0; i < SGP4_SIMD_LANES; ++i)
+    if (m[i])
+      return true;
+  return false;
+}
+
+inline vdouble
+vabs (vdouble x)
+{
+  return vselect (x < 0.0, -x, x);
+}
+
+inline vdouble
+vsqrt (vdouble x)
+{
+#if defined (__AVX512F__)
+  return (vdouble) _mm512_sqrt_pd ((__m512d) x);
+#elif defined (__AVX2__)
+  return (vdouble) _mm256_sqrt_pd ((__m256d) x);
+#else
+  for (int i = 0; i < SGP4_SIMD_LANES; ++i)
+    x[i] = sqrt (x[i]);
+  return x;
+#endif
+}
+
+// round towards zero
+inline vdouble
+vtrunc (vdouble x)
+{
+#if defined (__AVX512F__)
+  return (vdouble) _mm512_roundscale_pd (
+    (__m512d) x, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC
+  );
+#elif defined (__AVX2__)
+  return (vdouble) _mm256_round_pd (
+    (__m256d) x, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC
+  );
+#else
+  for (int i = 0; i < SGP4_SIMD_LANES; ++i)
+    x[i] = trunc (x[i]);
+  return x;
+#endif
+}
+
+// round to nearest integer
+inline vdouble
+vround (vdouble x)
+{
+#if defined (__AVX512F__)
+  return (vdouble) _mm512_roundscale_pd (
+    (__m512d) x, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC
+  );
+#elif defined (__AVX2__)
+  return (vdouble) _mm256_round_pd (
+    (__m256d) x, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC
+  );
+#else
+  for (int i = 0; i < SGP4_SIMD_LANES; ++i)
+    x[i] = nearbyint (x[i]);
+  return x;
+#endif
+}
+
+// same sign convention as fmod (the result has the sign of x)
+inline vdouble
+vfmod (vdouble x, double y)
+{
+  return x - vtrunc (x / y) * y;
+}
+
+/*
+*  sin and cos of x, reduced to [-pi/4, pi/4] by subtracting the nearest
+*  multiple of pi/2 in two parts (the first one has 33 significant bits, so
+*  the product by the multiple is exact for |x| < 1.6e6 rad).
+*/
+inline void
+vsincos (vdouble x, vdouble &s, vdouble &c)
+{
+  const double pio2_1  = 1.57079632673412561417e+00;
+  const double pio2_1t = 6.07710050650619224932e-11;
+  const double twoopi  = 6.36619772367581382433e-01;
+
+  vdouble q = vround (x * twoopi);
+  vdouble z = (x - q * pio2_1) - q * pio2_1t;
+  vdouble zz = z * z;
+
+  vdouble ps = ((((( 1.58962301576546568060e-10  * zz
+                   - 2.50507477628578072866e-8)  * zz
+                   + 2.75573136213857245213e-6)  * zz
+                   - 1.98412698295895385996e-4)  * zz
+                   + 8.33333333332211858878e-3)  * zz
+                   - 1.66666666666666307295e-1);
+  vdouble pc = (((((-1.13585365213876817300e-11  * zz
+                   + 2.08757008419747316778e-9)  * zz
+                   - 2.75573141792967388112e-7)  * zz
+                   + 2.48015872888517045348e-5)  * zz
+                   - 1.38888888888730564116e-3)  * zz
+                   + 4.16666666666665929218e-2);
+
+  vdouble sz = z + z * zz * ps;
+  vdouble cz = 1.0 - 0.5 * zz + zz * zz * pc;
+
+  // quadrant of x: 0 -> (s, c), 1 -> (c, -s), 2 -> (-s, -c), 3 -> (-c, s)
+  vdouble quad = q - 4.0 * vtrunc (q * 0.25);
+  quad = vselect (quad < 0.0, quad + 4.0, quad);
+
+  vmask odd = (quad == 1.0) | (quad == 3.0);
+  vdouble sr = vselect (odd, cz, sz);
+  vdouble cr = vselect (odd, sz, cz);
+
+  s = vselect (quad >= 2.0, -sr, sr);
+  c = vselect ((quad == 1.0) | (quad == 2.0), -cr, cr);
+}
+
+inline vdouble
+vsin (vdouble x)
+{
+  vdouble s, c;
+  vsincos (x, s, c);
+  return s;
+}
+
+inline vdouble
+vcos (vdouble x)
+{
+  vdouble s, c;
+  vsincos (x, s, c);
+  return c;
+}
+
+// arc tangent of x, reduced to [0, 0.66] with tan(3pi/8) and tan(pi/8) steps
+inline vdouble
+vatan (vdouble x)
+{
+  const double t3p8 = 2.41421356237309504880;
+  const double morebits = 6.123233995736765886130e-17;
+
+  vdouble ax = vabs (x);
+  vmask big = ax > t3p8;
+  vmask mid = (ax > 0.66) & ~big;
+
+  vdouble y0 = vselect (big, vset (pi/2), vselect (mid, vset (pi/4), vset (0)));
+  vdouble extra = vselect (
+    big, vset (morebits), vselect (mid, vset (0.5*morebits), vset (0))
+  );
+  vdouble xr = vselect (big, -1.0 / ax, vselect (mid, (ax-1.0)/(ax+1.0), ax));
+
+  vdouble z = xr * xr;
+  vdouble p = ((((-8.750608600031904122785e-1  * z
+                  -1.615753718733365076637e1)  * z
+                  -7.500855792314704667340e1)  * z
+                  -1.228866684490136173410e2)  * z
+                  -6.485021904942025371773e1);
+  vdouble q = (((((z + 2.485846490142306297962e1) * z
+                     + 1.650270098316988542046e2) * z
+                     + 4.328810604912902668951e2) * z
+                     + 4.853903996359136964868e2) * z
+                     + 1.945506571482613964425e2);
+
+  vdouble y = y0 + (xr * (z * p / q) + xr + extra);
+
+  return vselect (x < 0.0, -y, y);
+}
+
+inline vdouble
+vatan2 (vdouble y, vdouble x)
+{
+  vdouble z = vatan (y / x);
+  vdouble adj = vselect (y < 0.0, vset (-pi), vset (pi));
+
+  return vselect (x < 0.0, z + adj, z);
+}
+
+/*
+*  propagate up to SGP4_SIMD_LANES near earth satellites. lanes [count,
+*  SGP4_SIMD_LANES) repeat the last satellite and are discarded. satellites
+*  for which the model reports an error are propagated again by sgp4, which
+*  sets the error code and the outputs exactly as for a single satellite.
+*/
+bool
+sgp4nearlanes
+     (
+       gravconsttype whichconst, elsetrec satrec[], const double tsince[],
+       const int idx[], int count, double r[][3], double v[][3]
+     )
+{
+  const double twopi = 2.0 * pi;
+  const double x2o3  = 2.0 / 3.0;
+  double tumin, mu, radiusearthkm, xke, j2, j3, j4, j3oj2, vkmpersec;
+
+  getgravconst (whichconst, tumin, mu, radiusearthkm, xke, j2, j3, j4, j3oj2);
+  vkmpersec = radiusearthkm * xke/60.0;
+
+  vdouble t, mo, mdot, argpo, argpdot, nodeo, nodedot, nodecf, cc1, bstar,
+          cc4, t2cof, omgcof, eta, xmcof, delmo, d2, d3, d4, cc5, sinmao,
+          t3cof, t4cof, t5cof, no, am0, ecco, inclo, sinip, cosip, aycof,
+          xlcof, con41, x1mth2, x7thm1;
+
+  /* ---------------- gather the lanes' satellite records --------------- */
+  for (int l = 0; l < SGP4_SIMD_LANES; ++l)
+    {
+      const int i = idx[l < count ? l : count - 1];
+      const elsetrec &s = satrec[i];
+      // the simplified drag equations leave these terms out (and unset)
+      const bool simp = (s.isimp == 1);
+
+      t[l]       = tsince[i];
+      mo[l]      = s.mo;
+      mdot[l]    = s.mdot;
+      argpo[l]   = s.argpo;
+      argpdot[l] = s.argpdot;
+      nodeo[l]   = s.nodeo;
+      nodedot[l] = s.nodedot;
+      nodecf[l]  = s.nodecf;
+      cc1[l]     = s.cc1;
+      bstar[l]   = s.bstar;
+      cc4[l]     = s.cc4;
+      t2cof[l]   = s.t2cof;
+      omgcof[l]  = (simp ? 0.0 : s.omgcof);
+      eta[l]     = (simp ? 0.0 : s.eta);
+      xmcof[l]   = (simp ? 0.0 : s.xmcof);
+      delmo[l]   = (simp ? 0.0 : s.delmo);
+      d2[l]      = (simp ? 0.0 : s.d2);
+      d3[l]      = (simp ? 0.0 : s.d3);
+      d4[l]      = (simp ? 0.0 : s.d4);
+      cc5[l]     = (simp ? 0.0 : s.cc5);
+      sinmao[l]  = (simp ? 0.0 : s.sinmao);
+      t3cof[l]   = (simp ? 0.0 : s.t3cof);
+      t4cof[l]   = (simp ? 0.0 : s.t4cof);
+      t5cof[l]   = (simp ? 0.0 : s.t5cof);
+      no[l]      = s.no;
+      am0[l]     = pow (xke / s.no, x2o3);
+      ecco[l]    = s.ecco;
+      inclo[l]   = s.inclo;
+      sinip[l]   = sin (s.inclo);
+      cosip[l]   = cos (s.inclo);
+      aycof[l]   = s.aycof;
+      xlcof[l]   = s.xlcof;
+      con41[l]   = s.con41;
+      x1mth2[l]  = s.x1mth2;
+      x7thm1[l]  = s.x7thm1;
+    }
+
+  /* ------- update for secular gravity and atmospheric drag ----- */
+  vdouble xmdf   = mo + mdot * t;
+  vdouble argpdf = argpo + argpdot * t;
+  vdouble nodedf = nodeo + nodedot * t;
+  vdouble t2     = t * t;
+  vdouble nodem  = nodedf + nodecf * t2;
+  vdouble tempa  = 1.0 - cc1 * t;
+  vdouble tempe  = bstar * cc4 * t;
+  vdouble templ  = t2cof * t2;
+
+  vdouble delomg   = omgcof * t;
+  vdouble delmtemp = 1.0 + eta * vcos (xmdf);
+  vdouble delm     = xmcof * (delmtemp * delmtemp * delmtemp - delmo);
+  vdouble temp     = delomg + delm;
+  vdouble mm       = xmdf + temp;
+  vdouble argpm    = argpdf - temp;
+  vdouble t3       = t2 * t;
+  vdouble t4       = t3 * t;
+  tempa = tempa - d2 * t2 - d3 * t3 - d4 * t4;
+  tempe = tempe + bstar * cc5 * (vsin (mm) - sinmao);
+  templ = templ + t3cof * t3 + t4 * (t4cof + t * t5cof);
+
+  vdouble am = am0 * tempa * tempa;
+  vdouble nm = xke / (am * vsqrt (am));
+  vdouble em = ecco - tempe;
+
+  vmask error = (em >= 1.0) | (em < -0.001);
+
+  em = vselect (em < 1.0e-6, vset (1.0e-6), em);
+  mm = mm + no * templ;
+  vdouble xlm = mm + argpm + nodem;
+
+  nodem = vfmod (nodem, twopi);
+  argpm = vfmod (argpm, twopi);
+  xlm   = vfmod (xlm, twopi);
+  mm    = vfmod (xlm - argpm - nodem, twopi);
+
+  /* -------------------- long period periodics ------------------ */
+  vdouble sinargp, cosargp;
+  vsincos (argpm, sinargp, cosargp);
+
+  vdouble axnl = em * cosargp;
+  temp = 1.0 / (am * (1.0 - em * em));
+  vdouble aynl = em * sinargp + temp * aycof;
+  vdouble xl   = mm + argpm + nodem + temp * xlcof * axnl;
+
+  /* --------------------- solve kepler's equation --------------- */
+  vdouble u = vfmod (xl - nodem, twopi);
+  vdouble eo1 = u;
+  vdouble tem5 = vset (9999.9);
+  vdouble sineo1 = vset (0), coseo1 = vset (0);
+  vmask active = (vabs (tem5) >= 1.0e-12);
+
+  for (int ktr = 1; ktr <= 10 && vany (active); ++ktr)
+    {
+      vdouble s, c;
+      vsincos (eo1, s, c);
+
+      vdouble step = 1.0 - c * axnl - s * aynl;
+      step = (u - aynl * c + axnl * s - eo1) / step;
+      step = vselect (vabs (step) >= 0.95,
+                      vselect (step > 0.0, vset (0.95), vset (-0.95)), step);
+
+      // lanes that have already converged keep their last values
+      sineo1 = vselect (active, s, sineo1);
+      coseo1 = vselect (active, c, coseo1);
+      tem5   = vselect (active, step, tem5);
+      eo1    = vselect (active, eo1 + step, eo1);
+      active = active & (vabs (tem5) >= 1.0e-12);
+    }
+
+  /* ------------- short period preliminary quantities ----------- */
+  vdouble ecose = axnl*coseo1 + aynl*sineo1;
+  vdouble esine = axnl*sineo1 - aynl*coseo1;
+  vdouble el2   = axnl*axnl + aynl*aynl;
+  vdouble pl    = am*(1.0-el2);
+
+  error = error | (pl < 0.0);
+
+  vdouble rl     = am * (1.0 - ecose);
+  vdouble rdotl  = vsqrt (am) * esine/rl;
+  vdouble rvdotl = vsqrt (pl) / rl;
+  vdouble betal  = vsqrt (1.0 - el2);
+  temp           = esine / (1.0 + betal);
+  vdouble sinu   = am / rl * (sineo1 - aynl - axnl * temp);
+  vdouble cosu   = am / rl * (coseo1 - axnl + aynl * temp);
+  vdouble su     = vatan2 (sinu, cosu);
+  vdouble sin2u  = (cosu + cosu) * sinu;
+  vdouble cos2u  = 1.0 - 2.0 * sinu * sinu;
+  temp           = 1.0 / pl;
+  vdouble temp1  = 0.5 * j2 * temp;
+  vdouble temp2  = temp1 * temp;
+
+  /* -------------- update for short period periodics ------------ */
+  vdouble mrt   = rl * (1.0 - 1.5 * temp2 * betal * con41) +
+                  0.5 * temp1 * x1mth2 * cos2u;
+  su            = su - 0.25 * temp2 * x7thm1 * sin2u;
+  vdouble xnode = nodem + 1.5 * temp2 * cosip * sin2u;
+  vdouble xinc  = inclo + 1.5 * temp2 * cosip * sinip * cos2u;
+  vdouble mvt   = rdotl - nm * temp1 * x1mth2 * sin2u / xke;
+  vdouble rvdot = rvdotl + nm * temp1 * (x1mth2 * cos2u +
+                  1.5 * con41) / xke;
+
+  // sgp4fix for decaying satellites
+  error = error | (mrt < 1.0);
+
+  /* --------------------- orientation vectors ------------------- */
+  vdouble sinsu, cossu, snod, cnod, sini, cosi;
+  vsincos (su, sinsu, cossu);
+  vsincos (xnode, snod, cnod);
+  vsincos (xinc, sini, cosi);
+
+  vdouble xmx = -snod * cosi;
+  vdouble xmy =  cnod * cosi;
+  vdouble ux  =  xmx * sinsu + cnod * cossu;
+  vdouble uy  =  xmy * sinsu + snod * cossu;
+  vdouble uz  =  sini * sinsu;
+  vdouble vx  =  xmx * cossu - cnod * sinsu;
+  vdouble vy  =  xmy * cossu - snod * sinsu;
+  vdouble vz  =  sini * cossu;
+
+  /* --------- position and velocity (in km and km/sec) ---------- */
+  vdouble rx = (mrt * ux) * radiusearthkm;
+  vdouble ry = (mrt * uy) * radiusearthkm;
+  vdouble rz = (mrt * uz) * radiusearthkm;
+  vdouble wx = (mvt * ux + rvdot * vx) * vkmpersec;
+  vdouble wy = (mvt * uy + rvdot * vy) * vkmpersec;
+  vdouble wz = (mvt * uz + rvdot * vz) * vkmpersec;
+
+  /* ---------------- scatter the results to the lanes' satellites ------- */
+  bool ok = true;
+
+  for (int l = 0; l < count; ++l)
+    {
+      const int i = idx[l];
+      elsetrec &s = satrec[i];
+
+      if (error[l])
+        {
+          ok = sgp4 (whichconst, s, tsince[i], r[i], v[i]) && ok;
+          continue;
+        }
+
+      s.t     = t[l];
+      s.error = 0;
+
+      // ultrastar add
+      s.argpm_s = argpm[l];
+      s.nodem_s = nodem[l];
+      s.mm_s    = mm[l];
+      s.inclm_s = inclo[l];
+
+      r[i][0] = rx[l];
+      r[i][1] = ry[l];
+      r[i][2] = rz[l];
+      v[i][0] = wx[l];
+      v[i][1] = wy[l];
+      v[i][2] = wz[l];
+    }
+
+  return ok;
+}
+
+} // anonymous namespace
+
+bool sgp4simd
+     (
+       gravconsttype whichconst, elsetrec satrec[], const double tsince[],
+       int n, double r[][3], double v[][3]
+     )
+{
+  int idx[SGP4_SIMD_LANES];
+  int count = 0;
+  bool ok = true;
+
+  for (int i = 0; i < n; ++i)
+    {
+      // deep space, and invalid mean motion, are left to the scalar code
+      if (satrec[i].method != 'n' || satrec[i].no <= 0.0)
+        {
+          ok = sgp4 (whichconst, satrec[i], tsince[i], r[i], v[i]) && ok;
+          continue;
+        }
+
+      idx[count++] = i;
+
+      if (count == SGP4_SIMD_LANES)
+        {
+          ok = sgp4nearlanes (whichconst, satrec, tsince, idx, count, r, v) && ok;
+          count = 0;
+        }
+    }
+
+  if (count > 0)
+    ok = sgp4nearlanes (whichconst, satrec, tsince, idx, count, r, v) && ok;
+
+  return ok;
+}
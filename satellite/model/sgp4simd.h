@@ -0,0 +1,52 @@
+#ifndef _sgp4simd_
+#define _sgp4simd_
+/*     ----------------------------------------------------------------
+*
+*                                 sgp4simd.h
+*
+*    this file contains a data-parallel version of the near earth branch of
+*    the sgp4 propagator found in sgp4unit.cpp. satellites are propagated in
+*    groups of SGP4_SIMD_LANES, one satellite per simd lane: 8 when the
+*    compiler targets avx-512, 4 when it targets avx2 (e.g., -march=native),
+*    and 2 otherwise (sse2 on x86-64).
+*
+*    deep space satellites (method 'd') and satellites for which the model
+*    reports an error are handed over to the scalar sgp4 function, so that
+*    the results, the error codes and the side effects on elsetrec are the
+*    same as those of calling sgp4 for each satellite. near earth results
+*    agree with the scalar code well within 1 mm and 1 mm/s.
+*
+*       ----------------------------------------------------------------      */
+
+#include "sgp4unit.h"
+
+#if defined (__AVX512F__)
+#define SGP4_SIMD_LANES 8
+#elif defined (__AVX2__)
+#define SGP4_SIMD_LANES 4
+#else
+#define SGP4_SIMD_LANES 2
+#endif
+
+// --------------------------- function declarations ----------------------------
+/*
+*  inputs        :
+*    whichconst  - which set of constants to use  wgs72old, wgs72, wgs84
+*    satrec      - array of n initialized satellite records
+*    tsince      - array of n times since each satellite's epoch (minutes)
+*    n           - number of satellites
+*
+*  outputs       :
+*    r           - array of n position vectors     km
+*    v           - array of n velocity vectors     km/sec
+*    satrec      - t, error and mean elements updated as sgp4 does
+*
+*  returns true if every satellite was propagated with no error.
+*/
+bool sgp4simd
+     (
+       gravconsttype whichconst, elsetrec satrec[], const double tsince[],
+       int n, double r[][3], double v[][3]
+     );
+
+#endif
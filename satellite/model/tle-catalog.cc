@@ -0,0 +1,456 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 INESC TEC
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "tle-catalog.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+
+#include "ns3/assert.h"
+#include "ns3/boolean.h"
+#include "ns3/log.h"
+#include "ns3/system-thread.h"
+#include "ns3/uinteger.h"
+
+#include "sgp4io.h"
+#include "sgp4unit.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TleCatalog");
+
+NS_OBJECT_ENSURE_REGISTERED (TleCatalog);
+
+namespace {
+
+/**
+ * @brief Check if a line is a TLE element set line.
+ * @param line the line.
+ * @param length the line's length.
+ * @param set the element set number ('1' or '2').
+ * @return a boolean indicating whether the line starts as element set set.
+ */
+bool
+IsElementSet (const char *line, size_t length, char set)
+{
+  return (length >= 2 && line[0] == set && line[1] == ' ');
+}
+
+}
+
+/**
+ * @brief Initializes a range of catalog entries.
+ */
+class TleCatalog::Worker {
+public:
+  /**
+   * @brief Constructor.
+   * @param entries the catalog entries.
+   * @param first the first entry of the worker.
+   * @param last the entry after the worker's last one.
+   */
+  Worker (std::vector<Entry> &entries, uint32_t first, uint32_t last) :
+    m_entries (&entries), m_first (first), m_last (last)
+  {
+  }
+
+  /**
+   * @brief Initialize the worker's entries.
+   */
+  void Run (void)
+  {
+    for (uint32_t i = m_first; i < m_last; ++i)
+      TleCatalog::Initialize ((*m_entries)[i]);
+  }
+
+private:
+  std::vector<Entry> *m_entries;                  //!< catalog entries.
+  uint32_t m_first;                               //!< first entry.
+  uint32_t m_last;                                //!< entry after the last.
+};
+
+TypeId
+TleCatalog::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TleCatalog")
+    .SetParent<Object> ()
+    .SetGroupName ("Satellite")
+    .AddConstructor<TleCatalog> ()
+    .AddAttribute ("Threads",
+                   "Number of worker threads (0 for one per processor).",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&TleCatalog::m_threads),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("KeepTle",
+                   "Whether satellites keep a copy of their TLE lines.",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&TleCatalog::m_keepTle),
+                   MakeBooleanChecker ());
+
+  return tid;
+}
+
+TleCatalog::TleCatalog (void) :
+  m_threads (0), m_keepTle (true)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TleCatalog::~TleCatalog (void)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+TleCatalog::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_satellites.clear ();
+  m_rejections.clear ();
+
+  Object::DoDispose ();
+}
+
+bool
+TleCatalog::Load (const std::string &filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+
+  std::ifstream f (filename.c_str (), std::ios::in | std::ios::binary);
+
+  if (!f.is_open ())
+    {
+      NS_LOG_WARN ("Unable to open " << filename << " for reading");
+      return false;
+    }
+
+  std::ostringstream data;
+
+  data << f.rdbuf ();
+  Parse (data.str ());
+
+  return true;
+}
+
+void
+TleCatalog::Parse (const std::string &data)
+{
+  NS_LOG_FUNCTION (this << data.size ());
+
+  m_satellites.clear ();
+  m_rejections.clear ();
+
+  // split the catalog into entries, pointing into data
+  std::vector<Entry> entries;
+  const char *name = 0;
+  size_t nameLength = 0;
+  uint32_t nameLine = 0, line = 0;
+  size_t pos = 0;
+
+  while (pos < data.size ())
+    {
+      size_t end = data.find ('\n', pos);
+
+      if (end == std::string::npos)
+        end = data.size ();
+
+      const char *text = data.c_str () + pos;
+      size_t length = end - pos;
+
+      pos = end + 1;
+      ++line;
+
+      while (length > 0 && isspace (text[length - 1]))
+        --length;
+
+      if (length == 0)
+        continue;
+
+      if (IsElementSet (text, length, '2'))
+        {
+          // element set 2 not preceded by element set 1
+          Entry entry = Entry ();
+
+          entry.line = line;
+          entry.error = FormatError;
+          entries.push_back (entry);
+          continue;
+        }
+
+      if (!IsElementSet (text, length, '1'))
+        {
+          // name line, "0 " prefixed in three-line element sets
+          if (length >= 2 && text[0] == '0' && text[1] == ' ')
+            {
+              text += 2;
+              length -= 2;
+            }
+
+          name = text;
+          nameLength = std::min<size_t> (length, Satellite::TleSatNameWidth);
+          nameLine = line;
+          continue;
+        }
+
+      Entry entry = Entry ();
+
+      entry.line = line;
+      entry.line1 = text;
+      entry.length1 = length;
+
+      if (nameLine + 1 == line)
+        {
+          entry.name = name;
+          entry.nameLength = nameLength;
+        }
+
+      // element set 2 must follow right away
+      if (pos < data.size () && IsElementSet (data.c_str () + pos,
+                                              data.size () - pos, '2'))
+        {
+          end = data.find ('\n', pos);
+
+          if (end == std::string::npos)
+            end = data.size ();
+
+          entry.line2 = data.c_str () + pos;
+          entry.length2 = end - pos;
+
+          while (entry.length2 > 0 && isspace (entry.line2[entry.length2 - 1]))
+            --entry.length2;
+
+          pos = end + 1;
+          ++line;
+        }
+      else
+        entry.error = FormatError;
+
+      entries.push_back (entry);
+    }
+
+  // initialize the SGP4/SDP4 records on the worker threads
+  uint32_t threads = m_threads;
+
+  if (threads == 0)
+    threads = std::max<long> (sysconf (_SC_NPROCESSORS_ONLN), 1);
+
+  threads = std::max<uint32_t> (std::min<size_t> (threads, entries.size ()), 1);
+
+  NS_LOG_INFO ("Initializing " << entries.size () << " entries on " << threads
+               << " threads");
+
+  std::vector<Worker> workers;
+
+  for (uint32_t c = 0; c < threads; ++c)
+    workers.push_back (Worker (
+      entries, static_cast<uint64_t> (entries.size ())*c/threads,
+      static_cast<uint64_t> (entries.size ())*(c + 1)/threads
+    ));
+
+  if (threads == 1)
+    workers[0].Run ();
+  else
+    {
+      std::vector<Ptr<SystemThread> > running;
+
+      for (uint32_t c = 0; c < threads; ++c)
+        {
+          running.push_back (
+            Create<SystemThread> (MakeCallback (&Worker::Run, &workers[c]))
+          );
+          running.back ()->Start ();
+        }
+
+      for (uint32_t c = 0; c < threads; ++c)
+        running[c]->Join ();
+    }
+
+  // create the satellites of the valid entries
+  for (uint32_t i = 0; i < entries.size (); ++i)
+    {
+      const Entry &entry = entries[i];
+      const std::string name (entry.name ? entry.name : "", entry.nameLength);
+
+      if (entry.error != 0)
+        {
+          Rejection rejection;
+
+          rejection.line = entry.line;
+          rejection.name = name;
+          rejection.error = entry.error;
+
+          NS_LOG_WARN ("Rejected entry at line " << entry.line << ": "
+                       << GetErrorString (entry.error));
+
+          m_rejections.push_back (rejection);
+          continue;
+        }
+
+      Ptr<Satellite> sat = CreateObject<Satellite> ();
+
+      sat->m_sgp4_record = entry.record;
+
+      if (!name.empty ())
+        sat->SetName (name);
+
+      if (m_keepTle)
+        {
+          sat->m_tle1.assign (entry.line1, entry.length1);
+          sat->m_tle2.assign (entry.line2, entry.length2);
+        }
+
+      m_satellites.push_back (sat);
+    }
+}
+
+uint32_t
+TleCatalog::GetNSatellites (void) const
+{
+  return m_satellites.size ();
+}
+
+Ptr<Satellite>
+TleCatalog::GetSatellite (uint32_t i) const
+{
+  NS_ASSERT (i < m_satellites.size ());
+
+  return m_satellites[i];
+}
+
+const std::vector<Ptr<Satellite> >&
+TleCatalog::GetSatellites (void) const
+{
+  return m_satellites;
+}
+
+const std::vector<TleCatalog::Rejection>&
+TleCatalog::GetRejections (void) const
+{
+  return m_rejections;
+}
+
+void
+TleCatalog::PrintReport (std::ostream &os) const
+{
+  os << m_satellites.size () << " satellites loaded, " << m_rejections.size ()
+     << " entries rejected" << std::endl;
+
+  for (uint32_t i = 0; i < m_rejections.size (); ++i)
+    {
+      const Rejection &rejection = m_rejections[i];
+
+      os << "line " << rejection.line;
+
+      if (!rejection.name.empty ())
+        os << " (" << rejection.name << ")";
+
+      os << ": error " << rejection.error << ", "
+         << GetErrorString (rejection.error) << std::endl;
+    }
+}
+
+std::string
+TleCatalog::GetErrorString (int error)
+{
+  switch (error)
+    {
+    case FormatError:
+      return "malformed element set lines";
+    case ChecksumError:
+      return "wrong checksum";
+    case 1:
+      return "mean eccentricity out of range or semi-major axis below 0.95 "
+             "Earth radii";
+    case 2:
+      return "negative mean motion";
+    case 3:
+      return "perturbed eccentricity out of range";
+    case 4:
+      return "negative semi-latus rectum";
+    case 5:
+      return "sub-orbital epoch elements";
+    case 6:
+      return "satellite has decayed";
+    default:
+      return "unknown error";
+    }
+}
+
+uint32_t
+TleCatalog::ComputeChecksum (const char *line)
+{
+  uint32_t sum = 0;
+
+  // digits count as their value, minus signs as 1
+  for (uint32_t i = 0; i < Satellite::TleSatInfoWidth - 1; ++i)
+    {
+      if (line[i] >= '0' && line[i] <= '9')
+        sum += line[i] - '0';
+      else if (line[i] == '-')
+        sum += 1;
+    }
+
+  return sum % 10;
+}
+
+void
+TleCatalog::Initialize (Entry &entry)
+{
+  const uint32_t width = Satellite::TleSatInfoWidth;
+
+  if (entry.error != 0)
+    return;
+
+  if (entry.length1 != width || entry.length2 != width)
+    {
+      entry.error = FormatError;
+      return;
+    }
+
+  if (static_cast<char> ('0' + ComputeChecksum (entry.line1)) != entry.line1[width - 1] ||
+      static_cast<char> ('0' + ComputeChecksum (entry.line2)) != entry.line2[width - 1])
+    {
+      entry.error = ChecksumError;
+      return;
+    }
+
+  // twoline2rv modifies the lines it parses (and may read past their end)
+  char l1[130], l2[130];
+  double start, stop, delta, r[3], v[3];
+
+  memset (l1, 0, sizeof (l1));
+  memset (l2, 0, sizeof (l2));
+  memcpy (l1, entry.line1, width);
+  memcpy (l2, entry.line2, width);
+
+  // same modes as Satellite::SetTleInfo
+  twoline2rv (
+    l1, l2, 'c', 'e', 'i', Satellite::WGeoSys, start, stop, delta, entry.record
+  );
+  sgp4 (Satellite::WGeoSys, entry.record, 0, r, v);
+
+  entry.error = entry.record.error;
+}
+
+}
@@ -0,0 +1,178 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 INESC TEC
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef TLE_CATALOG_H
+#define TLE_CATALOG_H
+
+#include <ostream>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "ns3/type-id.h"
+
+#include "satellite.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup satellite
+ * @brief Bulk loader of TLE catalog files.
+ *
+ * Initializing the satellites of a catalog one by one through
+ * Satellite::SetTleInfo parses each entry, initializes SGP4/SDP4 and runs a
+ * test propagation in turn. This class reads a whole catalog file at once and
+ * does that work on several threads, each taking a share of the entries,
+ * before creating the Satellite objects of the valid ones.
+ *
+ * Catalogs may be in two-line or three-line format (as provided by, e.g.,
+ * https://celestrak.com/NORAD/elements/), the name line being optional and
+ * possibly starting with "0 ". Entries are rejected if their lines are
+ * malformed, their checksums are wrong, or SGP4/SDP4 fails at the TLE epoch;
+ * the rejections, with the SGP4/SDP4 error codes, are available after loading.
+ *
+ * When KeepTle is false, the satellites do not keep a copy of their TLE lines
+ * once their SGP4/SDP4 records are built, which saves memory on large
+ * catalogs; Satellite::GetTleInfo then returns empty strings.
+ */
+class TleCatalog : public Object {
+public:
+  /// error codes of rejected entries (positive codes are from SGP4/SDP4)
+  enum Error {
+    FormatError = -1,                             //!< malformed lines.
+    ChecksumError = -2,                           //!< wrong checksum.
+  };
+
+  /// rejected catalog entry
+  struct Rejection {
+    uint32_t line;                                //!< line of element set 1.
+    std::string name;                             //!< entry name, if any.
+    int error;                                    //!< error code.
+  };
+
+  /**
+   * @brief Get the type ID.
+   * @return the object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * @brief Default constructor.
+   */
+  TleCatalog (void);
+
+  /**
+   * @brief Destructor.
+   */
+  virtual ~TleCatalog (void);
+
+  /**
+   * @brief Load a catalog file, discarding the previously loaded satellites.
+   * @param filename the name of the file.
+   * @return a boolean indicating whether the file could be read.
+   */
+  bool Load (const std::string &filename);
+
+  /**
+   * @brief Load a catalog from memory, discarding the previously loaded
+   *        satellites.
+   * @param data the catalog's contents.
+   */
+  void Parse (const std::string &data);
+
+  /**
+   * @brief Get the number of satellites loaded.
+   * @return the number of satellites.
+   */
+  uint32_t GetNSatellites (void) const;
+
+  /**
+   * @brief Get a satellite.
+   * @param i the index of the satellite, in catalog order.
+   * @return the satellite.
+   */
+  Ptr<Satellite> GetSatellite (uint32_t i) const;
+
+  /**
+   * @brief Get all satellites.
+   * @return the satellites, in catalog order.
+   */
+  const std::vector<Ptr<Satellite> >& GetSatellites (void) const;
+
+  /**
+   * @brief Get the rejected entries.
+   * @return the rejected entries, in catalog order.
+   */
+  const std::vector<Rejection>& GetRejections (void) const;
+
+  /**
+   * @brief Print a report of the rejected entries.
+   * @param os the output stream.
+   */
+  void PrintReport (std::ostream &os) const;
+
+  /**
+   * @brief Describe an error code.
+   * @param error the error code.
+   * @return the description of the error.
+   */
+  static std::string GetErrorString (int error);
+
+  /**
+   * @brief Compute the checksum of a TLE line.
+   * @param line the first 68 characters of the line.
+   * @return the checksum (0 to 9).
+   */
+  static uint32_t ComputeChecksum (const char *line);
+
+private:
+  virtual void DoDispose (void);
+
+  class Worker;
+
+  /// catalog entry being loaded
+  struct Entry {
+    uint32_t line;                                //!< line of element set 1.
+    const char *name;                             //!< name (not terminated).
+    size_t nameLength;                            //!< name length.
+    const char *line1;                            //!< element set 1.
+    size_t length1;                               //!< element set 1 length.
+    const char *line2;                            //!< element set 2.
+    size_t length2;                               //!< element set 2 length.
+    int error;                                    //!< error code.
+    elsetrec record;                              //!< SGP4/SDP4 record.
+  };
+
+  /**
+   * @brief Validate an entry and initialize its SGP4/SDP4 record.
+   * @param entry the entry.
+   */
+  static void Initialize (Entry &entry);
+
+  uint32_t m_threads;                             //!< worker threads.
+  bool m_keepTle;                                 //!< keep TLE lines.
+  std::vector<Ptr<Satellite> > m_satellites;      //!< loaded satellites.
+  std::vector<Rejection> m_rejections;            //!< rejected entries.
+};
+
+}
+
+#endif /* TLE_CATALOG_H */
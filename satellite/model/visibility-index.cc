@@ -0,0 +1,363 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 INESC TEC
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "visibility-index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "ns3/assert.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("VisibilityIndex");
+
+const double VisibilityIndex::DefaultCellSize = 1000e3;
+
+namespace {
+
+/// bits of each grid coordinate in cell keys
+const uint32_t CellBits = 21;
+/// offset making grid coordinates non-negative
+const int64_t CellOffset = 1 << (CellBits - 1);
+/// largest grid coordinate
+const int64_t CellMax = (1 << CellBits) - 1;
+
+/// WGS84 semi-major axis (m)
+const double WgsA = 6378137.0;
+/// WGS84 semi-minor axis (m)
+const double WgsB = WgsA*(1 - 1/298.257223563);
+/// upper bound of the angle between the geodetic and geocentric verticals
+const double VerticalMargin = 0.2*M_PI/180;
+
+}
+
+VisibilityIndex::VisibilityIndex (double cellSize) :
+  m_cellSize (cellSize), m_maxRadius (0)
+{
+  NS_ASSERT_MSG (cellSize > 0, "Cell size must be positive!");
+}
+
+double
+VisibilityIndex::GetCellSize (void) const
+{
+  return m_cellSize;
+}
+
+void
+VisibilityIndex::Build (const std::vector<Vector3D> &positions)
+{
+  NS_LOG_FUNCTION (this << positions.size ());
+
+  const uint32_t n = positions.size ();
+
+  m_x.resize (n);
+  m_y.resize (n);
+  m_z.resize (n);
+
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      m_x[i] = positions[i].x;
+      m_y[i] = positions[i].y;
+      m_z[i] = positions[i].z;
+    }
+
+  Sort ();
+}
+
+void
+VisibilityIndex::Build (const ConstellationPropagator::StateTable &table)
+{
+  NS_LOG_FUNCTION (this << table.x.size ());
+
+  m_x = table.x;
+  m_y = table.y;
+  m_z = table.z;
+
+  Sort ();
+}
+
+uint32_t
+VisibilityIndex::GetN (void) const
+{
+  return m_ids.size ();
+}
+
+double
+VisibilityIndex::GetMaxRadius (void) const
+{
+  return m_maxRadius;
+}
+
+Vector3D
+VisibilityIndex::GetPosition (uint32_t i) const
+{
+  NS_ASSERT (i < m_slots.size ());
+
+  const uint32_t j = m_slots[i];
+
+  return Vector3D (m_x[j], m_y[j], m_z[j]);
+}
+
+template <typename F>
+void
+VisibilityIndex::Visit (const Vector3D &p, double range, F f) const
+{
+  if (m_ids.empty () || range < 0)
+    return;
+
+  // no position lies outside the sphere of radius m_maxRadius
+  const double lim = m_maxRadius;
+  const uint64_t ix0 = GetCell (std::max (p.x - range, -lim));
+  const uint64_t ix1 = GetCell (std::min (p.x + range, lim));
+  const uint64_t iy0 = GetCell (std::max (p.y - range, -lim));
+  const uint64_t iy1 = GetCell (std::min (p.y + range, lim));
+  const uint64_t iz0 = GetCell (std::max (p.z - range, -lim));
+  const uint64_t iz1 = GetCell (std::min (p.z + range, lim));
+  const double r2 = range*range;
+
+  for (uint64_t ix = ix0; ix <= ix1; ++ix)
+    {
+      // distance from p to the slab of cells ix along x
+      const double x0 = (static_cast<int64_t> (ix) - CellOffset)*m_cellSize;
+      const double dx = std::max (
+        std::max (x0 - p.x, p.x - x0 - m_cellSize), 0.0
+      );
+
+      for (uint64_t iy = iy0; iy <= iy1; ++iy)
+        {
+          const double y0 = (static_cast<int64_t> (iy) - CellOffset)*m_cellSize;
+          const double dy = std::max (
+            std::max (y0 - p.y, p.y - y0 - m_cellSize), 0.0
+          );
+
+          // skip columns out of range
+          if (dx*dx + dy*dy > r2)
+            continue;
+
+          const std::vector<uint64_t>::const_iterator lo = std::lower_bound (
+            m_keys.begin (), m_keys.end (), GetKey (ix, iy, iz0)
+          );
+          const std::vector<uint64_t>::const_iterator hi = std::upper_bound (
+            lo, m_keys.end (), GetKey (ix, iy, iz1)
+          );
+
+          for (uint32_t j = lo - m_keys.begin (); j < hi - m_keys.begin (); ++j)
+            {
+              const double ex = m_x[j] - p.x;
+              const double ey = m_y[j] - p.y;
+              const double ez = m_z[j] - p.z;
+              const double d2 = ex*ex + ey*ey + ez*ez;
+
+              if (d2 <= r2)
+                f (j, d2);
+            }
+        }
+    }
+}
+
+
+void
+VisibilityIndex::FindInRange (
+  const Vector3D &p, double range, std::vector<uint32_t> &result
+) const
+{
+  result.clear ();
+
+  const std::vector<uint32_t> &ids = m_ids;
+
+  Visit (p, range, [&result, &ids] (uint32_t j, double) {
+    result.push_back (ids[j]);
+  });
+
+  std::sort (result.begin (), result.end ());
+}
+
+void
+VisibilityIndex::FindNearest (
+  const Vector3D &p, uint32_t k, std::vector<uint32_t> &result
+) const
+{
+  result.clear ();
+
+  if (k == 0 || m_ids.empty ())
+    return;
+
+  std::vector<std::pair<double, uint32_t> > candidates;
+  const double all = sqrt (p.x*p.x + p.y*p.y + p.z*p.z) + m_maxRadius;
+  double range = m_cellSize;
+
+  // grow the search sphere until it holds k positions (those nearest to p are
+  // then necessarily among them)
+  for (;;)
+    {
+      candidates.clear ();
+
+      const std::vector<uint32_t> &ids = m_ids;
+
+      Visit (p, range, [&candidates, &ids] (uint32_t j, double d2) {
+        candidates.push_back (std::make_pair (d2, ids[j]));
+      });
+
+      if (candidates.size () >= k || range >= all)
+        break;
+
+      range = std::min (2*range, all);
+    }
+
+  const uint32_t m = std::min<uint32_t> (k, candidates.size ());
+
+  std::partial_sort (
+    candidates.begin (), candidates.begin () + m, candidates.end ()
+  );
+
+  for (uint32_t i = 0; i < m; ++i)
+    result.push_back (candidates[i].second);
+}
+
+void
+VisibilityIndex::FindVisible (
+  const Vector3D &station, double minElevation, std::vector<uint32_t> &result
+) const
+{
+  result.clear ();
+
+  // the slant range bound is computed for the geocentric vertical, which is
+  // within VerticalMargin of the geodetic one near the Earth's surface
+  const double range = GetMaxSlantRange (
+    station, minElevation - VerticalMargin, m_maxRadius
+  );
+
+  if (range < 0)
+    return;
+
+  const std::vector<uint32_t> &ids = m_ids;
+  const std::vector<double> &x = m_x, &y = m_y, &z = m_z;
+
+  Visit (station, range, [&] (uint32_t j, double) {
+    if (IsVisible (station, minElevation, Vector3D (x[j], y[j], z[j])))
+      result.push_back (ids[j]);
+  });
+
+  std::sort (result.begin (), result.end ());
+}
+
+bool
+VisibilityIndex::IsVisible (
+  const Vector3D &station, double minElevation, const Vector3D &p
+)
+{
+  // normal to the ellipsoid at the station
+  double nx = station.x/(WgsA*WgsA);
+  double ny = station.y/(WgsA*WgsA);
+  double nz = station.z/(WgsB*WgsB);
+  const double norm = sqrt (nx*nx + ny*ny + nz*nz);
+
+  if (norm == 0)
+    return false;
+
+  nx /= norm;
+  ny /= norm;
+  nz /= norm;
+
+  const double dx = p.x - station.x, dy = p.y - station.y, dz = p.z - station.z;
+  const double d = sqrt (dx*dx + dy*dy + dz*dz);
+
+  return (dx*nx + dy*ny + dz*nz >= d*sin (minElevation));
+}
+
+double
+VisibilityIndex::GetMaxSlantRange (
+  const Vector3D &station, double minElevation, double radius
+)
+{
+  // solve |station + d*u| = radius for the slant range d, where u is a unit
+  // vector at the given elevation above the geocentric horizon
+  const double r = sqrt (
+    station.x*station.x + station.y*station.y + station.z*station.z
+  );
+  const double s = sin (std::max (minElevation, -M_PI/2));
+  const double disc = r*r*s*s + radius*radius - r*r;
+
+  if (disc < 0)
+    return -1;
+
+  const double d = -r*s + sqrt (disc);
+
+  return (d < 0 ? -1 : d);
+}
+
+uint64_t
+VisibilityIndex::GetCell (double x) const
+{
+  const int64_t i = static_cast<int64_t> (floor (x/m_cellSize)) + CellOffset;
+
+  return static_cast<uint64_t> (std::min (std::max (i, int64_t (0)), CellMax));
+}
+
+uint64_t
+VisibilityIndex::GetKey (uint64_t ix, uint64_t iy, uint64_t iz)
+{
+  return (ix << (2*CellBits)) | (iy << CellBits) | iz;
+}
+
+void
+VisibilityIndex::Sort (void)
+{
+  const uint32_t n = m_x.size ();
+  std::vector<std::pair<uint64_t, uint32_t> > order (n);
+
+  m_maxRadius = 0;
+
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      order[i].first = GetKey (
+        GetCell (m_x[i]), GetCell (m_y[i]), GetCell (m_z[i])
+      );
+      order[i].second = i;
+
+      m_maxRadius = std::max (
+        m_maxRadius, sqrt (m_x[i]*m_x[i] + m_y[i]*m_y[i] + m_z[i]*m_z[i])
+      );
+    }
+
+  std::sort (order.begin (), order.end ());
+
+  const std::vector<double> x (m_x), y (m_y), z (m_z);
+
+  m_ids.resize (n);
+  m_keys.resize (n);
+  m_slots.resize (n);
+
+  for (uint32_t j = 0; j < n; ++j)
+    {
+      const uint32_t i = order[j].second;
+
+      m_keys[j] = order[j].first;
+      m_ids[j] = i;
+      m_slots[i] = j;
+      m_x[j] = x[i];
+      m_y[j] = y[i];
+      m_z[j] = z[i];
+    }
+}
+
+}
@@ -0,0 +1,208 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 INESC TEC
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef VISIBILITY_INDEX_H
+#define VISIBILITY_INDEX_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "ns3/vector.h"
+
+#include "constellation-propagator.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup satellite
+ * @brief Uniform grid index of satellite positions for visibility queries.
+ *
+ * Finding the satellites a ground station sees above a minimum elevation, or
+ * those within inter-satellite link range of another satellite, takes one
+ * test per satellite when done by brute force. This index sorts a snapshot of
+ * the satellite positions (ITRF, i.e., Earth-fixed, to be rebuilt on every
+ * time step, e.g., from ConstellationPropagator::GetItrfTable) into the cells
+ * of a uniform cubic grid, so that queries only test the satellites in the
+ * cells overlapping the region of interest.
+ *
+ * Cells are identified by a 64-bit key made of their three 21-bit integer
+ * coordinates, x being the most significant. Positions are stored sorted by
+ * key, so that the cells of a grid column along z occupy a contiguous range
+ * found with two binary searches. Building the index is O(N log N); a query
+ * of radius r costs O((r/c)^2 log N) searches for a cell size c, plus one test
+ * per satellite in the cells visited. The cell size should be of the order of
+ * the typical query radius: too small and many empty columns are searched,
+ * too large and many satellites out of range are tested.
+ *
+ * Query results are satellite indexes (the order in which positions were
+ * given), in ascending order except for KNearest, which sorts them by
+ * distance.
+ */
+class VisibilityIndex {
+public:
+  /// Default cell size (m).
+  static const double DefaultCellSize;
+
+  /**
+   * @brief Constructor.
+   * @param cellSize the length of the side of the grid cells (m).
+   */
+  VisibilityIndex (double cellSize = DefaultCellSize);
+
+  /**
+   * @brief Get the length of the side of the grid cells.
+   * @return the cell size (m).
+   */
+  double GetCellSize (void) const;
+
+  /**
+   * @brief Index a set of positions, discarding the previous ones.
+   * @param positions the satellite positions (m), by satellite index.
+   */
+  void Build (const std::vector<Vector3D> &positions);
+
+  /**
+   * @brief Index the positions of a state table, discarding the previous ones.
+   * @param table the state table (e.g., ConstellationPropagator's ITRF one).
+   */
+  void Build (const ConstellationPropagator::StateTable &table);
+
+  /**
+   * @brief Get the number of indexed positions.
+   * @return the number of satellites.
+   */
+  uint32_t GetN (void) const;
+
+  /**
+   * @brief Get the largest distance of an indexed position from the origin.
+   * @return the largest orbit radius (m).
+   */
+  double GetMaxRadius (void) const;
+
+  /**
+   * @brief Get an indexed position.
+   * @param i the satellite index.
+   * @return the satellite's position (m).
+   */
+  Vector3D GetPosition (uint32_t i) const;
+
+  /**
+   * @brief Find the satellites within a given distance of a point.
+   * @param p the point (m).
+   * @param range the distance (m).
+   * @param result the satellite indexes, in ascending order.
+   */
+  void FindInRange (
+    const Vector3D &p, double range, std::vector<uint32_t> &result
+  ) const;
+
+  /**
+   * @brief Find the satellites nearest to a point.
+   *
+   * Fewer than k indexes are returned if fewer than k positions are indexed.
+   *
+   * @param p the point (m).
+   * @param k the number of satellites.
+   * @param result the satellite indexes, nearest first.
+   */
+  void FindNearest (
+    const Vector3D &p, uint32_t k, std::vector<uint32_t> &result
+  ) const;
+
+  /**
+   * @brief Find the satellites seen from a ground station above an elevation.
+   *
+   * The elevation is measured above the plane normal to the WGS84 ellipsoid
+   * (i.e., the local horizon of geodetic coordinates) at the station.
+   *
+   * @param station the ground station's position (m, ITRF).
+   * @param minElevation the elevation mask (radians).
+   * @param result the satellite indexes, in ascending order.
+   */
+  void FindVisible (
+    const Vector3D &station, double minElevation, std::vector<uint32_t> &result
+  ) const;
+
+  /**
+   * @brief Check if a point is seen from a ground station above an elevation.
+   * @param station the ground station's position (m, ITRF).
+   * @param minElevation the elevation mask (radians).
+   * @param p the point (m, ITRF).
+   * @return a boolean indicating whether p is above the elevation mask.
+   */
+  static bool IsVisible (
+    const Vector3D &station, double minElevation, const Vector3D &p
+  );
+
+  /**
+   * @brief Get the largest distance at which a point can be seen from a
+   *        ground station above an elevation.
+   * @param station the ground station's position (m, ITRF).
+   * @param minElevation the elevation mask (radians).
+   * @param radius the largest distance of the point from the Earth's center.
+   * @return the slant range bound (m), or a negative value if no point within
+   *         radius can be seen.
+   */
+  static double GetMaxSlantRange (
+    const Vector3D &station, double minElevation, double radius
+  );
+
+private:
+  /**
+   * @brief Get the integer grid coordinate of a position coordinate.
+   * @param x the position coordinate (m).
+   * @return the grid coordinate, offset to be non-negative.
+   */
+  uint64_t GetCell (double x) const;
+
+  /**
+   * @brief Get the key of a cell.
+   * @param ix the grid coordinate along x.
+   * @param iy the grid coordinate along y.
+   * @param iz the grid coordinate along z.
+   * @return the cell key.
+   */
+  static uint64_t GetKey (uint64_t ix, uint64_t iy, uint64_t iz);
+
+  /**
+   * @brief Sort the positions set in m_x, m_y and m_z by cell.
+   */
+  void Sort (void);
+
+  /**
+   * @brief Visit the positions within a given distance of a point.
+   * @param p the point (m).
+   * @param range the distance (m).
+   * @param f the function called with the sorted position index and squared
+   *          distance of each position in range.
+   */
+  template <typename F>
+  void Visit (const Vector3D &p, double range, F f) const;
+
+  double m_cellSize;                              //!< cell size (m).
+  double m_maxRadius;                             //!< largest radius (m).
+  std::vector<double> m_x, m_y, m_z;              //!< positions, by cell.
+  std::vector<uint32_t> m_ids;                    //!< satellite indexes.
+  std::vector<uint64_t> m_keys;                   //!< cell keys.
+  std::vector<uint32_t> m_slots;                  //!< sorted slot, by index.
+};
+
+}
+
+#endif /* VISIBILITY_INDEX_H */
@@ -0,0 +1,1284 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 INESC TEC
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "ns3/boolean.h"
+#include "ns3/constellation-clock.h"
+#include "ns3/ephemeris.h"
+#include "ns3/ephemeris-file.h"
+#include "ns3/frame-transform.h"
+#include "ns3/julian-date.h"
+#include "ns3/log.h"
+#include "ns3/nstime.h"
+#include "ns3/ptr.h"
+#include "ns3/satellite.h"
+#include "ns3/satellite-position-mobility-model.h"
+#include "ns3/simulator.h"
+#include "ns3/sgp4io.h"
+#include "ns3/sgp4simd.h"
+#include "ns3/sgp4unit.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/test.h"
+#include "ns3/tle-catalog.h"
+#include "ns3/uinteger.h"
+#include "ns3/vector-extensions.h"
+#include "ns3/visibility-index.h"
+
+NS_LOG_COMPONENT_DEFINE ("SatelliteTestSuite");
+
+using namespace ns3;
+
+// objects from the SGP4 verification set (AIAA-2006-6753): near earth with
+// normal and simplified drag equations, and deep space (resonant and GEO)
+static const char *g_tles[][2] = {
+  { "1 00005U 58002B   00179.78495062  .00000023  00000-0  28098-4 0  4753",
+    "2 00005  34.2682 348.7242 1859667 331.7664  19.3264 10.82419157413667" },
+  { "1 06251U 62025E   06176.82412014  .00008885  00000-0  12808-3 0  3985",
+    "2 06251  58.0579  54.0425 0030035 139.1568 221.1854 15.56387291  6774" },
+  { "1 28057U 03049A   06177.78615833  .00000060  00000-0  35940-4 0  1836",
+    "2 28057  98.4283 247.6961 0000884  88.1964 272.0001 14.34920402143719" },
+  { "1 28350U 04020A   06167.21788666  .16154492  76267-5  18678-3 0  8894",
+    "2 28350  64.9977 345.6130 0024870 260.7578  99.9590 16.47856722116490" },
+  { "1 08195U 75081A   06176.33215444  .00000099  00000-0  11873-3 0   813",
+    "2 08195  64.1586 279.0717 6877146 264.7651  20.2257  2.00491383225656" },
+  { "1 28626U 05008A   06176.46683397 -.00000205  00000-0  10000-3 0  2190",
+    "2 28626   0.0019 286.9433 0000335  13.7918  55.6504  1.00270176  4891" },
+  { "1 25544U 98067A   08264.51782528 -.00002182  00000-0 -11606-4 0  2927",
+    "2 25544  51.6416 247.4627 0006703 130.5360 325.0288 15.72125391563537" },
+};
+
+static const uint32_t g_nTles = sizeof (g_tles) / sizeof (g_tles[0]);
+
+/**
+ * Initialize the SGP4/SDP4 records of the verification objects.
+ */
+static std::vector<elsetrec>
+GetRecords (void)
+{
+  std::vector<elsetrec> records (g_nTles);
+
+  for (uint32_t i = 0; i < g_nTles; ++i)
+    {
+      char l1[130], l2[130];
+      double start, stop, delta;
+
+      strncpy (l1, g_tles[i][0], sizeof (l1));
+      strncpy (l2, g_tles[i][1], sizeof (l2));
+
+      twoline2rv (
+        l1, l2, 'c', 'e', 'i', wgs72, start, stop, delta, records[i]
+      );
+    }
+
+  return records;
+}
+
+/**
+ * Check that the data-parallel near earth kernel matches the scalar SGP4/SDP4
+ * propagator to within 1 mm (and 1 mm/s), with the same error codes.
+ */
+class Sgp4SimdTestCase : public TestCase
+{
+public:
+  Sgp4SimdTestCase ();
+  virtual ~Sgp4SimdTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+Sgp4SimdTestCase::Sgp4SimdTestCase ()
+  : TestCase ("Check that sgp4simd matches sgp4 for near earth and deep space objects")
+{
+}
+
+Sgp4SimdTestCase::~Sgp4SimdTestCase ()
+{
+}
+
+void
+Sgp4SimdTestCase::DoRun (void)
+{
+  const std::vector<elsetrec> records = GetRecords ();
+  const double tolerance = 1e-6;                // km and km/s
+
+  // replicate the objects so that every lane position is exercised
+  std::vector<elsetrec> batch;
+
+  for (uint32_t k = 0; k < 3; ++k)
+    batch.insert (batch.end (), records.begin (), records.end ());
+
+  const uint32_t n = batch.size ();
+  std::vector<double> tsince (n), r (3*n), v (3*n);
+
+  for (double t = -1440.0; t <= 4320.0; t += 7.3)
+    {
+      std::vector<elsetrec> scalar = batch, simd = batch;
+
+      for (uint32_t i = 0; i < n; ++i)
+        tsince[i] = t + i;
+
+      sgp4simd (
+        wgs72, &simd[0], &tsince[0], n,
+        reinterpret_cast<double (*)[3]> (&r[0]),
+        reinterpret_cast<double (*)[3]> (&v[0])
+      );
+
+      for (uint32_t i = 0; i < n; ++i)
+        {
+          double rs[3], vs[3];
+
+          sgp4 (wgs72, scalar[i], tsince[i], rs, vs);
+
+          NS_TEST_ASSERT_MSG_EQ (simd[i].error, scalar[i].error,
+                                 "Error codes differ for object " <<
+                                 scalar[i].satnum << " at " << tsince[i]);
+
+          if (scalar[i].error != 0)
+            continue;
+
+          for (uint32_t k = 0; k < 3; ++k)
+            {
+              NS_TEST_ASSERT_MSG_EQ_TOL (r[3*i+k], rs[k], tolerance,
+                                         "Position differs for object " <<
+                                         scalar[i].satnum << " at " << tsince[i]);
+              NS_TEST_ASSERT_MSG_EQ_TOL (v[3*i+k], vs[k], tolerance,
+                                         "Velocity differs for object " <<
+                                         scalar[i].satnum << " at " << tsince[i]);
+            }
+
+          NS_TEST_ASSERT_MSG_EQ_TOL (simd[i].mm_s, scalar[i].mm_s, 1e-9,
+                                     "Mean anomaly differs");
+          NS_TEST_ASSERT_MSG_EQ_TOL (simd[i].nodem_s, scalar[i].nodem_s, 1e-9,
+                                     "Right ascension differs");
+          NS_TEST_ASSERT_MSG_EQ_TOL (simd[i].argpm_s, scalar[i].argpm_s, 1e-9,
+                                     "Argument of perigee differs");
+        }
+    }
+}
+
+/**
+ * Compare the time taken by sgp4 and sgp4simd to propagate a homogeneous
+ * near earth constellation of 4000 satellites over 100 time steps.
+ */
+class Sgp4SimdBenchmarkTestCase : public TestCase
+{
+public:
+  Sgp4SimdBenchmarkTestCase ();
+  virtual ~Sgp4SimdBenchmarkTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+Sgp4SimdBenchmarkTestCase::Sgp4SimdBenchmarkTestCase ()
+  : TestCase ("Benchmark sgp4simd against sgp4 for 4000 near earth satellites")
+{
+}
+
+Sgp4SimdBenchmarkTestCase::~Sgp4SimdBenchmarkTestCase ()
+{
+}
+
+void
+Sgp4SimdBenchmarkTestCase::DoRun (void)
+{
+  const std::vector<elsetrec> records = GetRecords ();
+  const uint32_t n = 4000, steps = 100;
+  std::vector<elsetrec> batch;
+  std::vector<double> tsince (n), r (3*n), v (3*n);
+  SystemWallClockMs clock;
+
+  for (uint32_t i = 0; i < n; ++i)
+    batch.push_back (records[(i % 2) ? 2 : 6]);
+
+  clock.Start ();
+  for (uint32_t s = 0; s < steps; ++s)
+    for (uint32_t i = 0; i < n; ++i)
+      sgp4 (wgs72, batch[i], s, &r[3*i], &v[3*i]);
+  int64_t scalar = clock.End ();
+
+  clock.Start ();
+  for (uint32_t s = 0; s < steps; ++s)
+    {
+      std::fill (tsince.begin (), tsince.end (), s);
+      sgp4simd (
+        wgs72, &batch[0], &tsince[0], n,
+        reinterpret_cast<double (*)[3]> (&r[0]),
+        reinterpret_cast<double (*)[3]> (&v[0])
+      );
+    }
+  int64_t simd = clock.End ();
+
+  std::cout << "sgp4: " << scalar << " ms, sgp4simd (" << SGP4_SIMD_LANES
+            << " lanes): " << simd << " ms for " << n << " satellites x "
+            << steps << " steps" << std::endl;
+
+  NS_TEST_EXPECT_MSG_EQ (batch[0].error, 0, "Propagation failed");
+}
+
+/**
+ * Check that the TEME-ITRF transformation cache returns the same values as
+ * computing the transformation anew, and that it counts hits and misses.
+ */
+class FrameTransformCacheTestCase : public TestCase
+{
+public:
+  FrameTransformCacheTestCase ();
+  virtual ~FrameTransformCacheTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+FrameTransformCacheTestCase::FrameTransformCacheTestCase ()
+  : TestCase ("Check the TEME-ITRF transformation cache")
+{
+}
+
+FrameTransformCacheTestCase::~FrameTransformCacheTestCase ()
+{
+}
+
+void
+FrameTransformCacheTestCase::DoRun (void)
+{
+  const JulianDate t0 ("2016-06-20 12:00:00");
+  const Vector3D rteme (-4123.2, 5291.8, -1034.5), vteme (-3.1, -3.4, 6.0);
+
+  FrameTransform::ClearCache ();
+
+  for (uint32_t i = 0; i < 3; ++i)
+    {
+      const JulianDate t = t0 + MilliSeconds (250*i);
+      const FrameTransform computed = FrameTransform::Compute (t);
+      const FrameTransform first = FrameTransform::Get (t);
+      const FrameTransform second = FrameTransform::Get (t);
+
+      NS_TEST_ASSERT_MSG_EQ (first.GetTime (), t, "Wrong time instant");
+      NS_TEST_ASSERT_MSG_EQ (second.GetTime (), t, "Wrong time instant");
+      NS_TEST_ASSERT_MSG_EQ (first.GetOmegaEarth (), computed.GetOmegaEarth (),
+                             "Cached angular velocity differs");
+
+      const Vector3D r = computed.rTemeTorItrf (rteme);
+      const Vector3D v = computed.rvTemeTovItrf (rteme, vteme);
+      Vector3D rc, vc;
+
+      second.TemeToItrf (rteme, vteme, rc, vc);
+
+      NS_TEST_ASSERT_MSG_EQ (first.rTemeTorItrf (rteme), r,
+                             "Cached position conversion differs");
+      NS_TEST_ASSERT_MSG_EQ (rc, r, "Cached position conversion differs");
+      NS_TEST_ASSERT_MSG_EQ (vc, v, "Cached velocity conversion differs");
+
+      // a rotation preserves the length of the position vector
+      NS_TEST_ASSERT_MSG_EQ_TOL (r.GetLength (), rteme.GetLength (), 1e-9,
+                                 "Conversion is not a rotation");
+    }
+
+  NS_TEST_ASSERT_MSG_EQ (FrameTransform::GetCacheMisses (), 3,
+                         "Every new time instant should be a miss");
+  NS_TEST_ASSERT_MSG_EQ (FrameTransform::GetCacheHits (), 3,
+                         "Every repeated time instant should be a hit");
+
+  FrameTransform::ClearCache ();
+
+  NS_TEST_ASSERT_MSG_EQ (FrameTransform::GetCacheMisses (), 0,
+                         "Counters should have been reset");
+  NS_TEST_ASSERT_MSG_EQ (FrameTransform::GetCacheHits (), 0,
+                         "Counters should have been reset");
+}
+
+/**
+ * Check that the precomputed ephemeris of a satellite stays within its error
+ * bounds, and that it survives a save/load round trip.
+ */
+class EphemerisTestCase : public TestCase
+{
+public:
+  EphemerisTestCase ();
+  virtual ~EphemerisTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+EphemerisTestCase::EphemerisTestCase ()
+  : TestCase ("Check the precomputed satellite ephemeris")
+{
+}
+
+EphemerisTestCase::~EphemerisTestCase ()
+{
+}
+
+void
+EphemerisTestCase::DoRun (void)
+{
+  Ptr<Satellite> sat = CreateObject<Satellite> ();
+  Ptr<Satellite> ref = CreateObject<Satellite> ();
+  const std::string filename = CreateTempDirFilename ("25544.eph");
+
+  sat->SetTleInfo (g_tles[6][0], g_tles[6][1]);
+  ref->SetTleInfo (g_tles[6][0], g_tles[6][1]);
+
+  const JulianDate start = sat->GetTleEpoch ();
+  const JulianDate stop = start + Hours (6);
+
+  NS_TEST_ASSERT_MSG_EQ (sat->PrecomputeEphemeris (start, stop, Seconds (60)),
+                         true, "Ephemeris should have been computed");
+
+  const Ephemeris &eph = sat->GetEphemeris ();
+  const double rbound = eph.GetPositionErrorBound ();
+  const double vbound = eph.GetVelocityErrorBound ();
+
+  NS_TEST_ASSERT_MSG_EQ ((eph.GetStop () >= stop), true, "Interval too short");
+  NS_TEST_ASSERT_MSG_LT (rbound, 1.0, "Position bound too loose for LEO");
+  NS_TEST_ASSERT_MSG_LT (vbound, 0.1, "Velocity bound too loose for LEO");
+
+  for (JulianDate t = start; t <= stop; t += MilliSeconds (7919))
+    {
+      const double dr = CalculateDistance (sat->GetPosition (t),
+                                           ref->GetPosition (t));
+      const double dv = CalculateDistance (sat->GetVelocity (t),
+                                           ref->GetVelocity (t));
+      const double dreci = CalculateDistance (sat->GetPositionInECI (t),
+                                              ref->GetPositionInECI (t));
+      const double dveci = CalculateDistance (sat->GetVelocityInECI (t),
+                                              ref->GetVelocityInECI (t));
+
+      NS_TEST_ASSERT_MSG_LT_OR_EQ (dr, rbound, "Position error at " << t);
+      NS_TEST_ASSERT_MSG_LT_OR_EQ (dv, vbound, "Velocity error at " << t);
+      NS_TEST_ASSERT_MSG_LT_OR_EQ (dreci, rbound, "ECI position error at " << t);
+      NS_TEST_ASSERT_MSG_LT_OR_EQ (dveci, vbound, "ECI velocity error at " << t);
+    }
+
+  NS_TEST_ASSERT_MSG_EQ (sat->SaveEphemeris (filename), true,
+                         "Ephemeris should have been saved");
+
+  // a satellite initialized with the same TLE accepts the file
+  NS_TEST_ASSERT_MSG_EQ (ref->LoadEphemeris (filename), true,
+                         "Ephemeris should have been loaded");
+  NS_TEST_ASSERT_MSG_EQ (ref->GetEphemeris ().GetNNodes (), eph.GetNNodes (),
+                         "Wrong number of nodes");
+  NS_TEST_ASSERT_MSG_EQ (ref->GetEphemeris ().GetPositionErrorBound (), rbound,
+                         "Wrong position error bound");
+
+  for (JulianDate t = start; t <= stop; t += MilliSeconds (104729))
+    {
+      NS_TEST_ASSERT_MSG_EQ (ref->GetPosition (t), sat->GetPosition (t),
+                             "Loaded ephemeris differs at " << t);
+      NS_TEST_ASSERT_MSG_EQ (ref->GetVelocityInECI (t), sat->GetVelocityInECI (t),
+                             "Loaded ephemeris differs at " << t);
+    }
+
+  // while any other satellite rejects it
+  Ptr<Satellite> other = CreateObject<Satellite> ();
+
+  other->SetTleInfo (g_tles[2][0], g_tles[2][1]);
+
+  NS_TEST_ASSERT_MSG_EQ (other->LoadEphemeris (filename), false,
+                         "Ephemeris of another satellite should be rejected");
+  NS_TEST_ASSERT_MSG_EQ (other->GetEphemeris ().IsEmpty (), true,
+                         "Rejected ephemeris should have been discarded");
+}
+
+/**
+ * Check that a constellation ephemeris file reproduces the propagated states
+ * and serves SatellitePositionMobilityModel without any Satellite object.
+ */
+class EphemerisFileTestCase : public TestCase
+{
+public:
+  EphemerisFileTestCase ();
+  virtual ~EphemerisFileTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+EphemerisFileTestCase::EphemerisFileTestCase ()
+  : TestCase ("Check the memory-mapped constellation ephemeris file")
+{
+}
+
+EphemerisFileTestCase::~EphemerisFileTestCase ()
+{
+}
+
+void
+EphemerisFileTestCase::DoRun (void)
+{
+  const std::string filename = CreateTempDirFilename ("constellation.eph");
+  const uint32_t ids[] = { 6, 2, 0 };
+  std::vector<Ptr<Satellite> > sats;
+
+  for (uint32_t i = 0; i < 3; ++i)
+    {
+      Ptr<Satellite> sat = CreateObject<Satellite> ();
+
+      sat->SetTleInfo (g_tles[ids[i]][0], g_tles[ids[i]][1]);
+      sat->SetName ("SAT " + std::string (1, 'A' + i));
+      sats.push_back (sat);
+    }
+
+  const JulianDate start = sats[0]->GetTleEpoch ();
+  const JulianDate stop = start + Hours (2);
+
+  NS_TEST_ASSERT_MSG_EQ (
+    EphemerisFile::Write (filename, sats, start, stop, Seconds (30)), true,
+    "Ephemeris file should have been written"
+  );
+
+  Ptr<EphemerisFile> file = CreateObject<EphemerisFile> ();
+
+  NS_TEST_ASSERT_MSG_EQ (file->Open (filename), true,
+                         "Ephemeris file should have been mapped");
+  NS_TEST_ASSERT_MSG_EQ (file->GetNSatellites (), 3, "Wrong satellites");
+  NS_TEST_ASSERT_MSG_EQ (file->GetNSamples (), 241, "Wrong samples");
+  NS_TEST_ASSERT_MSG_EQ (file->GetStart (), start, "Wrong start");
+  NS_TEST_ASSERT_MSG_EQ (file->GetStop (), stop, "Wrong stop");
+
+  for (uint32_t i = 0; i < 3; ++i)
+    {
+      uint32_t index;
+
+      NS_TEST_ASSERT_MSG_EQ (file->GetSatelliteName (i), sats[i]->GetName (),
+                             "Wrong name");
+      NS_TEST_ASSERT_MSG_EQ (file->FindSatellite (sats[i]->GetSatelliteNumber (),
+                                                  index), true,
+                             "Satellite should have been found");
+      NS_TEST_ASSERT_MSG_EQ (index, i, "Wrong index");
+
+      for (JulianDate t = start; t <= stop; t += MilliSeconds (9973))
+        {
+          // the interpolation error is well below 10 m for LEO at 30 s
+          NS_TEST_ASSERT_MSG_LT (
+            CalculateDistance (file->GetPosition (i, t),
+                               sats[i]->GetPosition (t)), 10,
+            "Position of satellite " << i << " differs at " << t
+          );
+          // SGP4 velocities of object 00005, years away from its epoch, are
+          // about 1 m/s off the derivative of its positions
+          NS_TEST_ASSERT_MSG_LT (
+            CalculateDistance (file->GetVelocityInECI (i, t),
+                               sats[i]->GetVelocityInECI (t)), 2,
+            "ECI velocity of satellite " << i << " differs at " << t
+          );
+        }
+    }
+
+  // the mobility model needs no satellite object at all
+  Ptr<SatellitePositionMobilityModel> model =
+    CreateObject<SatellitePositionMobilityModel> ();
+
+  model->SetStartTime (start);
+  model->SetEphemerisFile (file, 1);
+
+  NS_TEST_ASSERT_MSG_EQ (model->GetSatelliteName (), sats[1]->GetName (),
+                         "Wrong satellite name");
+  NS_TEST_ASSERT_MSG_EQ_TOL (CalculateDistance (model->GetPosition (),
+                                                sats[1]->GetPosition (start)),
+                             0, 1e-3, "Wrong mobility model position");
+  NS_TEST_ASSERT_MSG_EQ_TOL (CalculateDistance (model->GetVelocity (),
+                                                sats[1]->GetVelocity (start)),
+                             0, 1e-3, "Wrong mobility model velocity");
+
+  file->Dispose ();
+
+  NS_TEST_ASSERT_MSG_EQ (file->IsOpen (), false, "File should be unmapped");
+
+  // an interpolation segment needs two samples
+  NS_TEST_ASSERT_MSG_EQ (
+    EphemerisFile::Write (filename, sats, start, start, Seconds (30)), false,
+    "Empty interval should have been rejected"
+  );
+  NS_TEST_ASSERT_MSG_EQ (
+    EphemerisFile::Write (filename, sats, start, stop, MicroSeconds (500)),
+    false, "Sub-millisecond step should have been rejected"
+  );
+  NS_TEST_ASSERT_MSG_EQ (
+    EphemerisFile::Write (filename, sats, start, start + MilliSeconds (1),
+                          Seconds (30)), true,
+    "Shortest interval should have been written"
+  );
+  NS_TEST_ASSERT_MSG_EQ (file->Open (filename), true,
+                         "Shortest interval should have been mapped");
+  NS_TEST_ASSERT_MSG_EQ (file->GetNSamples (), 2, "Wrong samples");
+  NS_TEST_ASSERT_MSG_EQ (file->Covers (2, start + Seconds (30)), true,
+                         "Last sample should be covered");
+  NS_TEST_ASSERT_MSG_LT (CalculateDistance (file->GetPosition (2, start),
+                                            sats[2]->GetPosition (start)),
+                         1e-3, "Wrong position at the first sample");
+
+  // sub-orbital object of the SGP4 verification set, decayed after ~50 min
+  Ptr<Satellite> decayed = CreateObject<Satellite> ();
+
+  decayed->SetTleInfo (
+    "1 28872U 05037B   05333.02012661  .25992681  00000-0  24476-3 0  1534",
+    "2 28872  96.4736 157.9986 0303955 244.0492 110.6523 16.46015938 10708"
+  );
+  sats.push_back (decayed);
+
+  const JulianDate epoch = decayed->GetTleEpoch ();
+
+  NS_TEST_ASSERT_MSG_EQ (
+    EphemerisFile::Write (filename, sats, epoch, epoch + Hours (2),
+                          Seconds (60)), true,
+    "Ephemeris file should have been written"
+  );
+  NS_TEST_ASSERT_MSG_EQ (file->Open (filename), true,
+                         "Ephemeris file should have been mapped");
+  NS_TEST_ASSERT_MSG_EQ (file->Covers (epoch + Hours (2)), true,
+                         "Interval should be covered");
+  NS_TEST_ASSERT_MSG_EQ (file->Covers (1, epoch + Hours (2)), true,
+                         "Propagated satellite should be covered");
+  NS_TEST_ASSERT_MSG_EQ (file->Covers (3, epoch + Minutes (30)), true,
+                         "Satellite should be covered before decaying");
+  NS_TEST_ASSERT_MSG_EQ (file->Covers (3, epoch + Hours (1)), false,
+                         "Satellite should not be covered after decaying");
+  NS_TEST_ASSERT_MSG_LT (
+    CalculateDistance (file->GetPosition (3, epoch + Minutes (30)),
+                       decayed->GetPosition (epoch + Minutes (30))), 10,
+    "Wrong position before decaying"
+  );
+
+  file->Dispose ();
+}
+
+/**
+ * Check that the satellite's state cache is keyed on the query time, that a
+ * single propagation serves position and velocity in both frames, and that
+ * time keys can be quantized.
+ */
+class SatelliteStateCacheTestCase : public TestCase
+{
+public:
+  SatelliteStateCacheTestCase ();
+  virtual ~SatelliteStateCacheTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+SatelliteStateCacheTestCase::SatelliteStateCacheTestCase ()
+  : TestCase ("Check the satellite state cache")
+{
+}
+
+SatelliteStateCacheTestCase::~SatelliteStateCacheTestCase ()
+{
+}
+
+void
+SatelliteStateCacheTestCase::DoRun (void)
+{
+  std::vector<elsetrec> records = GetRecords ();
+  Ptr<Satellite> sat = CreateObject<Satellite> ();
+
+  sat->SetTleInfo (g_tles[6][0], g_tles[6][1]);
+
+  const JulianDate t0 = sat->GetTleEpoch () + Minutes (42);
+  const JulianDate t1 = t0 + MilliSeconds (1);
+  double r[3], v[3];
+
+  // reference state computed from scratch
+  sgp4 (wgs72, records[6], (t1 - sat->GetTleEpoch ()).GetMinutes (), r, v);
+
+  const FrameTransform ft = FrameTransform::Compute (t1);
+  const Vector3D rteme (r[0], r[1], r[2]), vteme (v[0], v[1], v[2]);
+  Vector3D ritrf, vitrf;
+
+  ft.TemeToItrf (rteme, vteme, ritrf, vitrf);
+
+  // the state set at t0 must not be returned at t1
+  sat->SetPosition (t0);
+
+  FrameTransform::ClearCache ();
+
+  NS_TEST_ASSERT_MSG_EQ (sat->GetPosition (t1), 1000*ritrf, "Stale position");
+  NS_TEST_ASSERT_MSG_EQ (sat->GetVelocity (t1), 1000*vitrf, "Stale velocity");
+  NS_TEST_ASSERT_MSG_EQ (sat->GetPositionInECI (t1), 1000*rteme,
+                         "Stale ECI position");
+  NS_TEST_ASSERT_MSG_EQ (sat->GetVelocityInECI (t1), 1000*vteme,
+                         "Stale ECI velocity");
+
+  // all four queries were served by a single propagation
+  NS_TEST_ASSERT_MSG_EQ (FrameTransform::GetCacheMisses (), 1,
+                         "State should have been computed once");
+  NS_TEST_ASSERT_MSG_EQ (FrameTransform::GetCacheHits (), 0,
+                         "State should have been computed once");
+
+  NS_TEST_ASSERT_MSG_NE (sat->GetPosition (t0), sat->GetPosition (t1),
+                         "Position should change with time");
+
+  // with 1 s quantum, the state is that of the start of each second
+  const JulianDate t2 ("2008-09-20 13:10:42");
+
+  sat->SetAttribute ("TimeQuantum", TimeValue (Seconds (1)));
+
+  const Vector3D r2 = sat->GetPosition (t2);
+
+  NS_TEST_ASSERT_MSG_EQ (sat->GetPosition (t2 + MilliSeconds (999)), r2,
+                         "Same quantum should yield the same position");
+  NS_TEST_ASSERT_MSG_NE (sat->GetPosition (t2 + MilliSeconds (1000)), r2,
+                         "Next quantum should yield a different position");
+
+  sat->SetAttribute ("TimeQuantum", TimeValue (Seconds (0)));
+
+  NS_TEST_ASSERT_MSG_NE (sat->GetPosition (t2 + MilliSeconds (999)), r2,
+                         "Exact keys should yield a different position");
+}
+
+/**
+ * Check that a constellation clock updates its mobility models on every tick,
+ * firing their CourseChange traces, and that queries between ticks are close
+ * to the actual state.
+ */
+class ConstellationClockTestCase : public TestCase
+{
+public:
+  ConstellationClockTestCase ();
+  virtual ~ConstellationClockTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Count a course change.
+   * @param model the mobility model.
+   */
+  void CourseChange (Ptr<const MobilityModel> model);
+
+  /**
+   * Compare the model's state with the satellite's at the current time.
+   * @param tolerance the position tolerance (m).
+   */
+  void Check (double tolerance);
+
+  Ptr<Satellite> m_sat;                         //!< satellite.
+  Ptr<SatellitePositionMobilityModel> m_model;  //!< its mobility model.
+  JulianDate m_start;                           //!< simulation start.
+  uint32_t m_changes;                           //!< course changes.
+};
+
+ConstellationClockTestCase::ConstellationClockTestCase ()
+  : TestCase ("Check the constellation clock"), m_changes (0)
+{
+}
+
+ConstellationClockTestCase::~ConstellationClockTestCase ()
+{
+}
+
+void
+ConstellationClockTestCase::CourseChange (Ptr<const MobilityModel> model)
+{
+  ++m_changes;
+  Check (1e-6);
+}
+
+void
+ConstellationClockTestCase::Check (double tolerance)
+{
+  const JulianDate t = m_start + Simulator::Now ();
+
+  NS_TEST_ASSERT_MSG_LT (
+    CalculateDistance (m_model->GetPosition (), m_sat->GetPosition (t)),
+    tolerance, "Position at " << Simulator::Now ().GetMilliSeconds () << " ms"
+  );
+  NS_TEST_ASSERT_MSG_LT (
+    CalculateDistance (m_model->DoGetPositionInECI (),
+                       m_sat->GetPositionInECI (t)),
+    tolerance, "ECI position at " << Simulator::Now ().GetMilliSeconds ()
+  );
+}
+
+void
+ConstellationClockTestCase::DoRun (void)
+{
+  m_sat = CreateObject<Satellite> ();
+  m_sat->SetTleInfo (g_tles[6][0], g_tles[6][1]);
+
+  m_start = m_sat->GetTleEpoch () + Minutes (42);
+  m_model = CreateObject<SatellitePositionMobilityModel> ();
+  m_model->SetSatellite (m_sat);
+  m_model->SetStartTime (m_start);
+  m_model->TraceConnectWithoutContext (
+    "CourseChange",
+    MakeCallback (&ConstellationClockTestCase::CourseChange, this)
+  );
+
+  Ptr<ConstellationClock> clock = CreateObject<ConstellationClock> ();
+
+  clock->Add (m_model);
+  Simulator::ScheduleNow (&ConstellationClock::Start, clock);
+
+  // exact on ticks (see CourseChange) and extrapolated in between, a*dt^2/2
+  // being about 4 cm at 100 ms from a tick (the check at 200 ms was scheduled
+  // before the tick at that time, and thus runs first)
+  Simulator::Schedule (MilliSeconds (150),
+                       &ConstellationClockTestCase::Check, this, 0.02);
+  Simulator::Schedule (MilliSeconds (200),
+                       &ConstellationClockTestCase::Check, this, 0.06);
+  Simulator::Schedule (MilliSeconds (1050), &ConstellationClock::Stop, clock);
+
+  // after stopping, the state is computed on every query again
+  Simulator::Schedule (MilliSeconds (1120),
+                       &ConstellationClockTestCase::Check, this, 1e-6);
+
+  Simulator::Stop (Seconds (2));
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_changes, 11, "One course change per tick");
+  NS_TEST_ASSERT_MSG_EQ (clock->IsRunning (), false, "Clock was stopped");
+
+  clock->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * Positions of a Walker delta constellation (circular orbits, evenly spaced
+ * planes and satellites), rotated by a given angle.
+ */
+static std::vector<Vector3D>
+GetWalkerPositions (uint32_t planes, uint32_t perPlane, double altitude,
+                    double inclination, double phase)
+{
+  std::vector<Vector3D> positions;
+  const double r = 6378137.0 + altitude;
+
+  for (uint32_t p = 0; p < planes; ++p)
+    for (uint32_t s = 0; s < perPlane; ++s)
+      {
+        const double raan = 2*M_PI*p/planes;
+        const double u = 2*M_PI*(s + 0.5*p/planes)/perPlane + phase;
+
+        positions.push_back (Vector3D (
+          r*(cos (raan)*cos (u) - sin (raan)*sin (u)*cos (inclination)),
+          r*(sin (raan)*cos (u) + cos (raan)*sin (u)*cos (inclination)),
+          r*sin (u)*sin (inclination)
+        ));
+      }
+
+  return positions;
+}
+
+/**
+ * Positions of ground stations on a latitude/longitude grid of the WGS84
+ * ellipsoid, between latitudes -70 and 70 degrees.
+ */
+static std::vector<Vector3D>
+GetStationPositions (uint32_t n)
+{
+  std::vector<Vector3D> positions;
+  const double a = 6378137.0, e2 = 6.69437999014e-3;
+
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      const double lat = (-70 + 140.0*((i*37) % n)/n)*M_PI/180;
+      const double lon = (360.0*i/n)*M_PI/180;
+      const double N = a/sqrt (1 - e2*sin (lat)*sin (lat));
+
+      positions.push_back (Vector3D (
+        N*cos (lat)*cos (lon), N*cos (lat)*sin (lon), N*(1 - e2)*sin (lat)
+      ));
+    }
+
+  return positions;
+}
+
+/**
+ * Brute force counterpart of VisibilityIndex::FindVisible.
+ */
+static void
+FindVisibleBruteForce (const std::vector<Vector3D> &sats,
+                       const Vector3D &station, double minElevation,
+                       std::vector<uint32_t> &result)
+{
+  result.clear ();
+
+  for (uint32_t i = 0; i < sats.size (); ++i)
+    if (VisibilityIndex::IsVisible (station, minElevation, sats[i]))
+      result.push_back (i);
+}
+
+/**
+ * Check that the visibility index answers range, nearest neighbor and
+ * elevation mask queries as brute force does.
+ */
+class VisibilityIndexTestCase : public TestCase
+{
+public:
+  VisibilityIndexTestCase ();
+  virtual ~VisibilityIndexTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+VisibilityIndexTestCase::VisibilityIndexTestCase ()
+  : TestCase ("Check the satellite visibility index")
+{
+}
+
+VisibilityIndexTestCase::~VisibilityIndexTestCase ()
+{
+}
+
+void
+VisibilityIndexTestCase::DoRun (void)
+{
+  // two shells at different altitudes and inclinations
+  std::vector<Vector3D> sats = GetWalkerPositions (
+    24, 22, 550e3, 53*M_PI/180, 0.1
+  );
+  const std::vector<Vector3D> polar = GetWalkerPositions (
+    6, 11, 1200e3, 87*M_PI/180, 0.3
+  );
+  const std::vector<Vector3D> stations = GetStationPositions (40);
+
+  sats.insert (sats.end (), polar.begin (), polar.end ());
+
+  VisibilityIndex index (500e3);
+  std::vector<uint32_t> result, expected;
+
+  index.Build (sats);
+
+  NS_TEST_ASSERT_MSG_EQ (index.GetN (), sats.size (), "Wrong size");
+  NS_TEST_ASSERT_MSG_EQ_TOL (index.GetMaxRadius (), 6378137.0 + 1200e3, 1e-3,
+                             "Wrong largest radius");
+  NS_TEST_ASSERT_MSG_EQ (index.GetPosition (500), sats[500], "Wrong position");
+
+  // inter-satellite link range
+  for (uint32_t i = 0; i < sats.size (); i += 17)
+    {
+      const double range = 2000e3;
+
+      index.FindInRange (sats[i], range, result);
+
+      expected.clear ();
+      for (uint32_t j = 0; j < sats.size (); ++j)
+        if (CalculateDistance (sats[i], sats[j]) <= range)
+          expected.push_back (j);
+
+      NS_TEST_ASSERT_MSG_EQ ((result == expected), true,
+                             "Range query differs for satellite " << i);
+    }
+
+  // nearest neighbors, from satellites and from ground stations
+  for (uint32_t i = 0; i < stations.size (); ++i)
+    {
+      const Vector3D &p = (i % 2) ? stations[i] : sats[i*13];
+      const uint32_t k = 5;
+      std::vector<std::pair<double, uint32_t> > all;
+
+      for (uint32_t j = 0; j < sats.size (); ++j)
+        all.push_back (std::make_pair (CalculateDistance (p, sats[j]), j));
+
+      std::sort (all.begin (), all.end ());
+      index.FindNearest (p, k, result);
+
+      NS_TEST_ASSERT_MSG_EQ (result.size (), k, "Wrong number of neighbors");
+
+      for (uint32_t j = 0; j < k; ++j)
+        NS_TEST_ASSERT_MSG_EQ (result[j], all[j].second,
+                               "Neighbor " << j << " differs for point " << i);
+    }
+
+  index.FindNearest (stations[0], sats.size () + 10, result);
+  NS_TEST_ASSERT_MSG_EQ (result.size (), sats.size (),
+                         "All satellites should be returned");
+
+  // elevation masks
+  const double masks[] = { -10, 0, 10, 25, 40, 80 };
+
+  for (uint32_t m = 0; m < sizeof (masks)/sizeof (masks[0]); ++m)
+    for (uint32_t i = 0; i < stations.size (); ++i)
+      {
+        const double mask = masks[m]*M_PI/180;
+
+        index.FindVisible (stations[i], mask, result);
+        FindVisibleBruteForce (sats, stations[i], mask, expected);
+
+        NS_TEST_ASSERT_MSG_EQ ((result == expected), true,
+                               "Visible set differs for station " << i
+                               << " at mask " << masks[m]);
+      }
+
+  // ConstellationPropagator tables are indexed the same way
+  ConstellationPropagator::StateTable table;
+
+  table.Resize (sats.size ());
+  for (uint32_t i = 0; i < sats.size (); ++i)
+    {
+      table.x[i] = sats[i].x;
+      table.y[i] = sats[i].y;
+      table.z[i] = sats[i].z;
+    }
+
+  VisibilityIndex other (500e3);
+
+  other.Build (table);
+  other.FindVisible (stations[3], 0.2, result);
+  index.FindVisible (stations[3], 0.2, expected);
+
+  NS_TEST_ASSERT_MSG_EQ ((result == expected), true,
+                         "State table index differs");
+}
+
+/**
+ * Compare the time taken by the visibility index and by brute force to find
+ * the satellites seen by 500 ground stations in a 4000 satellite
+ * constellation, including the time to build the index.
+ */
+class VisibilityIndexBenchmarkTestCase : public TestCase
+{
+public:
+  VisibilityIndexBenchmarkTestCase ();
+  virtual ~VisibilityIndexBenchmarkTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+VisibilityIndexBenchmarkTestCase::VisibilityIndexBenchmarkTestCase ()
+  : TestCase ("Benchmark the visibility index for 4000 satellites x 500 "
+              "ground stations")
+{
+}
+
+VisibilityIndexBenchmarkTestCase::~VisibilityIndexBenchmarkTestCase ()
+{
+}
+
+void
+VisibilityIndexBenchmarkTestCase::DoRun (void)
+{
+  const uint32_t steps = 10;
+  const double mask = 25*M_PI/180;
+  const std::vector<Vector3D> stations = GetStationPositions (500);
+  std::vector<std::vector<Vector3D> > sats;
+  std::vector<uint32_t> result;
+  uint64_t brute = 0, indexed = 0;
+  SystemWallClockMs clock;
+  VisibilityIndex index;
+
+  for (uint32_t s = 0; s < steps; ++s)
+    sats.push_back (GetWalkerPositions (80, 50, 550e3, 53*M_PI/180, 0.01*s));
+
+  clock.Start ();
+  for (uint32_t s = 0; s < steps; ++s)
+    for (uint32_t i = 0; i < stations.size (); ++i)
+      {
+        FindVisibleBruteForce (sats[s], stations[i], mask, result);
+        brute += result.size ();
+      }
+  int64_t bruteTime = clock.End ();
+
+  clock.Start ();
+  for (uint32_t s = 0; s < steps; ++s)
+    {
+      index.Build (sats[s]);
+
+      for (uint32_t i = 0; i < stations.size (); ++i)
+        {
+          index.FindVisible (stations[i], mask, result);
+          indexed += result.size ();
+        }
+    }
+  int64_t indexTime = clock.End ();
+
+  std::cout << "brute force: " << bruteTime << " ms, index (including build): "
+            << indexTime << " ms for " << stations.size ()
+            << " stations x 4000 satellites x " << steps << " steps, "
+            << indexed/(steps*stations.size ()) << " visible per station"
+            << std::endl;
+
+  NS_TEST_ASSERT_MSG_EQ (indexed, brute, "Index missed visible satellites");
+}
+
+/**
+ * Replace the checksum of a TLE line by the right one.
+ */
+static std::string
+FixChecksum (std::string line)
+{
+  line[68] = '0' + TleCatalog::ComputeChecksum (line.c_str ());
+
+  return line;
+}
+
+/**
+ * Check that the catalog loader initializes the same satellites as
+ * Satellite::SetTleInfo, with or without keeping TLE lines and whatever the
+ * number of threads, and that it reports the entries it rejects.
+ */
+class TleCatalogTestCase : public TestCase
+{
+public:
+  TleCatalogTestCase ();
+  virtual ~TleCatalogTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+TleCatalogTestCase::TleCatalogTestCase ()
+  : TestCase ("Check the TLE catalog loader")
+{
+}
+
+TleCatalogTestCase::~TleCatalogTestCase ()
+{
+}
+
+void
+TleCatalogTestCase::DoRun (void)
+{
+  std::string badChecksum = g_tles[1][1];
+  std::string decayed = g_tles[1][1];
+
+  badChecksum[68] = '0' + (badChecksum[68] - '0' + 1) % 10;
+  decayed.replace (52, 11, "19.00000000");
+  decayed = FixChecksum (decayed);
+
+  std::ostringstream catalog;
+
+  // line 1: three-line entry with a "0 " prefixed name
+  catalog << "0 ISS (ZARYA)\n" << g_tles[6][0] << "\n" << g_tles[6][1] << "\n";
+  // line 4: two-line entry, DOS line endings
+  catalog << g_tles[0][0] << "\r\n" << g_tles[0][1] << "\r\n";
+  // line 6: wrong checksum
+  catalog << "BAD CHECKSUM\n" << g_tles[1][0] << "\n" << badChecksum << "\n";
+  // line 9: truncated line
+  catalog << "TRUNCATED\n" << g_tles[1][0] << "\n"
+          << std::string (g_tles[1][1]).substr (0, 60) << "\n";
+  // line 12: missing element set 2, then an orphan element set 2
+  catalog << "\n" << g_tles[1][0] << "\n\n" << g_tles[1][1] << "\n";
+  // line 16: SGP4 failure
+  catalog << "DECAYED\n" << g_tles[1][0] << "\n" << decayed << "\n";
+  // line 19: deep space entry, trailing blanks
+  catalog << "GEO   \n" << g_tles[5][0] << "  \n" << g_tles[5][1] << "\n";
+
+  Ptr<TleCatalog> tle = CreateObject<TleCatalog> ();
+
+  tle->SetAttribute ("Threads", UintegerValue (1));
+  tle->Parse (catalog.str ());
+
+  NS_TEST_ASSERT_MSG_EQ (tle->GetNSatellites (), 3, "Wrong satellite count");
+  NS_TEST_ASSERT_MSG_EQ (tle->GetSatellite (0)->GetName (), "ISS (ZARYA)",
+                         "Wrong name");
+  NS_TEST_ASSERT_MSG_EQ (tle->GetSatellite (1)->GetName (), "", "Wrong name");
+  NS_TEST_ASSERT_MSG_EQ (tle->GetSatellite (2)->GetName (), "GEO",
+                         "Wrong name");
+
+  const uint32_t indexes[] = { 6, 0, 5 };
+
+  for (uint32_t i = 0; i < 3; ++i)
+    {
+      Ptr<Satellite> sat = tle->GetSatellite (i);
+      Ptr<Satellite> ref = CreateObject<Satellite> ();
+
+      ref->SetTleInfo (g_tles[indexes[i]][0], g_tles[indexes[i]][1]);
+
+      const JulianDate t = ref->GetTleEpoch () + Hours (5);
+
+      NS_TEST_ASSERT_MSG_EQ (sat->IsInitialized (), true, "Not initialized");
+      NS_TEST_ASSERT_MSG_EQ (sat->GetSatelliteNumber (),
+                             ref->GetSatelliteNumber (), "Wrong number");
+      NS_TEST_ASSERT_MSG_EQ ((sat->GetTleInfo () == ref->GetTleInfo ()), true,
+                             "Wrong TLE lines");
+      NS_TEST_ASSERT_MSG_EQ (sat->GetPosition (t), ref->GetPosition (t),
+                             "Wrong position");
+    }
+
+  const std::vector<TleCatalog::Rejection> &rejections = tle->GetRejections ();
+  const uint32_t lines[] = { 7, 10, 13, 15, 17 };
+  const int errors[] = {
+    TleCatalog::ChecksumError, TleCatalog::FormatError,
+    TleCatalog::FormatError, TleCatalog::FormatError, 6
+  };
+
+  NS_TEST_ASSERT_MSG_EQ (rejections.size (), 5, "Wrong rejection count");
+
+  for (uint32_t i = 0; i < rejections.size (); ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (rejections[i].line, lines[i],
+                             "Wrong line of rejection " << i);
+      NS_TEST_ASSERT_MSG_EQ (rejections[i].error, errors[i],
+                             "Wrong error of rejection " << i);
+    }
+
+  NS_TEST_ASSERT_MSG_EQ (rejections[0].name, "BAD CHECKSUM", "Wrong name");
+  NS_TEST_ASSERT_MSG_EQ (rejections[2].name, "", "Wrong name");
+
+  std::ostringstream report;
+
+  tle->PrintReport (report);
+  NS_TEST_ASSERT_MSG_NE (report.str ().find ("line 17 (DECAYED): error 6"),
+                         std::string::npos, "Wrong report");
+
+  // without TLE lines, and on several threads
+  Ptr<TleCatalog> other = CreateObject<TleCatalog> ();
+
+  other->SetAttribute ("Threads", UintegerValue (4));
+  other->SetAttribute ("KeepTle", BooleanValue (false));
+  other->Parse (catalog.str ());
+
+  NS_TEST_ASSERT_MSG_EQ (other->GetNSatellites (), 3, "Wrong satellite count");
+  NS_TEST_ASSERT_MSG_EQ (other->GetRejections ().size (), 5,
+                         "Wrong rejection count");
+
+  for (uint32_t i = 0; i < 3; ++i)
+    {
+      Ptr<Satellite> sat = other->GetSatellite (i);
+      const JulianDate t = sat->GetTleEpoch () + Hours (5);
+
+      NS_TEST_ASSERT_MSG_EQ (sat->IsInitialized (), true, "Not initialized");
+      NS_TEST_ASSERT_MSG_EQ (sat->GetTleInfo ().first, "", "TLE was kept");
+      NS_TEST_ASSERT_MSG_EQ (sat->GetPosition (t),
+                             tle->GetSatellite (i)->GetPosition (t),
+                             "Wrong position");
+    }
+
+  NS_TEST_ASSERT_MSG_EQ (tle->Load (CreateTempDirFilename ("missing.tle")),
+                         false, "Missing file should not load");
+}
+
+/**
+ * Compare the time taken to load a 10000 entry catalog line by line through
+ * Satellite::SetTleInfo and through the catalog loader.
+ */
+class TleCatalogBenchmarkTestCase : public TestCase
+{
+public:
+  TleCatalogBenchmarkTestCase ();
+  virtual ~TleCatalogBenchmarkTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+TleCatalogBenchmarkTestCase::TleCatalogBenchmarkTestCase ()
+  : TestCase ("Benchmark the TLE catalog loader for 10000 entries")
+{
+}
+
+TleCatalogBenchmarkTestCase::~TleCatalogBenchmarkTestCase ()
+{
+}
+
+void
+TleCatalogBenchmarkTestCase::DoRun (void)
+{
+  const uint32_t n = 10000;
+  const std::string filename = CreateTempDirFilename ("catalog.tle");
+
+  {
+    std::ofstream f (filename.c_str ());
+
+    // near earth and deep space objects, renumbered
+    for (uint32_t i = 0; i < n; ++i)
+      {
+        const uint32_t k = (i % 4 ? (i % 2 ? 6 : 2) : 4);
+        std::string line1 = g_tles[k][0], line2 = g_tles[k][1];
+        char satnum[6];
+
+        snprintf (satnum, sizeof (satnum), "%05u", 10000 + i);
+        line1.replace (2, 5, satnum);
+        line2.replace (2, 5, satnum);
+
+        f << "SAT " << i << "\n" << FixChecksum (line1) << "\n"
+          << FixChecksum (line2) << "\n";
+      }
+  }
+
+  SystemWallClockMs clock;
+  std::vector<Ptr<Satellite> > sats;
+
+  clock.Start ();
+  {
+    std::ifstream f (filename.c_str ());
+    std::string name, line1, line2;
+
+    while (std::getline (f, name) && std::getline (f, line1) &&
+           std::getline (f, line2))
+      {
+        Ptr<Satellite> sat = CreateObject<Satellite> ();
+
+        if (sat->SetTleInfo (line1, line2))
+          {
+            sat->SetName (name);
+            sats.push_back (sat);
+          }
+      }
+  }
+  int64_t serial = clock.End ();
+
+  Ptr<TleCatalog> tle = CreateObject<TleCatalog> ();
+
+  clock.Start ();
+  tle->Load (filename);
+  int64_t parallel = clock.End ();
+
+  tle->SetAttribute ("KeepTle", BooleanValue (false));
+
+  clock.Start ();
+  tle->Load (filename);
+  int64_t compact = clock.End ();
+
+  std::cout << "SetTleInfo: " << serial << " ms, TleCatalog: " << parallel
+            << " ms, without TLE lines: " << compact << " ms for " << n
+            << " entries" << std::endl;
+
+  NS_TEST_ASSERT_MSG_EQ (sats.size (), n, "Entries were rejected");
+  NS_TEST_ASSERT_MSG_EQ (tle->GetNSatellites (), n, "Entries were rejected");
+}
+
+static class SatelliteTestSuite : public TestSuite
+{
+public:
+  SatelliteTestSuite ()
+  : TestSuite ("satellite", UNIT)
+    {
+      NS_LOG_INFO ("creating SatelliteTestSuite");
+
+      AddTestCase (new Sgp4SimdTestCase (), TestCase::QUICK);
+      AddTestCase (new Sgp4SimdBenchmarkTestCase (), TestCase::EXTENSIVE);
+      AddTestCase (new FrameTransformCacheTestCase (), TestCase::QUICK);
+      AddTestCase (new EphemerisTestCase (), TestCase::QUICK);
+      AddTestCase (new EphemerisFileTestCase (), TestCase::QUICK);
+      AddTestCase (new SatelliteStateCacheTestCase (), TestCase::QUICK);
+      AddTestCase (new ConstellationClockTestCase (), TestCase::QUICK);
+      AddTestCase (new VisibilityIndexTestCase (), TestCase::QUICK);
+      AddTestCase (new VisibilityIndexBenchmarkTestCase (),
+                   TestCase::EXTENSIVE);
+      AddTestCase (new TleCatalogTestCase (), TestCase::QUICK);
+      AddTestCase (new TleCatalogBenchmarkTestCase (), TestCase::EXTENSIVE);
+    }
+
+} g_satelliteTestSuite;